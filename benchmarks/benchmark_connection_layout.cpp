@@ -0,0 +1,266 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "core/client_connection.hpp"
+#include "core/message_handler.hpp"
+#include "crypto/encryption_manager.hpp"
+#include "network/protocol_handler.hpp"
+#include "utils/message_buffer.hpp"
+
+using namespace securechat;
+
+// False-sharing benchmark for ClientConnection's per-direction fields. One
+// real, authenticated connection over a socketpair is driven the way the
+// server drives it: thread 0 is the receive path (a DATA record is read,
+// decrypted and counted, writing messages_received_ and last_activity_),
+// thread 1 the send path (a record is sealed and written, writing
+// messages_sent_ and the send lock). Both read state_ on every message.
+//
+// Each path is measured alone, then both at once. With the fields split by
+// writer, running the directions together should cost each no more cache
+// misses per message than running it alone; a layout that puts the two
+// directions on one line shows up as the difference.
+//
+// Reported per run, from Linux perf counters on each thread (absent when
+// perf_event_open is not permitted, e.g. perf_event_paranoid > 2):
+//   l1d_misses_per_op   L1 data-cache read misses per operation
+//   cache_misses_per_op last-level cache misses per operation
+// Both include the work around the fields (crypto, syscalls), which is the
+// same alone and together.
+//
+// Run with both threads on separate physical cores, e.g.
+//   taskset -c 0,2 ./benchmark_connection_layout
+
+namespace {
+
+class PerfCounter {
+public:
+    PerfCounter(uint32_t type, uint64_t config) {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // This thread only, on whichever CPU it runs
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)type;
+        (void)config;
+#endif
+    }
+
+    ~PerfCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool isAvailable() const { return fd_ >= 0; }
+
+    void start() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t stop() {
+        uint64_t value = 0;
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+                value = 0;
+            }
+        }
+#endif
+        return value;
+    }
+
+private:
+    int fd_{-1};
+};
+
+// Accepts every credential and ignores messages, so only the connection's
+// own work is measured
+class NullHandler : public core::MessageHandler {
+public:
+    network::AuthStatus authenticate(core::ClientConnection&, std::string_view, std::string_view) override {
+        return network::AuthStatus::OK;
+    }
+    void onJoinRoom(core::ClientConnection&, uint64_t) override {}
+    void onMessage(core::ClientConnection&, const std::string&) override {}
+    void onResume(core::ClientConnection&, std::string_view, uint64_t) override {}
+    void onDisconnect(core::ClientConnection&) override {}
+    security::RateLimitConfig getRateLimit() const override {
+        security::RateLimitConfig config;
+        config.messages_per_second = 1e12;
+        config.burst_size = 1e12;
+        return config;
+    }
+};
+
+// An authenticated connection and the peer end of its socket. The peer's
+// keys seal what the receive path reads; whatever the send path writes is
+// read back from the peer and discarded.
+class Session {
+public:
+    static Session& get() {
+        static Session session;
+        return session;
+    }
+
+    bool isReady() const { return ready_; }
+
+    // One chat record through the receive path
+    void receiveOne() {
+        auto record = peer_keys_.encrypt(utils::MessageBuffer(RECEIVED));
+        writeAll(record.data(), record.size());
+        connection_->onReadable();
+    }
+
+    // One chat record through the send path
+    void sendOne() {
+        connection_->sendEncryptedMessage(sent_);
+        char buffer[4096];
+        while (::read(peer_fd_, buffer, sizeof(buffer)) > 0) {
+        }
+    }
+
+    bool isConnected() const { return connection_->isAuthenticated(); }
+
+private:
+    static constexpr const char* RECEIVED = "a message of the usual length from a chat client";
+
+    Session() : sent_("a message of the usual length from a chat server") {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) != 0) {
+            return;
+        }
+        peer_fd_ = fds[1];
+        connection_ = std::make_unique<core::ClientConnection>(fds[0], 1);
+        connection_->setMessageHandler(&handler_);
+        if (!connection_->initialize() || !peer_keys_.generateEphemeralKeys()) {
+            return;
+        }
+        connection_->start(nullptr);
+
+        std::string hello;
+        network::ProtocolHandler::appendFrame(hello, network::FrameType::KEY_EXCHANGE, peer_keys_.getPublicKey());
+        network::ProtocolHandler::appendAuth(hello, "benchmark", "secret");
+        writeAll(hello.data(), hello.size());
+        connection_->onReadable();
+
+        network::ProtocolHandler decoder;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::read(peer_fd_, buffer, sizeof(buffer))) > 0) {
+            decoder.append(buffer, static_cast<size_t>(n));
+        }
+        network::Frame frame;
+        while (decoder.nextFrame(frame)) {
+            if (frame.type == network::FrameType::KEY_EXCHANGE &&
+                !peer_keys_.exchangeKeys(std::string(frame.payload))) {
+                return;
+            }
+        }
+        ready_ = connection_->isAuthenticated();
+    }
+
+    ~Session() {
+        connection_.reset();
+        if (peer_fd_ >= 0) {
+            close(peer_fd_);
+        }
+    }
+
+    void writeAll(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = ::write(peer_fd_, data, size);
+            if (n <= 0) {
+                return;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    NullHandler handler_;
+    int peer_fd_{-1};
+    std::unique_ptr<core::ClientConnection> connection_;
+    crypto::EncryptionManager peer_keys_;
+    const utils::MessageBuffer sent_;
+    bool ready_{false};
+};
+
+enum Path { RECEIVE, SEND, BOTH };
+
+template<Path P>
+void BM_ConnectionPaths(benchmark::State& state) {
+    Session& session = Session::get();
+    if (!session.isReady()) {
+        state.SkipWithError("could not authenticate the connection");
+        return;
+    }
+
+    PerfCounter l1d_misses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    PerfCounter cache_misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    l1d_misses.start();
+    cache_misses.start();
+
+    const bool receive_path = P == RECEIVE || (P == BOTH && state.thread_index() == 0);
+    for (auto _ : state) {
+        if (receive_path) {
+            session.receiveOne();
+        } else {
+            session.sendOne();
+        }
+    }
+
+    uint64_t l1d = l1d_misses.stop();
+    uint64_t llc = cache_misses.stop();
+    if (!session.isConnected()) {
+        state.SkipWithError("connection dropped");
+        return;
+    }
+    double ops = static_cast<double>(state.iterations());
+    if (l1d_misses.isAvailable() && ops > 0) {
+        state.counters["l1d_misses_per_op"] =
+            benchmark::Counter(static_cast<double>(l1d) / ops, benchmark::Counter::kAvgThreads);
+    }
+    if (cache_misses.isAvailable() && ops > 0) {
+        state.counters["cache_misses_per_op"] =
+            benchmark::Counter(static_cast<double>(llc) / ops, benchmark::Counter::kAvgThreads);
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_ConnectionPaths, RECEIVE)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConnectionPaths, SEND)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConnectionPaths, BOTH)->Threads(2)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include "plugins/content_filter.hpp"
+#include "plugins/spam_detector.hpp"
+
+using namespace securechat::plugins;
+
+namespace {
+
+std::vector<FilterPattern> makePatterns(size_t count) {
+    std::vector<FilterPattern> patterns;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    for (size_t i = 0; i < count; ++i) {
+        std::string word(5 + i % 6, 'a');
+        for (auto& c : word) {
+            c = static_cast<char>(letter(rng));
+        }
+        patterns.push_back({word, i % 10 == 0 ? FilterAction::REJECT : FilterAction::MASK, true});
+    }
+    return patterns;
+}
+
+std::string makeMessage(size_t length) {
+    static const std::string text =
+        "Hey everyone, the deploy finished and metrics look healthy. "
+        "Ping me if the dashboards show anything odd tonight. ";
+    std::string message;
+    while (message.size() < length) {
+        message += text;
+    }
+    message.resize(length);
+    return message;
+}
+
+} // namespace
+
+// Messages per second per core for a clean message against N patterns
+static void BM_ContentFilterScan(benchmark::State& state) {
+    auto matcher = PatternMatcher::compile(makePatterns(static_cast<size_t>(state.range(0))));
+    auto message = makeMessage(static_cast<size_t>(state.range(1)));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matcher->scan(message));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(message.size()));
+    state.counters["states"] = static_cast<double>(matcher->getStateCount());
+}
+BENCHMARK(BM_ContentFilterScan)
+    ->ArgsProduct({{10, 1000, 10000}, {64, 256, 4096}});
+
+// Selective pattern sets let the SIMD start-byte prefilter skip most input
+static void BM_ContentFilterScanPrefiltered(benchmark::State& state) {
+    auto matcher = PatternMatcher::compile({
+        {"zebra", FilterAction::MASK, false},
+        {"quartz", FilterAction::REJECT, false},
+    });
+    auto message = makeMessage(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matcher->scan(message));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(message.size()));
+}
+BENCHMARK(BM_ContentFilterScanPrefiltered)->Arg(64)->Arg(256)->Arg(4096);
+
+// Full filter stage including the thread-local snapshot lookup and masking
+static void BM_ContentFilterApply(benchmark::State& state) {
+    securechat::utils::ConfigManager config;
+    ContentFilter filter(config);
+    auto patterns = makePatterns(1000);
+    filter.setPatterns(patterns);
+
+    auto message = makeMessage(128);
+    if (state.range(0)) {
+        message.replace(20, patterns[1].text.size() + 2, " " + patterns[1].text + " ");
+    }
+
+    std::string rewritten;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.apply(message, rewritten));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ContentFilterApply)->Arg(0)->Arg(1)->ThreadRange(1, 8);
+
+// SimHash cost is linear in message length
+static void BM_SimHashFingerprint(benchmark::State& state) {
+    auto message = makeMessage(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SpamDetector::fingerprint(message));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(message.size()));
+}
+BENCHMARK(BM_SimHashFingerprint)->Arg(16)->Arg(128)->Arg(1024);
+
+// Fingerprint plus the per-user and per-room window probes; 32 bytes is the
+// shortest prefix with min_tokens tokens, below which check() stops early
+static void BM_SpamDetectorCheck(benchmark::State& state) {
+    static SpamDetector detector;
+    auto message = makeMessage(static_cast<size_t>(state.range(0)));
+    auto now = std::chrono::steady_clock::now();
+    uint64_t user = static_cast<uint64_t>(state.thread_index()) * 100000;
+
+    for (auto _ : state) {
+        ++user;
+        benchmark::DoNotOptimize(detector.check(user % 5000, user % 64, message, now));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpamDetectorCheck)->Arg(32)->Arg(128)->ThreadRange(1, 8);
+
+BENCHMARK_MAIN();
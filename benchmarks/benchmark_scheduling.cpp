@@ -0,0 +1,288 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "core/event_loop.hpp"
+#include "core/executor.hpp"
+#include "core/shard.hpp"
+#include "core/thread_pool.hpp"
+#include "utils/latency_histogram.hpp"
+
+using namespace securechat;
+using Clock = std::chrono::steady_clock;
+
+// Scheduler microbenchmarks. Each scheduler is wrapped in an adapter with a
+// submit() method so new executors can be added with one adapter and one
+// BENCHMARK_TEMPLATE line and compared on the same numbers.
+//
+// Reported per run:
+//   time/iteration    producer-side cost of one submit under contention
+//   tasks_per_second  completed tasks over wall time, including the drain
+//   p50/p99/p999/max  enqueue-to-start latency in microseconds
+
+namespace {
+
+size_t workerCount() {
+    return std::max(2u, std::thread::hardware_concurrency());
+}
+
+struct ThreadPoolScheduler {
+    ThreadPoolScheduler() : pool(workerCount()) {}
+
+    template<class F>
+    void submit(F&& task) {
+        pool.enqueue(std::forward<F>(task));
+    }
+
+    core::ThreadPool pool;
+};
+
+// Autoscaling executor, starting from one thread
+struct ExecutorScheduler {
+    ExecutorScheduler() : executor([]() {
+        core::ExecutorConfig config;
+        config.name = "benchmark";
+        config.min_threads = 1;
+        config.max_threads = workerCount();
+        config.target_queue_delay = std::chrono::microseconds(200);
+        return config;
+    }()) {}
+
+    template<class F>
+    void submit(F&& task) {
+        executor.submit(std::forward<F>(task));
+    }
+
+    core::Executor executor;
+};
+
+struct EventLoopScheduler {
+    EventLoopScheduler() {
+        loop.initialize();
+        loop.start();
+    }
+    ~EventLoopScheduler() { loop.stop(); }
+
+    template<class F>
+    void submit(F&& task) {
+        loop.scheduleTask(std::forward<F>(task));
+    }
+
+    core::EventLoop loop;
+};
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+// Collects start latencies into one histogram per worker thread, so recording
+// adds no shared writes beyond the completion counter
+class LatencyRecorder {
+public:
+    LatencyRecorder() : id_(next_id_.fetch_add(1)) {}
+
+    void record(uint64_t enqueued_ns) {
+        uint64_t now = nowNs();
+        histogram().record(now > enqueued_ns ? now - enqueued_ns : 0);
+        completed_.fetch_add(1, std::memory_order_release);
+    }
+
+    void waitFor(uint64_t tasks) const {
+        while (completed_.load(std::memory_order_acquire) < tasks) {
+            std::this_thread::yield();
+        }
+    }
+
+    utils::LatencyHistogram merged() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        utils::LatencyHistogram result;
+        for (const auto& histogram : histograms_) {
+            result.merge(*histogram);
+        }
+        return result;
+    }
+
+private:
+    utils::LatencyHistogram& histogram() {
+        thread_local uint64_t cached_id = 0;
+        thread_local utils::LatencyHistogram* cached = nullptr;
+        if (cached_id != id_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            histograms_.push_back(std::make_unique<utils::LatencyHistogram>());
+            cached = histograms_.back().get();
+            cached_id = id_;
+        }
+        return *cached;
+    }
+
+    static inline std::atomic<uint64_t> next_id_{1};
+
+    const uint64_t id_;
+    std::atomic<uint64_t> completed_{0};
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<utils::LatencyHistogram>> histograms_;
+};
+
+void reportLatency(benchmark::State& state, const utils::LatencyHistogram& latency) {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    state.counters["p50_us"] = us(latency.percentile(50));
+    state.counters["p99_us"] = us(latency.percentile(99));
+    state.counters["p999_us"] = us(latency.percentile(99.9));
+    state.counters["max_us"] = us(latency.getMax());
+}
+
+} // namespace
+
+// Producers (benchmark threads) submit as fast as they can
+template<class Scheduler>
+static void BM_SubmitUnderContention(benchmark::State& state) {
+    static std::unique_ptr<Scheduler> scheduler;
+    static std::unique_ptr<LatencyRecorder> recorder;
+    static std::atomic<uint64_t> submitted{0};
+    static Clock::time_point start;
+
+    if (state.thread_index() == 0) {
+        scheduler = std::make_unique<Scheduler>();
+        recorder = std::make_unique<LatencyRecorder>();
+        submitted.store(0);
+        start = Clock::now();
+    }
+
+    uint64_t local = 0;
+    for (auto _ : state) {
+        LatencyRecorder* target = recorder.get();
+        uint64_t enqueued = nowNs();
+        scheduler->submit([target, enqueued]() { target->record(enqueued); });
+        local++;
+    }
+    submitted.fetch_add(local);
+    state.SetItemsProcessed(static_cast<int64_t>(local));
+
+    if (state.thread_index() == 0) {
+        // Other producers have left the loop; wait for their tasks to finish
+        while (submitted.load() < static_cast<uint64_t>(state.iterations()) * static_cast<uint64_t>(state.threads())) {
+            std::this_thread::yield();
+        }
+        recorder->waitFor(submitted.load());
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        state.counters["tasks_per_second"] = static_cast<double>(submitted.load()) / seconds;
+        reportLatency(state, recorder->merged());
+        scheduler.reset();
+        recorder.reset();
+    }
+}
+BENCHMARK_TEMPLATE(BM_SubmitUnderContention, ThreadPoolScheduler)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SubmitUnderContention, EventLoopScheduler)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SubmitUnderContention, ExecutorScheduler)->ThreadRange(1, 64)->UseRealTime();
+
+// One task at a time against an idle scheduler: the cost of waking a sleeping worker
+template<class Scheduler>
+static void BM_IdleWakeupLatency(benchmark::State& state) {
+    Scheduler scheduler;
+    LatencyRecorder recorder;
+    std::atomic<bool> started{false};
+
+    uint64_t tasks = 0;
+    for (auto _ : state) {
+        started.store(false, std::memory_order_relaxed);
+        uint64_t enqueued = nowNs();
+        scheduler.submit([&recorder, &started, enqueued]() {
+            recorder.record(enqueued);
+            started.store(true, std::memory_order_release);
+        });
+        while (!started.load(std::memory_order_acquire)) {
+        }
+        tasks++;
+
+        // Give the worker time to go back to sleep before the next sample
+        state.PauseTiming();
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(state.range(0))));
+        state.ResumeTiming();
+    }
+
+    recorder.waitFor(tasks);
+    state.SetItemsProcessed(static_cast<int64_t>(tasks));
+    reportLatency(state, recorder.merged());
+}
+BENCHMARK_TEMPLATE(BM_IdleWakeupLatency, ThreadPoolScheduler)->Arg(0)->Arg(200)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_IdleWakeupLatency, EventLoopScheduler)->Arg(0)->Arg(200)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_IdleWakeupLatency, ExecutorScheduler)->Arg(0)->Arg(200)->UseRealTime();
+
+// Shared-nothing fan-out: every shard publishes into its own room of local
+// members, and one message in FORWARD_EVERY goes to a room with a member on
+// every shard. Arg = shard count; deliveries/second should grow close to
+// linearly with it on enough cores.
+static void BM_ShardedFanOut(benchmark::State& state) {
+    constexpr uint64_t MEMBERS_PER_SHARD = 16;
+    constexpr uint64_t SHARED_ROOM = ~uint64_t{0};
+    constexpr int BATCH = 1024;
+    constexpr int FORWARD_EVERY = 8;
+
+    size_t shard_count = static_cast<size_t>(state.range(0));
+    core::ShardedRuntime runtime(shard_count, [](core::Shard&, uint64_t, uint64_t, const utils::MessageBuffer& message) {
+        benchmark::DoNotOptimize(message.data());
+    });
+    runtime.start();
+
+    auto onEveryShard = [&](std::function<void(core::Shard&)> task) {
+        std::vector<std::promise<void>> done(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            runtime.post(i, [&task, &done, i](core::Shard& shard) {
+                task(shard);
+                done[i].set_value();
+            });
+        }
+        for (auto& promise : done) {
+            promise.get_future().wait();
+        }
+    };
+    auto deliveries = [&]() {
+        uint64_t total = 0;
+        for (size_t i = 0; i < shard_count; ++i) {
+            total += runtime.getShard(i).getLocalDeliveries();
+        }
+        return total;
+    };
+
+    // Client ids are assigned so that shardOf() places each on its shard
+    onEveryShard([&](core::Shard& shard) {
+        for (uint64_t member = 0; member < MEMBERS_PER_SHARD; ++member) {
+            shard.join(member * shard_count + shard.getIndex(), shard.getIndex());
+        }
+        shard.join(shard.getIndex(), SHARED_ROOM);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // Senders are not members, so every copy is delivered
+    const utils::MessageBuffer message(std::string(256, 'x'));
+    const uint64_t per_batch = shard_count * (BATCH * MEMBERS_PER_SHARD + (BATCH / FORWARD_EVERY) * shard_count);
+    uint64_t expected = deliveries();
+    for (auto _ : state) {
+        onEveryShard([&](core::Shard& shard) {
+            for (int i = 0; i < BATCH; ++i) {
+                shard.publish(shard.getIndex(), SHARED_ROOM, message);
+                if (i % FORWARD_EVERY == 0) {
+                    shard.publish(SHARED_ROOM, SHARED_ROOM, message);
+                }
+            }
+        });
+        expected += per_batch;
+        while (deliveries() < expected) {
+            std::this_thread::yield();
+        }
+    }
+
+    runtime.stop();
+    state.counters["deliveries_per_second"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * per_batch), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ShardedFanOut)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
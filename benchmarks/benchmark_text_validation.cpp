@@ -0,0 +1,51 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include "utils/text_validator.hpp"
+
+using namespace securechat::utils;
+
+namespace {
+
+std::string makeText(size_t length, bool multilingual) {
+    static const std::string ascii =
+        "Hey everyone, the deploy finished and metrics look healthy. "
+        "Ping me if the dashboards show anything odd tonight.\n";
+    // Latin-1, Greek, CJK and emoji: two- to four-byte sequences
+    static const std::string mixed =
+        "Caf\xc3\xa9 r\xc3\xa9sum\xc3\xa9 \xce\xba\xce\xb1\xce\xbb\xce\xb7\xce\xbc\xce\xad\xcf\x81\xce\xb1 "
+        "\xe4\xbd\xa0\xe5\xa5\xbd\xe4\xb8\x96\xe7\x95\x8c \xf0\x9f\x9a\x80\xf0\x9f\x8e\x89 done.\n";
+    const std::string& piece = multilingual ? mixed : ascii;
+    std::string text;
+    while (text.size() + piece.size() <= length) {
+        text += piece;
+    }
+    // Pad with ASCII so every sequence stays whole
+    text.append(length - text.size(), 'x');
+    return text;
+}
+
+template<TextStatus (*Validate)(std::string_view)>
+void BM_ValidateText(benchmark::State& state) {
+    auto text = makeText(static_cast<size_t>(state.range(0)), state.range(1) != 0);
+    if (Validate(text) != TextStatus::VALID) {
+        state.SkipWithError("benchmark text failed validation");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Validate(text));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+
+} // namespace
+
+// Bytes per second per core; the second argument selects multilingual text
+BENCHMARK_TEMPLATE(BM_ValidateText, validateTextScalar)->ArgsProduct({{64, 1024, 65536}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_ValidateText, validateTextSSSE3)->ArgsProduct({{64, 1024, 65536}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_ValidateText, validateTextAVX2)->ArgsProduct({{64, 1024, 65536}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_ValidateText, validateText)->ArgsProduct({{64, 1024, 65536}, {0, 1}});
+
+BENCHMARK_MAIN();
@@ -7,25 +7,32 @@
 #include <mutex>
 #include <chrono>
 #include <thread>
+#include <vector>
 
+#include "core/connection_table.hpp"
+#include "core/message_handler.hpp"
+#include "core/retransmit_window.hpp"
 #include "crypto/encryption_manager.hpp"
+#include "network/async_io.hpp"
 #include "network/message_queue.hpp"
+#include "network/protocol_handler.hpp"
+#include "network/transport.hpp"
 #include "security/rate_limiter.hpp"
+#include "utils/clock.hpp"
+#include "utils/cpu_topology.hpp"
+#include "utils/huge_page_arena.hpp"
 #include "utils/logger.hpp"
+#include "utils/memory_pool.hpp"
+#include "utils/message_buffer.hpp"
 
 namespace securechat::core {
 
-enum class ClientState {
-    CONNECTING,
-    AUTHENTICATING,
-    AUTHENTICATED,
-    DISCONNECTING,
-    DISCONNECTED
-};
-
 class ClientConnection {
 public:
+    // Wraps the socket in a SocketTransport
     explicit ClientConnection(int socket_fd, uint64_t client_id);
+    ClientConnection(std::unique_ptr<network::Transport> transport, uint64_t client_id,
+                     const utils::Clock& clock = utils::Clock::system());
     ~ClientConnection();
 
     // Non-copyable, non-movable
@@ -35,20 +42,41 @@ public:
     ClientConnection& operator=(ClientConnection&&) = delete;
 
     bool initialize();
-    void start();
+    // Receives the connection's decoded frames; set before start()
+    void setMessageHandler(MessageHandler* handler) { handler_ = handler; }
+    // Registers for readiness instead of running per-connection threads:
+    // sockets with async_io, in-process transports through their read handler.
+    // With a null async_io the owner of the socket (a shard poller) calls
+    // onReadable() itself. disconnect() deregisters before the transport is
+    // closed.
+    void start(network::AsyncIO* async_io);
     void disconnect();
 
-    // Message handling
+    // Drains the transport and handles every complete message. Returns false
+    // once the peer has gone away.
+    bool onReadable();
+    // Reads at most max_bytes and handles the complete messages; the turn is
+    // not drained only when the budget ran out first. The reactor calls this
+    // through its FairShareScheduler.
+    network::ReadTurn readTurn(size_t max_bytes);
+
+    // Message handling. Outgoing chat messages arrive as shared buffers and
+    // stay shared until encryption; a record that cannot be written at once
+    // is queued without copying its bytes. Sending to a connection that is
+    // not authenticated fails, and a failed write disconnects it.
     bool sendMessage(const std::string& message);
-    bool sendEncryptedMessage(const std::string& message);
-    void queueMessage(const std::string& message);
+    bool sendEncryptedMessage(const utils::MessageBuffer& message);
 
-    // Authentication
+    // Authentication; credentials are an AUTH frame payload. The handler
+    // may answer later from another thread; until it does, frames read are
+    // held back. False when the credentials are malformed or were refused
+    // at once.
     bool authenticate(const std::string& credentials);
     void setAuthenticated(bool authenticated);
 
     // Getters
     uint64_t getId() const { return client_id_; }
+    int getNativeHandle() const { return transport_ ? transport_->nativeHandle() : -1; }
     ClientState getState() const { return state_.load(); }
     bool isAuthenticated() const { return state_.load() == ClientState::AUTHENTICATED; }
     bool isConnected() const { 
@@ -65,49 +93,208 @@ public:
     // Rate limiting
     bool checkRateLimit();
 
+    // The server's ConnectionTable row. State transitions, activity, send
+    // queue depth and byte counts are mirrored into it for the server's
+    // sweeps; the table outlives every connection it holds. The row is bound
+    // to this connection's generation of the slot, so once the server
+    // removes the connection its writes are dropped.
+    void attachToTable(ConnectionTable& table, ConnectionTable::Slot slot) { table_row_ = table.row(slot); }
+    const ConnectionTable::Row& getTableRow() const { return table_row_; }
+
+    // At-least-once delivery, when the server enables it. The window opens
+    // with the peer's first ACK or RESUME, so clients that never acknowledge
+    // are not tracked. From then on every chat record sent stays in the
+    // window until the peer ACKs its sequence number, or until newer records
+    // push it out of a full window, and the window's occupancy is mirrored
+    // into the table row. The window outlives the connection: on disconnect
+    // the server parks it under the resume token, and on RESUME replays it
+    // with resumeFrom().
+    void enableRetransmitWindow(size_t capacity) { retransmit_capacity_ = capacity; }
+    std::shared_ptr<RetransmitWindow> getRetransmitWindow() const {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        return retransmit_window_;
+    }
+    // Handles an ACK frame; receive path only
+    void acknowledge(uint64_t sequence) {
+        if (retransmit_window_ && retransmit_window_->acknowledge(sequence) > 0) {
+            publishRetransmitWindow();
+        }
+    }
+    // Resends, oldest first, what the previous session sent after
+    // `acknowledged`; returns how many messages that was
+    size_t resumeFrom(RetransmitWindow& previous, uint64_t acknowledged) {
+        auto messages = previous.drainAfter(acknowledged);
+        for (const auto& message : messages) {
+            sendEncryptedMessage(message);
+        }
+        return messages.size();
+    }
+    // Set on authentication; RESUME presents the previous session's token,
+    // and only a connection authenticated as the same user may claim it
+    void setResumeToken(std::string token) { resume_token_ = std::move(token); }
+    const std::string& getResumeToken() const { return resume_token_; }
+    void setUserId(std::string user_id) { user_id_ = std::move(user_id); }
+    const std::string& getUserId() const { return user_id_; }
+
+    // The room JOIN_ROOM last named, 0 (the lobby) until then; mirrored into
+    // the table row, where broadcasts pick their recipients
+    void setRoom(uint64_t room_id) {
+        room_id_.store(room_id, std::memory_order_relaxed);
+        getTableRow().setRoom(room_id);
+    }
+    uint64_t getRoom() const { return room_id_.load(std::memory_order_relaxed); }
+
+    // Idle memory. After idle_after without traffic the receive block goes
+    // back to the pool, the rate limiter is released (a bucket idle that
+    // long is full anyway) and the X25519 handshake keys and cached record
+    // cipher contexts are dropped, leaving only session keys; send queues are
+    // already released once drained.
+    // Returns true if anything was freed. Sockets registered with AsyncIO
+    // are trimmed as if by their own handler; otherwise call this from the
+    // thread that drains the connection.
+    bool trimIdle(utils::Clock::time_point now, utils::Clock::duration idle_after);
+    // Heap and object bytes currently held by this connection; same
+    // threading rule as trimIdle()
+    size_t getResidentBytes() const;
+
 private:
-    void receiveLoop();
-    void sendLoop();
-    bool processIncomingData();
-    bool handleMessage(const std::string& message);
+    // flushPendingWrites() and sendFrame() take send_mutex_, the *Locked
+    // forms run under it. False means the peer is gone or has stalled.
+    bool flushPendingWrites();
+    bool drainLocked();
+    bool writeLocked(utils::MessageBuffer bytes);
+    bool sendFrame(network::FrameType type, std::string_view payload);
+    // Handles every complete frame among the length bytes just read into
+    // the receive block; false on a protocol violation
+    bool processIncomingData(size_t length);
+    // Appends data to what is buffered and handles the complete frames,
+    // stopping while an AUTH is pending; runs under frames_mutex_
+    bool processFrames(std::string_view data);
+    bool handleFrame(const network::Frame& frame);
+    // The handler's answer to AUTH: writes the result, then handles the
+    // frames held back while it was pending
+    void completeAuthentication(const std::string& username, network::AuthStatus status);
     void updateLastActivity();
+    // The receive path opens the window on the peer's first ACK or RESUME
+    void openRetransmitWindow() {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (!retransmit_window_ && retransmit_capacity_ > 0) {
+            retransmit_window_ = std::make_shared<RetransmitWindow>(retransmit_capacity_);
+        }
+    }
+    // The send path calls this under send_mutex_ once a chat record is
+    // sealed. A full window drops its oldest record; the send goes ahead.
+    void recordSent(uint64_t sequence, const utils::MessageBuffer& message) {
+        if (retransmit_window_) {
+            retransmit_window_->push(sequence, message);
+            publishRetransmitWindow();
+        }
+    }
+    void publishRetransmitWindow() const {
+        getTableRow().setRetransmitWindow(static_cast<uint32_t>(retransmit_window_->size()),
+                                          retransmit_window_->getBytes());
+    }
     void cleanup();
+    // Every state transition goes through here to keep the table row current
+    void setState(ClientState state) {
+        state_.store(state);
+        getTableRow().setState(state);
+    }
 
-    // Connection details
-    const int socket_fd_;
+    // Members are grouped by who writes them. The receive path and the send
+    // path run on different threads, so each direction's write-heavy fields
+    // start their own cache line and neither invalidates the other's, nor
+    // the read-mostly line every message reads. With 64-bit libstdc++ the
+    // three groups fill exactly three cache lines, which
+    // ClientConnectionLayout checks at compile time; the AsyncIO
+    // registration, the message handler (read per message but written
+    // once), delivery state, the room and the AUTH state follow them.
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    friend struct ClientConnectionLayout;
+
+    // Hot, read-mostly: set at connect, read on every message
+    std::unique_ptr<network::Transport> transport_;
     const uint64_t client_id_;
+    const utils::Clock& clock_;
+    // Written only on state transitions
     std::atomic<ClientState> state_{ClientState::CONNECTING};
-
-    // Encryption
+    // Cold: written at most once, or on the first message after connect or
+    // trimIdle() in the case of the rate limiter
+    std::atomic<bool> shutdown_requested_{false};
+    ConnectionTable::Row table_row_;
     std::unique_ptr<crypto::EncryptionManager> encryption_;
+    std::unique_ptr<security::RateLimiter> rate_limiter_;
+
+    // Receive path, written by the thread draining the transport. The
+    // receive block is borrowed from receiveBufferPool() only while the
+    // connection is active.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> messages_received_{0};
+    std::atomic<std::chrono::steady_clock::time_point> last_activity_;
+    utils::MemoryPool::Block receive_buffer_;
+    std::string partial_message_;
 
-    // Message queuing
+    // Send path, written by whichever thread sends. The queue is created
+    // when a write would block. connect_time_ only fills the line's tail.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> messages_sent_{0};
+    mutable std::mutex send_mutex_;
     std::unique_ptr<network::MessageQueue> message_queue_;
+    const std::chrono::steady_clock::time_point connect_time_;
 
-    // Security
-    std::unique_ptr<security::RateLimiter> rate_limiter_;
+    // Set by start(), cleared by disconnect(); both write it under
+    // send_mutex_, where trimIdle() reads it
+    network::AsyncIO* async_io_{nullptr};
+    MessageHandler* handler_{nullptr};
 
-    // Threading
-    std::thread receive_thread_;
-    std::thread send_thread_;
+    // Delivery. The window is opened under send_mutex_ by the receive path
+    // and read by the send path; shared so it can be parked for resume
+    // after disconnect.
+    size_t retransmit_capacity_{0};
+    std::shared_ptr<RetransmitWindow> retransmit_window_;
+    std::string resume_token_;
+    std::string user_id_;
+    // Written by the receive path on JOIN_ROOM
+    std::atomic<uint64_t> room_id_{0};
 
-    // Statistics
-    std::atomic<uint64_t> messages_sent_{0};
-    std::atomic<uint64_t> messages_received_{0};
-    const std::chrono::steady_clock::time_point connect_time_;
-    std::atomic<std::chrono::steady_clock::time_point> last_activity_;
+    // AUTH in flight. Frame handling is serialized by frames_mutex_ between
+    // the thread reading the transport and the one the handler answers on;
+    // frames_owner_ names the thread holding it, so an answer given inline
+    // is not mistaken for a late one.
+    enum class AuthProgress : uint8_t { NONE, PENDING, DONE, FAILED };
+    std::atomic<AuthProgress> auth_progress_{AuthProgress::NONE};
+    std::mutex frames_mutex_;
+    std::atomic<std::thread::id> frames_owner_{};
+    // The last DATA frame decrypted, under frames_mutex_. Kept so a busy
+    // connection reuses its capacity; trimIdle() frees it.
+    std::string plaintext_;
 
-    // Buffers
     static constexpr size_t BUFFER_SIZE = 8192;
-    std::vector<char> receive_buffer_;
-    std::string partial_message_;
+    // A peer that lets this much pile up unread is disconnected
+    static constexpr size_t MAX_QUEUED_BYTES = 4 * 1024 * 1024;
+    // What a peer may pipeline behind an unanswered AUTH: one largest frame
+    static constexpr size_t MAX_PENDING_AUTH_BYTES =
+        network::ProtocolHandler::HEADER_SIZE + network::ProtocolHandler::DEFAULT_MAX_FRAME_SIZE;
+    static constexpr size_t RECEIVE_POOL_CACHED_BLOCKS = 256;
 
-    // Logging
-    utils::Logger logger_;
+    // One pool per NUMA node: blocks are first touched, and later reused, by
+    // threads on the node that reads into them. With a huge page arena the
+    // blocks come from it instead, pre-faulted at startup.
+    static utils::MemoryPool& receiveBufferPool() {
+        static std::vector<std::unique_ptr<utils::MemoryPool>> pools = []() {
+            std::vector<std::unique_ptr<utils::MemoryPool>> per_node;
+            for (size_t node = 0; node < utils::CpuTopology::system().getNodeCount(); ++node) {
+                per_node.push_back(std::make_unique<utils::MemoryPool>(BUFFER_SIZE, RECEIVE_POOL_CACHED_BLOCKS,
+                                                                       utils::HugePageArena::buffers()));
+            }
+            return per_node;
+        }();
+        return *pools[utils::currentNumaNode()];
+    }
 
-    // Synchronization
-    mutable std::mutex send_mutex_;
-    std::atomic<bool> shutdown_requested_{false};
+    // Logging, one component logger shared by every connection
+    static utils::Logger& logger() {
+        static utils::Logger logger("ClientConnection");
+        return logger;
+    }
 };
 
 } // namespace securechat::core
\ No newline at end of file
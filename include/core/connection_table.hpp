@@ -0,0 +1,287 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace securechat::core {
+
+class ClientConnection;
+
+enum class ClientState : uint8_t {
+    CONNECTING,
+    AUTHENTICATING,
+    AUTHENTICATED,
+    DISCONNECTING,
+    DISCONNECTED
+};
+
+// Names one connection without owning it: a table slot plus the generation
+// the slot had when the handle was taken. Copying a handle touches no shared
+// state; once the connection is removed the generation moves on and the
+// handle resolves to nothing.
+struct ConnectionHandle {
+    uint32_t slot{~uint32_t{0}};
+    uint32_t generation{0};
+
+    explicit operator bool() const { return slot != ~uint32_t{0}; }
+    bool operator==(const ConnectionHandle& other) const = default;
+};
+
+// Dense, slot-indexed table of the server's connections. The scalars that
+// periodic sweeps and fan-out look at (state, room, last activity, send queue
+// depth, bytes in and out, retransmit window occupancy) live in parallel
+// column arrays rather than behind each
+// connection's shared_ptr, so cleanup, idle trimming and metrics are linear
+// scans over a few contiguous arrays: the state column of 10k connections
+// is 10 KB. Connection objects are referenced by slot and only touched for
+// the rows a sweep selects.
+//
+// Columns are atomics written by each connection through its Row, from any
+// thread. A Row remembers the generation its slot had when it was taken and
+// drops writes once the slot has moved on, so a removed connection cannot
+// write into the row of whichever connection is given the slot next.
+// Inserting, removing and looking up slots is not thread-safe; the owner
+// serializes those, and sweeps hold the same lock shared. resolve() is the
+// exception: tasks call it without the lock, inside a ReadGuard, to turn a
+// handle back into a connection when they run.
+//
+// remove() bumps the slot's generation, so outstanding handles and rows go
+// stale at once, and stamps the slot with the table's epoch. reclaim(),
+// which the owner calls from a periodic sweep and insert() calls when it
+// runs out of slots, frees the slot and drops the
+// table's reference to its connection only once every ReadGuard that was
+// open at removal has closed, however long that takes. A task that resolved
+// its handle just before removal therefore finishes against the old object,
+// which stays alive. The slot is also kept for as long as anyone else holds
+// the removed connection: a Row write that passed its generation check just
+// before remove() may still land, and it must land in a row nobody owns.
+class ConnectionTable {
+public:
+    using Slot = uint32_t;
+    using TimePoint = std::chrono::steady_clock::time_point;
+    static constexpr Slot INVALID_SLOT = ~Slot{0};
+
+    // A connection's handle on its own row
+    class Row {
+    public:
+        Row() = default;
+
+        explicit operator bool() const { return table_ != nullptr; }
+        Slot getSlot() const { return slot_; }
+        // False once the connection this row was taken for has been removed
+        bool isCurrent() const {
+            return table_ && table_->generation_[slot_].load(std::memory_order_acquire) == generation_;
+        }
+
+        void setState(ClientState state) const {
+            if (isCurrent()) {
+                table_->state_[slot_].store(state, std::memory_order_relaxed);
+            }
+        }
+        void setRoom(uint64_t room_id) const {
+            if (isCurrent()) {
+                table_->room_[slot_].store(room_id, std::memory_order_relaxed);
+            }
+        }
+        void touch(TimePoint now) const {
+            if (isCurrent()) {
+                table_->last_activity_[slot_].store(now.time_since_epoch().count(), std::memory_order_relaxed);
+            }
+        }
+        void setQueueDepth(uint32_t depth) const {
+            if (isCurrent()) {
+                table_->queue_depth_[slot_].store(depth, std::memory_order_relaxed);
+            }
+        }
+        void addBytesIn(uint64_t bytes) const {
+            if (isCurrent()) {
+                table_->bytes_in_[slot_].fetch_add(bytes, std::memory_order_relaxed);
+            }
+        }
+        void addBytesOut(uint64_t bytes) const {
+            if (isCurrent()) {
+                table_->bytes_out_[slot_].fetch_add(bytes, std::memory_order_relaxed);
+            }
+        }
+        void setRetransmitWindow(uint32_t messages, uint64_t bytes) const {
+            if (isCurrent()) {
+                table_->unacked_messages_[slot_].store(messages, std::memory_order_relaxed);
+                table_->unacked_bytes_[slot_].store(bytes, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        friend class ConnectionTable;
+        Row(ConnectionTable* table, Slot slot, uint32_t generation)
+            : table_(table), slot_(slot), generation_(generation) {}
+
+        ConnectionTable* table_{nullptr};
+        Slot slot_{INVALID_SLOT};
+        uint32_t generation_{0};
+    };
+
+    // Pins the connections resolve() returns for as long as it is open.
+    // Opening one announces the current epoch in a reader slot; reclaim()
+    // keeps every slot removed at or after the oldest announced epoch. With
+    // more than READER_SLOTS guards open at once, the next one waits for a
+    // reader slot to free up.
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const ConnectionTable& table);
+        ~ReadGuard() { reader_->store(IDLE_EPOCH, std::memory_order_release); }
+
+        // Non-copyable, non-movable
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard(ReadGuard&&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+    private:
+        std::atomic<uint64_t>* reader_{nullptr};
+    };
+
+    static constexpr size_t READER_SLOTS = 128;
+
+    explicit ConnectionTable(size_t capacity);
+
+    // Non-copyable, non-movable
+    ConnectionTable(const ConnectionTable&) = delete;
+    ConnectionTable& operator=(const ConnectionTable&) = delete;
+    ConnectionTable(ConnectionTable&&) = delete;
+    ConnectionTable& operator=(ConnectionTable&&) = delete;
+
+    // Returns INVALID_SLOT when the table is full, even after reclaiming,
+    // or the id is present
+    Slot insert(uint64_t client_id, std::shared_ptr<ClientConnection> connection, ClientState state,
+                TimePoint now);
+    // Returns the connection that held the slot, or null
+    std::shared_ptr<ClientConnection> remove(Slot slot);
+    // Frees removed slots for insert() and drops the table's reference to
+    // their connections, once no ReadGuard open at removal remains and no
+    // one else holds the connection; other slots wait for a later reclaim()
+    void reclaim();
+    // Drops every connection at once; no ReadGuard may be open
+    void clear();
+
+    Slot find(uint64_t client_id) const;
+    // Bound to the slot's current occupant; take it right after insert()
+    Row row(Slot slot) { return Row(this, slot, generation_[slot].load(std::memory_order_relaxed)); }
+    ConnectionHandle handle(Slot slot) const {
+        return {slot, generation_[slot].load(std::memory_order_relaxed)};
+    }
+    // Thread-safe. Null once the handle's connection has been removed;
+    // otherwise the connection stays alive until the guard closes.
+    ClientConnection* resolve(ConnectionHandle handle, const ReadGuard&) const {
+        if (handle.slot >= capacity_) {
+            return nullptr;
+        }
+        // Seqlock-style read: the object is only trusted if the generation
+        // matched both before and after loading it
+        if (generation_[handle.slot].load(std::memory_order_acquire) != handle.generation) {
+            return nullptr;
+        }
+        ClientConnection* connection = objects_[handle.slot].load(std::memory_order_acquire);
+        if (generation_[handle.slot].load(std::memory_order_relaxed) != handle.generation) {
+            return nullptr;
+        }
+        return connection;
+    }
+    const std::shared_ptr<ClientConnection>& get(Slot slot) const { return connections_[slot]; }
+    uint64_t getClientId(Slot slot) const { return client_ids_[slot]; }
+
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return capacity_; }
+
+    // Column reads
+    ClientState getState(Slot slot) const { return state_[slot].load(std::memory_order_relaxed); }
+    uint64_t getRoom(Slot slot) const { return room_[slot].load(std::memory_order_relaxed); }
+    TimePoint getLastActivity(Slot slot) const {
+        return TimePoint(TimePoint::duration(last_activity_[slot].load(std::memory_order_relaxed)));
+    }
+    uint32_t getQueueDepth(Slot slot) const { return queue_depth_[slot].load(std::memory_order_relaxed); }
+    uint64_t getBytesIn(Slot slot) const { return bytes_in_[slot].load(std::memory_order_relaxed); }
+    uint64_t getBytesOut(Slot slot) const { return bytes_out_[slot].load(std::memory_order_relaxed); }
+    uint32_t getUnackedMessages(Slot slot) const { return unacked_messages_[slot].load(std::memory_order_relaxed); }
+    uint64_t getUnackedBytes(Slot slot) const { return unacked_bytes_[slot].load(std::memory_order_relaxed); }
+
+    // Sweeps. Each scans its columns up to the highest slot ever used.
+    template<typename F>
+    void forEach(F&& fn) const {
+        for (Slot slot = 0; slot < high_water_; ++slot) {
+            if (live_[slot]) {
+                fn(slot, connections_[slot]);
+            }
+        }
+    }
+    // Live slots whose state is DISCONNECTING or DISCONNECTED
+    std::vector<Slot> collectDisconnected() const;
+    // Live slots with no activity since cutoff
+    std::vector<Slot> collectIdleSince(TimePoint cutoff) const;
+
+    struct Totals {
+        size_t connections{0};
+        size_t authenticated{0};
+        uint64_t queue_depth{0};
+        uint32_t max_queue_depth{0};
+        uint64_t bytes_in{0};
+        uint64_t bytes_out{0};
+        uint64_t unacked_messages{0};
+        uint32_t max_unacked_messages{0};
+        uint64_t unacked_bytes{0};
+    };
+    Totals sumColumns() const;
+
+private:
+    const size_t capacity_;
+
+    // Hot scalar columns, indexed by slot
+    std::unique_ptr<std::atomic<ClientState>[]> state_;
+    std::unique_ptr<std::atomic<uint64_t>[]> room_;
+    std::unique_ptr<std::atomic<int64_t>[]> last_activity_;
+    std::unique_ptr<std::atomic<uint32_t>[]> queue_depth_;
+    std::unique_ptr<std::atomic<uint64_t>[]> bytes_in_;
+    std::unique_ptr<std::atomic<uint64_t>[]> bytes_out_;
+    std::unique_ptr<std::atomic<uint32_t>[]> unacked_messages_;
+    std::unique_ptr<std::atomic<uint64_t>[]> unacked_bytes_;
+
+    // Handle resolution: bumped on remove(), and the object each live
+    // generation names
+    std::unique_ptr<std::atomic<uint32_t>[]> generation_;
+    std::unique_ptr<std::atomic<ClientConnection*>[]> objects_;
+
+    // Reclamation epochs. remove() stamps a slot with epoch_ and advances
+    // it; each open ReadGuard announces the epoch it started in, one reader
+    // per cache line. IDLE_EPOCH marks a free reader slot.
+    static constexpr uint64_t IDLE_EPOCH = 0;
+    struct alignas(64) Reader {
+        std::atomic<uint64_t> epoch{IDLE_EPOCH};
+    };
+    std::atomic<uint64_t> epoch_{IDLE_EPOCH + 1};
+    std::unique_ptr<Reader[]> readers_;
+    uint64_t oldestReaderEpoch() const;
+
+    // Which rows hold a connection, so scans skip removed rows without
+    // touching the connection column
+    std::vector<uint8_t> live_;
+
+    // Cold columns
+    std::vector<uint64_t> client_ids_;
+    std::vector<std::shared_ptr<ClientConnection>> connections_;
+
+    std::unordered_map<uint64_t, Slot> index_;
+    std::vector<Slot> free_slots_;
+    // Removed and not yet freed, with the epoch of their removal
+    struct Retired {
+        Slot slot;
+        uint64_t epoch;
+    };
+    std::vector<Retired> retired_;
+    Slot high_water_{0};
+};
+
+} // namespace securechat::core
@@ -2,20 +2,29 @@
 
 #include <memory>
 #include <atomic>
-#include <thread>
+#include <chrono>
 #include <functional>
 #include <vector>
-#include <mutex>
-#include <condition_variable>
 
 #include "network/async_io.hpp"
 #include "utils/logger.hpp"
+#include "utils/mpsc_queue.hpp"
 
 namespace securechat::core {
 
+// Task and timer loop driven by the AsyncIO reactor. Tasks from any thread go
+// onto a lock-free MPSC queue and wake the loop through an eventfd watched in
+// the reactor's own epoll set, next to the client sockets, so there is one
+// wait mechanism; a timerfd, also watched there, covers the nearest timer.
+// Tasks run on whichever reactor thread takes the eventfd, one batch at a
+// time and never two at once, like any socket handler. Wake-ups are
+// coalesced: only the first post after a batch announces it is done writes
+// the eventfd. Delayed and periodic tasks travel through the same queue and
+// are then kept in a heap only the running batch touches, so no lock is
+// shared with producers.
 class EventLoop {
 public:
-    EventLoop();
+    explicit EventLoop(network::AsyncIOConfig io_config = {});
     ~EventLoop();
 
     // Non-copyable, non-movable
@@ -26,26 +35,36 @@ public:
 
     bool initialize();
     void start();
+    // Safe from a task: the reactor threads are then joined later, by the
+    // destructor
     void stop();
 
-    // Event scheduling
+    // Event scheduling; safe from any thread, including from a task
     void scheduleTask(std::function<void()> task);
     void scheduleDelayedTask(std::function<void()> task, std::chrono::milliseconds delay);
     void schedulePeriodicTask(std::function<void()> task, std::chrono::milliseconds interval);
 
+    network::AsyncIO& getAsyncIO() { return *async_io_; }
+
     // Statistics
     uint64_t getProcessedEvents() const { return processed_events_.load(); }
+    // eventfd writes; far fewer than posted tasks under bursty load
+    uint64_t getWakeups() const { return wakeups_.load(); }
     bool isRunning() const { return running_.load(); }
 
 private:
-    void eventLoopThread();
-    void processScheduledTasks();
+    // eventfd handler: runs one batch, then announces it is done
+    void runBatch();
+    size_t processPostedTasks();
+    size_t processScheduledTasks();
+    // Points the timerfd at the nearest timer, or disarms it
+    void armTimer();
+    void wake();
 
     std::unique_ptr<network::AsyncIO> async_io_;
     
     std::atomic<bool> running_{false};
     std::atomic<bool> stop_requested_{false};
-    std::thread event_thread_;
     
     // Task scheduling
     struct ScheduledTask {
@@ -54,13 +73,27 @@ private:
         std::chrono::milliseconds interval{0}; // 0 for one-time tasks
         bool periodic{false};
     };
+
+    void post(ScheduledTask task);
     
+    // Posted by any thread, drained in one batch per iteration. A batch
+    // takes up to MAX_POSTED_ROUNDS snapshots, so tasks posted while it
+    // runs do not each cost another wake-up.
+    utils::MpscQueue<ScheduledTask> posted_tasks_;
+    static constexpr size_t MAX_POSTED_ROUNDS = 4;
+    // Timer heap ordered by execute_time; running batch only
     std::vector<ScheduledTask> scheduled_tasks_;
-    std::mutex tasks_mutex_;
-    std::condition_variable tasks_cv_;
+    bool timer_armed_{false};
+
+    // Wake-up channel. wake_pending_ is true while a batch runs or a wake-up
+    // is already in flight, so producers skip the write.
+    int wake_fd_{-1};
+    int timer_fd_{-1};
+    std::atomic<bool> wake_pending_{true};
     
     // Statistics
     std::atomic<uint64_t> processed_events_{0};
+    std::atomic<uint64_t> wakeups_{0};
     
     // Logging
     utils::Logger logger_;
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "utils/cpu_topology.hpp"
+#include "utils/logger.hpp"
+
+namespace securechat::core {
+
+struct ExecutorConfig {
+    std::string name{"executor"};
+    size_t min_threads{1};
+    size_t max_threads{4};
+    // Grow while queued tasks wait longer than this before starting
+    std::chrono::microseconds target_queue_delay{1000};
+    // Threads above min_threads exit after idling this long
+    std::chrono::milliseconds idle_timeout{5000};
+    // Workers pin themselves here when non-empty
+    utils::CpuSet cpus;
+    // No threads at all: submit() runs each task on the calling thread.
+    // Single-threaded simulations use this to stay reproducible.
+    bool run_inline{false};
+};
+
+// Thread pool that sizes itself between min_threads and max_threads from
+// queue delay rather than queue length: a long queue of short tasks that
+// start promptly needs no more threads, while a few tasks stuck behind slow
+// ones do. A thread is added at most once per target_queue_delay, when the
+// smoothed delay exceeds the target and no worker is idle.
+//
+// The server runs one executor for CPU-bound work (crypto, sends) and a
+// separate one for blocking work (disk, database), so a stalled blocking
+// call never holds a thread that latency-sensitive tasks wait for.
+class Executor {
+public:
+    explicit Executor(ExecutorConfig config);
+    ~Executor();
+
+    // Non-copyable, non-movable
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+    Executor(Executor&&) = delete;
+    Executor& operator=(Executor&&) = delete;
+
+    // Returns false once stopped
+    bool submit(std::function<void()> task);
+    // Runs the tasks already queued, then joins every worker
+    void stop();
+
+    const std::string& getName() const { return config_.name; }
+
+    // Statistics
+    size_t getThreadCount() const { return thread_count_.load(std::memory_order_relaxed); }
+    size_t getQueueSize() const;
+    uint64_t getTasksCompleted() const { return tasks_completed_.load(std::memory_order_relaxed); }
+    // Smoothed time from submit() to a task starting
+    std::chrono::microseconds getQueueDelay() const {
+        return std::chrono::microseconds(queue_delay_us_.load(std::memory_order_relaxed));
+    }
+    // Share of worker time spent running tasks since the previous call, 0..1
+    double sampleUtilization();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct QueuedTask {
+        std::function<void()> task;
+        Clock::time_point enqueued;
+    };
+
+    struct Worker {
+        std::thread thread;
+        bool finished{false};
+    };
+
+    void workerLoop(Worker* self);
+    // Runs one task outside mutex_ and records its statistics
+    void runTask(QueuedTask& queued);
+    // Caller holds mutex_
+    void growLocked(Clock::time_point now);
+    void recordDelay(Clock::duration delay);
+
+    const ExecutorConfig config_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<QueuedTask> queue_;
+    std::list<Worker> workers_;
+    size_t idle_workers_{0};
+    bool stopping_{false};
+    Clock::time_point last_growth_;
+
+    // Statistics
+    std::atomic<size_t> thread_count_{0};
+    std::atomic<uint64_t> tasks_completed_{0};
+    std::atomic<int64_t> queue_delay_us_{0};
+    std::atomic<int64_t> busy_ns_{0};
+    Clock::time_point last_sample_;
+    int64_t last_busy_ns_{0};
+
+    // Logging
+    utils::Logger logger_;
+};
+
+} // namespace securechat::core
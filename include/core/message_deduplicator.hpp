@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "utils/config_manager.hpp"
+
+namespace securechat::core {
+
+// Opt-out (security.deduplication). capacity is the number of distinct
+// message ids remembered per window across all senders: the peak message
+// rate times the window.
+struct DeduplicationConfig {
+    bool enabled{true};
+    std::chrono::seconds window{60};
+    size_t capacity{65536};
+
+    static DeduplicationConfig fromConfig(const utils::ConfigManager& config);
+};
+
+// Remembers which (sender, client-supplied message id) pairs were seen
+// recently, so a client that retries after a lost ack does not deliver the
+// same chat message twice. The sender key must outlive a connection, e.g.
+// a hash of the authenticated user, since retries follow reconnects. Pairs are reduced to 64-bit fingerprints in
+// fixed-size open-addressed tables, kept at most half full so a check is a
+// short linear probe and never allocates.
+//
+// Expiry is by generation rather than per entry: each stripe has a current
+// and a previous table, and once a window has passed the previous one is
+// cleared and the two swap. An id is therefore remembered for between one
+// and two windows. A stripe whose current table fills up rotates early;
+// getEarlyRotations() counting up means capacity is below the real rate and
+// the effective window has shrunk.
+//
+// Thread-safe; fingerprints are spread over independently locked stripes.
+class MessageDeduplicator {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    static constexpr size_t STRIPES = 16;
+    static constexpr std::string_view MESSAGE_ID_FIELD = "messageId";
+    static constexpr size_t MAX_MESSAGE_ID_LENGTH = 128;
+
+    explicit MessageDeduplicator(const DeduplicationConfig& config = {});
+    ~MessageDeduplicator() = default;
+
+    // Non-copyable, non-movable
+    MessageDeduplicator(const MessageDeduplicator&) = delete;
+    MessageDeduplicator& operator=(const MessageDeduplicator&) = delete;
+    MessageDeduplicator(MessageDeduplicator&&) = delete;
+    MessageDeduplicator& operator=(MessageDeduplicator&&) = delete;
+
+    // Returns true if the sender already used message_id within the window;
+    // otherwise records it and returns false
+    bool checkAndRecord(uint64_t sender_key, std::string_view message_id, TimePoint now);
+
+    // The string value of the first "messageId" member of a JSON message, or
+    // empty when there is none, it contains escapes or it is too long
+    static std::string_view extractMessageId(std::string_view message);
+
+    // Statistics
+    uint64_t getDuplicates() const { return duplicates_.load(std::memory_order_relaxed); }
+    uint64_t getEarlyRotations() const { return early_rotations_.load(std::memory_order_relaxed); }
+    size_t getMemoryUsage() const { return STRIPES * 2 * (mask_ + 1) * sizeof(uint64_t); }
+
+private:
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        int64_t rotated_at{0};
+        size_t current_size{0};
+        std::unique_ptr<uint64_t[]> current;
+        std::unique_ptr<uint64_t[]> previous;
+    };
+
+    static bool contains(const uint64_t* table, size_t mask, uint64_t fingerprint);
+    void rotate(Stripe& stripe, int64_t now_ticks);
+
+    const int64_t window_ticks_;
+    // Ids per stripe generation before it rotates early
+    size_t stripe_capacity_;
+    size_t mask_;
+    std::unique_ptr<Stripe[]> stripes_;
+
+    // Statistics
+    std::atomic<uint64_t> duplicates_{0};
+    std::atomic<uint64_t> early_rotations_{0};
+};
+
+} // namespace securechat::core
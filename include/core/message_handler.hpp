@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "network/protocol_handler.hpp"
+#include "security/rate_limiter.hpp"
+
+namespace securechat::core {
+
+class ClientConnection;
+
+// What a ClientConnection hands up to its server once a frame is decoded.
+// Calls come from whichever thread drains the connection, one at a time per
+// connection.
+class MessageHandler {
+public:
+    virtual ~MessageHandler() = default;
+
+    // AUTH frame; `secret` is the token the client presented
+    virtual network::AuthStatus authenticate(ClientConnection& client, std::string_view username,
+                                             std::string_view secret) = 0;
+    // The connection's entry point for AUTH: checks the credentials, on
+    // another thread if the handler likes, and calls done exactly once with
+    // the result, keeping the connection alive until then. Frames that
+    // arrive meanwhile wait for it. The default checks them inline.
+    virtual void authenticateAsync(ClientConnection& client, std::string username, std::string secret,
+                                   std::function<void(network::AuthStatus)> done) {
+        done(authenticate(client, username, secret));
+    }
+    // JOIN_ROOM frame from an authenticated client
+    virtual void onJoinRoom(ClientConnection& client, uint64_t room_id) = 0;
+    // Decrypted DATA frame from an authenticated client
+    virtual void onMessage(ClientConnection& client, const std::string& plaintext) = 0;
+    // RESUME frame from an authenticated client: `token` names its previous
+    // session, which received every record up to `acknowledged`
+    virtual void onResume(ClientConnection& client, std::string_view token, uint64_t acknowledged) = 0;
+    // The connection went away, from either side; called once
+    virtual void onDisconnect(ClientConnection& client) = 0;
+
+    // Message rate limit for each connection
+    virtual security::RateLimitConfig getRateLimit() const = 0;
+};
+
+} // namespace securechat::core
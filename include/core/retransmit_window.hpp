@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/message_buffer.hpp"
+
+namespace securechat::core {
+
+// Outbound chat messages a connection has sent but the peer has not yet
+// acknowledged, for at-least-once delivery. Entries hold the shared
+// plaintext MessageBuffer, not the sealed record: replaying after a resume
+// re-encrypts under the new session's keys and sequence numbers, and
+// keeping a message costs one reference, not a copy.
+//
+// A fixed ring of `capacity` entries, allocated by the first push and freed
+// again by releaseIfEmpty(), so an idle connection holds no ring; in
+// between, pushes and acks never allocate.
+// Acks are cumulative over the record sequence numbers the entries were
+// sent under. A full window means the peer is acknowledging slowly or not
+// at all; push() then drops the oldest entry, which can no longer be
+// replayed, rather than failing the send.
+//
+// Thread-safe. Sequences should be pushed in increasing order (under the
+// send lock); an entry pushed out of order is still kept until an ack
+// covers it, but it is only trimmed once the entries ahead of it are.
+class RetransmitWindow {
+public:
+    explicit RetransmitWindow(size_t capacity);
+    ~RetransmitWindow() = default;
+
+    // Non-copyable, non-movable
+    RetransmitWindow(const RetransmitWindow&) = delete;
+    RetransmitWindow& operator=(const RetransmitWindow&) = delete;
+    RetransmitWindow(RetransmitWindow&&) = delete;
+    RetransmitWindow& operator=(RetransmitWindow&&) = delete;
+
+    // Returns false when the window was full and its oldest entry was
+    // dropped to make room
+    bool push(uint64_t sequence, utils::MessageBuffer message);
+    // Drops every message up to and including sequence; returns how many
+    size_t acknowledge(uint64_t sequence);
+    // Empties the window, returning the messages sent after `acknowledged`
+    // oldest first, for replay on a new connection
+    std::vector<utils::MessageBuffer> drainAfter(uint64_t acknowledged);
+
+    // Frees the ring if nothing is waiting for an ack; returns true if it did
+    bool releaseIfEmpty();
+
+    size_t size() const;
+    size_t capacity() const { return capacity_; }
+    // Statistics
+    size_t getBytes() const;
+    // This object, its ring if allocated, and the bytes of the messages held
+    size_t getResidentBytes() const;
+    uint64_t getAcknowledged() const;
+    uint64_t getOverflows() const;
+
+private:
+    struct Entry {
+        uint64_t sequence{0};
+        utils::MessageBuffer message;
+    };
+
+    void popFront();
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+    size_t head_{0};
+    size_t size_{0};
+    size_t bytes_{0};
+    uint64_t acknowledged_{0};
+    uint64_t overflows_{0};
+};
+
+// Windows of connections that dropped with messages still unacknowledged,
+// held for resume_timeout under the session's resume token together with
+// the user the session was authenticated as. A client that reconnects sends
+// RESUME with that token and the last sequence it received; the server
+// claims the window for the user the new connection is authenticated as
+// and replays the rest through it. The token alone claims nothing: a claim
+// for another user fails and leaves the window parked for its owner.
+// Windows not claimed in time are dropped by expire().
+//
+// Thread-safe.
+class ResumableWindows {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    explicit ResumableWindows(std::chrono::seconds resume_timeout);
+
+    // Non-copyable, non-movable
+    ResumableWindows(const ResumableWindows&) = delete;
+    ResumableWindows& operator=(const ResumableWindows&) = delete;
+    ResumableWindows(ResumableWindows&&) = delete;
+    ResumableWindows& operator=(ResumableWindows&&) = delete;
+
+    // Replaces any window already parked under the token
+    void park(const std::string& token, const std::string& user_id, std::shared_ptr<RetransmitWindow> window,
+              TimePoint now);
+    // Removes and returns the token's window, or null if there is none, it
+    // expired or it belongs to another user
+    std::shared_ptr<RetransmitWindow> claim(const std::string& token, const std::string& user_id, TimePoint now);
+    // Returns the number of windows dropped
+    size_t expire(TimePoint now);
+
+    // Statistics
+    size_t size() const;
+    size_t getBytes() const;
+
+private:
+    struct Parked {
+        std::shared_ptr<RetransmitWindow> window;
+        std::string user_id;
+        TimePoint expires;
+    };
+
+    const std::chrono::seconds resume_timeout_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Parked> windows_;
+};
+
+} // namespace securechat::core
@@ -1,28 +1,50 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <atomic>
 #include <vector>
 #include <unordered_map>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
 #include <condition_variable>
+#include <future>
+#include <optional>
+#include <string_view>
 
 #include "core/client_connection.hpp"
-#include "core/thread_pool.hpp"
+#include "core/connection_table.hpp"
+#include "core/executor.hpp"
+#include "core/message_handler.hpp"
+#include "core/message_deduplicator.hpp"
+#include "core/retransmit_window.hpp"
 #include "core/event_loop.hpp"
+#include "core/shard.hpp"
+#include "network/busy_poll.hpp"
 #include "network/socket_manager.hpp"
+#include "network/transport.hpp"
+#include "plugins/content_filter.hpp"
+#include "plugins/spam_detector.hpp"
+#include "plugins/plugin_manager.hpp"
 #include "security/auth_manager.hpp"
+#include "utils/clock.hpp"
 #include "utils/config_manager.hpp"
+#include "utils/cpu_topology.hpp"
+#include "utils/huge_page_arena.hpp"
 #include "utils/logger.hpp"
+#include "utils/memory_pool.hpp"
+#include "utils/message_buffer.hpp"
 #include "utils/metrics_collector.hpp"
 
 namespace securechat::core {
 
-class Server {
+// Each connection hands its decoded frames back to the server through the
+// MessageHandler interface
+class Server : private MessageHandler {
 public:
-    explicit Server(const utils::ConfigManager& config);
-    ~Server();
+    explicit Server(const utils::ConfigManager& config, const utils::Clock& clock = utils::Clock::system());
+    ~Server() override;
 
     // Non-copyable, non-movable
     Server(const Server&) = delete;
@@ -35,39 +57,151 @@ public:
     void stop();
     void shutdown();
 
-    // Client management
-    void addClient(std::shared_ptr<ClientConnection> client);
+    // Client management. addClient() fails once max_connections are held.
+    bool addClient(std::shared_ptr<ClientConnection> client);
     void removeClient(uint64_t client_id);
     std::shared_ptr<ClientConnection> getClient(uint64_t client_id);
-
-    // Message broadcasting
-    void broadcastMessage(const std::string& message, uint64_t sender_id = 0);
-    void sendToClient(uint64_t client_id, const std::string& message);
+    // Entry point for every new connection; simulations hand in MemoryTransports directly
+    void acceptTransport(std::unique_ptr<network::Transport> transport);
+
+    // Rooms. Connections start in the lobby and move with JOIN_ROOM; only
+    // the server can address ALL_ROOMS.
+    static constexpr uint64_t LOBBY_ROOM = 0;
+    static constexpr uint64_t ALL_ROOMS = ~uint64_t{0};
+
+    // Message broadcasting to the members of room_id other than the sender.
+    // A sender's retries (same message id) are dropped before anything else
+    // looks at the message. sender_user is userKey() of the sending
+    // connection, which retries and spam windows are matched on; 0 for the
+    // server's own messages, which are never deduplicated or spam checked.
+    void broadcastMessage(const std::string& message, uint64_t sender_id = 0, uint64_t room_id = ALL_ROOMS,
+                          uint64_t sender_user = 0);
+    void sendToClient(uint64_t client_id, const std::string& message, uint64_t sender_id = 0,
+                      uint64_t sender_user = 0);
+    // Identifies the authenticated user behind a connection across its
+    // reconnects; 0 before authentication
+    static uint64_t userKey(const ClientConnection& client);
+
+    // At-least-once delivery. Called for a RESUME frame on the client's new
+    // connection: replays the messages the session identified by `token`
+    // sent after `acknowledged` and never saw acked. Returns how many; none
+    // unless `client` is authenticated as the user that session belonged to.
+    size_t resumeSession(ClientConnection& client, const std::string& token, uint64_t acknowledged);
+
+    // Plugins. The word lists are read on the blocking executor; the
+    // future holds whether they all loaded.
+    std::future<bool> reloadPlugins();
+
+    // Executors: CPU-bound work (crypto, sends) and blocking work (disk,
+    // database) never share threads
+    Executor& getCpuExecutor() { return *cpu_executor_; }
+    Executor& getBlockingExecutor() { return *blocking_executor_; }
 
     // Statistics
     size_t getConnectedClientsCount() const;
+    // Bytes held by every connection, from getResidentBytes(). Sharded
+    // connections report as of their shard's last idle sweep.
+    size_t getConnectionMemoryBytes() const;
     utils::ServerStats getStats() const;
 
 private:
+    // MessageHandler
+    network::AuthStatus authenticate(ClientConnection& client, std::string_view username,
+                                     std::string_view secret) override;
+    void authenticateAsync(ClientConnection& client, std::string username, std::string secret,
+                           std::function<void(network::AuthStatus)> done) override;
+    void onJoinRoom(ClientConnection& client, uint64_t room_id) override;
+    void onMessage(ClientConnection& client, const std::string& plaintext) override;
+    void onResume(ClientConnection& client, std::string_view token, uint64_t acknowledged) override;
+    void onDisconnect(ClientConnection& client) override;
+    security::RateLimitConfig getRateLimit() const override;
+
     void acceptConnections();
     void handleClientConnection(int client_socket);
     void cleanupDisconnectedClients();
+    void trimIdleClients();
+    struct ShardState;
+    void startShardedClient(Shard& shard, std::shared_ptr<ClientConnection> client);
+    void removeShardedClient(Shard& shard, uint64_t client_id);
+    void sweepShard(Shard& shard, std::chrono::steady_clock::time_point now, std::chrono::seconds idle_after);
+    // The calling shard's state, or null off the shard threads
+    ShardState* currentShardState() const;
     void updateMetrics();
+    // Sleeps for interval; false once the server is stopping
+    bool waitForBackgroundRun(std::chrono::seconds interval);
+    // The message path proper, on the sender's shard when there are shards
+    void routeBroadcast(std::string_view message, uint64_t sender_id, uint64_t sender_user, uint64_t room_id);
+    void routeToClient(uint64_t client_id, std::string_view message, uint64_t sender_id, uint64_t sender_user);
+    // The bytes to deliver, which view message or rewritten; nullopt drops
+    // the message
+    std::optional<std::string_view> filterMessage(std::string_view message, uint64_t sender_id,
+                                                  uint64_t recipient_id, uint64_t room_id, std::string& rewritten);
+    bool isDuplicate(uint64_t sender_id, uint64_t sender_user, std::string_view message);
+    bool isSpam(uint64_t sender_id, uint64_t sender_user, uint64_t room_id, std::string_view message);
+    void parkRetransmitWindow(const ClientConnection& client);
+
+    // One send task's recipients and the payload they share
+    static constexpr size_t FANOUT_BATCH = 64;
+    struct FanoutBatch {
+        utils::MessageBuffer payload;
+        size_t size{0};
+        std::array<ConnectionHandle, FANOUT_BATCH> recipients;
+    };
+    // Runs the batch on the CPU executor and returns it to its pool
+    void submitFanout(FanoutBatch* batch);
 
     // Configuration
     const utils::ConfigManager& config_;
+    const utils::Clock& clock_;
+    utils::ThreadPlacement placement_;
+    network::BusyPollConfig busy_poll_;
     
+    // Send tasks capture a pointer to a batch from this pool, which
+    // std::function stores inline, so fan-out allocates nothing. Declared
+    // before the executors, which may still hold tasks.
+    static constexpr size_t FANOUT_POOL_CACHED_BLOCKS = 1024;
+    utils::MemoryPool fanout_batches_{sizeof(FanoutBatch), FANOUT_POOL_CACHED_BLOCKS};
+
     // Core components
     std::unique_ptr<network::SocketManager> socket_manager_;
-    std::unique_ptr<ThreadPool> thread_pool_;
+    std::unique_ptr<Executor> cpu_executor_;
+    std::unique_ptr<Executor> blocking_executor_;
     std::unique_ptr<EventLoop> event_loop_;
     std::unique_ptr<security::AuthManager> auth_manager_;
     std::unique_ptr<utils::MetricsCollector> metrics_;
-
-    // Client management
+    std::unique_ptr<plugins::ContentFilter> content_filter_;
+    std::unique_ptr<MessageDeduplicator> deduplicator_;
+    std::unique_ptr<plugins::SpamDetector> spam_detector_;
+    std::unique_ptr<plugins::PluginManager> plugin_manager_;
+
+    // Shared-nothing mode. Everything a shard's message path touches is its
+    // own and written only from its thread: the connections it owns, its
+    // counters; only the dedup table and spam windows are shared. The table
+    // mutex orders the shard's inserts and removals against sweeps from
+    // other threads; the shard's own lookups take no lock.
+    struct ShardState {
+        explicit ShardState(size_t capacity) : table(capacity) {}
+
+        mutable std::shared_mutex table_mutex;
+        ConnectionTable table;
+        // Written by the shard, read by statistics
+        std::atomic<uint64_t> messages_received{0};
+        // As of the shard's last idle sweep
+        std::atomic<size_t> memory_bytes{0};
+    };
+    // Outlives the runtime, whose threads deliver from it until joined
+    std::vector<std::unique_ptr<ShardState>> shard_state_;
+    std::unique_ptr<ShardedRuntime> shards_;
+
+    // Client management. The mutex serializes inserts and removals in the
+    // table; sweeps and lookups hold it shared. Unused in shared-nothing mode.
     mutable std::shared_mutex clients_mutex_;
-    std::unordered_map<uint64_t, std::shared_ptr<ClientConnection>> clients_;
+    ConnectionTable connection_table_;
     std::atomic<uint64_t> next_client_id_{1};
+    // Retransmit windows of dropped sessions awaiting RESUME; null when
+    // at-least-once delivery is off
+    std::unique_ptr<ResumableWindows> resumable_windows_;
+    size_t retransmit_window_size_{0};
 
     // Server state
     std::atomic<bool> running_{false};
@@ -77,6 +211,9 @@ private:
     std::thread accept_thread_;
     std::thread cleanup_thread_;
     std::thread metrics_thread_;
+    // Background threads sleep on this between runs so stop() wakes them
+    std::mutex background_mutex_;
+    std::condition_variable background_wakeup_;
 
     // Logging
     utils::Logger logger_;
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "network/busy_poll.hpp"
+#include "utils/clock.hpp"
+#include "utils/cpu_topology.hpp"
+#include "utils/logger.hpp"
+#include "utils/message_buffer.hpp"
+#include "utils/spsc_queue.hpp"
+
+namespace securechat::core {
+
+class ShardedRuntime;
+
+// Cross-shard traffic. Room interest notices tell other shards whether this
+// shard has local members of a room, so publishers forward only where needed.
+// DIRECT carries a message for one client on the receiving shard.
+struct ShardMessage {
+    enum class Kind : uint8_t {
+        DELIVER,
+        ROOM_JOINED,
+        ROOM_LEFT,
+        DIRECT
+    };
+
+    Kind kind{Kind::DELIVER};
+    uint64_t room_id{0};
+    uint64_t sender_id{0};
+    // Shared with every other shard the message is forwarded to
+    utils::MessageBuffer payload;
+    // DIRECT only
+    uint64_t client_id{0};
+};
+
+// One core's share of the server in shared-nothing mode. A shard owns a
+// disjoint set of connections, the local member lists of their rooms, its
+// timers and its readiness poller, all touched only from its own thread.
+// Other shards reach it through per-pair SPSC queues drained in batches, so
+// routing a message never takes a lock or writes memory another shard reads,
+// apart from the queue indices themselves.
+//
+// Unless noted, methods must be called on the shard's thread, e.g. from a
+// task passed to ShardedRuntime::post() or from a watch callback.
+class Shard {
+public:
+    using DeliverFn = std::function<void(Shard& shard, uint64_t client_id, uint64_t sender_id,
+                                         const utils::MessageBuffer& message)>;
+
+    ~Shard();
+
+    // Non-copyable, non-movable
+    Shard(const Shard&) = delete;
+    Shard& operator=(const Shard&) = delete;
+    Shard(Shard&&) = delete;
+    Shard& operator=(Shard&&) = delete;
+
+    // The shard running on the calling thread, or nullptr
+    static Shard* current();
+    size_t getIndex() const { return index_; }
+
+    // Rooms. A join becomes visible to publishers on other shards once the
+    // interest notice has been drained there.
+    void join(uint64_t client_id, uint64_t room_id);
+    void leave(uint64_t client_id, uint64_t room_id);
+    // Delivers to local members other than the sender and forwards one copy
+    // to every other shard with members in the room
+    void publish(uint64_t room_id, uint64_t sender_id, const utils::MessageBuffer& message);
+    // Delivers to one client, here if this shard owns it and otherwise over
+    // the queue to the shard that does
+    void sendTo(uint64_t client_id, uint64_t sender_id, const utils::MessageBuffer& message);
+
+    // Timers, advanced to the steady clock on every loop iteration
+    utils::SimulatedClock& timers() { return timers_; }
+
+    // Readiness for sockets owned by this shard (Linux). Callbacks run on the
+    // shard thread; watching an fd again replaces its callback.
+    bool watch(int fd, std::function<void()> on_readable);
+    void unwatch(int fd);
+
+    // Busy polling: spin for an adaptive interval before blocking
+    void setBusyPoll(const network::BusyPollConfig& config);
+
+    // Statistics, readable from any thread
+    uint64_t getLocalDeliveries() const { return local_deliveries_.load(std::memory_order_relaxed); }
+    uint64_t getForwarded() const { return forwarded_.load(std::memory_order_relaxed); }
+    uint64_t getBatchesDrained() const { return batches_drained_.load(std::memory_order_relaxed); }
+    uint64_t getBackloggedMessages() const { return backlogged_.load(std::memory_order_relaxed); }
+    uint64_t getSpinHits() const { return spin_hits_.load(std::memory_order_relaxed); }
+    uint64_t getSpinMisses() const { return spin_misses_.load(std::memory_order_relaxed); }
+
+private:
+    friend class ShardedRuntime;
+
+    static constexpr size_t DRAIN_BATCH_SIZE = 64;
+    static constexpr int IDLE_WAIT_MS = 100;
+
+    Shard(ShardedRuntime& runtime, size_t index, int cpu);
+
+    void run();
+    size_t drainInbound();
+    size_t runPostedTasks();
+    size_t flushBacklog();
+    bool hasPendingWork();
+    bool spinForWork();
+    size_t pollReadiness(int timeout_ms);
+    void handle(size_t from, ShardMessage&& message);
+    void deliverLocal(uint64_t room_id, uint64_t sender_id, const utils::MessageBuffer& message);
+    void send(size_t to, ShardMessage&& message);
+    void notifyInterest(ShardMessage::Kind kind, uint64_t room_id);
+    void wake();
+    // Single writer; a plain load and store avoid a locked read-modify-write
+    static void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    ShardedRuntime& runtime_;
+    const size_t index_;
+    const int cpu_;
+    std::thread thread_;
+
+    // Shard-local state
+    std::unordered_map<uint64_t, std::vector<uint64_t>> local_members_;   // room -> clients here
+    std::unordered_map<uint64_t, std::vector<size_t>> remote_interest_;   // room -> other shards
+    std::vector<std::deque<ShardMessage>> backlog_;                      // per destination, when its queue is full
+    size_t backlog_size_{0};
+    utils::SimulatedClock timers_;
+    std::unordered_map<int, std::function<void()>> watched_;
+    network::AdaptiveSpin spin_;
+
+    // Tasks from threads outside the runtime; not on the message path
+    std::mutex posted_mutex_;
+    std::vector<std::function<void(Shard&)>> posted_;
+    std::vector<std::function<void(Shard&)>> running_tasks_;
+
+    // Sleep/wake handshake with producers
+    std::atomic<bool> sleeping_{false};
+    int poll_fd_{-1};
+    int wake_fd_{-1};
+
+    // Statistics
+    std::atomic<uint64_t> local_deliveries_{0};
+    std::atomic<uint64_t> forwarded_{0};
+    std::atomic<uint64_t> batches_drained_{0};
+    std::atomic<uint64_t> backlogged_{0};
+    std::atomic<uint64_t> spin_hits_{0};
+    std::atomic<uint64_t> spin_misses_{0};
+};
+
+// Shared-nothing execution: one Shard per core, each on its own thread pinned
+// to one CPU when a CPU set is given. Connections are assigned to shards by
+// client id.
+class ShardedRuntime {
+public:
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 4096;
+
+    ShardedRuntime(size_t shard_count, Shard::DeliverFn deliver, const utils::CpuSet& cpus = {},
+                   size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
+    ~ShardedRuntime();
+
+    // Non-copyable, non-movable
+    ShardedRuntime(const ShardedRuntime&) = delete;
+    ShardedRuntime& operator=(const ShardedRuntime&) = delete;
+    ShardedRuntime(ShardedRuntime&&) = delete;
+    ShardedRuntime& operator=(ShardedRuntime&&) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    size_t getShardCount() const { return shards_.size(); }
+    size_t shardOf(uint64_t client_id) const { return static_cast<size_t>(client_id % shards_.size()); }
+    Shard& getShard(size_t index) { return *shards_[index]; }
+
+    // Runs task on the shard's thread. Safe from any thread; intended for
+    // connection setup and teardown rather than per-message work.
+    void post(size_t shard, std::function<void(Shard&)> task);
+
+private:
+    friend class Shard;
+
+    utils::SpscQueue<ShardMessage>& queue(size_t from, size_t to) { return *queues_[from * shards_.size() + to]; }
+
+    const Shard::DeliverFn deliver_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    // queues_[from * n + to]; the diagonal is unused
+    std::vector<std::unique_ptr<utils::SpscQueue<ShardMessage>>> queues_;
+    std::atomic<bool> running_{false};
+
+    // Logging
+    utils::Logger logger_;
+};
+
+} // namespace securechat::core
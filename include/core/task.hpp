@@ -0,0 +1,229 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "utils/memory_pool.hpp"
+
+namespace securechat::core {
+
+template<typename T>
+class Task;
+template<typename T>
+void spawn(Task<T> task);
+
+namespace detail {
+
+// Coroutine frames carry a small header recording the pool they came from
+// (or nullptr for the heap) so the frame can be returned without the caller
+// knowing where it was allocated.
+struct FrameHeader {
+    utils::MemoryPool* pool;
+};
+inline constexpr size_t FRAME_HEADER_SIZE =
+    (sizeof(FrameHeader) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+inline void* allocateFrame(size_t size, utils::MemoryPool* pool) {
+    char* memory = nullptr;
+    if (pool && size + FRAME_HEADER_SIZE <= pool->getBlockSize()) {
+        memory = pool->allocate();
+    } else {
+        pool = nullptr;
+        memory = static_cast<char*>(::operator new(size + FRAME_HEADER_SIZE));
+    }
+    new (memory) FrameHeader{pool};
+    return memory + FRAME_HEADER_SIZE;
+}
+
+inline void deallocateFrame(void* frame) {
+    char* memory = static_cast<char*>(frame) - FRAME_HEADER_SIZE;
+    utils::MemoryPool* pool = reinterpret_cast<FrameHeader*>(memory)->pool;
+    if (pool) {
+        pool->deallocate(memory);
+    } else {
+        ::operator delete(memory);
+    }
+}
+
+class PromiseBase {
+public:
+    // Frames of coroutines declared with (std::allocator_arg_t, MemoryPool&, ...)
+    // parameters, either leading or after the object for member functions,
+    // come from that pool when they fit a block; everything else uses the heap.
+    template<typename... Args>
+    static void* operator new(size_t size, std::allocator_arg_t, utils::MemoryPool& pool, const Args&...) {
+        return allocateFrame(size, &pool);
+    }
+    template<typename Self, typename... Args>
+    static void* operator new(size_t size, const Self&, std::allocator_arg_t, utils::MemoryPool& pool,
+                              const Args&...) {
+        return allocateFrame(size, &pool);
+    }
+    static void* operator new(size_t size) { return allocateFrame(size, nullptr); }
+    static void operator delete(void* frame) { deallocateFrame(frame); }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            PromiseBase& promise = handle.promise();
+            if (promise.detached_) {
+                handle.destroy();
+                return std::noop_coroutine();
+            }
+            return promise.continuation_ ? promise.continuation_ : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() {
+        // A detached task has nobody to report to, as with an uncaught
+        // exception on a std::thread
+        if (detached_) {
+            std::terminate();
+        }
+        exception_ = std::current_exception();
+    }
+
+protected:
+    template<typename T>
+    friend class core::Task;
+    template<typename T>
+    friend void core::spawn(Task<T> task);
+
+    void rethrowIfFailed() {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+    bool detached_{false};
+};
+
+template<typename T>
+class Promise : public PromiseBase {
+public:
+    Task<T> get_return_object();
+
+    template<typename U>
+    void return_value(U&& value) { value_.emplace(std::forward<U>(value)); }
+
+    T take() {
+        rethrowIfFailed();
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template<>
+class Promise<void> : public PromiseBase {
+public:
+    Task<void> get_return_object();
+
+    void return_void() {}
+    void take() { rethrowIfFailed(); }
+};
+
+} // namespace detail
+
+// Lazily started coroutine producing a T. Awaiting a Task starts it and
+// resumes the awaiter, by symmetric transfer, once it finishes, so chains of
+// nested tasks use no stack and no thread of their own. Exceptions propagate
+// to the awaiter.
+//
+// Top-level tasks are handed to spawn(), which starts them and frees the
+// frame when they finish.
+template<typename T = void>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    // Move-only
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    bool valid() const { return static_cast<bool>(handle_); }
+    bool done() const { return handle_ && handle_.done(); }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            handle_type handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation_ = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().take(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    friend class detail::Promise<T>;
+    template<typename U>
+    friend void spawn(Task<U> task);
+
+    explicit Task(handle_type handle) : handle_(handle) {}
+
+    handle_type handle_;
+};
+
+// Starts task on the calling thread and lets it run to completion on its own;
+// it continues on whichever thread resumes its awaits. The result is
+// discarded, and an exception escaping the task terminates the process.
+template<typename T>
+void spawn(Task<T> task) {
+    if (!task.handle_) {
+        return;
+    }
+    auto handle = std::exchange(task.handle_, {});
+    handle.promise().detached_ = true;
+    handle.resume();
+}
+
+namespace detail {
+
+template<typename T>
+Task<T> Promise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+} // namespace securechat::core
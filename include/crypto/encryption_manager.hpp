@@ -1,13 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <array>
 #include <mutex>
 
+#include "utils/message_buffer.hpp"
+
 #include <openssl/evp.h>
-#include <openssl/rsa.h>
 #include <openssl/aes.h>
 #include <openssl/rand.h>
 #include <openssl/hmac.h>
@@ -17,10 +21,7 @@ namespace securechat::crypto {
 // AES-256 key size
 constexpr size_t AES_KEY_SIZE = 32;
 constexpr size_t AES_IV_SIZE = 16;
-constexpr size_t AES_BLOCK_SIZE = 16;
-
-// RSA key size
-constexpr int RSA_KEY_SIZE = 2048;
+// AES_BLOCK_SIZE comes from <openssl/aes.h>; redeclaring it collides with the macro
 
 // HMAC key size
 constexpr size_t HMAC_KEY_SIZE = 32;
@@ -38,6 +39,105 @@ struct EncryptedMessage {
     uint64_t sequence_number;
 };
 
+// One encrypted message as a complete DATA frame in a single pooled buffer:
+//
+//   frame header | sequence | timestamp | iv | tag length | tag | ciphertext
+//
+// This is byte for byte what ProtocolHandler::appendEncrypted() writes for
+// the same EncryptedMessage, so peers parse it with parseEncrypted(), but
+// sealing writes the ciphertext straight into its final place and computes
+// the tag over it there: no intermediate vectors, and no serialization copy
+// before the bytes go to send() or writev(). Copies share the buffer.
+class EncryptedRecord {
+public:
+    static constexpr size_t FRAME_HEADER_SIZE = 5;
+    static constexpr uint8_t DATA_FRAME_TYPE = 4;
+    static constexpr size_t SEQUENCE_OFFSET = FRAME_HEADER_SIZE;
+    static constexpr size_t TIMESTAMP_OFFSET = SEQUENCE_OFFSET + 8;
+    static constexpr size_t IV_OFFSET = TIMESTAMP_OFFSET + 8;
+    static constexpr size_t TAG_LENGTH_OFFSET = IV_OFFSET + AES_IV_SIZE;
+    static constexpr size_t TAG_OFFSET = TAG_LENGTH_OFFSET + 1;
+    static constexpr size_t CIPHERTEXT_OFFSET = TAG_OFFSET + HMAC_DIGEST_SIZE;
+
+    // AES-256-CBC with PKCS#7 padding always adds 1..16 bytes
+    static constexpr size_t ciphertextSize(size_t plaintext_size) {
+        return (plaintext_size / AES_IV_SIZE + 1) * AES_IV_SIZE;
+    }
+
+    EncryptedRecord() = default;
+
+    // Encrypts plaintext into a new record and tags sequence, timestamp, iv
+    // and ciphertext with HMAC-SHA256. Returns an empty record on failure.
+    static EncryptedRecord seal(const AESKey& key, const HMACKey& hmac_key, uint64_t sequence,
+                                uint64_t timestamp, std::string_view plaintext);
+    // Verifies and decrypts a DATA frame payload (frame header already
+    // stripped). Returns false on a malformed record, bad tag or bad padding.
+    static bool open(const AESKey& key, const HMACKey& hmac_key, std::string_view payload,
+                     std::string& plaintext);
+
+    bool empty() const { return bytes_.empty(); }
+    // The whole frame, ready to write
+    const char* data() const { return bytes_.data(); }
+    size_t size() const { return bytes_.size(); }
+    const utils::MessageBuffer& buffer() const { return bytes_; }
+
+    uint64_t getSequence() const;
+    uint64_t getTimestamp() const;
+    std::string_view iv() const { return bytes_.view().substr(IV_OFFSET, AES_IV_SIZE); }
+    std::string_view tag() const { return bytes_.view().substr(TAG_OFFSET, HMAC_DIGEST_SIZE); }
+    std::string_view ciphertext() const { return bytes_.view().substr(CIPHERTEXT_OFFSET); }
+
+private:
+    friend class RecordCipher;
+    explicit EncryptedRecord(utils::MessageBuffer bytes) : bytes_(std::move(bytes)) {}
+
+    utils::MessageBuffer bytes_;
+};
+
+// One session's keys in the form sealing and opening use them: the keyed
+// HMAC states and the AES key schedules are built on first use and reused
+// for every record after, which only sets its IV and copies the MAC states,
+// so sealing and opening a record never allocate.
+// EncryptedRecord::seal() and open() build one per call. Not thread-safe.
+class RecordCipher {
+public:
+    RecordCipher();
+    ~RecordCipher();
+
+    // Non-copyable, non-movable
+    RecordCipher(const RecordCipher&) = delete;
+    RecordCipher& operator=(const RecordCipher&) = delete;
+    RecordCipher(RecordCipher&&) = delete;
+    RecordCipher& operator=(RecordCipher&&) = delete;
+
+    // Replaces the keys and drops what was built from the old ones
+    void setKeys(const AESKey& key, const HMACKey& hmac_key);
+    bool hasKeys() const { return has_keys_; }
+    // Frees the OpenSSL contexts, keeping the keys; the next record
+    // rebuilds them. Returns true if anything was freed.
+    bool releaseContexts();
+    // Approximate bytes OpenSSL holds for the contexts
+    size_t getContextBytes() const;
+
+    // As EncryptedRecord::seal() and open(), with these keys
+    EncryptedRecord seal(uint64_t sequence, uint64_t timestamp, std::string_view plaintext);
+    bool open(std::string_view payload, std::string& plaintext);
+
+private:
+    bool computeTag(const unsigned char* header, const unsigned char* ciphertext, size_t ciphertext_size,
+                    unsigned char* tag);
+
+    // SHA-256 states after the inner and outer padded HMAC key
+    struct TagKeys;
+
+    AESKey key_{};
+    HMACKey hmac_key_{};
+    bool has_keys_{false};
+    std::unique_ptr<TagKeys> tag_keys_;
+    EVP_CIPHER_CTX* encrypt_{nullptr};
+    EVP_CIPHER_CTX* decrypt_{nullptr};
+};
+
 class EncryptionManager {
 public:
     EncryptionManager();
@@ -51,14 +151,25 @@ public:
 
     bool initialize();
 
-    // Key management
+    // Key management. Each side generates an ephemeral X25519 key pair and
+    // sends getPublicKey() (PEM); exchangeKeys() with the peer's key derives
+    // the same session keys on both sides with HKDF-SHA256. Until then
+    // initialize() leaves random session keys in place.
     bool generateEphemeralKeys();
     bool exchangeKeys(const std::string& peer_public_key);
     std::string getPublicKey() const;
 
     // Encryption/Decryption
     std::unique_ptr<EncryptedMessage> encrypt(const std::string& plaintext);
+    // Reads the shared bytes in place and seals them into one wire-ready
+    // record with the session keys; the send path uses this form
+    EncryptedRecord encrypt(const utils::MessageBuffer& plaintext);
     std::string decrypt(const EncryptedMessage& encrypted_msg);
+    // Takes a DATA frame payload, e.g. Frame::payload; empty on failure
+    std::string decrypt(std::string_view record_payload);
+    // As above into a buffer the caller reuses, so a warm buffer is never
+    // reallocated; the receive path uses this form
+    bool decrypt(std::string_view record_payload, std::string& plaintext);
 
     // HMAC operations
     std::vector<unsigned char> computeHMAC(const std::vector<unsigned char>& data) const;
@@ -68,6 +179,15 @@ public:
     // Perfect Forward Secrecy
     void rotateKeys();
     bool deriveSessionKeys(const std::vector<unsigned char>& shared_secret);
+    // Frees the X25519 key pair and peer key once session keys exist; only
+    // the handshake and rotateKeys() need them, and rotation generates new
+    // ones. Returns true if anything was freed.
+    bool releaseHandshakeKeys();
+    // Frees the record ciphers' OpenSSL contexts; the next record in each
+    // direction rebuilds them. Returns true if anything was freed.
+    bool releaseRecordContexts();
+    // This object plus the OpenSSL key objects it holds, approximately
+    size_t getResidentBytes() const;
 
     // Utility functions
     static std::vector<unsigned char> generateRandomBytes(size_t length);
@@ -75,21 +195,14 @@ public:
     static std::vector<unsigned char> hexToBytes(const std::string& hex);
 
 private:
-    bool initializeRSA();
     bool initializeAES();
     bool initializeHMAC();
-    
-    std::vector<unsigned char> rsaEncrypt(const std::vector<unsigned char>& data) const;
-    std::vector<unsigned char> rsaDecrypt(const std::vector<unsigned char>& data) const;
-    
-    std::vector<unsigned char> aesEncrypt(const std::vector<unsigned char>& plaintext, 
-                                        const AESIv& iv) const;
-    std::vector<unsigned char> aesDecrypt(const std::vector<unsigned char>& ciphertext, 
-                                        const AESIv& iv) const;
+    // Hands the session keys to both record ciphers; under crypto_mutex_
+    void installSessionKeysLocked();
 
     // OpenSSL contexts
-    EVP_PKEY* rsa_keypair_;
-    EVP_PKEY* peer_public_key_;
+    EVP_PKEY* keypair_{nullptr};
+    EVP_PKEY* peer_public_key_{nullptr};
     
     // Session keys
     AESKey session_key_;
@@ -105,6 +218,13 @@ private:
     
     // Thread safety
     mutable std::mutex crypto_mutex_;
+
+    // Sealing and opening run on the send and receive paths, so each
+    // direction has its own cipher and lock. Taken after crypto_mutex_.
+    mutable std::mutex seal_mutex_;
+    RecordCipher sealer_;
+    mutable std::mutex open_mutex_;
+    RecordCipher opener_;
     
     // Initialization state
     bool initialized_{false};
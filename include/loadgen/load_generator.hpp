@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "utils/latency_histogram.hpp"
+#include "utils/logger.hpp"
+
+namespace securechat::loadgen {
+
+struct LoadGeneratorConfig {
+    std::string host{"127.0.0.1"};
+    int port{8080};
+    size_t clients{1000};
+    int threads{0};                    // 0 = one per hardware thread
+    size_t room_size{100};
+    double messages_per_second{1.0};   // per client
+    size_t message_size{128};
+    double connect_rate{2000.0};       // new connections per second, all threads
+    std::chrono::seconds warmup{5};
+    std::chrono::seconds duration{60};
+    std::string username_prefix{"loadgen"};
+    // The server's authentication.jwt_secret; each client authenticates with
+    // an HS256 token for its own username signed with it
+    std::string jwt_secret;
+};
+
+struct LoadReport {
+    uint64_t connected{0};
+    uint64_t handshake_failures{0};
+    uint64_t auth_failures{0};
+    uint64_t disconnects{0};
+    uint64_t decrypt_failures{0};
+
+    // Counted only inside the measurement window (after warmup)
+    uint64_t messages_sent{0};
+    uint64_t messages_received{0};
+    uint64_t expected_deliveries{0};
+    double measured_seconds{0.0};
+
+    utils::LatencyHistogram handshake_latency;   // TCP connect to AUTH_RESULT
+    utils::LatencyHistogram delivery_latency;    // embedded send time to receive
+};
+
+// Simulates many chat clients from one process. Clients are spread across
+// worker threads, each running its own epoll loop fed by a key generation
+// thread, and speak the frame protocol defined in ProtocolHandler: key
+// exchange, authentication, room join and encrypted messages.
+// Every message carries its send time, so delivery latency is measured end to
+// end by whichever simulated client receives it.
+class LoadGenerator {
+public:
+    explicit LoadGenerator(const LoadGeneratorConfig& config);
+    ~LoadGenerator();
+
+    // Non-copyable, non-movable
+    LoadGenerator(const LoadGenerator&) = delete;
+    LoadGenerator& operator=(const LoadGenerator&) = delete;
+    LoadGenerator(LoadGenerator&&) = delete;
+    LoadGenerator& operator=(LoadGenerator&&) = delete;
+
+    // Blocks for warmup + duration (or until stop()) and returns merged results
+    LoadReport run();
+    void stop();
+
+    static void printReport(const LoadGeneratorConfig& config, const LoadReport& report, std::ostream& out);
+
+private:
+    class Worker;
+
+    void printProgress(std::chrono::steady_clock::time_point start);
+
+    const LoadGeneratorConfig config_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> stop_requested_{false};
+
+    // Logging
+    utils::Logger logger_;
+};
+
+} // namespace securechat::loadgen
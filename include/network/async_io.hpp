@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
+#include <chrono>
+#include <coroutine>
 #include <functional>
 #include <vector>
 #include <unordered_map>
@@ -8,6 +11,9 @@
 #include <thread>
 #include <mutex>
 
+#include "network/fair_share.hpp"
+#include "utils/config_manager.hpp"
+
 #ifdef _WIN32
 #include <winsock2.h>
 #include <mswsock.h>
@@ -31,7 +37,8 @@ enum class IOOperation {
 struct IOEvent {
     int fd;
     IOOperation operation;
-    std::vector<char> buffer;
+    // READ: the buffer given to asyncRead(), holding bytes_transferred bytes
+    char* buffer;
     size_t bytes_transferred;
     int error_code;
     void* user_data;
@@ -39,9 +46,72 @@ struct IOEvent {
 
 using IOCallback = std::function<void(const IOEvent&)>;
 
+// Reactor sizing (performance.async_io). Each worker thread takes up to
+// max_events readiness events per wait and reads at most read_budget_bytes
+// from one socket per iteration, carrying a socket that still has data over
+// to the next iteration (see FairShareScheduler).
+struct AsyncIOConfig {
+    int max_events{1024};
+    size_t worker_threads{4};
+    size_t read_budget_bytes{65536};
+
+    static AsyncIOConfig fromConfig(const utils::ConfigManager& config) {
+        AsyncIOConfig result;
+        result.max_events = std::max(1, config.getAsyncIOMaxEvents());
+        result.worker_threads = static_cast<size_t>(std::max(1, config.getAsyncIOWorkerThreads()));
+        result.read_budget_bytes = static_cast<size_t>(std::max(1, config.getAsyncIOReadBudgetBytes()));
+        return result;
+    }
+};
+
+class AsyncIO;
+
+// Outcome of an awaited operation. For ACCEPT, fd is the accepted socket;
+// for READ, bytes_transferred bytes were read into the caller's buffer.
+struct IOResult {
+    int fd{-1};
+    size_t bytes_transferred{0};
+    int error_code{0};
+
+    bool ok() const { return error_code == 0; }
+};
+
+// Awaitable form of one AsyncIO operation. The awaiter lives in the awaiting
+// coroutine's frame and is passed to the operation as its user_data, and
+// reads and writes use buffers owned by the caller, so an await adds no
+// allocation of its own; the coroutine resumes on the I/O thread that
+// completed the operation.
+class IOAwaiter {
+public:
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> waiter);
+    IOResult await_resume() const noexcept { return result_; }
+
+private:
+    friend class AsyncIO;
+
+    IOAwaiter(AsyncIO& io, IOOperation operation, int fd)
+        : io_(io), operation_(operation), fd_(fd) {}
+
+    bool startTimer();
+    void complete(const IOEvent& event);
+
+    AsyncIO& io_;
+    IOOperation operation_;
+    int fd_;
+    char* read_buffer_{nullptr};
+    const char* write_data_{nullptr};
+    size_t size_{0};
+    std::chrono::milliseconds delay_{-1};
+    // sleep() reads its timerfd's expiration count here
+    uint64_t expirations_{0};
+    std::coroutine_handle<> waiter_;
+    IOResult result_;
+};
+
 class AsyncIO {
 public:
-    AsyncIO();
+    explicit AsyncIO(AsyncIOConfig config = {});
     ~AsyncIO();
 
     // Non-copyable, non-movable
@@ -52,31 +122,61 @@ public:
 
     bool initialize();
     void start();
+    // Joins the worker threads, except when called from one of them: then it
+    // only stops them, and a later stop() or the destructor joins them
     void stop();
 
-    // Socket operations
+    // Socket operations. A socket is registered edge-triggered for reads and
+    // writes, and either completes the async operations below through its
+    // IOCallback or, with watchSocket(), reports readiness and leaves the
+    // reads and writes to its owner. on_readable reads at most the bytes it
+    // is given; a socket it does not drain gets another turn in the worker's
+    // next iteration (see FairShareScheduler). Handlers for one socket never
+    // run concurrently. removeSocket() waits for a handler running on another
+    // thread to return, so it must not be called while holding a lock that
+    // handler takes; called from the socket's own handler it returns at once.
     bool addSocket(int fd, IOCallback callback);
+    using ReadHandler = std::function<ReadTurn(size_t max_bytes)>;
+    bool watchSocket(int fd, ReadHandler on_readable, std::function<void()> on_writable = {});
     bool removeSocket(int fd);
+    // Runs task on the calling thread as if it were the socket's handler, so
+    // it never overlaps one; events arriving meanwhile go back to an I/O
+    // thread. Returns false, without running it, when the socket is unknown
+    // or a handler is running right now.
+    bool runExclusive(int fd, const std::function<void()>& task);
     
-    // Async operations
-    bool asyncRead(int fd, size_t buffer_size, void* user_data = nullptr);
-    bool asyncWrite(int fd, const std::vector<char>& data, void* user_data = nullptr);
+    // Async operations. Each completes once, through the socket's callback on
+    // an I/O thread, even when the socket is ready at once; at most one of
+    // each kind may be outstanding per socket. Reads go straight into the
+    // caller's buffer and writes send from the caller's bytes, which must
+    // stay valid until the operation completes.
+    bool asyncRead(int fd, char* buffer, size_t capacity, void* user_data = nullptr);
+    bool asyncWrite(int fd, const char* data, size_t length, void* user_data = nullptr);
     bool asyncAccept(int listen_fd, void* user_data = nullptr);
     bool asyncConnect(int fd, const sockaddr* addr, socklen_t addrlen, void* user_data = nullptr);
 
-    // Zero-copy operations (where supported)
-    bool asyncSendFile(int out_fd, int in_fd, off_t offset, size_t count, void* user_data = nullptr);
-    bool asyncSplice(int in_fd, int out_fd, size_t len, void* user_data = nullptr);
+    // Coroutine operations, e.g. `auto result = co_await io.read(fd, buffer, sizeof(buffer));`.
+    // The socket must first be registered with addAwaitableSocket(), which
+    // routes each completion to the awaiter that started it; at most one read
+    // and one write may be outstanding per socket. Buffers belong to the
+    // caller and must stay valid until the await resumes.
+    bool addAwaitableSocket(int fd);
+    IOAwaiter read(int fd, char* buffer, size_t capacity);
+    IOAwaiter write(int fd, const char* data, size_t length);
+    IOAwaiter accept(int listen_fd);
+    // Resumes after delay on an I/O thread (Linux timerfd)
+    IOAwaiter sleep(std::chrono::milliseconds delay);
 
     // Statistics
     uint64_t getTotalOperations() const { return total_operations_.load(); }
     uint64_t getPendingOperations() const { return pending_operations_.load(); }
     double getAverageLatency() const;
+    // Read turns cut short by the per-socket budget, across all workers
+    uint64_t getBudgetHits() const { return budget_hits_.load(); }
+    const AsyncIOConfig& getConfig() const { return config_; }
 
 private:
-    void eventLoop();
-    void processEvents();
-    void handleEvent(const IOEvent& event);
+    void eventLoop(size_t worker_index);
 
 #ifdef _WIN32
     // Windows IOCP implementation
@@ -97,38 +197,76 @@ private:
 #else
     // Linux epoll implementation
     bool initializeEpoll();
-    void processEpollEvents();
-    int epoll_fd_;
-    
+    int epoll_fd_{-1};
+    // Wakes the workers out of epoll_wait on stop()
+    int wake_fd_{-1};
+
+    // One outstanding operation of each kind, guarded by op_mutex
+    struct PendingOp {
+        bool active{false};
+        void* user_data{nullptr};
+        std::chrono::steady_clock::time_point start_time;
+    };
+
     struct EpollContext {
+        int fd{-1};
         IOCallback callback;
-        std::vector<char> read_buffer;
-        std::vector<char> write_buffer;
-        size_t write_offset;
-        void* user_data;
-        std::chrono::steady_clock::time_point start_time;
+        ReadHandler on_readable;
+        std::function<void()> on_writable;
+
+        // Buffers belong to whoever started the operation
+        std::mutex op_mutex;
+        PendingOp read_op;
+        char* read_buffer{nullptr};
+        size_t read_capacity{0};
+        PendingOp write_op;
+        const char* write_data{nullptr};
+        size_t write_length{0};
+        size_t write_offset{0};
+        PendingOp accept_op;
+        PendingOp connect_op;
+
+        // Events not yet handled. Whichever thread wins run_mutex handles
+        // them; others only add theirs, so handlers never overlap.
+        std::atomic<uint32_t> pending_events{0};
+        std::recursive_mutex run_mutex;
+        std::atomic<bool> removed{false};
     };
+
+    std::shared_ptr<EpollContext> findContext(int fd);
+    bool registerContext(std::shared_ptr<EpollContext> context);
+    // Re-arms the edge so readiness that already exists is reported again
+    bool rearm(int fd);
+    void dispatch(const std::shared_ptr<EpollContext>& context, uint32_t events);
+    // One budgeted read for the worker's scheduler; a socket whose handler
+    // is busy elsewhere has the read left to that thread
+    ReadTurn readTurn(int fd, size_t max_bytes);
+    void runHandlers(EpollContext& context, uint32_t events);
+    void completeOperations(EpollContext& context, uint32_t events);
+    void complete(EpollContext& context, PendingOp& op, IOEvent event);
     
-    std::unordered_map<int, std::unique_ptr<EpollContext>> epoll_contexts_;
+    std::unordered_map<int, std::shared_ptr<EpollContext>> epoll_contexts_;
+    // max_events entries per worker, each worker using its own slice
     std::vector<epoll_event> events_;
+    // One per worker thread, indexed like worker_threads_
+    std::vector<std::unique_ptr<FairShareScheduler>> read_schedulers_;
 #endif
 
     // Thread management
     std::vector<std::thread> worker_threads_;
     std::atomic<bool> running_{false};
     
-    // Socket management
+    // Socket management; guards epoll_contexts_
     std::mutex sockets_mutex_;
-    std::unordered_map<int, IOCallback> socket_callbacks_;
     
     // Statistics
     std::atomic<uint64_t> total_operations_{0};
     std::atomic<uint64_t> pending_operations_{0};
     std::atomic<uint64_t> total_latency_us_{0};
+    std::atomic<uint64_t> budget_hits_{0};
     
     // Configuration
-    static constexpr int MAX_EVENTS = 1024;
-    static constexpr int WORKER_THREADS = 4;
+    const AsyncIOConfig config_;
 };
 
 // Platform-specific socket utilities
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "utils/config_manager.hpp"
+
+namespace securechat::network {
+
+// Opt-in low-latency mode (performance.busy_poll). Reactors spin for up to
+// max_spin before blocking in epoll_wait, and sockets get SO_BUSY_POLL /
+// SO_PREFER_BUSY_POLL so the kernel polls the device queue instead of
+// waiting for an interrupt.
+struct BusyPollConfig {
+    bool enabled{false};
+    std::chrono::microseconds min_spin{5};
+    std::chrono::microseconds max_spin{50};
+    // Socket options; 0 leaves SO_BUSY_POLL unset
+    int socket_busy_poll_us{50};
+    bool prefer_busy_poll{true};
+    int budget{64};
+
+    // Reactor index selects an entry of performance.busy_poll.reactor_max_spin_us
+    // when present; an entry of 0 turns spinning off for that reactor.
+    static BusyPollConfig fromConfig(const utils::ConfigManager& config, size_t reactor_index = 0);
+};
+
+// Applies the socket half of config to fd. Returns false if busy polling is
+// disabled or the kernel rejected SO_BUSY_POLL (e.g. without CAP_NET_ADMIN
+// above net.core.busy_read); prefer/budget are best effort.
+bool applySocketBusyPoll(int fd, const BusyPollConfig& config);
+
+// Per-reactor spin interval. Every idle period starts with a spin of
+// getSpinBudget(); a spin that finds work doubles the budget (up to
+// max_spin), one that expires halves it, and below min_spin the reactor
+// blocks straight away. While load stays away an idle reactor therefore
+// burns at most about 2 * max_spin of CPU before it stops spinning, and a
+// blocking wait that ends sooner than max_spin re-arms it.
+//
+// Not thread-safe; owned by one reactor thread.
+class AdaptiveSpin {
+public:
+    using duration = std::chrono::nanoseconds;
+
+    explicit AdaptiveSpin(const BusyPollConfig& config = {});
+
+    void configure(const BusyPollConfig& config);
+    bool isEnabled() const { return enabled_; }
+    duration getSpinBudget() const { return budget_; }
+
+    // Outcome of one spin of getSpinBudget()
+    void onSpin(bool found_work);
+    // A blocking wait that returned with work after blocked_for
+    void onWake(duration blocked_for);
+
+    // Statistics
+    uint64_t getSpinHits() const { return spin_hits_; }
+    uint64_t getSpinMisses() const { return spin_misses_; }
+
+private:
+    void grow();
+
+    bool enabled_{false};
+    duration min_spin_{0};
+    duration max_spin_{0};
+    duration budget_{0};
+
+    // Statistics
+    uint64_t spin_hits_{0};
+    uint64_t spin_misses_{0};
+};
+
+} // namespace securechat::network
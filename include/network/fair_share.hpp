@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace securechat::network {
+
+// Outcome of one budgeted read turn on a socket
+struct ReadTurn {
+    size_t bytes{0};
+    // Socket reported EAGAIN, EOF or an error; nothing is left to read
+    bool drained{true};
+};
+
+// Per-reactor fair share of read work. Every ready socket gets one turn per
+// iteration of at most budget_bytes; a socket that uses its whole budget
+// without draining is carried over to the next iteration instead of being
+// read until EAGAIN. Edge-triggered epoll will not report such a socket
+// again, so the carry-over list is what keeps it from stalling, and the
+// caller should poll with a zero timeout while hasCarryOver() is true.
+//
+// A flooding client therefore costs each iteration at most one budget,
+// and quiet clients that become ready are served in the same iteration.
+//
+// Once its lists have grown to the number of ready sockets an iteration
+// allocates nothing. Not thread-safe; owned by one reactor thread.
+class FairShareScheduler {
+public:
+    // Reads from fd until max_bytes are consumed or the socket would block
+    using ReadFn = std::function<ReadTurn(int fd, size_t max_bytes)>;
+
+    explicit FairShareScheduler(size_t budget_bytes);
+
+    // Gives each carried-over socket, then each newly ready one, a single
+    // turn. Returns the bytes read.
+    size_t runIteration(const std::vector<int>& ready, const ReadFn& read);
+
+    // Forget a socket that was closed or unregistered
+    void remove(int fd);
+
+    bool hasCarryOver() const { return !carry_over_.empty(); }
+    size_t getBudgetBytes() const { return budget_bytes_; }
+
+    // Statistics
+    // Turns that ended on the budget rather than an empty socket
+    uint64_t getBudgetHits() const { return budget_hits_; }
+
+private:
+    // Records fd's turn in this iteration; true if it already had one
+    bool markServed(int fd);
+
+    size_t budget_bytes_;
+    std::vector<int> carry_over_;
+    // The previous iteration's carry-over while this one runs
+    std::vector<int> carried_;
+    // Indexed by fd: the iteration in which the socket last had its turn
+    std::vector<uint64_t> served_in_;
+    uint64_t iteration_{0};
+
+    // Statistics
+    uint64_t budget_hits_{0};
+};
+
+} // namespace securechat::network
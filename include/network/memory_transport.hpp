@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "network/transport.hpp"
+
+namespace securechat::network {
+
+class MemoryTransport;
+
+// In-process network of memory pipes for deterministic simulation. connect()
+// returns the client end of a new connection and queues the server end for
+// accept(). Each direction is bounded like a socket buffer, so writers see
+// backpressure. Readiness is edge-triggered: an endpoint is queued once when
+// bytes or end-of-stream arrive, and its read handler should drain it until
+// read() returns 0. runReady() dispatches handlers in arrival order, so a run
+// driven from one thread is fully reproducible.
+//
+// Not thread-safe. The network must outlive every transport it hands out.
+class MemoryNetwork {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 262144;
+
+    explicit MemoryNetwork(size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    ~MemoryNetwork();
+
+    // Non-copyable, non-movable
+    MemoryNetwork(const MemoryNetwork&) = delete;
+    MemoryNetwork& operator=(const MemoryNetwork&) = delete;
+    MemoryNetwork(MemoryNetwork&&) = delete;
+    MemoryNetwork& operator=(MemoryNetwork&&) = delete;
+
+    std::unique_ptr<MemoryTransport> connect();
+    // Returns nullptr when no connection is waiting
+    std::unique_ptr<MemoryTransport> accept();
+
+    // Runs read handlers of readable endpoints until none are left or
+    // max_events have run. Handlers may write, connect and close freely.
+    size_t runReady(size_t max_events = std::numeric_limits<size_t>::max());
+    bool hasReady() const { return ready_head_ < ready_.size(); }
+
+    // Statistics
+    size_t getPendingAccepts() const { return pending_accepts_.size(); }
+    size_t getOpenEndpoints() const { return open_endpoints_; }
+    uint64_t getBytesTransferred() const { return bytes_transferred_; }
+
+private:
+    friend class MemoryTransport;
+
+    struct Endpoint {
+        std::string inbox;
+        size_t read_offset{0};
+        uint32_t peer{0};
+        bool open{true};
+        bool peer_closed{false};
+        bool ready_queued{false};
+        std::function<void()> read_handler;
+    };
+
+    int64_t read(uint32_t id, char* buffer, size_t length);
+    int64_t write(uint32_t id, const char* data, size_t length);
+    void close(uint32_t id);
+    bool isOpen(uint32_t id) const { return endpoints_[id].open; }
+    void setReadHandler(uint32_t id, std::function<void()> handler);
+    void markReadable(uint32_t id);
+
+    const size_t buffer_size_;
+
+    // Indexed by endpoint id; ids are never reused and a deque keeps
+    // references stable while handlers open new connections
+    std::deque<Endpoint> endpoints_;
+    std::deque<uint32_t> pending_accepts_;
+    // Endpoints to dispatch from ready_head_ on; emptied, keeping its
+    // capacity, whenever it is drained, so steady traffic never allocates
+    std::vector<uint32_t> ready_;
+    size_t ready_head_{0};
+
+    // Statistics
+    size_t open_endpoints_{0};
+    uint64_t bytes_transferred_{0};
+};
+
+// One end of a MemoryNetwork connection. Closing either end delivers
+// end-of-stream to the other once its buffered bytes are read.
+class MemoryTransport : public Transport {
+public:
+    ~MemoryTransport() override;
+
+    // Non-copyable, non-movable
+    MemoryTransport(const MemoryTransport&) = delete;
+    MemoryTransport& operator=(const MemoryTransport&) = delete;
+    MemoryTransport(MemoryTransport&&) = delete;
+    MemoryTransport& operator=(MemoryTransport&&) = delete;
+
+    int64_t read(char* buffer, size_t length) override;
+    int64_t write(const char* data, size_t length) override;
+    void close() override;
+    bool isOpen() const override;
+    bool setReadHandler(std::function<void()> handler) override;
+
+    uint32_t getEndpointId() const { return id_; }
+
+private:
+    friend class MemoryNetwork;
+
+    MemoryTransport(MemoryNetwork& network, uint32_t id);
+
+    MemoryNetwork& network_;
+    const uint32_t id_;
+};
+
+} // namespace securechat::network
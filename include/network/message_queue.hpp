@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+#include "utils/message_buffer.hpp"
+
+namespace securechat::network {
+
+// Outgoing bytes a connection could not write yet, in order. Buffers are
+// queued as shared handles, and a partial write only advances an offset into
+// the front one, so nothing is copied while a slow reader catches up.
+//
+// Not thread-safe; the owning connection serializes access with its send
+// lock.
+class MessageQueue {
+public:
+    void push(utils::MessageBuffer message);
+
+    bool empty() const { return messages_.empty(); }
+    size_t size() const { return messages_.size(); }
+    // Bytes still to be written
+    size_t bytes() const { return bytes_; }
+
+    // Unwritten part of the front buffer; empty() must be false
+    const char* frontData() const { return messages_.front().data() + front_offset_; }
+    size_t frontSize() const { return messages_.front().size() - front_offset_; }
+
+    // Marks length bytes of the front buffer written, dropping it once all are
+    void consume(size_t length);
+    void clear();
+
+private:
+    std::deque<utils::MessageBuffer> messages_;
+    size_t front_offset_{0};
+    size_t bytes_{0};
+};
+
+} // namespace securechat::network
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "crypto/encryption_manager.hpp"
+
+namespace securechat::network {
+
+// Wire protocol: every frame is a 4-byte big-endian payload length, a 1-byte
+// frame type and the payload. A session runs
+//
+//   client                         server
+//   KEY_EXCHANGE(public key)  ->
+//                             <-   KEY_EXCHANGE(public key)
+//   AUTH(username \0 secret)  ->
+//                             <-   AUTH_RESULT(status byte, token or reason)
+//   RESUME(sequence, token)   ->                                  (optional)
+//   JOIN_ROOM(room id)        ->
+//   DATA(encrypted message)   <->  DATA(encrypted message)
+//   ACK(sequence)             ->
+//
+// DATA payloads carry a serialized crypto::EncryptedMessage. ACK
+// acknowledges every DATA record from the server up to and including the
+// given sequence number. After a dropped connection the client
+// authenticates again and sends RESUME with the previous session's token
+// and the last sequence it received from it; the server then resends the
+// chat messages it had not yet seen.
+enum class FrameType : uint8_t {
+    KEY_EXCHANGE = 1,
+    AUTH = 2,
+    AUTH_RESULT = 3,
+    DATA = 4,
+    JOIN_ROOM = 5,
+    PING = 6,
+    PONG = 7,
+    ERROR = 8,
+    ACK = 9,
+    RESUME = 10
+};
+
+enum class AuthStatus : uint8_t {
+    OK = 0,
+    INVALID_CREDENTIALS = 1,
+    RATE_LIMITED = 2
+};
+
+struct Frame {
+    FrameType type;
+    std::string_view payload;
+};
+
+// Incremental frame decoder for one connection. Bytes are appended as they
+// arrive and complete frames are returned as views into the internal buffer,
+// valid until the next call to append().
+class ProtocolHandler {
+public:
+    static constexpr size_t HEADER_SIZE = 5;
+    static constexpr size_t DEFAULT_MAX_FRAME_SIZE = 1048576;
+
+    explicit ProtocolHandler(size_t max_frame_size = DEFAULT_MAX_FRAME_SIZE);
+
+    void append(const char* data, size_t length);
+
+    // Returns true and fills `frame` when a complete frame is buffered. A frame
+    // larger than the limit puts the handler into the error state.
+    bool nextFrame(Frame& frame);
+    bool hasError() const { return error_; }
+    size_t getBufferedBytes() const { return buffer_.size() - read_offset_; }
+
+    // Encoding
+    static void appendFrame(std::string& out, FrameType type, std::string_view payload);
+    static void appendAuth(std::string& out, std::string_view username, std::string_view secret);
+    static void appendAuthResult(std::string& out, AuthStatus status, std::string_view detail);
+    static void appendJoinRoom(std::string& out, uint64_t room_id);
+    static void appendEncrypted(std::string& out, const crypto::EncryptedMessage& message);
+    static void appendAck(std::string& out, uint64_t sequence);
+    static void appendResume(std::string& out, uint64_t sequence, std::string_view token);
+
+    // Decoding
+    static bool parseAuth(std::string_view payload, std::string_view& username, std::string_view& secret);
+    static bool parseAuthResult(std::string_view payload, AuthStatus& status, std::string_view& detail);
+    static bool parseJoinRoom(std::string_view payload, uint64_t& room_id);
+    static bool parseEncrypted(std::string_view payload, crypto::EncryptedMessage& message);
+    static bool parseAck(std::string_view payload, uint64_t& sequence);
+    static bool parseResume(std::string_view payload, uint64_t& sequence, std::string_view& token);
+
+private:
+    std::string buffer_;
+    size_t read_offset_{0};
+    const size_t max_frame_size_;
+    bool error_{false};
+};
+
+} // namespace securechat::network
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace securechat::network {
+
+// Non-blocking byte stream beneath a ClientConnection. read() and write()
+// return the number of bytes moved, 0 when the call would block and -1 once
+// the stream is closed or has failed. Socket transports are driven by AsyncIO
+// through nativeHandle(); in-process transports report readiness themselves
+// through the read handler.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual int64_t read(char* buffer, size_t length) = 0;
+    virtual int64_t write(const char* data, size_t length) = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    // OS handle to register with AsyncIO, or -1 for in-process transports
+    virtual int nativeHandle() const { return -1; }
+
+    // Called whenever new bytes or end-of-stream become readable. Returns false
+    // when readiness comes from the OS instead.
+    virtual bool setReadHandler(std::function<void()> handler) {
+        (void)handler;
+        return false;
+    }
+};
+
+// Transport over a connected, non-blocking socket. Owns and closes the fd.
+class SocketTransport : public Transport {
+public:
+    explicit SocketTransport(int socket_fd);
+    ~SocketTransport() override;
+
+    // Non-copyable, non-movable
+    SocketTransport(const SocketTransport&) = delete;
+    SocketTransport& operator=(const SocketTransport&) = delete;
+    SocketTransport(SocketTransport&&) = delete;
+    SocketTransport& operator=(SocketTransport&&) = delete;
+
+    int64_t read(char* buffer, size_t length) override;
+    int64_t write(const char* data, size_t length) override;
+    void close() override;
+    bool isOpen() const override { return socket_fd_ >= 0; }
+    int nativeHandle() const override { return socket_fd_; }
+
+private:
+    int socket_fd_;
+};
+
+} // namespace securechat::network
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+#include "utils/config_manager.hpp"
+#include "utils/logger.hpp"
+
+namespace securechat::plugins {
+
+enum class FilterAction : uint8_t {
+    ALLOW = 0,
+    MASK = 1,
+    REJECT = 2
+};
+
+struct FilterPattern {
+    std::string text;
+    FilterAction action{FilterAction::REJECT};
+    bool whole_word{true};
+};
+
+struct FilterMatch {
+    size_t offset;
+    size_t length;
+    uint32_t pattern_id;
+};
+
+// Immutable Aho-Corasick automaton over every configured pattern. Patterns are
+// matched ASCII case-insensitively; input bytes are folded into equivalence
+// classes so the transition table is states x classes rather than states x 256.
+// While the automaton sits in the root state, a SIMD start-byte prefilter skips
+// over input that cannot begin any pattern.
+class PatternMatcher {
+public:
+    static std::shared_ptr<const PatternMatcher> compile(const std::vector<FilterPattern>& patterns);
+
+    // Scans once in O(length). Returns the strongest action among all matches;
+    // stops early on REJECT unless every match has been requested.
+    FilterAction scan(std::string_view text, std::vector<FilterMatch>* matches = nullptr) const;
+
+    size_t getPatternCount() const { return patterns_.size(); }
+    size_t getStateCount() const { return state_count_; }
+    size_t getMemoryUsage() const;
+    bool isPrefilterEnabled() const { return prefilter_enabled_; }
+
+private:
+    PatternMatcher() = default;
+
+    size_t findCandidate(const unsigned char* data, size_t pos, size_t length) const;
+    bool isWordBoundary(std::string_view text, size_t begin, size_t end) const;
+
+    struct CompiledPattern {
+        uint32_t length;
+        FilterAction action;
+        bool whole_word;
+    };
+
+    // Transition entries hold the target row offset (state * stride) with the
+    // high bit set when the target state emits at least one match.
+    static constexpr uint32_t OUTPUT_FLAG = 0x80000000u;
+    static constexpr uint32_t OFFSET_MASK = 0x7fffffffu;
+
+    std::array<uint8_t, 256> byte_class_{};
+    uint32_t stride_{1};
+    size_t state_count_{0};
+    std::vector<uint32_t> transitions_;
+
+    // Outputs of state s live in output_ids_[output_begin_[s] .. output_begin_[s + 1])
+    std::vector<uint32_t> output_begin_;
+    std::vector<uint32_t> output_ids_;
+    std::vector<CompiledPattern> patterns_;
+
+    // Start-byte prefilter (shufti-style nibble tables)
+    bool prefilter_enabled_{false};
+    std::array<uint8_t, 16> prefilter_lo_{};
+    std::array<uint8_t, 16> prefilter_hi_{};
+    std::array<bool, 256> start_bytes_{};
+
+    static constexpr size_t PREFILTER_MAX_START_BYTES = 24;
+};
+
+struct FilterVerdict {
+    FilterAction action{FilterAction::ALLOW};
+    size_t match_count{0};
+};
+
+// Content-filter stage for the message_filter and profanity_filter plugins.
+// Word lists are compiled into a single PatternMatcher which is published
+// atomically; scanning threads keep a thread-local snapshot and only touch the
+// shared pointer again after a reload bumps the generation.
+class ContentFilter {
+public:
+    explicit ContentFilter(const utils::ConfigManager& config);
+    ~ContentFilter() = default;
+
+    // Non-copyable, non-movable
+    ContentFilter(const ContentFilter&) = delete;
+    ContentFilter& operator=(const ContentFilter&) = delete;
+    ContentFilter(ContentFilter&&) = delete;
+    ContentFilter& operator=(ContentFilter&&) = delete;
+
+    // Loads the word list of each enabled filter plugin. Lists load
+    // independently: one that cannot be read is logged as an error and
+    // keeps the patterns it had (none at startup), the others still
+    // reload, and the call returns false.
+    bool initialize();
+    bool reload();
+    void setPatterns(const std::vector<FilterPattern>& patterns);
+
+    // Applies the filter to a message. MASK verdicts write the masked text to
+    // `rewritten`; ALLOW and REJECT leave it untouched.
+    FilterVerdict apply(std::string_view message, std::string& rewritten) const;
+    FilterAction check(std::string_view message) const;
+
+    // Statistics
+    uint64_t getGeneration() const { return generation_.load(std::memory_order_acquire); }
+    uint64_t getRejectedMessages() const { return rejected_messages_.load(); }
+    uint64_t getMaskedMessages() const { return masked_messages_.load(); }
+    std::shared_ptr<const PatternMatcher> getMatcher() const;
+
+    static std::vector<FilterPattern> loadPatternFile(const std::string& filename,
+                                                      FilterAction action, bool whole_word);
+
+private:
+    const PatternMatcher& localMatcher() const;
+
+    const utils::ConfigManager& config_;
+
+    std::atomic<std::shared_ptr<const PatternMatcher>> matcher_;
+    std::atomic<uint64_t> generation_{0};
+    std::mutex reload_mutex_;
+
+    // Each list's patterns as last loaded, under lists_mutex_
+    std::mutex lists_mutex_;
+    std::vector<FilterPattern> blocked_patterns_;
+    std::vector<FilterPattern> masked_patterns_;
+
+    // Statistics
+    mutable std::atomic<uint64_t> rejected_messages_{0};
+    mutable std::atomic<uint64_t> masked_messages_{0};
+
+    // Logging
+    utils::Logger logger_;
+};
+
+} // namespace securechat::plugins
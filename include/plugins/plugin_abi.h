@@ -0,0 +1,97 @@
+/*
+ * SecureChat message pipeline plugin ABI.
+ *
+ * Plugins are shared objects exporting SECURECHAT_PLUGIN_ENTRY, a function
+ * returning a pointer to a static securechat_plugin descriptor. The server
+ * creates one instance per worker thread, so instances are only ever called
+ * from a single thread and need no locking. Messages are passed as read-only
+ * views of the decrypted payload owned by the server; a view is only valid
+ * for the duration of the on_message call.
+ *
+ * The ABI is plain C. New fields are only ever appended to the descriptor;
+ * the server checks abi_version and struct_size before using it.
+ */
+#ifndef SECURECHAT_PLUGIN_ABI_H
+#define SECURECHAT_PLUGIN_ABI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SECURECHAT_PLUGIN_ABI_VERSION 1u
+#define SECURECHAT_PLUGIN_ENTRY "securechat_plugin_descriptor"
+
+#if defined(_WIN32)
+#define SECURECHAT_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define SECURECHAT_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+typedef enum securechat_verdict {
+    SECURECHAT_VERDICT_ACCEPT = 0,
+    SECURECHAT_VERDICT_REJECT = 1,
+    SECURECHAT_VERDICT_REWRITE = 2
+} securechat_verdict;
+
+typedef struct securechat_message_header {
+    uint64_t sender_id;
+    uint64_t recipient_id;   /* 0 for broadcasts */
+    uint64_t room_id;        /* 0 for the lobby and direct messages */
+    uint64_t timestamp_us;   /* server receive time, microseconds since epoch */
+    uint32_t flags;
+    uint32_t reserved;
+} securechat_message_header;
+
+typedef struct securechat_message_view {
+    const char* data;
+    size_t length;
+    const securechat_message_header* header;
+} securechat_message_view;
+
+/*
+ * Output buffer for SECURECHAT_VERDICT_REWRITE. The plugin writes at most
+ * `capacity` bytes to `data` and stores the new length in `length`. A length
+ * larger than capacity is treated as a rejection.
+ */
+typedef struct securechat_rewrite_buffer {
+    char* data;
+    size_t capacity;
+    size_t length;
+} securechat_rewrite_buffer;
+
+/* securechat_plugin.flags: the plugin may return SECURECHAT_VERDICT_REWRITE.
+ * Plugins without it are given an empty rewrite buffer, and a REWRITE
+ * verdict from them counts as a rejection. */
+#define SECURECHAT_PLUGIN_REWRITES 1u
+
+typedef struct securechat_plugin {
+    uint32_t abi_version;   /* SECURECHAT_PLUGIN_ABI_VERSION */
+    uint32_t struct_size;   /* sizeof(securechat_plugin) */
+    const char* name;
+    const char* version;
+
+    /* Called once per worker thread; `config` is the plugin's configuration
+     * string (may be empty, never NULL). Returning NULL disables the plugin
+     * on that thread. */
+    void* (*create_instance)(const char* config, uint32_t worker_index);
+    void (*destroy_instance)(void* instance);
+
+    securechat_verdict (*on_message)(void* instance,
+                                     const securechat_message_view* message,
+                                     securechat_rewrite_buffer* rewrite);
+
+    /* SECURECHAT_PLUGIN_* bits. Descriptors whose struct_size ends before
+     * this field are treated as SECURECHAT_PLUGIN_REWRITES. */
+    uint32_t flags;
+} securechat_plugin;
+
+typedef const securechat_plugin* (*securechat_plugin_entry_fn)(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* SECURECHAT_PLUGIN_ABI_H */
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+#include "plugins/plugin_abi.h"
+#include "utils/config_manager.hpp"
+#include "utils/logger.hpp"
+
+namespace securechat::plugins {
+
+struct PluginStats {
+    std::string name;
+    uint64_t calls{0};
+    uint64_t rejects{0};
+    uint64_t rewrites{0};
+    uint64_t slow_calls{0};
+    uint64_t total_ns{0};
+    uint64_t max_ns{0};
+
+    double getAverageLatencyUs() const {
+        return calls ? static_cast<double>(total_ns) / static_cast<double>(calls) / 1000.0 : 0.0;
+    }
+};
+
+class PluginManager;
+
+// Chain of plugin instances owned by one thread. Counters are written only by
+// the owning thread and read with relaxed loads when stats are collected.
+class PluginPipeline {
+public:
+    ~PluginPipeline();
+
+    // Non-copyable, non-movable
+    PluginPipeline(const PluginPipeline&) = delete;
+    PluginPipeline& operator=(const PluginPipeline&) = delete;
+    PluginPipeline(PluginPipeline&&) = delete;
+    PluginPipeline& operator=(PluginPipeline&&) = delete;
+
+    // Runs every plugin in load order. On ACCEPT or REWRITE `output` views the
+    // final payload: the input itself when nothing was rewritten, otherwise a
+    // thread-local buffer valid until the next call on this thread.
+    securechat_verdict process(const securechat_message_header& header,
+                               std::string_view message, std::string_view& output);
+
+private:
+    friend class PluginManager;
+
+    struct Counters {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> rejects{0};
+        std::atomic<uint64_t> rewrites{0};
+        std::atomic<uint64_t> slow_calls{0};
+        std::atomic<uint64_t> total_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+    };
+
+    struct Stage {
+        const securechat_plugin* descriptor;
+        void* instance;
+        size_t plugin_index;
+        // SECURECHAT_PLUGIN_REWRITES; other stages never get a rewrite buffer
+        bool rewrites;
+        std::unique_ptr<Counters> counters;
+    };
+
+    PluginPipeline(PluginManager& manager, uint32_t worker_index);
+
+    char* rewriteBuffer(int index);
+
+    PluginManager& manager_;
+    const uint32_t worker_index_;
+    std::vector<Stage> stages_;
+    std::unique_ptr<char[]> buffers_[2];
+};
+
+// Loads message pipeline plugins from plugins.directory and hands out one
+// PluginPipeline per calling thread. Plugins are loaded during startup; once
+// the first pipeline has been created the plugin set is fixed. A thread's
+// pipeline is destroyed when the thread exits, and its worker index and
+// counters are kept for the next thread.
+//
+// shutdown() may run while other threads are inside process(): each call is
+// counted in a reader stripe, and shutdown() turns new calls away and waits
+// for the counted ones to return before destroying instances and unloading
+// libraries.
+class PluginManager {
+public:
+    explicit PluginManager(const utils::ConfigManager& config);
+    ~PluginManager();
+
+    // Non-copyable, non-movable
+    PluginManager(const PluginManager&) = delete;
+    PluginManager& operator=(const PluginManager&) = delete;
+    PluginManager(PluginManager&&) = delete;
+    PluginManager& operator=(PluginManager&&) = delete;
+
+    bool initialize();
+    void shutdown();
+
+    bool loadPlugin(const std::string& path);
+    bool registerPlugin(const securechat_plugin* descriptor, const std::string& plugin_config = "");
+
+    PluginPipeline& localPipeline();
+    // The calling thread's pipeline. While shutdown() is running, accepts
+    // without calling any plugin; a rewritten `output` is invalid after
+    // shutdown() returns.
+    securechat_verdict process(const securechat_message_header& header,
+                               std::string_view message, std::string_view& output);
+
+    // Statistics
+    bool empty() const { return plugin_count_.load(std::memory_order_acquire) == 0; }
+    size_t getPluginCount() const { return plugin_count_.load(std::memory_order_acquire); }
+    std::vector<PluginStats> getStats() const;
+
+    // Names handled by built-in stages rather than shared objects
+    static bool isBuiltinPlugin(const std::string& name);
+
+private:
+    friend class PluginPipeline;
+
+    struct LoadedPlugin {
+        std::string name;
+        std::string path;
+        std::string config;
+        void* handle;
+        const securechat_plugin* descriptor;
+    };
+
+    // Pipelines outlive the manager's lock scope at thread exit, so they live
+    // in shared state that exiting threads reach through a weak reference
+    struct PipelineRegistry;
+    struct ThreadPipelines;
+
+    bool addPlugin(LoadedPlugin plugin);
+    void reportSlowCall(size_t plugin_index, uint32_t worker_index, uint64_t elapsed_ns);
+
+    static ThreadPipelines& threadPipelines();
+    static void releasePipeline(PipelineRegistry& registry, uint64_t generation, PluginPipeline* pipeline);
+    static void addCounters(std::vector<PluginStats>& stats, const PluginPipeline& pipeline);
+
+    const utils::ConfigManager& config_;
+    const uint64_t id_;
+
+    std::vector<LoadedPlugin> plugins_;
+    std::atomic<size_t> plugin_count_{0};
+    bool sealed_{false};
+
+    std::shared_ptr<PipelineRegistry> registry_;
+    mutable std::mutex mutex_;
+
+    // Calls in process(), striped by thread so readers rarely share a line
+    static constexpr size_t READER_STRIPES = 16;
+    struct alignas(64) ReaderStripe {
+        std::atomic<uint32_t> active{0};
+    };
+    ReaderStripe readers_[READER_STRIPES];
+    // Shutdowns in progress; process() stays out while non-zero
+    std::atomic<uint32_t> closing_{0};
+    static size_t readerStripe();
+
+    // Limits
+    const size_t rewrite_capacity_;
+    const uint64_t slow_call_ns_;
+
+    // Logging
+    utils::Logger logger_;
+};
+
+} // namespace securechat::plugins
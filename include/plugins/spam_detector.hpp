@@ -0,0 +1,115 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "utils/logger.hpp"
+
+namespace securechat::plugins {
+
+// Defaults match config/server.json.
+struct SpamDetectorConfig {
+    // Fingerprints at most this many bits apart count as near-duplicates
+    int hamming_radius{10};
+    // Shorter messages are neither checked nor recorded
+    size_t min_tokens{5};
+    // How long a fingerprint counts against its user and room
+    std::chrono::seconds window{30};
+    int user_threshold{3};   // near-duplicates from one user before flagging
+    int room_threshold{5};   // near-duplicates in one room before flagging
+    size_t table_slots{16384};
+};
+
+struct SpamVerdict {
+    bool flagged{false};
+    uint8_t user_duplicates{0};
+    uint8_t room_duplicates{0};
+    uint64_t fingerprint{0};
+    size_t tokens{0};
+};
+
+// Fixed-size table of recent fingerprints keyed by user or room id. Each key
+// maps to a two-way set of slots guarded by a spinlock in the first slot; a
+// slot holds a small ring of (fingerprint, timestamp) pairs, so a lookup never
+// allocates. Keys that collide evict the least recently used window: the table
+// is a cache, not a registry.
+class FingerprintWindowTable {
+public:
+    static constexpr size_t WINDOW_SIZE = 8;
+
+    explicit FingerprintWindowTable(size_t slots);
+
+    // Counts entries within `radius` bits of `fingerprint` no older than
+    // `horizon_ms`, then records the fingerprint.
+    uint8_t recordAndCount(uint64_t key, uint64_t fingerprint, uint32_t now_ms,
+                           uint32_t horizon_ms, int radius);
+
+    size_t getSlotCount() const { return mask_ + 1; }
+    size_t getMemoryUsage() const { return (mask_ + 1) * sizeof(Slot); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> lock{0};
+        uint32_t last_seen{0};
+        uint64_t key{0};
+        uint8_t head{0};
+        uint8_t size{0};
+        std::array<uint32_t, WINDOW_SIZE> stamps{};
+        std::array<uint64_t, WINDOW_SIZE> fingerprints{};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+};
+
+// Near-duplicate flood detection for the spam_detection plugin. Each message
+// is reduced to a 64-bit SimHash over its normalized word tokens; floods of
+// lightly edited copies land within a few bits of each other.
+class SpamDetector {
+public:
+    explicit SpamDetector(const SpamDetectorConfig& config = {});
+    ~SpamDetector() = default;
+
+    // Non-copyable, non-movable
+    SpamDetector(const SpamDetector&) = delete;
+    SpamDetector& operator=(const SpamDetector&) = delete;
+    SpamDetector(SpamDetector&&) = delete;
+    SpamDetector& operator=(SpamDetector&&) = delete;
+
+    // Room id for messages not posted to a room: only the per-user window
+    // applies to them
+    static constexpr uint64_t NO_ROOM = 0;
+
+    // Messages with fewer than min_tokens tokens are neither flagged nor
+    // recorded
+    SpamVerdict check(uint64_t user_id, uint64_t room_id, std::string_view message,
+                      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+    static uint64_t fingerprint(std::string_view message);
+    static uint64_t fingerprint(std::string_view message, size_t& tokens);
+    static int distance(uint64_t a, uint64_t b);
+
+    // Statistics
+    uint64_t getFlaggedMessages() const { return flagged_messages_.load(); }
+    size_t getMemoryUsage() const { return user_windows_.getMemoryUsage() + room_windows_.getMemoryUsage(); }
+
+private:
+    const SpamDetectorConfig config_;
+    const std::chrono::steady_clock::time_point epoch_;
+
+    FingerprintWindowTable user_windows_;
+    FingerprintWindowTable room_windows_;
+
+    // Statistics
+    std::atomic<uint64_t> flagged_messages_{0};
+
+    // Logging
+    utils::Logger logger_;
+};
+
+} // namespace securechat::plugins
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "network/protocol_handler.hpp"
+#include "utils/clock.hpp"
+#include "utils/config_manager.hpp"
+#include "utils/logger.hpp"
+
+namespace securechat::security {
+
+// Checks the secret an AUTH frame carries: an HS256 JWT signed with
+// authentication.jwt_secret whose "sub" is the username and whose "exp", if
+// present, has not passed. After login_attempts failures in a row a username
+// is locked out for lockout_duration seconds, during which every attempt,
+// right or wrong, gets RATE_LIMITED.
+//
+// With authentication.enable_jwt off there is no way to authenticate and
+// every attempt is rejected. Thread-safe.
+class AuthManager {
+public:
+    explicit AuthManager(const utils::ConfigManager& config, const utils::Clock& clock = utils::Clock::system());
+
+    // Non-copyable, non-movable
+    AuthManager(const AuthManager&) = delete;
+    AuthManager& operator=(const AuthManager&) = delete;
+    AuthManager(AuthManager&&) = delete;
+    AuthManager& operator=(AuthManager&&) = delete;
+
+    // Fails when JWT authentication is enabled without a secret
+    bool initialize();
+
+    network::AuthStatus authenticate(std::string_view username, std::string_view token);
+
+    // Statistics
+    uint64_t getSuccessfulLogins() const { return successful_logins_.load(); }
+    uint64_t getFailedLogins() const { return failed_logins_.load(); }
+
+private:
+    bool verifyToken(std::string_view username, std::string_view token) const;
+
+    const utils::ConfigManager& config_;
+    const utils::Clock& clock_;
+    std::string secret_;
+    bool jwt_enabled_{true};
+    int max_attempts_{5};
+    std::chrono::seconds lockout_duration_{300};
+
+    struct Failures {
+        int count{0};
+        utils::Clock::time_point locked_until{};
+    };
+    std::mutex failures_mutex_;
+    std::unordered_map<std::string, Failures> failures_;
+
+    // Statistics
+    std::atomic<uint64_t> successful_logins_{0};
+    std::atomic<uint64_t> failed_logins_{0};
+
+    // Logging
+    utils::Logger logger_;
+};
+
+} // namespace securechat::security
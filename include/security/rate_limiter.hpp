@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "utils/clock.hpp"
+#include "utils/config_manager.hpp"
+
+namespace securechat::security {
+
+// Message rate limits for one connection (rate_limiting section)
+struct RateLimitConfig {
+    double messages_per_second{100.0};
+    double burst_size{200.0};
+
+    static RateLimitConfig fromConfig(const utils::ConfigManager& config) {
+        RateLimitConfig result;
+        result.messages_per_second = static_cast<double>(std::max(1, config.getMessagesPerSecond()));
+        result.burst_size = static_cast<double>(std::max(1, config.getBurstSize()));
+        return result;
+    }
+};
+
+// Token bucket: up to burst_size messages at once, refilled at
+// messages_per_second. Not thread-safe; each connection owns one and
+// consults it from its receive path.
+class RateLimiter {
+public:
+    explicit RateLimiter(RateLimitConfig config, const utils::Clock& clock = utils::Clock::system());
+
+    // Takes `cost` tokens if that many are available
+    bool tryAcquire(double cost = 1.0);
+
+    double getAvailableTokens() const { return tokens_; }
+
+    // Statistics
+    uint64_t getRejected() const { return rejected_; }
+
+private:
+    void refill();
+
+    const RateLimitConfig config_;
+    const utils::Clock& clock_;
+    double tokens_;
+    utils::Clock::time_point last_refill_;
+
+    // Statistics
+    uint64_t rejected_{0};
+};
+
+} // namespace securechat::security
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace securechat::utils {
+
+// Per-thread heap allocation counts, for proving that a path allocates
+// nothing. Counting needs the interposer in allocation_interposer.cpp, which
+// replaces the global operator new (and, outside sanitizer builds on glibc,
+// malloc) and is linked into test and benchmark binaries built with
+// -DENABLE_ALLOCATION_COUNTING=ON. Without it the counts stay at zero and
+// isEnabled() returns false.
+class AllocationCounter {
+public:
+    // True when allocations are actually being counted
+    static bool isEnabled();
+
+    // Totals for the calling thread since it started
+    static uint64_t getThreadAllocations();
+    static uint64_t getThreadAllocatedBytes();
+
+    // Called by the interposer on every allocation
+    static void record(size_t bytes);
+};
+
+// A region of code that must not allocate. The allocations the current thread
+// makes while the scope is open are counted; call finish() to read them. A
+// scope that ends with allocations and was never finished reports them to
+// stderr and aborts, like a failed assertion. Scopes nest.
+class NoAllocationScope {
+public:
+    explicit NoAllocationScope(const char* name);
+    ~NoAllocationScope();
+
+    // Non-copyable, non-movable
+    NoAllocationScope(const NoAllocationScope&) = delete;
+    NoAllocationScope& operator=(const NoAllocationScope&) = delete;
+    NoAllocationScope(NoAllocationScope&&) = delete;
+    NoAllocationScope& operator=(NoAllocationScope&&) = delete;
+
+    // Allocations so far; later ones are no longer checked
+    uint64_t finish();
+    uint64_t getAllocations() const { return AllocationCounter::getThreadAllocations() - start_allocations_; }
+    uint64_t getAllocatedBytes() const { return AllocationCounter::getThreadAllocatedBytes() - start_bytes_; }
+
+private:
+    const char* const name_;
+    const uint64_t start_allocations_;
+    const uint64_t start_bytes_;
+    bool finished_{false};
+};
+
+} // namespace securechat::utils
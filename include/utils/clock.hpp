@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+namespace securechat::utils {
+
+// Source of monotonic time. Components that track timeouts or uptime take a
+// Clock so simulations can substitute SimulatedClock for the steady clock.
+class Clock {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+    using duration = std::chrono::steady_clock::duration;
+
+    virtual ~Clock() = default;
+    virtual time_point now() const = 0;
+
+    // Process-wide clock backed by std::chrono::steady_clock
+    static Clock& system();
+};
+
+// Manually advanced clock with a timer queue. Time only moves in advance(),
+// which fires due timers in deadline order (ties in scheduling order), each
+// with now() equal to its deadline. Timers scheduled from inside a callback
+// fire in the same advance() if they fall within it.
+//
+// Not thread-safe; drive it from the simulation thread.
+class SimulatedClock : public Clock {
+public:
+    using TimerId = uint64_t;
+
+    explicit SimulatedClock(time_point start = time_point{});
+
+    time_point now() const override { return now_; }
+
+    TimerId runAt(time_point deadline, std::function<void()> callback);
+    TimerId runAfter(duration delay, std::function<void()> callback);
+    // Returns false if the timer already fired or was cancelled
+    bool cancel(TimerId id);
+
+    // Returns the number of timers fired
+    size_t advance(duration delta);
+    size_t advanceTo(time_point target);
+    // Jumps straight to the next deadline and fires everything due there
+    size_t advanceToNextTimer();
+    // Earliest pending deadline; false when no timer is pending
+    bool getNextDeadline(time_point& deadline);
+
+    // Statistics
+    size_t getPendingTimers() const { return live_timers_.size(); }
+    uint64_t getFiredTimers() const { return fired_timers_; }
+
+private:
+    struct Timer {
+        time_point deadline;
+        TimerId id;
+        std::function<void()> callback;
+    };
+
+    // Min-heap on (deadline, id); ids increase, so equal deadlines keep FIFO order
+    struct Later {
+        bool operator()(const Timer& a, const Timer& b) const {
+            return a.deadline != b.deadline ? a.deadline > b.deadline : a.id > b.id;
+        }
+    };
+
+    time_point now_;
+    std::priority_queue<Timer, std::vector<Timer>, Later> timers_;
+    std::unordered_set<TimerId> live_timers_;
+    TimerId next_timer_id_{1};
+    uint64_t fired_timers_{0};
+};
+
+} // namespace securechat::utils
@@ -40,6 +40,9 @@ public:
     int getBacklog() const { return getInt("server.backlog", 128); }
     int getKeepaliveTimeout() const { return getInt("server.keepalive_timeout", 300); }
     int getClientTimeout() const { return getInt("server.client_timeout", 60); }
+    int getIdleTrimSeconds() const { return getInt("server.idle_trim_seconds", 30); }
+    bool isSharedNothingEnabled() const { return getBool("server.shared_nothing", false); }
+    int getShardCount() const { return getInt("server.shards", 0); }
     
     void setWorkerThreads(int threads) { setInt("server.worker_threads", threads); }
     
@@ -53,6 +56,11 @@ public:
     bool isPerfectForwardSecrecy() const { return getBool("security.perfect_forward_secrecy", true); }
     int getKeyRotationInterval() const { return getInt("security.key_rotation_interval", 1800); }
     int getSessionTimeout() const { return getInt("security.session_timeout", 3600); }
+
+    // Message deduplication by client-supplied message id
+    bool isDeduplicationEnabled() const { return getBool("security.deduplication.enabled", true); }
+    int getDeduplicationWindowSeconds() const { return getInt("security.deduplication.window_seconds", 60); }
+    int getDeduplicationCapacity() const { return getInt("security.deduplication.capacity", 65536); }
     
     // Encryption configuration
     std::string getEncryptionAlgorithm() const { return getString("encryption.algorithm", "AES-256-GCM"); }
@@ -86,6 +94,47 @@ public:
     bool isTCPFastOpenEnabled() const { return getBool("performance.enable_tcp_fastopen", true); }
     int getSocketRecvBuffer() const { return getInt("performance.socket_recv_buffer", 65536); }
     int getSocketSendBuffer() const { return getInt("performance.socket_send_buffer", 65536); }
+
+    // CPU placement
+    bool isCpuAffinityEnabled() const { return getBool("performance.cpu_affinity.enabled", false); }
+    std::string getReactorCpus() const { return getString("performance.cpu_affinity.reactor_cpus", ""); }
+    std::string getWorkerCpus() const { return getString("performance.cpu_affinity.worker_cpus", ""); }
+    std::string getServiceCpus() const { return getString("performance.cpu_affinity.service_cpus", ""); }
+
+    // Executors; 0 threads means derive from the core count
+    int getCpuExecutorMinThreads() const { return getInt("performance.executors.cpu.min_threads", 0); }
+    int getCpuExecutorMaxThreads() const { return getInt("performance.executors.cpu.max_threads", 0); }
+    int getCpuExecutorQueueDelayUs() const { return getInt("performance.executors.cpu.target_queue_delay_us", 500); }
+    int getBlockingExecutorMinThreads() const { return getInt("performance.executors.blocking.min_threads", 1); }
+    int getBlockingExecutorMaxThreads() const { return getInt("performance.executors.blocking.max_threads", 32); }
+    int getBlockingExecutorQueueDelayUs() const { return getInt("performance.executors.blocking.target_queue_delay_us", 5000); }
+    int getExecutorIdleTimeoutMs() const { return getInt("performance.executors.idle_timeout_ms", 10000); }
+    // Run every task on the submitting thread; for single-threaded simulation only
+    bool isInlineExecutionEnabled() const { return getBool("performance.executors.inline", false); }
+
+    // Busy polling
+    bool isBusyPollEnabled() const { return getBool("performance.busy_poll.enabled", false); }
+    int getBusyPollMinSpinUs() const { return getInt("performance.busy_poll.min_spin_us", 5); }
+    int getBusyPollMaxSpinUs() const { return getInt("performance.busy_poll.max_spin_us", 50); }
+    std::string getReactorMaxSpinUs() const { return getString("performance.busy_poll.reactor_max_spin_us", ""); }
+    int getSocketBusyPollUs() const { return getInt("performance.busy_poll.socket_busy_poll_us", 50); }
+    bool isPreferBusyPoll() const { return getBool("performance.busy_poll.prefer_busy_poll", true); }
+    int getBusyPollBudget() const { return getInt("performance.busy_poll.budget", 64); }
+
+    // Async I/O reactor
+    int getAsyncIOMaxEvents() const { return getInt("performance.async_io.max_events", 1024); }
+    int getAsyncIOWorkerThreads() const { return getInt("performance.async_io.worker_threads", 4); }
+    int getAsyncIOReadBudgetBytes() const { return getInt("performance.async_io.read_budget_bytes", 65536); }
+
+    // At-least-once delivery; a window of 0 turns it off
+    int getRetransmitWindowSize() const { return getInt("delivery.retransmit_window", 256); }
+    int getResumeTimeoutSeconds() const { return getInt("delivery.resume_timeout_seconds", 120); }
+
+    // Huge page buffer arena
+    bool isHugePagesEnabled() const { return getBool("performance.huge_pages.enabled", false); }
+    std::string getHugePagesMode() const { return getString("performance.huge_pages.mode", "thp"); }
+    bool isHugePagesLocked() const { return getBool("performance.huge_pages.lock", false); }
+    int getHugePagesPerConnectionBytes() const { return getInt("performance.huge_pages.per_connection_bytes", 16384); }
     
     // Logging configuration
     std::string getLogLevel() const { return getString("logging.level", "info"); }
@@ -133,6 +182,16 @@ public:
     std::string getPluginDirectory() const { return getString("plugins.directory", "plugins"); }
     bool isAutoLoadEnabled() const { return getBool("plugins.auto_load", true); }
     std::vector<std::string> getEnabledPlugins() const;
+    std::string getMessageFilterPatternsFile() const { return getString("plugins.message_filter.patterns_file", "plugins/message_filter.txt"); }
+    std::string getProfanityWordsFile() const { return getString("plugins.profanity_filter.words_file", "plugins/profanity_filter.txt"); }
+    int getSpamHammingRadius() const { return getInt("plugins.spam_detection.hamming_radius", 10); }
+    int getSpamMinTokens() const { return getInt("plugins.spam_detection.min_tokens", 5); }
+    int getSpamWindowSeconds() const { return getInt("plugins.spam_detection.window_seconds", 30); }
+    int getSpamUserThreshold() const { return getInt("plugins.spam_detection.user_threshold", 3); }
+    int getSpamRoomThreshold() const { return getInt("plugins.spam_detection.room_threshold", 5); }
+    int getSpamTableSlots() const { return getInt("plugins.spam_detection.table_slots", 16384); }
+    std::string getPluginConfig(const std::string& name) const { return getString("plugins." + name + ".config", ""); }
+    int getPluginSlowCallThreshold() const { return getInt("plugins.slow_call_threshold_us", 200); }
 
 private:
     // Generic getters/setters
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace securechat::utils {
+
+// Instruction set extensions detected at runtime. Code paths compiled with
+// per-function target attributes check these before dispatching so the same
+// binary runs on hosts without AVX2.
+struct CpuFeatures {
+    bool sse2{false};
+    bool ssse3{false};
+    bool sse42{false};
+    bool avx2{false};
+};
+
+inline const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = []() {
+        CpuFeatures detected;
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        detected.sse2 = __builtin_cpu_supports("sse2");
+        detected.ssse3 = __builtin_cpu_supports("ssse3");
+        detected.sse42 = __builtin_cpu_supports("sse4.2");
+        detected.avx2 = __builtin_cpu_supports("avx2");
+#endif
+        return detected;
+    }();
+    return features;
+}
+
+} // namespace securechat::utils
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/config_manager.hpp"
+
+namespace securechat::utils {
+
+using CpuSet = std::vector<int>;
+
+// Linux cpulist syntax, e.g. "0-3,8,10-11". Returns an empty set on malformed input.
+CpuSet parseCpuList(std::string_view list);
+std::string formatCpuList(const CpuSet& cpus);
+
+// CPUs this process may run on, grouped by NUMA node. Nodes are numbered
+// densely from 0 in sysfs order; hosts without NUMA information report one
+// node holding every allowed CPU.
+struct CpuTopology {
+    std::vector<CpuSet> nodes;
+    CpuSet cpus;
+
+    size_t getNodeCount() const { return nodes.size(); }
+    // Dense node index of a CPU, 0 if unknown
+    size_t nodeOf(int cpu) const;
+    std::string describe() const;
+
+    // Reads <sysfs_root>/node/node*/cpulist and intersects with the allowed set
+    static CpuTopology detect(const std::string& sysfs_root = "/sys/devices/system");
+    static const CpuTopology& system();
+
+private:
+    std::vector<size_t> node_of_cpu_;
+    void index();
+};
+
+// Node of the CPU the calling thread is running on right now
+size_t currentNumaNode();
+
+bool setThreadAffinity(const CpuSet& cpus);
+CpuSet getThreadAffinity();
+
+// Restricts the calling thread to a CPU set for the lifetime of the scope.
+// Threads started inside the scope inherit the mask, which is how components
+// that create their own threads (ThreadPool, EventLoop, the async logger)
+// are placed without changing their interfaces. An empty set is a no-op.
+class ScopedAffinity {
+public:
+    explicit ScopedAffinity(const CpuSet& cpus);
+    ~ScopedAffinity();
+
+    ScopedAffinity(const ScopedAffinity&) = delete;
+    ScopedAffinity& operator=(const ScopedAffinity&) = delete;
+
+    bool applied() const { return applied_; }
+
+private:
+    CpuSet previous_;
+    bool applied_{false};
+};
+
+enum class ThreadRole {
+    REACTOR,   // accept and I/O readiness threads
+    WORKER,    // message processing pool
+    SERVICE    // logging, metrics and housekeeping, kept off the message cores
+};
+
+// Where each kind of thread may run, from performance.cpu_affinity. Lists
+// left empty are derived from the topology: the last CPU for service
+// threads, an eighth of the rest (at least one) for reactors, and the
+// remainder for workers. With fewer than four CPUs, or when disabled, every
+// role gets an empty set and threads are not pinned.
+struct ThreadPlacement {
+    bool enabled{false};
+    CpuSet reactor;
+    CpuSet workers;
+    CpuSet service;
+    std::vector<std::string> warnings;
+
+    const CpuSet& cpusFor(ThreadRole role) const;
+    std::string describe() const;
+
+    static ThreadPlacement fromConfig(const ConfigManager& config, const CpuTopology& topology);
+};
+
+} // namespace securechat::utils
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "utils/config_manager.hpp"
+
+namespace securechat::utils {
+
+enum class HugePageMode {
+    // Explicit hugetlbfs pages (MAP_HUGETLB); needs vm.nr_hugepages
+    HUGETLB,
+    // Transparent huge pages requested with madvise(MADV_HUGEPAGE)
+    TRANSPARENT
+};
+
+// Opt-in (performance.huge_pages). The reservation is max_connections times
+// the per-connection buffer budget, rounded up to whole huge pages.
+struct HugePageConfig {
+    bool enabled{false};
+    HugePageMode mode{HugePageMode::TRANSPARENT};
+    // mlock the arena so it is never swapped or compacted away
+    bool lock{false};
+    size_t bytes{0};
+
+    static HugePageConfig fromConfig(const ConfigManager& config);
+};
+
+// Buffer memory reserved once at startup in 2 MB pages. Every page is
+// faulted in by reserve(), so steady-state buffer traffic takes neither page
+// faults nor 4 KB TLB misses. Blocks are carved off the front and never
+// given back; MemoryPools backed by the arena keep them on their free lists
+// instead. Touching the pages from the reserving thread places them on its
+// NUMA node.
+//
+// carve() is thread-safe; reserve() must finish before it is called.
+class HugePageArena {
+public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+    explicit HugePageArena(HugePageConfig config);
+    ~HugePageArena();
+
+    // Non-copyable, non-movable
+    HugePageArena(const HugePageArena&) = delete;
+    HugePageArena& operator=(const HugePageArena&) = delete;
+    HugePageArena(HugePageArena&&) = delete;
+    HugePageArena& operator=(HugePageArena&&) = delete;
+
+    // Maps, advises, optionally locks and prefaults the arena. On failure
+    // nothing stays mapped and getError() says what to change.
+    bool reserve();
+    const std::string& getError() const { return error_; }
+
+    // Returns nullptr once the arena is used up
+    char* carve(size_t size);
+    bool contains(const void* block) const {
+        auto address = static_cast<const char*>(block);
+        return base_ && address >= base_ && address < base_ + size_;
+    }
+
+    // Arena behind the process's buffer pools. install() keeps the first
+    // arena for the life of the process, since static pools hold its blocks
+    // until exit, and returns whichever arena is installed.
+    static HugePageArena* buffers() { return buffers_.load(std::memory_order_acquire); }
+    static HugePageArena* install(std::unique_ptr<HugePageArena> arena);
+
+    // Statistics
+    size_t getReservedBytes() const { return size_; }
+    size_t getUsedBytes() const { return std::min(used_.load(std::memory_order_relaxed), size_); }
+    bool isLocked() const { return locked_; }
+
+private:
+    bool fail(const std::string& what, int error_number);
+    void release();
+
+    const HugePageConfig config_;
+    char* base_{nullptr};
+    size_t size_{0};
+    // The mapping itself; for THP it includes alignment slack around base_
+    char* mapping_{nullptr};
+    size_t mapping_size_{0};
+    bool locked_{false};
+    std::string error_;
+
+    std::atomic<size_t> used_{0};
+
+    static std::atomic<HugePageArena*> buffers_;
+};
+
+} // namespace securechat::utils
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace securechat::utils {
+
+// Fixed-size log-linear histogram of nanosecond latencies. Each power-of-two
+// range is split into SUB_BUCKETS linear buckets, so reported percentiles are
+// within ~3% of the true value. Recording is a handful of integer ops and the
+// histogram never allocates; merge per-thread instances for a combined view.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 44;   // ~4.9 hours in nanoseconds
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    void record(uint64_t value_ns) {
+        counts_[bucketIndex(value_ns)]++;
+        count_++;
+        sum_ += value_ns;
+        min_ = std::min(min_, value_ns);
+        max_ = std::max(max_, value_ns);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    // Smallest recorded bucket value at or above the given percentile (0-100)
+    uint64_t percentile(double p) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        auto rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count_) + 0.5);
+        rank = std::clamp<uint64_t>(rank, 1, count_);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::clamp(bucketUpperBound(i), min_, max_);
+            }
+        }
+        return max_;
+    }
+
+    // Statistics
+    uint64_t getCount() const { return count_; }
+    uint64_t getMin() const { return count_ ? min_ : 0; }
+    uint64_t getMax() const { return max_; }
+    double getMean() const { return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+private:
+    static size_t bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        int exponent = std::min(static_cast<int>(std::bit_width(value)) - 1, MAX_EXPONENT);
+        int shift = exponent - SUB_BUCKET_BITS;
+        uint64_t sub = std::min((value >> shift) - SUB_BUCKETS, SUB_BUCKETS - 1);
+        return static_cast<size_t>((shift + 1) * SUB_BUCKETS + sub);
+    }
+
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        uint64_t shift = index / SUB_BUCKETS - 1;
+        uint64_t sub = index % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
+
+    std::array<uint64_t, BUCKET_COUNT> counts_{};
+    uint64_t count_{0};
+    uint64_t sum_{0};
+    uint64_t min_{std::numeric_limits<uint64_t>::max()};
+    uint64_t max_{0};
+};
+
+} // namespace securechat::utils
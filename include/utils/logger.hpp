@@ -52,19 +52,15 @@ public:
     static void setMaxFileSize(size_t max_size);
     static void setMaxFiles(int max_files);
 
-    // Logging methods
-    void trace(const std::string& message, const char* file = __builtin_FILE(), 
-               int line = __builtin_LINE(), const char* function = __builtin_FUNCTION());
-    void debug(const std::string& message, const char* file = __builtin_FILE(), 
-               int line = __builtin_LINE(), const char* function = __builtin_FUNCTION());
-    void info(const std::string& message, const char* file = __builtin_FILE(), 
-              int line = __builtin_LINE(), const char* function = __builtin_FUNCTION());
-    void warn(const std::string& message, const char* file = __builtin_FILE(), 
-              int line = __builtin_LINE(), const char* function = __builtin_FUNCTION());
-    void error(const std::string& message, const char* file = __builtin_FILE(), 
-               int line = __builtin_LINE(), const char* function = __builtin_FUNCTION());
-    void fatal(const std::string& message, const char* file = __builtin_FILE(), 
-               int line = __builtin_LINE(), const char* function = __builtin_FUNCTION());
+    // Logging with an explicit source location, for the LOG_* macros. There
+    // are no defaults, so a message with a single const char* argument goes
+    // to the formatting overloads below instead of being read as a file name.
+    void trace(const std::string& message, const char* file, int line, const char* function);
+    void debug(const std::string& message, const char* file, int line, const char* function);
+    void info(const std::string& message, const char* file, int line, const char* function);
+    void warn(const std::string& message, const char* file, int line, const char* function);
+    void error(const std::string& message, const char* file, int line, const char* function);
+    void fatal(const std::string& message, const char* file, int line, const char* function);
 
     // Template logging with formatting
     template<typename... Args>
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace securechat::utils {
+
+class HugePageArena;
+
+// Thread-safe pool of fixed-size blocks. Released blocks are cached on a free
+// list up to max_cached_blocks and returned to the heap beyond that, so a
+// burst of activity does not keep memory pinned once connections go idle.
+//
+// A pool backed by a HugePageArena takes new blocks from the arena before
+// the heap. Arena blocks cannot be freed, so they always go back on the free
+// list; only heap blocks are subject to max_cached_blocks.
+class MemoryPool {
+public:
+    // Move-only handle that returns its block to the pool when destroyed
+    class Block {
+    public:
+        Block() = default;
+        ~Block() { reset(); }
+
+        Block(const Block&) = delete;
+        Block& operator=(const Block&) = delete;
+        Block(Block&& other) noexcept : pool_(other.pool_), data_(other.data_) {
+            other.pool_ = nullptr;
+            other.data_ = nullptr;
+        }
+        Block& operator=(Block&& other) noexcept {
+            if (this != &other) {
+                reset();
+                pool_ = other.pool_;
+                data_ = other.data_;
+                other.pool_ = nullptr;
+                other.data_ = nullptr;
+            }
+            return *this;
+        }
+
+        char* data() const { return data_; }
+        size_t size() const { return pool_ ? pool_->getBlockSize() : 0; }
+        explicit operator bool() const { return data_ != nullptr; }
+
+        void reset() {
+            if (data_) {
+                pool_->deallocate(data_);
+                pool_ = nullptr;
+                data_ = nullptr;
+            }
+        }
+
+    private:
+        friend class MemoryPool;
+        Block(MemoryPool* pool, char* data) : pool_(pool), data_(data) {}
+
+        MemoryPool* pool_{nullptr};
+        char* data_{nullptr};
+    };
+
+    MemoryPool(size_t block_size, size_t max_cached_blocks, HugePageArena* arena = nullptr);
+    ~MemoryPool();
+
+    // Non-copyable, non-movable
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+    MemoryPool(MemoryPool&&) = delete;
+    MemoryPool& operator=(MemoryPool&&) = delete;
+
+    Block acquire();
+    size_t getBlockSize() const { return block_size_; }
+
+    // Raw blocks for owners that track them themselves, e.g. coroutine frames
+    char* allocate();
+    void deallocate(char* block);
+
+    // Statistics
+    size_t getBlocksInUse() const { return blocks_in_use_.load(std::memory_order_relaxed); }
+    size_t getCachedBlocks() const;
+    uint64_t getHeapAllocations() const { return heap_allocations_.load(std::memory_order_relaxed); }
+    uint64_t getArenaAllocations() const { return arena_allocations_.load(std::memory_order_relaxed); }
+
+private:
+    const size_t block_size_;
+    const size_t max_cached_blocks_;
+    HugePageArena* const arena_;
+
+    mutable std::mutex mutex_;
+    std::vector<char*> free_blocks_;
+
+    // Statistics
+    std::atomic<size_t> blocks_in_use_{0};
+    std::atomic<uint64_t> heap_allocations_{0};
+    std::atomic<uint64_t> arena_allocations_{0};
+};
+
+} // namespace securechat::utils
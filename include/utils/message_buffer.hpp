@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace securechat::utils {
+
+// Immutable message bytes shared along the send path. The bytes are written
+// once, when the buffer is built, and every later hop (executor task, shard
+// queue, connection send queue, encryption) holds a handle instead of a copy.
+//
+// Payloads up to INLINE_CAPACITY live inside the handle and are copied with
+// it, which is cheaper than touching a shared counter. Larger payloads live
+// in one block holding an atomic reference count and the bytes; blocks come
+// from size-class MemoryPools (see MAX_POOLED_SIZE) and bigger ones from the
+// heap. The last handle to go returns the block.
+class MessageBuffer {
+public:
+    static constexpr size_t INLINE_CAPACITY = 40;
+    // Largest pooled block, reference count included; bigger ones use the heap
+    static constexpr size_t MAX_POOLED_SIZE = 64 * 1024;
+
+    MessageBuffer() = default;
+    explicit MessageBuffer(std::string_view bytes);
+
+    // Builds a buffer of exactly size bytes; fill(char*) writes them once
+    template<typename F>
+    static MessageBuffer build(size_t size, F&& fill) {
+        MessageBuffer buffer;
+        fill(buffer.allocate(size));
+        return buffer;
+    }
+
+    MessageBuffer(const MessageBuffer& other) : size_(other.size_) {
+        if (isInline()) {
+            std::memcpy(inline_, other.inline_, size_);
+        } else {
+            storage_ = other.storage_;
+            storage_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    MessageBuffer(MessageBuffer&& other) noexcept : size_(other.size_) {
+        if (isInline()) {
+            std::memcpy(inline_, other.inline_, size_);
+        } else {
+            storage_ = other.storage_;
+        }
+        other.size_ = 0;
+    }
+
+    MessageBuffer& operator=(const MessageBuffer& other) {
+        if (this != &other) {
+            MessageBuffer copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    MessageBuffer& operator=(MessageBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            size_ = other.size_;
+            if (isInline()) {
+                std::memcpy(inline_, other.inline_, size_);
+            } else {
+                storage_ = other.storage_;
+            }
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~MessageBuffer() { release(); }
+
+    const char* data() const { return isInline() ? inline_ : storage_->bytes(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    std::string_view view() const { return {data(), size_}; }
+    // Copies; for APIs that still take std::string
+    std::string str() const { return std::string(view()); }
+
+    bool isInline() const { return size_ <= INLINE_CAPACITY; }
+    // Handles sharing the bytes; 1 for inline buffers, which are never shared
+    uint32_t useCount() const {
+        return isInline() ? 1 : storage_->refs.load(std::memory_order_relaxed);
+    }
+
+    bool operator==(const MessageBuffer& other) const { return view() == other.view(); }
+
+private:
+    struct Storage {
+        std::atomic<uint32_t> refs{1};
+        // Size class the block came from, 0 for heap blocks
+        uint32_t pool_class;
+
+        char* bytes() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    // Sets size_ and returns where the bytes go
+    char* allocate(size_t size);
+    void release() {
+        if (!isInline() && storage_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            free(storage_);
+        }
+        size_ = 0;
+    }
+    static void free(Storage* storage);
+
+    size_t size_{0};
+    union {
+        char inline_[INLINE_CAPACITY];
+        Storage* storage_;
+    };
+};
+
+} // namespace securechat::utils
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "utils/config_manager.hpp"
+#include "utils/logger.hpp"
+
+namespace securechat::utils {
+
+// Named counters and gauges, served in the Prometheus text format on
+// monitoring.metrics_port at monitoring.metrics_path. Names get a
+// "securechat_" prefix on export. Updates take one mutex; they happen per
+// connection event or from the periodic metrics sweep, not per recipient.
+class MetricsCollector {
+public:
+    explicit MetricsCollector(const ConfigManager& config);
+    ~MetricsCollector();
+
+    // Non-copyable, non-movable
+    MetricsCollector(const MetricsCollector&) = delete;
+    MetricsCollector& operator=(const MetricsCollector&) = delete;
+    MetricsCollector(MetricsCollector&&) = delete;
+    MetricsCollector& operator=(MetricsCollector&&) = delete;
+
+    // Binds the metrics port and starts serving scrapes
+    bool initialize();
+    void stop();
+
+    void incrementCounter(const std::string& name, uint64_t value = 1);
+    void setGauge(const std::string& name, double value);
+
+    uint64_t getCounter(const std::string& name) const;
+    double getGauge(const std::string& name) const;
+
+    // Every metric in the Prometheus text exposition format
+    std::string exportPrometheus() const;
+
+private:
+    void serve();
+    void handleScrape(int client_fd);
+
+    const ConfigManager& config_;
+
+    mutable std::mutex metrics_mutex_;
+    std::map<std::string, uint64_t> counters_;
+    std::map<std::string, double> gauges_;
+
+    // Scrape endpoint
+    int listen_fd_{-1};
+    std::string path_;
+    std::atomic<bool> running_{false};
+    std::thread server_thread_;
+
+    // Logging
+    Logger logger_;
+};
+
+} // namespace securechat::utils
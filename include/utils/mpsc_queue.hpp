@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace securechat::utils {
+
+// Unbounded multi-producer single-consumer queue. Producers link a node onto
+// an atomic list head with one CAS; the consumer takes the whole list with a
+// single exchange and runs it oldest first, so a burst of N pushes costs the
+// consumer one atomic operation rather than N lock round trips. Elements from
+// one producer keep their order; elements from different producers interleave
+// in push order.
+//
+// Nodes are pooled: the consumer puts drained nodes on a free stack that
+// push() takes from, so a queue that has seen its peak backlog allocates no
+// more. The free stack's head carries a version in its top 16 bits, above
+// the 48-bit address, so a pop that raced with another pop and push of the
+// same node fails its CAS instead of linking a node that is in use. Nodes
+// are only freed by the destructor, which is what makes reading a stale
+// head's link safe.
+template<typename T>
+class MpscQueue {
+public:
+    MpscQueue() = default;
+
+    ~MpscQueue() {
+        Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            node->value()->~T();
+            delete node;
+            node = next;
+        }
+        node = address(free_head_.load(std::memory_order_acquire));
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    // Non-copyable, non-movable
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+    MpscQueue(MpscQueue&&) = delete;
+    MpscQueue& operator=(MpscQueue&&) = delete;
+
+    // Any thread. Returns true if the queue was empty, i.e. this push starts
+    // a new batch.
+    bool push(T value) {
+        Node* node = acquireNode();
+        new (node->storage) T(std::move(value));
+        Node* head = head_.load(std::memory_order_relaxed);
+        do {
+            node->next.store(head, std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(head, node, std::memory_order_seq_cst, std::memory_order_relaxed));
+        return head == nullptr;
+    }
+
+    // Consumer side. Passes every element pushed so far to fn in FIFO order
+    // and returns how many there were; later pushes wait for the next call.
+    template<typename F>
+    size_t drain(F&& fn) {
+        Node* node = head_.exchange(nullptr, std::memory_order_seq_cst);
+
+        // The list is newest first
+        Node* oldest = nullptr;
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            node->next.store(oldest, std::memory_order_relaxed);
+            oldest = node;
+            node = next;
+        }
+
+        size_t count = 0;
+        while (oldest) {
+            Node* next = oldest->next.load(std::memory_order_relaxed);
+            T* value = oldest->value();
+            fn(std::move(*value));
+            value->~T();
+            releaseNode(oldest);
+            oldest = next;
+            ++count;
+        }
+        return count;
+    }
+
+    bool empty() const { return head_.load(std::memory_order_seq_cst) == nullptr; }
+
+    // Statistics
+    // Nodes ever allocated; stays flat once the pool covers the peak backlog
+    uint64_t getAllocatedNodes() const { return allocated_nodes_.load(std::memory_order_relaxed); }
+
+private:
+    struct Node {
+        alignas(T) unsigned char storage[sizeof(T)];
+        // Atomic because a pop holding a stale head reads it while the
+        // node's current owner may be writing it
+        std::atomic<Node*> next{nullptr};
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    static constexpr int VERSION_SHIFT = 48;
+    static constexpr uint64_t ADDRESS_MASK = (uint64_t{1} << VERSION_SHIFT) - 1;
+
+    static Node* address(uint64_t tagged) { return reinterpret_cast<Node*>(tagged & ADDRESS_MASK); }
+    static uint64_t tag(Node* node, uint64_t previous) {
+        return (((previous >> VERSION_SHIFT) + 1) << VERSION_SHIFT) | reinterpret_cast<uint64_t>(node);
+    }
+
+    Node* acquireNode() {
+        uint64_t head = free_head_.load(std::memory_order_acquire);
+        while (Node* node = address(head)) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            if (free_head_.compare_exchange_weak(head, tag(next, head), std::memory_order_acquire,
+                                                 std::memory_order_acquire)) {
+                return node;
+            }
+        }
+        allocated_nodes_.fetch_add(1, std::memory_order_relaxed);
+        return new Node;
+    }
+
+    void releaseNode(Node* node) {
+        uint64_t head = free_head_.load(std::memory_order_relaxed);
+        do {
+            node->next.store(address(head), std::memory_order_relaxed);
+        } while (!free_head_.compare_exchange_weak(head, tag(node, head), std::memory_order_release,
+                                                   std::memory_order_relaxed));
+    }
+
+    std::atomic<Node*> head_{nullptr};
+    // Tagged pointer to the newest free node
+    std::atomic<uint64_t> free_head_{0};
+
+    // Statistics
+    std::atomic<uint64_t> allocated_nodes_{0};
+};
+
+} // namespace securechat::utils
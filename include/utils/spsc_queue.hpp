@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace securechat::utils {
+
+// Bounded single-producer single-consumer ring. Each side keeps a cached copy
+// of the other side's index and only reloads it when the ring looks full or
+// holds less than a batch, and drain() publishes its progress once per batch, so a steady
+// stream costs roughly one shared cache-line transfer per batch rather than
+// per element. T must be default-constructible and movable.
+template<typename T>
+class SpscQueue {
+public:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    explicit SpscQueue(size_t capacity)
+        : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+        , slots_(std::make_unique<T[]>(mask_ + 1)) {
+    }
+
+    // Non-copyable, non-movable
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    SpscQueue(SpscQueue&&) = delete;
+    SpscQueue& operator=(SpscQueue&&) = delete;
+
+    // Producer side. Returns false, leaving value untouched, when full.
+    bool tryPush(T&& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Passes up to max_items elements to fn in FIFO order and
+    // returns how many were consumed.
+    template<typename F>
+    size_t drain(F&& fn, size_t max_items) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ - head < max_items) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+
+        size_t count = std::min(cached_tail_ - head, max_items);
+        for (size_t i = 0; i < count; ++i) {
+            T& slot = slots_[(head + i) & mask_];
+            fn(std::move(slot));
+            slot = T();
+        }
+        if (count > 0) {
+            head_.store(head + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Approximate from any thread, exact from the consumer
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    const size_t mask_;
+    const std::unique_ptr<T[]> slots_;
+
+    // Consumer-owned line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    size_t cached_tail_{0};
+
+    // Producer-owned line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    size_t cached_head_{0};
+};
+
+} // namespace securechat::utils
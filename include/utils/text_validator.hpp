@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace securechat::utils {
+
+enum class TextStatus : uint8_t {
+    VALID,
+    // Malformed, overlong, surrogate or out-of-range UTF-8
+    INVALID_UTF8,
+    // Well-formed, but contains a C0 control other than tab, LF and CR, DEL,
+    // or a C1 control (U+0080-U+009F)
+    CONTROL_CHARACTER
+};
+
+// Validates UTF-8 and looks for disallowed control characters in a single
+// pass. Invalid UTF-8 takes precedence when text has both problems.
+//
+// Dispatches at runtime to AVX2 (32 bytes per step) or SSSE3 (16 bytes)
+// where available, using the lookup-table validator of Keiser and Lemire:
+// three nibble lookups classify each byte pair, and a saturating compare of
+// the bytes two and three back checks continuation counts. Blocks of pure
+// ASCII skip the lookups. Other CPUs use the scalar decoder.
+TextStatus validateText(std::string_view text);
+
+// Individual implementations, for tests and benchmarks. The SIMD variants
+// fall back to the scalar one on CPUs without the instruction set.
+TextStatus validateTextScalar(std::string_view text);
+TextStatus validateTextSSSE3(std::string_view text);
+TextStatus validateTextAVX2(std::string_view text);
+
+} // namespace securechat::utils
@@ -0,0 +1,599 @@
+#include "core/client_connection.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace securechat::core {
+
+namespace {
+
+constexpr size_t RESUME_TOKEN_BYTES = 16;
+
+uint32_t getUint32(const char* data) {
+    auto bytes = reinterpret_cast<const unsigned char*>(data);
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+} // namespace
+
+#if defined(__GLIBCXX__) && UINTPTR_MAX == UINT64_MAX
+// The grouping the header describes: the hot, receive and send groups each
+// fill one cache line, and everything else starts on the fourth
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+struct ClientConnectionLayout {
+    using Connection = ClientConnection;
+    static constexpr size_t LINE = Connection::CACHE_LINE_SIZE;
+
+    static_assert(alignof(Connection) == LINE);
+    static_assert(offsetof(Connection, transport_) == 0);
+    static_assert(offsetof(Connection, rate_limiter_) + sizeof(Connection::rate_limiter_) == LINE);
+    static_assert(offsetof(Connection, messages_received_) == LINE);
+    static_assert(offsetof(Connection, partial_message_) + sizeof(Connection::partial_message_) == 2 * LINE);
+    static_assert(offsetof(Connection, messages_sent_) == 2 * LINE);
+    static_assert(offsetof(Connection, connect_time_) + sizeof(Connection::connect_time_) == 3 * LINE);
+    static_assert(offsetof(Connection, async_io_) == 3 * LINE);
+};
+#pragma GCC diagnostic pop
+#endif
+
+ClientConnection::ClientConnection(int socket_fd, uint64_t client_id)
+    : ClientConnection(std::make_unique<network::SocketTransport>(socket_fd), client_id) {
+}
+
+ClientConnection::ClientConnection(std::unique_ptr<network::Transport> transport, uint64_t client_id,
+                                   const utils::Clock& clock)
+    : transport_(std::move(transport))
+    , client_id_(client_id)
+    , clock_(clock)
+    , last_activity_(clock.now())
+    , connect_time_(clock.now()) {
+}
+
+ClientConnection::~ClientConnection() {
+    // The owner is tearing down; nobody is left to tell
+    handler_ = nullptr;
+    disconnect();
+    cleanup();
+}
+
+bool ClientConnection::initialize() {
+    if (!transport_ || !transport_->isOpen()) {
+        return false;
+    }
+    updateLastActivity();
+    return true;
+}
+
+void ClientConnection::start(network::AsyncIO* async_io) {
+    int fd = getNativeHandle();
+    if (fd < 0) {
+        transport_->setReadHandler([this]() { onReadable(); });
+        return;
+    }
+    if (!async_io) {
+        return;
+    }
+
+    // Set first: a handler may run, and disconnect, before watchSocket() returns
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        async_io_ = async_io;
+    }
+    bool watched = async_io->watchSocket(fd,
+        [this](size_t max_bytes) { return readTurn(max_bytes); },
+        [this]() {
+            if (!flushPendingWrites()) {
+                disconnect();
+            }
+        });
+    if (!watched) {
+        logger().warn("Failed to register client {} for readiness", client_id_);
+        {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            async_io_ = nullptr;
+        }
+        disconnect();
+    }
+}
+
+void ClientConnection::disconnect() {
+    if (shutdown_requested_.exchange(true)) {
+        return;
+    }
+    setState(ClientState::DISCONNECTING);
+
+    // Deregister before closing, so a reused fd is never touched on our
+    // behalf. Only start() and this call write async_io_, and start() has
+    // returned by the time anything can disconnect.
+    if (async_io_) {
+        async_io_->removeSocket(getNativeHandle());
+    }
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        async_io_ = nullptr;
+        if (transport_) {
+            transport_->close();
+        }
+        message_queue_.reset();
+    }
+    setState(ClientState::DISCONNECTED);
+
+    if (handler_) {
+        handler_->onDisconnect(*this);
+    }
+}
+
+bool ClientConnection::onReadable() {
+    if (!transport_) {
+        return false;
+    }
+    readTurn(std::numeric_limits<size_t>::max());
+    return !shutdown_requested_.load();
+}
+
+network::ReadTurn ClientConnection::readTurn(size_t max_bytes) {
+    network::ReadTurn turn;
+    if (shutdown_requested_.load() || !transport_) {
+        return turn;
+    }
+    if (!receive_buffer_) {
+        receive_buffer_ = receiveBufferPool().acquire();
+    }
+
+    // In-process transports report no writability, so queued bytes go out
+    // whenever the peer is heard from
+    if (!flushPendingWrites()) {
+        disconnect();
+        return turn;
+    }
+
+    while (turn.bytes < max_bytes) {
+        size_t length = std::min(receive_buffer_.size(), max_bytes - turn.bytes);
+        int64_t received = transport_->read(receive_buffer_.data(), length);
+        if (received == 0) {
+            return turn;
+        }
+        if (received < 0) {
+            disconnect();
+            return turn;
+        }
+
+        turn.bytes += static_cast<size_t>(received);
+        updateLastActivity();
+        getTableRow().addBytesIn(static_cast<uint64_t>(received));
+        if (!processIncomingData(static_cast<size_t>(received)) || shutdown_requested_.load()) {
+            disconnect();
+            return turn;
+        }
+    }
+    turn.drained = false;
+    return turn;
+}
+
+bool ClientConnection::processIncomingData(size_t length) {
+    std::lock_guard<std::mutex> lock(frames_mutex_);
+    frames_owner_.store(std::this_thread::get_id());
+    bool processed = processFrames(std::string_view(receive_buffer_.data(), length));
+    frames_owner_.store(std::thread::id());
+    return processed;
+}
+
+bool ClientConnection::processFrames(std::string_view data) {
+    // Frames are handled in place in the receive block; only a frame split
+    // across reads, or frames that arrive behind a pending AUTH, are
+    // assembled in partial_message_
+    bool pending = auth_progress_.load() == AuthProgress::PENDING;
+    if (pending && partial_message_.size() + data.size() > MAX_PENDING_AUTH_BYTES) {
+        logger().warn("Client {} sent more than {} bytes before authentication completed", client_id_,
+                      MAX_PENDING_AUTH_BYTES);
+        return false;
+    }
+    if (!partial_message_.empty() || pending) {
+        partial_message_.append(data);
+        data = partial_message_;
+    }
+    if (pending) {
+        return true;
+    }
+
+    size_t consumed = 0;
+    while (data.size() - consumed >= network::ProtocolHandler::HEADER_SIZE) {
+        const char* header = data.data() + consumed;
+        size_t payload_size = getUint32(header);
+        if (payload_size > network::ProtocolHandler::DEFAULT_MAX_FRAME_SIZE) {
+            logger().warn("Client {} sent a {} byte frame", client_id_, payload_size);
+            return false;
+        }
+        size_t frame_size = network::ProtocolHandler::HEADER_SIZE + payload_size;
+        if (data.size() - consumed < frame_size) {
+            break;
+        }
+
+        network::Frame frame{static_cast<network::FrameType>(header[4]),
+                             data.substr(consumed + network::ProtocolHandler::HEADER_SIZE, payload_size)};
+        consumed += frame_size;
+        if (!handleFrame(frame) || shutdown_requested_.load()) {
+            return false;
+        }
+        if (auth_progress_.load() == AuthProgress::PENDING) {
+            break;
+        }
+    }
+
+    if (data.data() == partial_message_.data()) {
+        partial_message_.erase(0, consumed);
+    } else {
+        partial_message_.assign(data.substr(consumed));
+    }
+    return true;
+}
+
+bool ClientConnection::handleFrame(const network::Frame& frame) {
+    switch (frame.type) {
+        case network::FrameType::KEY_EXCHANGE: {
+            // Session keys are set once; the send path reads them unlocked
+            if (encryption_) {
+                return false;
+            }
+            auto encryption = std::make_unique<crypto::EncryptionManager>();
+            if (!encryption->initialize() || !encryption->generateEphemeralKeys() ||
+                !encryption->exchangeKeys(std::string(frame.payload))) {
+                logger().warn("Key exchange with client {} failed", client_id_);
+                return false;
+            }
+            std::string public_key = encryption->getPublicKey();
+            encryption_ = std::move(encryption);
+            setState(ClientState::AUTHENTICATING);
+            return sendFrame(network::FrameType::KEY_EXCHANGE, public_key);
+        }
+
+        case network::FrameType::AUTH:
+            if (!encryption_ || auth_progress_.load() != AuthProgress::NONE) {
+                return false;
+            }
+            return authenticate(std::string(frame.payload));
+
+        case network::FrameType::JOIN_ROOM: {
+            uint64_t room_id = 0;
+            if (!isAuthenticated() || !network::ProtocolHandler::parseJoinRoom(frame.payload, room_id)) {
+                return false;
+            }
+            if (handler_) {
+                handler_->onJoinRoom(*this, room_id);
+            }
+            return true;
+        }
+
+        case network::FrameType::DATA: {
+            if (!isAuthenticated()) {
+                return false;
+            }
+            // Over the limit is dropped, not fatal
+            if (!checkRateLimit()) {
+                return true;
+            }
+            if (!encryption_->decrypt(frame.payload, plaintext_) || plaintext_.empty()) {
+                logger().debug("Dropping undecryptable record from client {}", client_id_);
+                return true;
+            }
+            messages_received_.fetch_add(1, std::memory_order_relaxed);
+            if (handler_) {
+                handler_->onMessage(*this, plaintext_);
+            }
+            return true;
+        }
+
+        case network::FrameType::PING:
+            return sendFrame(network::FrameType::PONG, frame.payload);
+
+        case network::FrameType::ACK: {
+            uint64_t sequence = 0;
+            if (!isAuthenticated() || !network::ProtocolHandler::parseAck(frame.payload, sequence)) {
+                return false;
+            }
+            openRetransmitWindow();
+            acknowledge(sequence);
+            return true;
+        }
+
+        case network::FrameType::RESUME: {
+            uint64_t acknowledged = 0;
+            std::string_view token;
+            if (!isAuthenticated() || !network::ProtocolHandler::parseResume(frame.payload, acknowledged, token)) {
+                return false;
+            }
+            openRetransmitWindow();
+            if (handler_) {
+                handler_->onResume(*this, token, acknowledged);
+            }
+            return true;
+        }
+
+        case network::FrameType::PONG:
+            return true;
+
+        default:
+            logger().warn("Client {} sent unexpected frame type {}", client_id_, static_cast<int>(frame.type));
+            return false;
+    }
+}
+
+bool ClientConnection::authenticate(const std::string& credentials) {
+    std::string_view username;
+    std::string_view secret;
+    if (!network::ProtocolHandler::parseAuth(credentials, username, secret)) {
+        return false;
+    }
+
+    auth_progress_.store(AuthProgress::PENDING);
+    std::string user(username);
+    if (handler_) {
+        handler_->authenticateAsync(*this, user, std::string(secret), [this, user](network::AuthStatus status) {
+            completeAuthentication(user, status);
+        });
+    } else {
+        completeAuthentication(user, network::AuthStatus::INVALID_CREDENTIALS);
+    }
+    // Answered inline, the rest of this read is handled by the caller
+    return auth_progress_.load() != AuthProgress::FAILED;
+}
+
+void ClientConnection::completeAuthentication(const std::string& username, network::AuthStatus status) {
+    std::string result;
+    bool authenticated = status == network::AuthStatus::OK;
+    if (!authenticated) {
+        network::ProtocolHandler::appendAuthResult(result, status, "authentication failed");
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        writeLocked(utils::MessageBuffer(result));
+    } else {
+        user_id_ = username;
+        resume_token_ = crypto::EncryptionManager::bytesToHex(
+            crypto::EncryptionManager::generateRandomBytes(RESUME_TOKEN_BYTES));
+
+        // The state flips under the send lock just before the result is
+        // written: a broadcast that picks this connection waits for the
+        // lock, so none overtakes the result on the wire, and none sent
+        // after the peer has seen it skips this connection
+        network::ProtocolHandler::appendAuthResult(result, network::AuthStatus::OK, resume_token_);
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        setAuthenticated(true);
+        authenticated = writeLocked(utils::MessageBuffer(result));
+    }
+    auth_progress_.store(authenticated ? AuthProgress::DONE : AuthProgress::FAILED);
+
+    // Inline, the reading thread still holds the frames and carries on
+    if (frames_owner_.load() == std::this_thread::get_id()) {
+        return;
+    }
+    if (authenticated) {
+        std::lock_guard<std::mutex> lock(frames_mutex_);
+        authenticated = !shutdown_requested_.load() && processFrames(std::string_view()) &&
+                        !shutdown_requested_.load();
+    }
+    if (!authenticated) {
+        disconnect();
+    }
+}
+
+void ClientConnection::setAuthenticated(bool authenticated) {
+    setState(authenticated ? ClientState::AUTHENTICATED : ClientState::AUTHENTICATING);
+}
+
+bool ClientConnection::checkRateLimit() {
+    if (!rate_limiter_) {
+        rate_limiter_ = std::make_unique<security::RateLimiter>(
+            handler_ ? handler_->getRateLimit() : security::RateLimitConfig{}, clock_);
+    }
+    return rate_limiter_->tryAcquire();
+}
+
+bool ClientConnection::sendMessage(const std::string& message) {
+    return sendEncryptedMessage(utils::MessageBuffer(message));
+}
+
+bool ClientConnection::sendEncryptedMessage(const utils::MessageBuffer& message) {
+    // Authentication happens after the key exchange, so the keys are set
+    if (state_.load() != ClientState::AUTHENTICATED) {
+        return false;
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (shutdown_requested_.load()) {
+            return false;
+        }
+        crypto::EncryptedRecord record = encryption_->encrypt(message);
+        sent = !record.empty();
+        if (sent) {
+            recordSent(record.getSequence(), message);
+            sent = writeLocked(record.buffer());
+        }
+    }
+    if (!sent) {
+        disconnect();
+        return false;
+    }
+    messages_sent_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ClientConnection::sendFrame(network::FrameType type, std::string_view payload) {
+    std::string frame;
+    network::ProtocolHandler::appendFrame(frame, type, payload);
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    return writeLocked(utils::MessageBuffer(frame));
+}
+
+bool ClientConnection::flushPendingWrites() {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    return drainLocked();
+}
+
+bool ClientConnection::drainLocked() {
+    if (!message_queue_) {
+        return true;
+    }
+    while (!message_queue_->empty()) {
+        int64_t written = transport_->write(message_queue_->frontData(), message_queue_->frontSize());
+        if (written < 0) {
+            return false;
+        }
+        if (written == 0) {
+            break;
+        }
+        getTableRow().addBytesOut(static_cast<uint64_t>(written));
+        message_queue_->consume(static_cast<size_t>(written));
+    }
+    getTableRow().setQueueDepth(static_cast<uint32_t>(message_queue_->size()));
+    // Drained queues are not kept around on idle connections
+    if (message_queue_->empty()) {
+        message_queue_.reset();
+    }
+    return true;
+}
+
+bool ClientConnection::writeLocked(utils::MessageBuffer bytes) {
+    if (!transport_ || !transport_->isOpen()) {
+        return false;
+    }
+
+    size_t written = 0;
+    if (!message_queue_) {
+        int64_t result = transport_->write(bytes.data(), bytes.size());
+        if (result < 0) {
+            return false;
+        }
+        written = static_cast<size_t>(result);
+        getTableRow().addBytesOut(written);
+        if (written == bytes.size()) {
+            return true;
+        }
+        message_queue_ = std::make_unique<network::MessageQueue>();
+    }
+
+    message_queue_->push(std::move(bytes));
+    message_queue_->consume(written);
+    if (message_queue_->bytes() > MAX_QUEUED_BYTES) {
+        logger().warn("Client {} has {} bytes unread; disconnecting", client_id_, message_queue_->bytes());
+        return false;
+    }
+    return drainLocked();
+}
+
+bool ClientConnection::trimIdle(utils::Clock::time_point now, utils::Clock::duration idle_after) {
+    const auto idle_since = now - idle_after;
+    if (last_activity_.load(std::memory_order_relaxed) > idle_since) {
+        return false;
+    }
+
+    network::AsyncIO* async_io;
+    int fd;
+    std::shared_ptr<RetransmitWindow> window;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (shutdown_requested_.load()) {
+            return false;
+        }
+        async_io = async_io_;
+        fd = getNativeHandle();
+        window = retransmit_window_;
+    }
+    bool trimmed = window && window->releaseIfEmpty();
+
+    // Receive-path state; traffic may have arrived since the check above,
+    // and a late AUTH answer may be handling frames
+    auto trim = [this, idle_since, &trimmed]() {
+        std::unique_lock<std::mutex> frames(frames_mutex_, std::try_to_lock);
+        if (!frames || last_activity_.load(std::memory_order_relaxed) > idle_since) {
+            return;
+        }
+        if (receive_buffer_ && partial_message_.empty()) {
+            receive_buffer_.reset();
+            trimmed = true;
+        }
+        if (plaintext_.capacity() > std::string().capacity()) {
+            std::string().swap(plaintext_);
+            trimmed = true;
+        }
+        if (rate_limiter_) {
+            rate_limiter_.reset();
+            trimmed = true;
+        }
+        if (encryption_ && encryption_->releaseHandshakeKeys()) {
+            trimmed = true;
+        }
+        if (encryption_ && encryption_->releaseRecordContexts()) {
+            trimmed = true;
+        }
+    };
+    if (async_io && fd >= 0) {
+        async_io->runExclusive(fd, trim);
+    } else {
+        trim();
+    }
+    return trimmed;
+}
+
+size_t ClientConnection::getResidentBytes() const {
+    size_t bytes = sizeof(*this);
+    network::AsyncIO* async_io;
+    int fd;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (message_queue_) {
+            bytes += sizeof(network::MessageQueue) + message_queue_->bytes();
+        }
+        async_io = async_io_;
+        fd = getNativeHandle();
+        if (retransmit_window_) {
+            bytes += retransmit_window_->getResidentBytes();
+        }
+    }
+
+    auto count = [this, &bytes]() {
+        if (receive_buffer_) {
+            bytes += receive_buffer_.size();
+        }
+        if (partial_message_.capacity() > std::string().capacity()) {
+            bytes += partial_message_.capacity();
+        }
+        if (plaintext_.capacity() > std::string().capacity()) {
+            bytes += plaintext_.capacity();
+        }
+        if (rate_limiter_) {
+            bytes += sizeof(security::RateLimiter);
+        }
+        if (encryption_) {
+            bytes += encryption_->getResidentBytes();
+        }
+    };
+    // A connection busy in its handler right now is active; count its block
+    if (async_io && fd >= 0) {
+        if (!async_io->runExclusive(fd, count)) {
+            bytes += BUFFER_SIZE;
+        }
+    } else {
+        count();
+    }
+    return bytes;
+}
+
+void ClientConnection::updateLastActivity() {
+    auto now = clock_.now();
+    last_activity_.store(now, std::memory_order_relaxed);
+    getTableRow().touch(now);
+}
+
+void ClientConnection::cleanup() {
+    receive_buffer_.reset();
+    std::string().swap(partial_message_);
+    std::string().swap(plaintext_);
+}
+
+} // namespace securechat::core
@@ -0,0 +1,219 @@
+#include "core/connection_table.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace securechat::core {
+
+ConnectionTable::ReadGuard::ReadGuard(const ConnectionTable& table) {
+    // Threads start probing at different reader slots so that guards opened
+    // together rarely contend for the same one
+    thread_local const size_t hint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    for (;;) {
+        for (size_t i = 0; i < READER_SLOTS; ++i) {
+            auto& reader = table.readers_[(hint + i) % READER_SLOTS].epoch;
+            uint64_t idle = IDLE_EPOCH;
+            uint64_t epoch = table.epoch_.load();
+            if (!reader.compare_exchange_strong(idle, epoch)) {
+                continue;
+            }
+            // reclaim() may have scanned before the announcement was made, so
+            // recheck the epoch after making it. If a remove() advanced it in
+            // between, re-announce: resolve() is then ordered after that
+            // removal and rejects its handles.
+            uint64_t current;
+            while ((current = table.epoch_.load()) != epoch) {
+                reader.store(current);
+                epoch = current;
+            }
+            reader_ = &reader;
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+ConnectionTable::ConnectionTable(size_t capacity)
+    : capacity_(std::min<size_t>(capacity, INVALID_SLOT)),
+      state_(std::make_unique<std::atomic<ClientState>[]>(capacity_)),
+      room_(std::make_unique<std::atomic<uint64_t>[]>(capacity_)),
+      last_activity_(std::make_unique<std::atomic<int64_t>[]>(capacity_)),
+      queue_depth_(std::make_unique<std::atomic<uint32_t>[]>(capacity_)),
+      bytes_in_(std::make_unique<std::atomic<uint64_t>[]>(capacity_)),
+      bytes_out_(std::make_unique<std::atomic<uint64_t>[]>(capacity_)),
+      unacked_messages_(std::make_unique<std::atomic<uint32_t>[]>(capacity_)),
+      unacked_bytes_(std::make_unique<std::atomic<uint64_t>[]>(capacity_)),
+      generation_(std::make_unique<std::atomic<uint32_t>[]>(capacity_)),
+      objects_(std::make_unique<std::atomic<ClientConnection*>[]>(capacity_)),
+      readers_(std::make_unique<Reader[]>(READER_SLOTS)),
+      live_(capacity_, 0),
+      client_ids_(capacity_, 0),
+      connections_(capacity_) {
+    index_.reserve(capacity_);
+    free_slots_.reserve(capacity_);
+    retired_.reserve(capacity_);
+}
+
+ConnectionTable::Slot ConnectionTable::insert(uint64_t client_id, std::shared_ptr<ClientConnection> connection,
+                                              ClientState state, TimePoint now) {
+    if (!connection || index_.count(client_id) > 0) {
+        return INVALID_SLOT;
+    }
+
+    // Out of slots: removed ones may be free by now, without waiting for
+    // the owner's next sweep
+    if (free_slots_.empty() && high_water_ == capacity_) {
+        reclaim();
+    }
+
+    Slot slot;
+    if (!free_slots_.empty()) {
+        // Lowest freed slots first keeps live rows packed below high_water_
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    } else if (high_water_ < capacity_) {
+        slot = high_water_++;
+    } else {
+        return INVALID_SLOT;
+    }
+
+    state_[slot].store(state, std::memory_order_relaxed);
+    room_[slot].store(0, std::memory_order_relaxed);
+    last_activity_[slot].store(now.time_since_epoch().count(), std::memory_order_relaxed);
+    queue_depth_[slot].store(0, std::memory_order_relaxed);
+    bytes_in_[slot].store(0, std::memory_order_relaxed);
+    bytes_out_[slot].store(0, std::memory_order_relaxed);
+    unacked_messages_[slot].store(0, std::memory_order_relaxed);
+    unacked_bytes_[slot].store(0, std::memory_order_relaxed);
+    live_[slot] = 1;
+    client_ids_[slot] = client_id;
+    // The slot's generation already moved past every handle to the previous
+    // occupant, so a resolve() racing this store rejects both objects
+    objects_[slot].store(connection.get(), std::memory_order_release);
+    connections_[slot] = std::move(connection);
+    index_.emplace(client_id, slot);
+    return slot;
+}
+
+std::shared_ptr<ClientConnection> ConnectionTable::remove(Slot slot) {
+    if (slot >= high_water_ || !live_[slot]) {
+        return nullptr;
+    }
+
+    index_.erase(client_ids_[slot]);
+    live_[slot] = 0;
+    // Cleared before the generation moves on, so the new generation never
+    // names the removed object, even before the slot's next insert()
+    objects_[slot].store(nullptr, std::memory_order_relaxed);
+    generation_[slot].fetch_add(1, std::memory_order_release);
+    state_[slot].store(ClientState::DISCONNECTED, std::memory_order_relaxed);
+    // Guards announcing this epoch or an earlier one may have resolved the
+    // connection; guards opened from here on see the new generation
+    retired_.push_back({slot, epoch_.fetch_add(1)});
+    // The table keeps its reference until the slot is freed
+    return connections_[slot];
+}
+
+void ConnectionTable::reclaim() {
+    if (retired_.empty()) {
+        return;
+    }
+    const uint64_t oldest_reader = oldestReaderEpoch();
+    bool freed = false;
+    auto kept = std::remove_if(retired_.begin(), retired_.end(), [&](const Retired& retired) {
+        // Whoever else holds the connection may still be writing through
+        // its Row; the slot is only reused once the table's is the last
+        // reference
+        if (retired.epoch >= oldest_reader || connections_[retired.slot].use_count() > 1) {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        connections_[retired.slot].reset();
+        free_slots_.push_back(retired.slot);
+        freed = true;
+        return true;
+    });
+    retired_.erase(kept, retired_.end());
+    if (freed) {
+        std::sort(free_slots_.begin(), free_slots_.end(), std::greater<Slot>());
+    }
+}
+
+uint64_t ConnectionTable::oldestReaderEpoch() const {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (size_t i = 0; i < READER_SLOTS; ++i) {
+        uint64_t epoch = readers_[i].epoch.load();
+        if (epoch != IDLE_EPOCH) {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+    return oldest;
+}
+
+void ConnectionTable::clear() {
+    for (Slot slot = 0; slot < high_water_; ++slot) {
+        live_[slot] = 0;
+        generation_[slot].fetch_add(1, std::memory_order_release);
+        objects_[slot].store(nullptr, std::memory_order_relaxed);
+        connections_[slot].reset();
+        state_[slot].store(ClientState::DISCONNECTED, std::memory_order_relaxed);
+    }
+    index_.clear();
+    free_slots_.clear();
+    retired_.clear();
+    high_water_ = 0;
+}
+
+ConnectionTable::Slot ConnectionTable::find(uint64_t client_id) const {
+    auto it = index_.find(client_id);
+    return it == index_.end() ? INVALID_SLOT : it->second;
+}
+
+std::vector<ConnectionTable::Slot> ConnectionTable::collectDisconnected() const {
+    std::vector<Slot> slots;
+    for (Slot slot = 0; slot < high_water_; ++slot) {
+        ClientState state = state_[slot].load(std::memory_order_relaxed);
+        if ((state == ClientState::DISCONNECTING || state == ClientState::DISCONNECTED) && live_[slot]) {
+            slots.push_back(slot);
+        }
+    }
+    return slots;
+}
+
+std::vector<ConnectionTable::Slot> ConnectionTable::collectIdleSince(TimePoint cutoff) const {
+    const int64_t cutoff_ticks = cutoff.time_since_epoch().count();
+    std::vector<Slot> slots;
+    for (Slot slot = 0; slot < high_water_; ++slot) {
+        if (last_activity_[slot].load(std::memory_order_relaxed) <= cutoff_ticks && live_[slot]) {
+            slots.push_back(slot);
+        }
+    }
+    return slots;
+}
+
+ConnectionTable::Totals ConnectionTable::sumColumns() const {
+    Totals totals;
+    totals.connections = index_.size();
+    for (Slot slot = 0; slot < high_water_; ++slot) {
+        if (!live_[slot]) {
+            continue;
+        }
+        if (state_[slot].load(std::memory_order_relaxed) == ClientState::AUTHENTICATED) {
+            ++totals.authenticated;
+        }
+        uint32_t depth = queue_depth_[slot].load(std::memory_order_relaxed);
+        totals.queue_depth += depth;
+        totals.max_queue_depth = std::max(totals.max_queue_depth, depth);
+        totals.bytes_in += bytes_in_[slot].load(std::memory_order_relaxed);
+        totals.bytes_out += bytes_out_[slot].load(std::memory_order_relaxed);
+        uint32_t unacked = unacked_messages_[slot].load(std::memory_order_relaxed);
+        totals.unacked_messages += unacked;
+        totals.max_unacked_messages = std::max(totals.max_unacked_messages, unacked);
+        totals.unacked_bytes += unacked_bytes_[slot].load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+} // namespace securechat::core
@@ -0,0 +1,243 @@
+#include "core/event_loop.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace securechat::core {
+
+namespace {
+
+// Heap order for the timer list: earliest execute_time on top
+template<typename T>
+bool laterFirst(const T& a, const T& b) {
+    return a.execute_time > b.execute_time;
+}
+
+} // namespace
+
+EventLoop::EventLoop(network::AsyncIOConfig io_config)
+    : async_io_(std::make_unique<network::AsyncIO>(std::move(io_config)))
+    , logger_("EventLoop") {
+}
+
+EventLoop::~EventLoop() {
+    stop();
+    // Joins the reactor threads, also after a stop() from a task
+    async_io_.reset();
+#ifdef __linux__
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (timer_fd_ >= 0) {
+        close(timer_fd_);
+    }
+#endif
+}
+
+bool EventLoop::initialize() {
+#ifdef __linux__
+    if (wake_fd_ < 0) {
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    if (timer_fd_ < 0) {
+        timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    }
+    if (wake_fd_ < 0 || timer_fd_ < 0) {
+        logger_.error("Failed to create wake-up eventfd or timerfd");
+        return false;
+    }
+#endif
+
+    if (!async_io_->initialize()) {
+        logger_.error("Failed to initialize async I/O");
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    stop_requested_.store(false);
+
+#ifdef __linux__
+    // Both are read by their handlers at once, so a turn never has more to read
+    bool watched = async_io_->watchSocket(wake_fd_, [this](size_t) {
+        runBatch();
+        return network::ReadTurn{};
+    });
+    watched = async_io_->watchSocket(timer_fd_, [this](size_t) {
+        uint64_t expirations;
+        while (read(timer_fd_, &expirations, sizeof(expirations)) > 0) {
+        }
+        // Timers run in a batch like everything else
+        if (!wake_pending_.exchange(true, std::memory_order_seq_cst)) {
+            wakeups_++;
+            wake();
+        }
+        return network::ReadTurn{};
+    }) && watched;
+    if (!watched) {
+        logger_.error("Failed to register wake-up descriptors with the reactor");
+    }
+#endif
+    async_io_->start();
+
+    // Tasks posted before start() found wake_pending_ set and wrote nothing
+    wake_pending_.store(true);
+    wakeups_++;
+    wake();
+}
+
+void EventLoop::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    stop_requested_.store(true);
+#ifdef __linux__
+    // Waits for a batch running on another thread; from the batch itself it
+    // returns at once
+    async_io_->removeSocket(wake_fd_);
+    async_io_->removeSocket(timer_fd_);
+#endif
+    async_io_->stop();
+}
+
+void EventLoop::scheduleTask(std::function<void()> task) {
+    post({std::move(task), {}, std::chrono::milliseconds(0), false});
+}
+
+void EventLoop::scheduleDelayedTask(std::function<void()> task, std::chrono::milliseconds delay) {
+    post({std::move(task), std::chrono::steady_clock::now() + delay, std::chrono::milliseconds(0), false});
+}
+
+void EventLoop::schedulePeriodicTask(std::function<void()> task, std::chrono::milliseconds interval) {
+    interval = std::max(interval, std::chrono::milliseconds(1));
+    post({std::move(task), std::chrono::steady_clock::now() + interval, interval, true});
+}
+
+void EventLoop::post(ScheduledTask task) {
+    posted_tasks_.push(std::move(task));
+    // Only the first post after the loop announced a sleep pays for the write
+    if (!wake_pending_.exchange(true, std::memory_order_seq_cst)) {
+        wakeups_++;
+        wake();
+    }
+}
+
+void EventLoop::wake() {
+#ifdef __linux__
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = write(wake_fd_, &one, sizeof(one));
+#endif
+}
+
+void EventLoop::runBatch() {
+#ifdef __linux__
+    uint64_t value;
+    while (read(wake_fd_, &value, sizeof(value)) > 0) {
+    }
+#endif
+    if (stop_requested_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // A burst posted while the first snapshot ran is taken here rather than
+    // after another trip through the reactor
+    for (size_t round = 0; round < MAX_POSTED_ROUNDS; ++round) {
+        if (processPostedTasks() == 0 || posted_tasks_.empty()) {
+            break;
+        }
+    }
+    processScheduledTasks();
+    armTimer();
+
+    // Announce the batch is done, then look again: a producer either sees
+    // the flag clear and writes the eventfd, or pushed before it and is seen
+    // here. Leftovers go back through the reactor, so this thread's sockets
+    // are not kept waiting behind a steady stream of tasks.
+    wake_pending_.store(false, std::memory_order_seq_cst);
+    if (!posted_tasks_.empty() && !wake_pending_.exchange(true, std::memory_order_seq_cst)) {
+        wakeups_++;
+        wake();
+    }
+}
+
+size_t EventLoop::processPostedTasks() {
+    return posted_tasks_.drain([this](ScheduledTask&& posted) {
+        if (posted.periodic || posted.execute_time != std::chrono::steady_clock::time_point{}) {
+            scheduled_tasks_.push_back(std::move(posted));
+            std::push_heap(scheduled_tasks_.begin(), scheduled_tasks_.end(), laterFirst<ScheduledTask>);
+            return;
+        }
+
+        try {
+            posted.task();
+        } catch (const std::exception& e) {
+            logger_.error("Task threw: {}", e.what());
+        } catch (...) {
+            logger_.error("Task threw a non-standard exception");
+        }
+        processed_events_++;
+    });
+}
+
+size_t EventLoop::processScheduledTasks() {
+    auto now = std::chrono::steady_clock::now();
+    size_t ran = 0;
+    while (!scheduled_tasks_.empty() && scheduled_tasks_.front().execute_time <= now) {
+        std::pop_heap(scheduled_tasks_.begin(), scheduled_tasks_.end(), laterFirst<ScheduledTask>);
+        ScheduledTask due = std::move(scheduled_tasks_.back());
+        scheduled_tasks_.pop_back();
+
+        try {
+            due.task();
+        } catch (const std::exception& e) {
+            logger_.error("Scheduled task threw: {}", e.what());
+        } catch (...) {
+            logger_.error("Scheduled task threw a non-standard exception");
+        }
+        processed_events_++;
+        ran++;
+
+        if (due.periodic) {
+            // Skip missed ticks rather than running them back to back
+            due.execute_time += due.interval;
+            if (due.execute_time <= now) {
+                due.execute_time = now + due.interval;
+            }
+            scheduled_tasks_.push_back(std::move(due));
+            std::push_heap(scheduled_tasks_.begin(), scheduled_tasks_.end(), laterFirst<ScheduledTask>);
+        }
+    }
+    return ran;
+}
+
+void EventLoop::armTimer() {
+#ifdef __linux__
+    if (scheduled_tasks_.empty() && !timer_armed_) {
+        return;
+    }
+    // An absolute deadline already past fires at once; all zero disarms
+    itimerspec spec{};
+    if (!scheduled_tasks_.empty()) {
+        auto deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            scheduled_tasks_.front().execute_time.time_since_epoch()).count();
+        spec.it_value.tv_sec = static_cast<time_t>(deadline / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(deadline % 1000000000);
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1;
+        }
+    }
+    timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+    timer_armed_ = !scheduled_tasks_.empty();
+#endif
+}
+
+} // namespace securechat::core
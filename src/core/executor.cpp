@@ -0,0 +1,198 @@
+#include "core/executor.hpp"
+
+#include <algorithm>
+
+namespace securechat::core {
+
+namespace {
+
+// Weight of the newest sample in the smoothed queue delay, as 1/N
+constexpr int64_t DELAY_SMOOTHING = 8;
+
+} // namespace
+
+Executor::Executor(ExecutorConfig config)
+    : config_([&config]() {
+        config.max_threads = std::max<size_t>(1, config.max_threads);
+        config.min_threads = config.run_inline ? 0 : std::min(config.min_threads, config.max_threads);
+        return std::move(config);
+    }())
+    , last_sample_(Clock::now())
+    , logger_("Executor") {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < config_.min_threads; ++i) {
+        workers_.emplace_back();
+        Worker* worker = &workers_.back();
+        worker->thread = std::thread(&Executor::workerLoop, this, worker);
+    }
+    thread_count_.store(config_.min_threads);
+}
+
+Executor::~Executor() {
+    stop();
+}
+
+bool Executor::submit(std::function<void()> task) {
+    if (config_.run_inline) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return false;
+            }
+        }
+        QueuedTask queued{std::move(task), Clock::now()};
+        runTask(queued);
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return false;
+        }
+
+        auto now = Clock::now();
+        queue_.push_back({std::move(task), now});
+
+        // Nobody to run it, or the oldest task has already waited too long
+        if (idle_workers_ == 0 &&
+            (thread_count_.load() == 0 || now - queue_.front().enqueued > config_.target_queue_delay ||
+             getQueueDelay() > config_.target_queue_delay)) {
+            growLocked(now);
+        }
+    }
+    condition_.notify_one();
+    return true;
+}
+
+void Executor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+        // Queued tasks must still run even if every thread had idled out
+        if (thread_count_.load() == 0 && !queue_.empty()) {
+            workers_.emplace_back();
+            Worker* worker = &workers_.back();
+            worker->thread = std::thread(&Executor::workerLoop, this, worker);
+            thread_count_.fetch_add(1);
+        }
+    }
+    condition_.notify_all();
+
+    // Workers never remove themselves from the list, so joining outside the
+    // lock is safe once stopping_ prevents growth
+    for (auto& worker : workers_) {
+        if (worker.thread.joinable()) {
+            worker.thread.join();
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    workers_.clear();
+    thread_count_.store(0);
+}
+
+size_t Executor::getQueueSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+double Executor::sampleUtilization() {
+    auto now = Clock::now();
+    int64_t busy = busy_ns_.load(std::memory_order_relaxed);
+    int64_t wall = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_sample_).count();
+    size_t threads = std::max<size_t>(1, getThreadCount());
+
+    double utilization = wall > 0 ? static_cast<double>(busy - last_busy_ns_) /
+                                        (static_cast<double>(wall) * static_cast<double>(threads))
+                                  : 0.0;
+    last_sample_ = now;
+    last_busy_ns_ = busy;
+    return std::clamp(utilization, 0.0, 1.0);
+}
+
+void Executor::workerLoop(Worker* self) {
+    if (!config_.cpus.empty()) {
+        utils::setThreadAffinity(config_.cpus);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (queue_.empty()) {
+            if (stopping_) {
+                break;
+            }
+
+            idle_workers_++;
+            bool woke = condition_.wait_for(lock, config_.idle_timeout,
+                                            [this]() { return stopping_ || !queue_.empty(); });
+            idle_workers_--;
+
+            // Idle past the timeout: shrink toward min_threads
+            if (!woke && !stopping_ && thread_count_.load() > config_.min_threads) {
+                break;
+            }
+            continue;
+        }
+
+        QueuedTask queued = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        runTask(queued);
+        lock.lock();
+    }
+
+    self->finished = true;
+    thread_count_.fetch_sub(1);
+}
+
+void Executor::runTask(QueuedTask& queued) {
+    auto started = Clock::now();
+    recordDelay(started - queued.enqueued);
+    try {
+        queued.task();
+    } catch (const std::exception& e) {
+        logger_.error("{}: task threw: {}", config_.name, e.what());
+    } catch (...) {
+        logger_.error("{}: task threw a non-standard exception", config_.name);
+    }
+    busy_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count(),
+                       std::memory_order_relaxed);
+    tasks_completed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Executor::growLocked(Clock::time_point now) {
+    // Reap workers that idled out; their threads have already returned
+    for (auto it = workers_.begin(); it != workers_.end();) {
+        if (it->finished) {
+            it->thread.join();
+            it = workers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (workers_.size() >= config_.max_threads ||
+        (!workers_.empty() && now - last_growth_ < config_.target_queue_delay)) {
+        return;
+    }
+
+    workers_.emplace_back();
+    Worker* worker = &workers_.back();
+    worker->thread = std::thread(&Executor::workerLoop, this, worker);
+    thread_count_.fetch_add(1);
+    last_growth_ = now;
+    logger_.debug("{}: grew to {} threads, queue delay {}us", config_.name, workers_.size(),
+                  getQueueDelay().count());
+}
+
+// Workers update the average without a lock; a lost sample only slows it down
+void Executor::recordDelay(Clock::duration delay) {
+    int64_t sample = std::chrono::duration_cast<std::chrono::microseconds>(delay).count();
+    int64_t previous = queue_delay_us_.load(std::memory_order_relaxed);
+    queue_delay_us_.store(previous + (sample - previous) / DELAY_SMOOTHING, std::memory_order_relaxed);
+}
+
+} // namespace securechat::core
@@ -0,0 +1,132 @@
+#include "core/message_deduplicator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace securechat::core {
+
+namespace {
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline bool isJsonSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+} // namespace
+
+DeduplicationConfig DeduplicationConfig::fromConfig(const utils::ConfigManager& config) {
+    DeduplicationConfig result;
+    result.enabled = config.isDeduplicationEnabled();
+    result.window = std::chrono::seconds(std::max(1, config.getDeduplicationWindowSeconds()));
+    result.capacity = static_cast<size_t>(std::max(1, config.getDeduplicationCapacity()));
+    return result;
+}
+
+MessageDeduplicator::MessageDeduplicator(const DeduplicationConfig& config)
+    : window_ticks_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(config.window).count()),
+      stripe_capacity_(std::max<size_t>(1, (config.capacity + STRIPES - 1) / STRIPES)),
+      // At most half full, so probes stay short
+      mask_(std::bit_ceil(stripe_capacity_ * 2) - 1),
+      stripes_(std::make_unique<Stripe[]>(STRIPES)) {
+    for (size_t i = 0; i < STRIPES; ++i) {
+        stripes_[i].current = std::make_unique<uint64_t[]>(mask_ + 1);
+        stripes_[i].previous = std::make_unique<uint64_t[]>(mask_ + 1);
+    }
+}
+
+bool MessageDeduplicator::checkAndRecord(uint64_t sender_key, std::string_view message_id, TimePoint now) {
+    // Zero marks an empty slot
+    uint64_t fingerprint = mix64(std::hash<std::string_view>{}(message_id) ^ mix64(sender_key)) | 1;
+    // The top bits pick the stripe, the low bits the slot
+    Stripe& stripe = stripes_[fingerprint >> 60 & (STRIPES - 1)];
+    const int64_t now_ticks = now.time_since_epoch().count();
+
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (now_ticks - stripe.rotated_at >= window_ticks_) {
+        rotate(stripe, now_ticks);
+    }
+    if (contains(stripe.current.get(), mask_, fingerprint) || contains(stripe.previous.get(), mask_, fingerprint)) {
+        duplicates_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (stripe.current_size >= stripe_capacity_) {
+        early_rotations_.fetch_add(1, std::memory_order_relaxed);
+        rotate(stripe, now_ticks);
+    }
+    size_t slot = fingerprint & mask_;
+    while (stripe.current[slot] != 0) {
+        slot = (slot + 1) & mask_;
+    }
+    stripe.current[slot] = fingerprint;
+    ++stripe.current_size;
+    return false;
+}
+
+bool MessageDeduplicator::contains(const uint64_t* table, size_t mask, uint64_t fingerprint) {
+    for (size_t slot = fingerprint & mask; table[slot] != 0; slot = (slot + 1) & mask) {
+        if (table[slot] == fingerprint) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MessageDeduplicator::rotate(Stripe& stripe, int64_t now_ticks) {
+    // After two quiet windows neither generation is worth keeping
+    bool expired = now_ticks - stripe.rotated_at >= 2 * window_ticks_;
+    stripe.current.swap(stripe.previous);
+    std::fill_n(stripe.current.get(), mask_ + 1, 0);
+    if (expired) {
+        std::fill_n(stripe.previous.get(), mask_ + 1, 0);
+    }
+    stripe.current_size = 0;
+    stripe.rotated_at = now_ticks;
+}
+
+std::string_view MessageDeduplicator::extractMessageId(std::string_view message) {
+    size_t pos = 0;
+    while ((pos = message.find(MESSAGE_ID_FIELD, pos)) != std::string_view::npos) {
+        size_t end = pos + MESSAGE_ID_FIELD.size();
+        bool quoted = pos > 0 && message[pos - 1] == '"' && end < message.size() && message[end] == '"';
+        pos = end;
+        if (!quoted) {
+            continue;
+        }
+
+        size_t cursor = end + 1;
+        while (cursor < message.size() && isJsonSpace(message[cursor])) {
+            ++cursor;
+        }
+        if (cursor >= message.size() || message[cursor] != ':') {
+            continue;
+        }
+        ++cursor;
+        while (cursor < message.size() && isJsonSpace(message[cursor])) {
+            ++cursor;
+        }
+        if (cursor >= message.size() || message[cursor] != '"') {
+            return {};
+        }
+
+        size_t start = cursor + 1;
+        size_t close = message.find('"', start);
+        if (close == std::string_view::npos || close - start > MAX_MESSAGE_ID_LENGTH) {
+            return {};
+        }
+        std::string_view id = message.substr(start, close - start);
+        return id.find('\\') == std::string_view::npos ? id : std::string_view{};
+    }
+    return {};
+}
+
+} // namespace securechat::core
@@ -0,0 +1,149 @@
+#include "core/retransmit_window.hpp"
+
+#include <algorithm>
+
+namespace securechat::core {
+
+RetransmitWindow::RetransmitWindow(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)) {
+}
+
+bool RetransmitWindow::push(uint64_t sequence, utils::MessageBuffer message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool kept_all = size_ < capacity_;
+    if (!kept_all) {
+        ++overflows_;
+        popFront();
+    }
+    if (entries_.empty()) {
+        entries_.resize(capacity_);
+    }
+
+    Entry& entry = entries_[(head_ + size_) % capacity_];
+    entry.sequence = sequence;
+    bytes_ += message.size();
+    entry.message = std::move(message);
+    ++size_;
+    return kept_all;
+}
+
+size_t RetransmitWindow::acknowledge(uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence <= acknowledged_) {
+        // Duplicate or reordered ack
+        return 0;
+    }
+    acknowledged_ = sequence;
+
+    size_t trimmed = 0;
+    while (size_ > 0 && entries_[head_].sequence <= sequence) {
+        popFront();
+        ++trimmed;
+    }
+    return trimmed;
+}
+
+std::vector<utils::MessageBuffer> RetransmitWindow::drainAfter(uint64_t acknowledged) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<utils::MessageBuffer> messages;
+    messages.reserve(size_);
+    while (size_ > 0) {
+        Entry& entry = entries_[head_];
+        if (entry.sequence > acknowledged) {
+            messages.push_back(entry.message);
+        }
+        popFront();
+    }
+    acknowledged_ = std::max(acknowledged_, acknowledged);
+    return messages;
+}
+
+void RetransmitWindow::popFront() {
+    Entry& entry = entries_[head_];
+    bytes_ -= entry.message.size();
+    // Drops the reference now rather than when the slot is reused
+    entry.message = utils::MessageBuffer();
+    head_ = (head_ + 1) % capacity_;
+    --size_;
+}
+
+bool RetransmitWindow::releaseIfEmpty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size_ > 0 || entries_.empty()) {
+        return false;
+    }
+    std::vector<Entry>().swap(entries_);
+    head_ = 0;
+    return true;
+}
+
+size_t RetransmitWindow::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+size_t RetransmitWindow::getBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+size_t RetransmitWindow::getResidentBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sizeof(*this) + entries_.capacity() * sizeof(Entry) + bytes_;
+}
+
+uint64_t RetransmitWindow::getAcknowledged() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return acknowledged_;
+}
+
+uint64_t RetransmitWindow::getOverflows() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return overflows_;
+}
+
+ResumableWindows::ResumableWindows(std::chrono::seconds resume_timeout)
+    : resume_timeout_(resume_timeout) {
+}
+
+void ResumableWindows::park(const std::string& token, const std::string& user_id,
+                            std::shared_ptr<RetransmitWindow> window, TimePoint now) {
+    if (token.empty() || user_id.empty() || !window) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    windows_[token] = Parked{std::move(window), user_id, now + resume_timeout_};
+}
+
+std::shared_ptr<RetransmitWindow> ResumableWindows::claim(const std::string& token, const std::string& user_id,
+                                                          TimePoint now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = windows_.find(token);
+    if (it == windows_.end() || it->second.user_id != user_id) {
+        return nullptr;
+    }
+    auto parked = std::move(it->second);
+    windows_.erase(it);
+    return parked.expires > now ? std::move(parked.window) : nullptr;
+}
+
+size_t ResumableWindows::expire(TimePoint now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::erase_if(windows_, [now](const auto& entry) { return entry.second.expires <= now; });
+}
+
+size_t ResumableWindows::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return windows_.size();
+}
+
+size_t ResumableWindows::getBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (const auto& [token, parked] : windows_) {
+        bytes += parked.window->getBytes();
+    }
+    return bytes;
+}
+
+} // namespace securechat::core
@@ -1,13 +1,18 @@
 #include "core/server.hpp"
+#include "utils/text_validator.hpp"
 #include <algorithm>
 #include <chrono>
 
 namespace securechat::core {
 
-Server::Server(const utils::ConfigManager& config)
+Server::Server(const utils::ConfigManager& config, const utils::Clock& clock)
     : config_(config)
+    , clock_(clock)
+    // Shards keep their own tables
+    , connection_table_(config.isSharedNothingEnabled() ? 1
+                        : static_cast<size_t>(std::max(config.getMaxConnections(), 1)))
     , logger_("Server") {
-    start_time_ = std::chrono::steady_clock::now();
+    start_time_ = clock_.now();
 }
 
 Server::~Server() {
@@ -17,6 +22,39 @@ Server::~Server() {
 bool Server::initialize() {
     logger_.info("Initializing SecureChat Server");
 
+    // Topology and thread placement; threads inherit the mask of the scope
+    // they are started in
+    const auto& topology = utils::CpuTopology::system();
+    placement_ = utils::ThreadPlacement::fromConfig(config_, topology);
+    logger_.info("CPU topology: {}", topology.describe());
+    logger_.info("Thread placement: {}", placement_.describe());
+    for (const auto& warning : placement_.warnings) {
+        logger_.warn("CPU affinity: {}", warning);
+    }
+    busy_poll_ = network::BusyPollConfig::fromConfig(config_);
+    if (busy_poll_.enabled) {
+        logger_.info("Busy polling: spin up to {}us, SO_BUSY_POLL {}us",
+                     busy_poll_.max_spin.count(), busy_poll_.socket_busy_poll_us);
+    }
+
+    // Buffer memory is reserved before anything allocates from the pools, and
+    // a reservation that cannot be made stops startup rather than leaving
+    // the server to fault pages in under load
+    auto huge_pages = utils::HugePageConfig::fromConfig(config_);
+    if (huge_pages.enabled) {
+        utils::HugePageArena* arena = utils::HugePageArena::buffers();
+        if (!arena) {
+            auto reserved = std::make_unique<utils::HugePageArena>(huge_pages);
+            if (!reserved->reserve()) {
+                logger_.error("Failed to reserve huge page buffer arena: {}", reserved->getError());
+                return false;
+            }
+            arena = utils::HugePageArena::install(std::move(reserved));
+        }
+        logger_.info("Huge page buffer arena: {} MB{}", arena->getReservedBytes() / (1024 * 1024),
+                     arena->isLocked() ? ", locked" : "");
+    }
+
     try {
         // Initialize socket manager
         socket_manager_ = std::make_unique<network::SocketManager>(config_);
@@ -25,16 +63,67 @@ bool Server::initialize() {
             return false;
         }
 
-        // Initialize thread pool
-        int worker_threads = config_.getWorkerThreads();
-        if (worker_threads <= 0) {
-            worker_threads = std::thread::hardware_concurrency();
+        // Initialize executors. CPU work scales up to one thread per worker
+        // core; blocking work gets its own threads, off the worker cores.
+        auto idle_timeout = std::chrono::milliseconds(config_.getExecutorIdleTimeoutMs());
+        ExecutorConfig cpu;
+        cpu.name = "cpu";
+        cpu.max_threads = static_cast<size_t>(config_.getCpuExecutorMaxThreads());
+        if (cpu.max_threads == 0) {
+            cpu.max_threads = config_.getWorkerThreads() > 0 ? static_cast<size_t>(config_.getWorkerThreads())
+                : !placement_.workers.empty() ? placement_.workers.size()
+                : std::max(1u, std::thread::hardware_concurrency());
+        }
+        cpu.min_threads = config_.getCpuExecutorMinThreads() > 0
+            ? static_cast<size_t>(config_.getCpuExecutorMinThreads()) : std::max<size_t>(1, cpu.max_threads / 4);
+        cpu.target_queue_delay = std::chrono::microseconds(config_.getCpuExecutorQueueDelayUs());
+        cpu.idle_timeout = idle_timeout;
+        cpu.cpus = placement_.cpusFor(utils::ThreadRole::WORKER);
+        cpu.run_inline = config_.isInlineExecutionEnabled();
+        cpu_executor_ = std::make_unique<Executor>(cpu);
+
+        ExecutorConfig blocking;
+        blocking.name = "blocking";
+        blocking.min_threads = static_cast<size_t>(std::max(0, config_.getBlockingExecutorMinThreads()));
+        blocking.max_threads = static_cast<size_t>(std::max(1, config_.getBlockingExecutorMaxThreads()));
+        blocking.target_queue_delay = std::chrono::microseconds(config_.getBlockingExecutorQueueDelayUs());
+        blocking.idle_timeout = idle_timeout;
+        blocking.cpus = placement_.cpusFor(utils::ThreadRole::SERVICE);
+        blocking.run_inline = cpu.run_inline;
+        blocking_executor_ = std::make_unique<Executor>(blocking);
+        logger_.info("Initialized executors: cpu {}-{} threads, blocking {}-{} threads",
+                     cpu.min_threads, cpu.max_threads, blocking.min_threads, blocking.max_threads);
+
+        // Shared-nothing mode: one shard per worker core owns its connections
+        if (config_.isSharedNothingEnabled()) {
+            const auto& shard_cpus = placement_.enabled ? placement_.workers : utils::CpuSet{};
+            size_t shard_count = config_.getShardCount() > 0 ? static_cast<size_t>(config_.getShardCount())
+                : !shard_cpus.empty() ? shard_cpus.size()
+                : std::max(1u, std::thread::hardware_concurrency());
+            // The connection limit is split evenly between the shards
+            size_t max_connections = static_cast<size_t>(std::max(config_.getMaxConnections(), 1));
+            for (size_t i = 0; i < shard_count; ++i) {
+                shard_state_.push_back(std::make_unique<ShardState>((max_connections + shard_count - 1) / shard_count));
+            }
+            shards_ = std::make_unique<ShardedRuntime>(shard_count,
+                [this](Shard& shard, uint64_t client_id, uint64_t, const utils::MessageBuffer& message) {
+                    const auto& table = shard_state_[shard.getIndex()]->table;
+                    auto slot = table.find(client_id);
+                    if (slot != ConnectionTable::INVALID_SLOT && table.getState(slot) == ClientState::AUTHENTICATED) {
+                        table.get(slot)->sendEncryptedMessage(message);
+                    }
+                },
+                shard_cpus);
+            for (size_t i = 0; i < shard_count; ++i) {
+                shards_->post(i, [busy_poll = network::BusyPollConfig::fromConfig(config_, i)](Shard& shard) {
+                    shard.setBusyPoll(busy_poll);
+                });
+            }
+            logger_.info("Shared-nothing mode with {} shards", shard_count);
         }
-        thread_pool_ = std::make_unique<ThreadPool>(worker_threads);
-        logger_.info("Initialized thread pool with {} workers", worker_threads);
 
         // Initialize event loop
-        event_loop_ = std::make_unique<EventLoop>();
+        event_loop_ = std::make_unique<EventLoop>(network::AsyncIOConfig::fromConfig(config_));
         if (!event_loop_->initialize()) {
             logger_.error("Failed to initialize event loop");
             return false;
@@ -47,6 +136,55 @@ bool Server::initialize() {
             return false;
         }
 
+        // Initialize content filter
+        if (!config_.getEnabledPlugins().empty()) {
+            content_filter_ = std::make_unique<plugins::ContentFilter>(config_);
+            if (!content_filter_->initialize()) {
+                logger_.error("Failed to load content filter word lists");
+                return false;
+            }
+        }
+
+        // Drop client retries of messages already delivered. One striped
+        // table, shared by the shards: a user that reconnects lands on
+        // whichever shard its new connection hashes to, and its retry must
+        // still find the first attempt's id.
+        auto dedup_config = DeduplicationConfig::fromConfig(config_);
+        if (dedup_config.enabled) {
+            deduplicator_ = std::make_unique<MessageDeduplicator>(dedup_config);
+            logger_.info("Deduplicating message ids over {}s, {} KB", dedup_config.window.count(),
+                         deduplicator_->getMemoryUsage() / 1024);
+        }
+
+        // Keep unacknowledged messages per connection for replay on resume
+        if (config_.getRetransmitWindowSize() > 0) {
+            retransmit_window_size_ = static_cast<size_t>(config_.getRetransmitWindowSize());
+            resumable_windows_ = std::make_unique<ResumableWindows>(
+                std::chrono::seconds(std::max(1, config_.getResumeTimeoutSeconds())));
+        }
+
+        // Initialize spam detection
+        auto plugins = config_.getEnabledPlugins();
+        if (std::find(plugins.begin(), plugins.end(), "spam_detection") != plugins.end()) {
+            plugins::SpamDetectorConfig spam_config;
+            spam_config.hamming_radius = config_.getSpamHammingRadius();
+            spam_config.min_tokens = static_cast<size_t>(std::max(1, config_.getSpamMinTokens()));
+            spam_config.window = std::chrono::seconds(config_.getSpamWindowSeconds());
+            spam_config.user_threshold = config_.getSpamUserThreshold();
+            spam_config.room_threshold = config_.getSpamRoomThreshold();
+            spam_config.table_slots = static_cast<size_t>(config_.getSpamTableSlots());
+            // Shared by the shards, like deduplication: a user's windows must
+            // follow them to whichever shard their next connection lands on,
+            // and room windows see the room's traffic from every shard
+            spam_detector_ = std::make_unique<plugins::SpamDetector>(spam_config);
+        }
+
+        // Load message pipeline plugins
+        plugin_manager_ = std::make_unique<plugins::PluginManager>(config_);
+        if (!plugin_manager_->initialize()) {
+            logger_.warn("Some message pipeline plugins failed to load");
+        }
+
         // Initialize metrics collector
         if (config_.isMetricsEnabled()) {
             metrics_ = std::make_unique<utils::MetricsCollector>(config_);
@@ -77,29 +215,40 @@ void Server::start() {
         if (!socket_manager_->start()) {
             throw std::runtime_error("Failed to start socket manager");
         }
+        // Set before any thread that loops on it starts
+        running_.store(true);
 
-        // Start event loop
-        event_loop_->start();
+        // Start event loop and the accept thread on the reactor cores
+        {
+            utils::ScopedAffinity affinity(placement_.cpusFor(utils::ThreadRole::REACTOR));
+            event_loop_->start();
+            if (shards_) {
+                shards_->start();
+            }
+            accept_thread_ = std::thread(&Server::acceptConnections, this);
+        }
 
-        // Start background threads
-        accept_thread_ = std::thread(&Server::acceptConnections, this);
+        // Return idle connections to their minimal resident form
+        auto idle_trim = std::chrono::seconds(std::max(1, config_.getIdleTrimSeconds()));
+        event_loop_->schedulePeriodicTask([this]() { trimIdleClients(); },
+            std::max<std::chrono::milliseconds>(std::chrono::seconds(1), idle_trim / 2));
+
+        // Housekeeping and metrics stay off the message cores
+        utils::ScopedAffinity service_affinity(placement_.cpusFor(utils::ThreadRole::SERVICE));
         cleanup_thread_ = std::thread([this]() {
-            while (running_.load()) {
-                std::this_thread::sleep_for(std::chrono::seconds(30));
+            while (waitForBackgroundRun(std::chrono::seconds(30))) {
                 cleanupDisconnectedClients();
             }
         });
 
         if (metrics_) {
             metrics_thread_ = std::thread([this]() {
-                while (running_.load()) {
-                    std::this_thread::sleep_for(std::chrono::seconds(10));
+                while (waitForBackgroundRun(std::chrono::seconds(10))) {
                     updateMetrics();
                 }
             });
         }
 
-        running_.store(true);
         logger_.info("Server started successfully on port {}", config_.getPort());
 
     } catch (const std::exception& e) {
@@ -115,7 +264,11 @@ void Server::stop() {
     }
 
     logger_.info("Stopping SecureChat Server");
-    running_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(background_mutex_);
+        running_.store(false);
+    }
+    background_wakeup_.notify_all();
 
     // Stop accepting new connections
     if (socket_manager_) {
@@ -131,6 +284,15 @@ void Server::stop() {
     if (accept_thread_.joinable()) {
         accept_thread_.join();
     }
+    // Authentication answers from the blocking executor are posted to the
+    // shards or the CPU executor, so it finishes its queue before either
+    // stops
+    if (blocking_executor_) {
+        blocking_executor_->stop();
+    }
+    if (shards_) {
+        shards_->stop();
+    }
     if (cleanup_thread_.joinable()) {
         cleanup_thread_.join();
     }
@@ -138,85 +300,265 @@ void Server::stop() {
         metrics_thread_.join();
     }
 
-    // Disconnect all clients
+    // Queued sends resolve their handles against the table; let them finish
+    // before it is cleared
+    if (cpu_executor_) {
+        cpu_executor_->stop();
+    }
+
+    // Disconnect all clients. disconnect() waits out a handler running on
+    // the connection and reports back through removeClient(), so it is
+    // called without clients_mutex_ held.
+    std::vector<std::shared_ptr<ClientConnection>> clients;
+    auto collect = [&clients](ConnectionTable::Slot, const std::shared_ptr<ClientConnection>& client) {
+        clients.push_back(client);
+    };
+    {
+        std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+        connection_table_.forEach(collect);
+    }
+    // The shard threads have been joined, so their tables are ours now
+    for (auto& local : shard_state_) {
+        local->table.forEach(collect);
+    }
+    for (const auto& client : clients) {
+        client->disconnect();
+    }
     {
         std::unique_lock<std::shared_mutex> lock(clients_mutex_);
-        for (auto& [id, client] : clients_) {
-            client->disconnect();
-        }
-        clients_.clear();
+        connection_table_.clear();
+    }
+    for (auto& local : shard_state_) {
+        std::unique_lock<std::shared_mutex> lock(local->table_mutex);
+        local->table.clear();
+    }
+
+    // Nothing reads messages any more; unload the pipeline plugins
+    if (plugin_manager_) {
+        plugin_manager_->shutdown();
     }
 
     logger_.info("Server stopped");
 }
 
+bool Server::waitForBackgroundRun(std::chrono::seconds interval) {
+    std::unique_lock<std::mutex> lock(background_mutex_);
+    return !background_wakeup_.wait_for(lock, interval, [this]() { return !running_.load(); });
+}
+
 void Server::shutdown() {
     shutdown_requested_.store(true);
     stop();
 }
 
-void Server::addClient(std::shared_ptr<ClientConnection> client) {
+bool Server::addClient(std::shared_ptr<ClientConnection> client) {
     if (!client) {
-        return;
+        return false;
     }
 
     std::unique_lock<std::shared_mutex> lock(clients_mutex_);
-    clients_[client->getId()] = client;
+    auto slot = connection_table_.insert(client->getId(), client, client->getState(), clock_.now());
+    if (slot == ConnectionTable::INVALID_SLOT) {
+        logger_.warn("Rejecting client {}: {} of {} connection slots in use",
+                     client->getId(), connection_table_.size(), connection_table_.capacity());
+        if (metrics_) {
+            metrics_->incrementCounter("clients_rejected_total");
+        }
+        return false;
+    }
+    client->attachToTable(connection_table_, slot);
+    if (resumable_windows_) {
+        client->enableRetransmitWindow(retransmit_window_size_);
+    }
     
     logger_.info("Client {} connected. Total clients: {}", 
-                client->getId(), clients_.size());
+                client->getId(), connection_table_.size());
 
     if (metrics_) {
         metrics_->incrementCounter("clients_connected_total");
-        metrics_->setGauge("clients_active", static_cast<double>(clients_.size()));
+        metrics_->setGauge("clients_active", static_cast<double>(connection_table_.size()));
     }
+    return true;
 }
 
 void Server::removeClient(uint64_t client_id) {
+    // Sharded connections are removed by their shard, or here once the
+    // shard threads have stopped
+    if (shards_) {
+        size_t owner = shards_->shardOf(client_id);
+        Shard* shard = Shard::current();
+        if ((shard && shard->getIndex() == owner) || !shards_->isRunning()) {
+            removeShardedClient(shards_->getShard(owner), client_id);
+        } else {
+            shards_->post(owner, [this, client_id](Shard& shard) { removeShardedClient(shard, client_id); });
+        }
+        return;
+    }
+
     std::unique_lock<std::shared_mutex> lock(clients_mutex_);
-    auto it = clients_.find(client_id);
-    if (it != clients_.end()) {
-        clients_.erase(it);
+    if (auto client = connection_table_.remove(connection_table_.find(client_id))) {
         logger_.info("Client {} disconnected. Total clients: {}", 
-                    client_id, clients_.size());
+                    client_id, connection_table_.size());
+        parkRetransmitWindow(*client);
 
         if (metrics_) {
             metrics_->incrementCounter("clients_disconnected_total");
-            metrics_->setGauge("clients_active", static_cast<double>(clients_.size()));
+            metrics_->setGauge("clients_active", static_cast<double>(connection_table_.size()));
         }
     }
 }
 
 std::shared_ptr<ClientConnection> Server::getClient(uint64_t client_id) {
+    if (shards_) {
+        const auto& local = *shard_state_[shards_->shardOf(client_id)];
+        std::shared_lock<std::shared_mutex> lock(local.table_mutex);
+        auto slot = local.table.find(client_id);
+        return slot != ConnectionTable::INVALID_SLOT ? local.table.get(slot) : nullptr;
+    }
+
     std::shared_lock<std::shared_mutex> lock(clients_mutex_);
-    auto it = clients_.find(client_id);
-    return (it != clients_.end()) ? it->second : nullptr;
+    auto slot = connection_table_.find(client_id);
+    return slot != ConnectionTable::INVALID_SLOT ? connection_table_.get(slot) : nullptr;
 }
 
-void Server::broadcastMessage(const std::string& message, uint64_t sender_id) {
-    std::shared_lock<std::shared_mutex> lock(clients_mutex_);
-    
-    for (const auto& [id, client] : clients_) {
-        if (id != sender_id && client->isAuthenticated()) {
-            thread_pool_->enqueue([client, message]() {
-                client->sendEncryptedMessage(message);
-            });
+void Server::broadcastMessage(const std::string& message, uint64_t sender_id, uint64_t room_id,
+                              uint64_t sender_user) {
+    // Sharded senders are checked and published on their own shard. Client
+    // messages are read there already; this is for the server's own.
+    if (shards_ && !Shard::current()) {
+        shards_->post(shards_->shardOf(sender_id),
+                      [this, payload = utils::MessageBuffer(message), sender_id, room_id, sender_user](Shard&) {
+                          routeBroadcast(payload.view(), sender_id, sender_user, room_id);
+                      });
+        return;
+    }
+    routeBroadcast(message, sender_id, sender_user, room_id);
+}
+
+void Server::routeBroadcast(std::string_view message, uint64_t sender_id, uint64_t sender_user,
+                            uint64_t room_id) {
+    // Retries first: a retry must not reach the filter plugins or the spam
+    // windows a second time
+    if (isDuplicate(sender_id, sender_user, message)) {
+        return;
+    }
+    std::string rewritten;
+    auto outgoing = filterMessage(message, sender_id, 0, room_id, rewritten);
+    if (!outgoing || isSpam(sender_id, sender_user, room_id, message)) {
+        return;
+    }
+
+    // Written once here; every recipient below shares these bytes
+    utils::MessageBuffer payload(*outgoing);
+
+    // Shards deliver from their own member lists and count in getStats().
+    // Every sharded connection is also a member of ALL_ROOMS.
+    if (shards_) {
+        Shard::current()->publish(room_id, sender_id, payload);
+        if (metrics_) {
+            metrics_->incrementCounter("messages_broadcast_total");
         }
+        return;
     }
 
-    total_messages_sent_.fetch_add(clients_.size() - (sender_id ? 1 : 0));
+    // Recipients are picked from the state column and sent in batches of
+    // handles, so fan-out neither loads the connections here nor touches
+    // a shared reference count per recipient.
+    FanoutBatch* batch = nullptr;
+    uint64_t batched = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+        connection_table_.forEach([&](ConnectionTable::Slot slot, const std::shared_ptr<ClientConnection>&) {
+            if (connection_table_.getState(slot) == ClientState::AUTHENTICATED &&
+                (room_id == ALL_ROOMS || connection_table_.getRoom(slot) == room_id) &&
+                connection_table_.getClientId(slot) != sender_id) {
+                if (!batch) {
+                    batch = new (fanout_batches_.allocate()) FanoutBatch{payload};
+                }
+                batch->recipients[batch->size++] = connection_table_.handle(slot);
+                ++batched;
+                if (batch->size == FANOUT_BATCH) {
+                    submitFanout(batch);
+                    batch = nullptr;
+                }
+            }
+        });
+    }
+    total_messages_sent_.fetch_add(batched);
+    if (batch) {
+        submitFanout(batch);
+    }
     
     if (metrics_) {
         metrics_->incrementCounter("messages_broadcast_total");
     }
 }
 
-void Server::sendToClient(uint64_t client_id, const std::string& message) {
-    auto client = getClient(client_id);
-    if (client && client->isAuthenticated()) {
-        thread_pool_->enqueue([client, message]() {
-            client->sendEncryptedMessage(message);
-        });
+void Server::submitFanout(FanoutBatch* batch) {
+    // One read guard per batch keeps each resolved connection alive until
+    // its send returns, however long that takes
+    auto send = [this, batch]() {
+        {
+            ConnectionTable::ReadGuard guard(connection_table_);
+            for (size_t i = 0; i < batch->size; ++i) {
+                if (ClientConnection* client = connection_table_.resolve(batch->recipients[i], guard)) {
+                    client->sendEncryptedMessage(batch->payload);
+                }
+            }
+        }
+        batch->~FanoutBatch();
+        fanout_batches_.deallocate(reinterpret_cast<char*>(batch));
+    };
+    // Stopping: the batch is dropped with the connections
+    if (!cpu_executor_->submit(send)) {
+        batch->~FanoutBatch();
+        fanout_batches_.deallocate(reinterpret_cast<char*>(batch));
+    }
+}
+
+void Server::sendToClient(uint64_t client_id, const std::string& message, uint64_t sender_id,
+                          uint64_t sender_user) {
+    if (shards_ && !Shard::current()) {
+        shards_->post(shards_->shardOf(sender_id),
+                      [this, client_id, payload = utils::MessageBuffer(message), sender_id, sender_user](Shard&) {
+                          routeToClient(client_id, payload.view(), sender_id, sender_user);
+                      });
+        return;
+    }
+    routeToClient(client_id, message, sender_id, sender_user);
+}
+
+void Server::routeToClient(uint64_t client_id, std::string_view message, uint64_t sender_id,
+                           uint64_t sender_user) {
+    if (isDuplicate(sender_id, sender_user, message)) {
+        return;
+    }
+    std::string rewritten;
+    auto outgoing = filterMessage(message, sender_id, client_id, LOBBY_ROOM, rewritten);
+    if (!outgoing || isSpam(sender_id, sender_user, plugins::SpamDetector::NO_ROOM, message)) {
+        return;
+    }
+
+    utils::MessageBuffer payload(*outgoing);
+    // Over the shard queues; the recipient's shard counts the delivery
+    if (shards_) {
+        Shard::current()->sendTo(client_id, sender_id, payload);
+        return;
+    }
+
+    ConnectionHandle recipient;
+    {
+        std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+        auto slot = connection_table_.find(client_id);
+        if (slot != ConnectionTable::INVALID_SLOT &&
+            connection_table_.getState(slot) == ClientState::AUTHENTICATED) {
+            recipient = connection_table_.handle(slot);
+        }
+    }
+    if (recipient) {
+        auto* batch = new (fanout_batches_.allocate()) FanoutBatch{std::move(payload)};
+        batch->recipients[batch->size++] = recipient;
+        submitFanout(batch);
         
         total_messages_sent_.fetch_add(1);
         
@@ -226,17 +568,313 @@ void Server::sendToClient(uint64_t client_id, const std::string& message) {
     }
 }
 
+network::AuthStatus Server::authenticate(ClientConnection& client, std::string_view username,
+                                         std::string_view secret) {
+    auto status = auth_manager_->authenticate(username, secret);
+    if (status == network::AuthStatus::OK) {
+        logger_.info("Client {} authenticated as {}", client.getId(), username);
+    } else if (metrics_) {
+        metrics_->incrementCounter("auth_failures_total");
+    }
+    return status;
+}
+
+void Server::authenticateAsync(ClientConnection& client, std::string username, std::string secret,
+                               std::function<void(network::AuthStatus)> done) {
+    // Token checks and the lockout table stay off the threads that read
+    // connections. The answer goes back to the shard that owns the
+    // connection, or to the CPU executor, since the frames held behind it
+    // are handled where it lands.
+    auto connection = getClient(client.getId());
+    if (!connection) {
+        done(authenticate(client, username, secret));
+        return;
+    }
+    auto check = [this, connection, username = std::move(username), secret = std::move(secret),
+                  done = std::move(done)]() {
+        auto status = authenticate(*connection, username, secret);
+        Shard* shard = shards_ ? Shard::current() : nullptr;
+        if (shard && shard->getIndex() == shards_->shardOf(connection->getId())) {
+            // Checked inline on the owning shard, which may be stopping
+            done(status);
+        } else if (shards_ && shards_->isRunning()) {
+            shards_->post(shards_->shardOf(connection->getId()),
+                          [connection, done, status](Shard&) { done(status); });
+        } else if (!cpu_executor_->submit([connection, done, status]() { done(status); })) {
+            done(status);
+        }
+    };
+    // Stopping: check here
+    if (!blocking_executor_->submit(check)) {
+        check();
+    }
+}
+
+void Server::onJoinRoom(ClientConnection& client, uint64_t room_id) {
+    uint64_t previous = client.getRoom();
+    if (room_id == ALL_ROOMS || room_id == previous) {
+        return;
+    }
+    client.setRoom(room_id);
+
+    // Sharded connections are read on their shard's thread, which owns the
+    // member lists
+    if (Shard* shard = shards_ ? Shard::current() : nullptr) {
+        shard->leave(client.getId(), previous);
+        shard->join(client.getId(), room_id);
+    }
+    logger_.debug("Client {} moved from room {} to room {}", client.getId(), previous, room_id);
+}
+
+void Server::onMessage(ClientConnection& client, const std::string& plaintext) {
+    if (ShardState* local = currentShardState()) {
+        // Only this shard writes it
+        local->messages_received.store(local->messages_received.load(std::memory_order_relaxed) + 1,
+                                       std::memory_order_relaxed);
+    } else {
+        total_messages_received_.fetch_add(1, std::memory_order_relaxed);
+    }
+    broadcastMessage(plaintext, client.getId(), client.getRoom(), userKey(client));
+}
+
+void Server::onResume(ClientConnection& client, std::string_view token, uint64_t acknowledged) {
+    resumeSession(client, std::string(token), acknowledged);
+}
+
+void Server::onDisconnect(ClientConnection& client) {
+    removeClient(client.getId());
+}
+
+security::RateLimitConfig Server::getRateLimit() const {
+    return security::RateLimitConfig::fromConfig(config_);
+}
+
+std::future<bool> Server::reloadPlugins() {
+    auto reloaded = std::make_shared<std::promise<bool>>();
+    auto result = reloaded->get_future();
+    if (!content_filter_) {
+        reloaded->set_value(true);
+        return result;
+    }
+
+    logger_.info("Reloading content filter word lists");
+    if (!blocking_executor_->submit([this, reloaded]() { reloaded->set_value(content_filter_->reload()); })) {
+        reloaded->set_value(false);
+    }
+    return result;
+}
+
+std::optional<std::string_view> Server::filterMessage(std::string_view message, uint64_t sender_id,
+                                                      uint64_t recipient_id, uint64_t room_id,
+                                                      std::string& rewritten) {
+    // Text frames must be valid UTF-8 without terminal control sequences
+    // before any filter, plugin or recipient sees them
+    switch (utils::validateText(message)) {
+        case utils::TextStatus::INVALID_UTF8:
+            if (metrics_) {
+                metrics_->incrementCounter("messages_invalid_utf8_total");
+            }
+            return std::nullopt;
+        case utils::TextStatus::CONTROL_CHARACTER:
+            if (metrics_) {
+                metrics_->incrementCounter("messages_control_chars_total");
+            }
+            return std::nullopt;
+        default:
+            break;
+    }
+
+    std::string_view outgoing = message;
+
+    if (content_filter_) {
+        auto verdict = content_filter_->apply(message, rewritten);
+        switch (verdict.action) {
+            case plugins::FilterAction::REJECT:
+                if (metrics_) {
+                    metrics_->incrementCounter("messages_filtered_total");
+                }
+                return std::nullopt;
+            case plugins::FilterAction::MASK:
+                if (metrics_) {
+                    metrics_->incrementCounter("messages_masked_total");
+                }
+                outgoing = rewritten;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (!plugin_manager_ || plugin_manager_->empty()) {
+        return outgoing;
+    }
+
+    securechat_message_header header{};
+    header.sender_id = sender_id;
+    header.recipient_id = recipient_id;
+    header.room_id = room_id == ALL_ROOMS ? LOBBY_ROOM : room_id;
+    header.timestamp_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+
+    std::string_view output;
+    switch (plugin_manager_->process(header, outgoing, output)) {
+        case SECURECHAT_VERDICT_REJECT:
+            if (metrics_) {
+                metrics_->incrementCounter("messages_plugin_rejected_total");
+            }
+            return std::nullopt;
+        case SECURECHAT_VERDICT_REWRITE:
+            // The pipeline's buffer is reused by the next message on this thread
+            rewritten.assign(output.data(), output.size());
+            if (metrics_) {
+                metrics_->incrementCounter("messages_plugin_rewritten_total");
+            }
+            return std::string_view(rewritten);
+        default:
+            return outgoing;
+    }
+}
+
+size_t Server::resumeSession(ClientConnection& client, const std::string& token, uint64_t acknowledged) {
+    if (!resumable_windows_) {
+        return 0;
+    }
+
+    // The window holds the previous session's plaintext; the token names it,
+    // but only the user that session belonged to may have it
+    if (!client.isAuthenticated() || client.getUserId().empty()) {
+        logger_.warn("Client {} asked to resume a session before authenticating", client.getId());
+        if (metrics_) {
+            metrics_->incrementCounter("sessions_resume_rejected_total");
+        }
+        return 0;
+    }
+
+    auto window = resumable_windows_->claim(token, client.getUserId(), clock_.now());
+    if (!window) {
+        logger_.debug("Client {} asked to resume an unknown or expired session", client.getId());
+        if (metrics_) {
+            metrics_->incrementCounter("sessions_resume_missed_total");
+        }
+        return 0;
+    }
+    size_t replayed = client.resumeFrom(*window, acknowledged);
+    logger_.info("Client {} resumed its session; replayed {} unacknowledged messages", client.getId(), replayed);
+    if (metrics_) {
+        metrics_->incrementCounter("sessions_resumed_total");
+    }
+    return replayed;
+}
+
+void Server::parkRetransmitWindow(const ClientConnection& client) {
+    const auto& window = client.getRetransmitWindow();
+    if (!resumable_windows_ || !window || window->size() == 0 || client.getResumeToken().empty() ||
+        client.getUserId().empty()) {
+        return;
+    }
+    resumable_windows_->park(client.getResumeToken(), client.getUserId(), window, clock_.now());
+    if (metrics_) {
+        metrics_->incrementCounter("sessions_parked_total");
+    }
+}
+
+uint64_t Server::userKey(const ClientConnection& client) {
+    const std::string& user = client.getUserId();
+    // Never 0, which stands for no user
+    return user.empty() ? 0 : std::hash<std::string>{}(user) | 1;
+}
+
+bool Server::isDuplicate(uint64_t sender_id, uint64_t sender_user, std::string_view message) {
+    // Keyed on the user, not the connection: a retry after a reconnect
+    // arrives on a new connection
+    if (!deduplicator_ || sender_user == 0) {
+        return false;
+    }
+
+    // Messages without an id cannot be retried safely, so they always pass
+    auto message_id = MessageDeduplicator::extractMessageId(message);
+    if (message_id.empty() || !deduplicator_->checkAndRecord(sender_user, message_id, clock_.now())) {
+        return false;
+    }
+    logger_.debug("Dropping duplicate message {} from client {}", message_id, sender_id);
+    if (metrics_) {
+        metrics_->incrementCounter("messages_duplicate_total");
+    }
+    return true;
+}
+
+bool Server::isSpam(uint64_t sender_id, uint64_t sender_user, uint64_t room_id, std::string_view message) {
+    // Keyed on the user, so reconnecting does not open a fresh window
+    if (!spam_detector_ || sender_user == 0) {
+        return false;
+    }
+
+    // Every connection starts in the lobby, so the same few words from
+    // several users there is ordinary chatter rather than a coordinated
+    // flood; only rooms clients joined get the room check
+    if (room_id == LOBBY_ROOM || room_id == ALL_ROOMS) {
+        room_id = plugins::SpamDetector::NO_ROOM;
+    }
+    auto verdict = spam_detector_->check(sender_user, room_id, message);
+    if (verdict.flagged) {
+        logger_.warn("Dropping near-duplicate flood message from client {} ({} user / {} room matches)",
+                     sender_id, static_cast<int>(verdict.user_duplicates),
+                     static_cast<int>(verdict.room_duplicates));
+        if (metrics_) {
+            metrics_->incrementCounter("messages_spam_total");
+        }
+    }
+    return verdict.flagged;
+}
+
+Server::ShardState* Server::currentShardState() const {
+    Shard* shard = shards_ ? Shard::current() : nullptr;
+    return shard ? shard_state_[shard->getIndex()].get() : nullptr;
+}
+
 size_t Server::getConnectedClientsCount() const {
+    if (shards_) {
+        size_t count = 0;
+        for (const auto& local : shard_state_) {
+            std::shared_lock<std::shared_mutex> lock(local->table_mutex);
+            count += local->table.size();
+        }
+        return count;
+    }
+
     std::shared_lock<std::shared_mutex> lock(clients_mutex_);
-    return clients_.size();
+    return connection_table_.size();
+}
+
+size_t Server::getConnectionMemoryBytes() const {
+    if (shards_) {
+        size_t bytes = 0;
+        for (const auto& local : shard_state_) {
+            bytes += local->memory_bytes.load(std::memory_order_relaxed);
+        }
+        return bytes;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+    size_t bytes = 0;
+    connection_table_.forEach([&bytes](ConnectionTable::Slot, const std::shared_ptr<ClientConnection>& client) {
+        bytes += client->getResidentBytes();
+    });
+    return bytes;
 }
 
 utils::ServerStats Server::getStats() const {
     utils::ServerStats stats;
     stats.connected_clients = getConnectedClientsCount();
     stats.total_messages = total_messages_sent_.load() + total_messages_received_.load();
+    if (shards_) {
+        for (size_t i = 0; i < shards_->getShardCount(); ++i) {
+            stats.total_messages += shards_->getShard(i).getLocalDeliveries() +
+                shard_state_[i]->messages_received.load(std::memory_order_relaxed);
+        }
+    }
     
-    auto now = std::chrono::steady_clock::now();
+    auto now = clock_.now();
     auto uptime = std::chrono::duration_cast<std::chrono::seconds>(now - start_time_);
     stats.uptime_seconds = uptime.count();
     
@@ -250,7 +888,7 @@ void Server::acceptConnections() {
         try {
             int client_socket = socket_manager_->acceptConnection();
             if (client_socket >= 0) {
-                thread_pool_->enqueue([this, client_socket]() {
+                cpu_executor_->submit([this, client_socket]() {
                     handleClientConnection(client_socket);
                 });
             }
@@ -265,43 +903,191 @@ void Server::acceptConnections() {
 }
 
 void Server::handleClientConnection(int client_socket) {
+    acceptTransport(std::make_unique<network::SocketTransport>(client_socket));
+}
+
+void Server::acceptTransport(std::unique_ptr<network::Transport> transport) {
+    if (!transport) {
+        return;
+    }
+
     try {
+        network::applySocketBusyPoll(transport->nativeHandle(), busy_poll_);
         uint64_t client_id = next_client_id_.fetch_add(1);
-        auto client = std::make_shared<ClientConnection>(client_socket, client_id);
-        
+        auto client = std::make_shared<ClientConnection>(std::move(transport), client_id, clock_);
+        client->setMessageHandler(this);
+
+        if (shards_) {
+            shards_->post(shards_->shardOf(client_id), [this, client](Shard& shard) {
+                startShardedClient(shard, client);
+            });
+            return;
+        }
+
         if (client->initialize()) {
-            addClient(client);
-            client->start();
+            if (addClient(client)) {
+                client->start(&event_loop_->getAsyncIO());
+            } else {
+                client->disconnect();
+            }
         } else {
             logger_.warn("Failed to initialize client connection {}", client_id);
         }
     } catch (const std::exception& e) {
         logger_.error("Error handling client connection: {}", e.what());
-        close(client_socket);
     }
 }
 
+void Server::startShardedClient(Shard& shard, std::shared_ptr<ClientConnection> client) {
+    if (!client->initialize()) {
+        logger_.warn("Failed to initialize client connection {}", client->getId());
+        return;
+    }
+
+    auto& local = *shard_state_[shard.getIndex()];
+    ConnectionTable::Slot slot;
+    {
+        std::unique_lock<std::shared_mutex> lock(local.table_mutex);
+        slot = local.table.insert(client->getId(), client, client->getState(), clock_.now());
+    }
+    if (slot == ConnectionTable::INVALID_SLOT) {
+        logger_.warn("Rejecting client {}: shard {} holds {} of {} connection slots",
+                     client->getId(), shard.getIndex(), local.table.size(), local.table.capacity());
+        if (metrics_) {
+            metrics_->incrementCounter("clients_rejected_total");
+        }
+        client->disconnect();
+        return;
+    }
+    client->attachToTable(local.table, slot);
+    if (resumable_windows_) {
+        client->enableRetransmitWindow(retransmit_window_size_);
+    }
+    logger_.info("Client {} connected on shard {}", client->getId(), shard.getIndex());
+    if (metrics_) {
+        metrics_->incrementCounter("clients_connected_total");
+    }
+
+    // Sockets are polled by the shard; in-process transports signal readiness themselves
+    client->start(nullptr);
+    int fd = client->getNativeHandle();
+    if (fd >= 0) {
+        uint64_t client_id = client->getId();
+        shard.watch(fd, [this, client_id, connection = client.get()]() {
+            if (!connection->onReadable()) {
+                removeClient(client_id);
+            }
+        });
+    }
+
+    shard.join(client->getId(), LOBBY_ROOM);
+    shard.join(client->getId(), ALL_ROOMS);
+}
+
+void Server::removeShardedClient(Shard& shard, uint64_t client_id) {
+    auto& local = *shard_state_[shard.getIndex()];
+    std::shared_ptr<ClientConnection> client;
+    {
+        std::unique_lock<std::shared_mutex> lock(local.table_mutex);
+        client = local.table.remove(local.table.find(client_id));
+    }
+    if (!client) {
+        return;
+    }
+
+    shard.leave(client_id, client->getRoom());
+    shard.leave(client_id, ALL_ROOMS);
+    shard.unwatch(client->getNativeHandle());
+    logger_.info("Client {} disconnected from shard {}", client_id, shard.getIndex());
+    parkRetransmitWindow(*client);
+    if (metrics_) {
+        metrics_->incrementCounter("clients_disconnected_total");
+    }
+}
+
+void Server::sweepShard(Shard& shard, std::chrono::steady_clock::time_point now, std::chrono::seconds idle_after) {
+    auto& local = *shard_state_[shard.getIndex()];
+    std::vector<uint64_t> disconnected_clients;
+    {
+        std::unique_lock<std::shared_mutex> lock(local.table_mutex);
+        local.table.reclaim();
+        for (auto slot : local.table.collectDisconnected()) {
+            disconnected_clients.push_back(local.table.getClientId(slot));
+        }
+    }
+    for (uint64_t client_id : disconnected_clients) {
+        removeShardedClient(shard, client_id);
+    }
+
+    // Only this thread inserts or removes, so its own scan needs no lock
+    size_t bytes = 0;
+    local.table.forEach([&](ConnectionTable::Slot, const std::shared_ptr<ClientConnection>& client) {
+        client->trimIdle(now, idle_after);
+        bytes += client->getResidentBytes();
+    });
+    local.memory_bytes.store(bytes, std::memory_order_relaxed);
+}
+
 void Server::cleanupDisconnectedClients() {
     std::vector<uint64_t> disconnected_clients;
     
     {
-        std::shared_lock<std::shared_mutex> lock(clients_mutex_);
-        for (const auto& [id, client] : clients_) {
-            if (!client->isConnected()) {
-                disconnected_clients.push_back(id);
-            }
+        // Slots are freed once the send tasks that might have resolved them
+        // have finished and nothing else holds their connections
+        std::unique_lock<std::shared_mutex> lock(clients_mutex_);
+        connection_table_.reclaim();
+        for (auto slot : connection_table_.collectDisconnected()) {
+            disconnected_clients.push_back(connection_table_.getClientId(slot));
         }
     }
     
     for (uint64_t client_id : disconnected_clients) {
         removeClient(client_id);
     }
+
+    if (resumable_windows_) {
+        if (size_t expired = resumable_windows_->expire(clock_.now())) {
+            logger_.debug("Dropped {} retransmit windows never resumed", expired);
+        }
+    }
     
     if (!disconnected_clients.empty()) {
         logger_.debug("Cleaned up {} disconnected clients", disconnected_clients.size());
     }
 }
 
+void Server::trimIdleClients() {
+    auto now = clock_.now();
+    auto idle_after = std::chrono::seconds(config_.getIdleTrimSeconds());
+    size_t trimmed = 0;
+
+    // Each shard sweeps the connections it owns, on its own thread
+    if (shards_) {
+        for (size_t i = 0; i < shards_->getShardCount(); ++i) {
+            shards_->post(i, [this, now, idle_after](Shard& shard) { sweepShard(shard, now, idle_after); });
+        }
+        return;
+    }
+
+    {
+        // The activity column narrows the sweep to connections that may be
+        // idle; trimIdle() checks its own clock before freeing anything
+        std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+        for (auto slot : connection_table_.collectIdleSince(now - idle_after)) {
+            if (connection_table_.get(slot)->trimIdle(now, idle_after)) {
+                trimmed++;
+            }
+        }
+    }
+
+    if (trimmed > 0) {
+        logger_.debug("Trimmed {} idle client connections", trimmed);
+        if (metrics_) {
+            metrics_->setGauge("clients_trimmed_last_sweep", static_cast<double>(trimmed));
+        }
+    }
+}
+
 void Server::updateMetrics() {
     if (!metrics_) {
         return;
@@ -310,6 +1096,97 @@ void Server::updateMetrics() {
     auto stats = getStats();
     metrics_->setGauge("server_uptime_seconds", static_cast<double>(stats.uptime_seconds));
     metrics_->setGauge("messages_total", static_cast<double>(stats.total_messages));
+    metrics_->setGauge("connection_memory_bytes", static_cast<double>(getConnectionMemoryBytes()));
+
+    // Connection columns, summed without touching the connections
+    ConnectionTable::Totals connections;
+    {
+        std::shared_lock<std::shared_mutex> lock(clients_mutex_);
+        connections = connection_table_.sumColumns();
+    }
+    for (const auto& local : shard_state_) {
+        ConnectionTable::Totals shard;
+        {
+            std::shared_lock<std::shared_mutex> lock(local->table_mutex);
+            shard = local->table.sumColumns();
+        }
+        connections.connections += shard.connections;
+        connections.authenticated += shard.authenticated;
+        connections.queue_depth += shard.queue_depth;
+        connections.max_queue_depth = std::max(connections.max_queue_depth, shard.max_queue_depth);
+        connections.bytes_in += shard.bytes_in;
+        connections.bytes_out += shard.bytes_out;
+        connections.unacked_messages += shard.unacked_messages;
+        connections.max_unacked_messages = std::max(connections.max_unacked_messages, shard.max_unacked_messages);
+        connections.unacked_bytes += shard.unacked_bytes;
+    }
+    if (shards_) {
+        metrics_->setGauge("clients_active", static_cast<double>(connections.connections));
+    }
+    metrics_->setGauge("clients_authenticated", static_cast<double>(connections.authenticated));
+    metrics_->setGauge("client_send_queue_depth_total", static_cast<double>(connections.queue_depth));
+    metrics_->setGauge("client_send_queue_depth_max", static_cast<double>(connections.max_queue_depth));
+    metrics_->setGauge("client_bytes_in_total", static_cast<double>(connections.bytes_in));
+    metrics_->setGauge("client_bytes_out_total", static_cast<double>(connections.bytes_out));
+    // Memory held for at-least-once delivery, live and awaiting resume.
+    // Windows share message buffers, so a broadcast counts once per window.
+    metrics_->setGauge("client_retransmit_window_messages_total", static_cast<double>(connections.unacked_messages));
+    metrics_->setGauge("client_retransmit_window_messages_max", static_cast<double>(connections.max_unacked_messages));
+    metrics_->setGauge("client_retransmit_window_bytes_total", static_cast<double>(connections.unacked_bytes));
+    if (resumable_windows_) {
+        metrics_->setGauge("resumable_windows", static_cast<double>(resumable_windows_->size()));
+        metrics_->setGauge("resumable_window_bytes", static_cast<double>(resumable_windows_->getBytes()));
+    }
+
+    // Executor sizing follows queue delay; utilization shows headroom
+    for (Executor* executor : {cpu_executor_.get(), blocking_executor_.get()}) {
+        if (executor) {
+            const std::string prefix = "executor_" + executor->getName();
+            metrics_->setGauge(prefix + "_threads", static_cast<double>(executor->getThreadCount()));
+            metrics_->setGauge(prefix + "_queue_size", static_cast<double>(executor->getQueueSize()));
+            metrics_->setGauge(prefix + "_queue_delay_us", static_cast<double>(executor->getQueueDelay().count()));
+            metrics_->setGauge(prefix + "_utilization", executor->sampleUtilization());
+        }
+    }
+
+    if (event_loop_) {
+        metrics_->setGauge("event_loop_tasks_total", static_cast<double>(event_loop_->getProcessedEvents()));
+        metrics_->setGauge("event_loop_wakeups_total", static_cast<double>(event_loop_->getWakeups()));
+        // Rising while quiet clients see latency means the budget is too large
+        metrics_->setGauge("async_io_budget_hits_total",
+                           static_cast<double>(event_loop_->getAsyncIO().getBudgetHits()));
+    }
+
+    if (deduplicator_) {
+        // Rising means the dedup capacity is below the message rate
+        metrics_->setGauge("message_dedup_early_rotations_total",
+                           static_cast<double>(deduplicator_->getEarlyRotations()));
+        metrics_->setGauge("message_dedup_memory_bytes", static_cast<double>(deduplicator_->getMemoryUsage()));
+    }
+
+    if (auto* arena = utils::HugePageArena::buffers()) {
+        metrics_->setGauge("huge_page_arena_reserved_bytes", static_cast<double>(arena->getReservedBytes()));
+        metrics_->setGauge("huge_page_arena_used_bytes", static_cast<double>(arena->getUsedBytes()));
+    }
+
+    // Per-reactor busy polling; a high miss share means spinning is wasted
+    if (shards_ && busy_poll_.enabled) {
+        for (size_t i = 0; i < shards_->getShardCount(); ++i) {
+            const Shard& shard = shards_->getShard(i);
+            metrics_->setGauge("shard_" + std::to_string(i) + "_spin_hits", static_cast<double>(shard.getSpinHits()));
+            metrics_->setGauge("shard_" + std::to_string(i) + "_spin_misses", static_cast<double>(shard.getSpinMisses()));
+        }
+    }
+
+    // Per-plugin pipeline latency
+    if (plugin_manager_) {
+        for (const auto& plugin : plugin_manager_->getStats()) {
+            metrics_->setGauge("plugin_" + plugin.name + "_calls", static_cast<double>(plugin.calls));
+            metrics_->setGauge("plugin_" + plugin.name + "_avg_latency_us", plugin.getAverageLatencyUs());
+            metrics_->setGauge("plugin_" + plugin.name + "_max_latency_us", static_cast<double>(plugin.max_ns) / 1000.0);
+            metrics_->setGauge("plugin_" + plugin.name + "_slow_calls", static_cast<double>(plugin.slow_calls));
+        }
+    }
     
     // Memory usage
     // Note: This is a simplified implementation
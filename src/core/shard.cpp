@@ -0,0 +1,419 @@
+#include "core/shard.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace securechat::core {
+
+namespace {
+
+thread_local Shard* t_current_shard = nullptr;
+
+} // namespace
+
+Shard::Shard(ShardedRuntime& runtime, size_t index, int cpu)
+    : runtime_(runtime)
+    , index_(index)
+    , cpu_(cpu)
+    , timers_(std::chrono::steady_clock::now()) {
+#ifdef __linux__
+    poll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (poll_fd_ >= 0 && wake_fd_ >= 0) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wake_fd_;
+        epoll_ctl(poll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    }
+#endif
+}
+
+Shard::~Shard() {
+#ifdef __linux__
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (poll_fd_ >= 0) {
+        close(poll_fd_);
+    }
+#endif
+}
+
+Shard* Shard::current() {
+    return t_current_shard;
+}
+
+void Shard::join(uint64_t client_id, uint64_t room_id) {
+    auto& members = local_members_[room_id];
+    members.push_back(client_id);
+    if (members.size() == 1) {
+        notifyInterest(ShardMessage::Kind::ROOM_JOINED, room_id);
+    }
+}
+
+void Shard::leave(uint64_t client_id, uint64_t room_id) {
+    auto it = local_members_.find(room_id);
+    if (it == local_members_.end()) {
+        return;
+    }
+
+    auto& members = it->second;
+    auto member = std::find(members.begin(), members.end(), client_id);
+    if (member != members.end()) {
+        *member = members.back();
+        members.pop_back();
+    }
+    if (members.empty()) {
+        local_members_.erase(it);
+        notifyInterest(ShardMessage::Kind::ROOM_LEFT, room_id);
+    }
+}
+
+void Shard::publish(uint64_t room_id, uint64_t sender_id, const utils::MessageBuffer& message) {
+    deliverLocal(room_id, sender_id, message);
+
+    auto interested = remote_interest_.find(room_id);
+    if (interested == remote_interest_.end()) {
+        return;
+    }
+    for (size_t to : interested->second) {
+        send(to, ShardMessage{ShardMessage::Kind::DELIVER, room_id, sender_id, message});
+    }
+    bump(forwarded_, interested->second.size());
+}
+
+void Shard::sendTo(uint64_t client_id, uint64_t sender_id, const utils::MessageBuffer& message) {
+    size_t to = runtime_.shardOf(client_id);
+    if (to == index_) {
+        runtime_.deliver_(*this, client_id, sender_id, message);
+        bump(local_deliveries_);
+        return;
+    }
+    send(to, ShardMessage{ShardMessage::Kind::DIRECT, 0, sender_id, message, client_id});
+    bump(forwarded_);
+}
+
+bool Shard::watch(int fd, std::function<void()> on_readable) {
+#ifdef __linux__
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    if (epoll_ctl(poll_fd_, EPOLL_CTL_ADD, fd, &event) != 0 &&
+        (errno != EEXIST || epoll_ctl(poll_fd_, EPOLL_CTL_MOD, fd, &event) != 0)) {
+        return false;
+    }
+    watched_[fd] = std::move(on_readable);
+    return true;
+#else
+    (void)fd;
+    (void)on_readable;
+    return false;
+#endif
+}
+
+void Shard::unwatch(int fd) {
+#ifdef __linux__
+    epoll_ctl(poll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+    watched_.erase(fd);
+}
+
+void Shard::setBusyPoll(const network::BusyPollConfig& config) {
+    spin_.configure(config);
+}
+
+void Shard::run() {
+    t_current_shard = this;
+    if (cpu_ >= 0) {
+        utils::setThreadAffinity({cpu_});
+    }
+
+    while (runtime_.running_.load(std::memory_order_relaxed)) {
+        size_t work = drainInbound() + runPostedTasks() + flushBacklog();
+        work += timers_.advanceTo(std::chrono::steady_clock::now());
+        if (work > 0) {
+            pollReadiness(0);
+            continue;
+        }
+        if (spin_.getSpinBudget().count() > 0 && spinForWork()) {
+            continue;
+        }
+
+        // Announce the sleep, then look again: a producer either sees the
+        // flag and wakes us, or published before the fence and is seen here
+        sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool pending = hasPendingWork();
+        int timeout_ms = pending ? 0 : IDLE_WAIT_MS;
+        utils::Clock::time_point deadline;
+        if (timeout_ms > 0 && timers_.getNextDeadline(deadline)) {
+            auto until = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            timeout_ms = static_cast<int>(std::clamp<int64_t>(until.count(), 0, IDLE_WAIT_MS));
+        }
+        auto blocked_at = std::chrono::steady_clock::now();
+        size_t ready = pollReadiness(timeout_ms);
+        sleeping_.store(false, std::memory_order_relaxed);
+        if (ready > 0 && spin_.isEnabled()) {
+            spin_.onWake(std::chrono::steady_clock::now() - blocked_at);
+        }
+    }
+
+    t_current_shard = nullptr;
+}
+
+size_t Shard::drainInbound() {
+    size_t drained = 0;
+    for (size_t from = 0; from < runtime_.getShardCount(); ++from) {
+        if (from == index_) {
+            continue;
+        }
+        size_t count = runtime_.queue(from, index_).drain(
+            [this, from](ShardMessage&& message) { handle(from, std::move(message)); }, DRAIN_BATCH_SIZE);
+        if (count > 0) {
+            bump(batches_drained_);
+            drained += count;
+        }
+    }
+    return drained;
+}
+
+size_t Shard::runPostedTasks() {
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        if (posted_.empty()) {
+            return 0;
+        }
+        running_tasks_.swap(posted_);
+    }
+
+    size_t count = running_tasks_.size();
+    for (auto& task : running_tasks_) {
+        task(*this);
+    }
+    running_tasks_.clear();
+    return count;
+}
+
+size_t Shard::flushBacklog() {
+    if (backlog_size_ == 0) {
+        return 0;
+    }
+
+    size_t flushed = 0;
+    for (size_t to = 0; to < backlog_.size(); ++to) {
+        auto& pending = backlog_[to];
+        size_t before = flushed;
+        while (!pending.empty() && runtime_.queue(index_, to).tryPush(std::move(pending.front()))) {
+            pending.pop_front();
+            flushed++;
+        }
+        if (flushed > before) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (runtime_.shards_[to]->sleeping_.load(std::memory_order_relaxed)) {
+                runtime_.shards_[to]->wake();
+            }
+        }
+    }
+    backlog_size_ -= flushed;
+    return flushed;
+}
+
+bool Shard::hasPendingWork() {
+    if (backlog_size_ > 0) {
+        return true;
+    }
+    for (size_t from = 0; from < runtime_.getShardCount(); ++from) {
+        if (from != index_ && !runtime_.queue(from, index_).empty()) {
+            return true;
+        }
+    }
+    std::lock_guard<std::mutex> lock(posted_mutex_);
+    return !posted_.empty();
+}
+
+bool Shard::spinForWork() {
+    auto deadline = std::chrono::steady_clock::now() + spin_.getSpinBudget();
+    bool found = false;
+    do {
+        found = pollReadiness(0) > 0 || hasPendingWork();
+    } while (!found && std::chrono::steady_clock::now() < deadline);
+
+    spin_.onSpin(found);
+    bump(found ? spin_hits_ : spin_misses_);
+    return found;
+}
+
+size_t Shard::pollReadiness(int timeout_ms) {
+#ifdef __linux__
+    epoll_event events[64];
+    int ready = epoll_wait(poll_fd_, events, 64, timeout_ms);
+    for (int i = 0; i < ready; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == wake_fd_) {
+            uint64_t value;
+            while (read(wake_fd_, &value, sizeof(value)) > 0) {
+            }
+            continue;
+        }
+
+        auto it = watched_.find(fd);
+        if (it != watched_.end()) {
+            // The callback may unwatch its own fd
+            auto callback = it->second;
+            callback();
+        }
+    }
+    return ready > 0 ? static_cast<size_t>(ready) : 0;
+#else
+    if (timeout_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return 0;
+#endif
+}
+
+void Shard::handle(size_t from, ShardMessage&& message) {
+    switch (message.kind) {
+        case ShardMessage::Kind::DELIVER:
+            deliverLocal(message.room_id, message.sender_id, message.payload);
+            break;
+        case ShardMessage::Kind::ROOM_JOINED: {
+            auto& shards = remote_interest_[message.room_id];
+            if (std::find(shards.begin(), shards.end(), from) == shards.end()) {
+                shards.push_back(from);
+            }
+            break;
+        }
+        case ShardMessage::Kind::ROOM_LEFT: {
+            auto it = remote_interest_.find(message.room_id);
+            if (it != remote_interest_.end()) {
+                auto& shards = it->second;
+                shards.erase(std::remove(shards.begin(), shards.end(), from), shards.end());
+                if (shards.empty()) {
+                    remote_interest_.erase(it);
+                }
+            }
+            break;
+        }
+        case ShardMessage::Kind::DIRECT:
+            runtime_.deliver_(*this, message.client_id, message.sender_id, message.payload);
+            bump(local_deliveries_);
+            break;
+    }
+}
+
+void Shard::deliverLocal(uint64_t room_id, uint64_t sender_id, const utils::MessageBuffer& message) {
+    auto it = local_members_.find(room_id);
+    if (it == local_members_.end()) {
+        return;
+    }
+
+    uint64_t delivered = 0;
+    for (uint64_t client_id : it->second) {
+        if (client_id != sender_id) {
+            runtime_.deliver_(*this, client_id, sender_id, message);
+            delivered++;
+        }
+    }
+    bump(local_deliveries_, delivered);
+}
+
+void Shard::send(size_t to, ShardMessage&& message) {
+    // Keep per-destination order: once anything is backlogged, queue behind it
+    if (!backlog_[to].empty() || !runtime_.queue(index_, to).tryPush(std::move(message))) {
+        backlog_[to].push_back(std::move(message));
+        backlog_size_++;
+        bump(backlogged_);
+        return;
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (runtime_.shards_[to]->sleeping_.load(std::memory_order_relaxed)) {
+        runtime_.shards_[to]->wake();
+    }
+}
+
+void Shard::notifyInterest(ShardMessage::Kind kind, uint64_t room_id) {
+    for (size_t to = 0; to < runtime_.getShardCount(); ++to) {
+        if (to != index_) {
+            send(to, ShardMessage{kind, room_id, 0, {}});
+        }
+    }
+}
+
+void Shard::wake() {
+#ifdef __linux__
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = write(wake_fd_, &one, sizeof(one));
+#endif
+}
+
+ShardedRuntime::ShardedRuntime(size_t shard_count, Shard::DeliverFn deliver, const utils::CpuSet& cpus,
+                               size_t queue_capacity)
+    : deliver_(std::move(deliver))
+    , logger_("ShardedRuntime") {
+    size_t count = std::max<size_t>(1, shard_count);
+    for (size_t i = 0; i < count; ++i) {
+        int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        shards_.push_back(std::unique_ptr<Shard>(new Shard(*this, i, cpu)));
+    }
+    for (auto& shard : shards_) {
+        shard->backlog_.resize(count);
+    }
+
+    queues_.resize(count * count);
+    for (size_t from = 0; from < count; ++from) {
+        for (size_t to = 0; to < count; ++to) {
+            if (from != to) {
+                queues_[from * count + to] = std::make_unique<utils::SpscQueue<ShardMessage>>(queue_capacity);
+            }
+        }
+    }
+}
+
+ShardedRuntime::~ShardedRuntime() {
+    stop();
+}
+
+void ShardedRuntime::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    for (auto& shard : shards_) {
+        shard->thread_ = std::thread(&Shard::run, shard.get());
+    }
+    logger_.info("Started {} shards", shards_.size());
+}
+
+void ShardedRuntime::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (auto& shard : shards_) {
+        shard->wake();
+    }
+    for (auto& shard : shards_) {
+        if (shard->thread_.joinable()) {
+            shard->thread_.join();
+        }
+    }
+    logger_.info("Stopped {} shards", shards_.size());
+}
+
+void ShardedRuntime::post(size_t shard, std::function<void(Shard&)> task) {
+    Shard& target = *shards_[shard];
+    {
+        std::lock_guard<std::mutex> lock(target.posted_mutex_);
+        target.posted_.push_back(std::move(task));
+    }
+    target.wake();
+}
+
+} // namespace securechat::core
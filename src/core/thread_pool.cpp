@@ -0,0 +1,56 @@
+#include "core/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace securechat::core {
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    num_threads = std::max<size_t>(1, num_threads);
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.emplace_back([this]() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex_);
+                    condition_.wait(lock, [this]() { return stop_flag_.load() || !tasks_.empty(); });
+                    // Queued tasks still run after stop(); their futures are waited on
+                    if (tasks_.empty()) {
+                        return;
+                    }
+                    task = std::move(tasks_.front());
+                    tasks_.pop();
+                }
+                active_threads_++;
+                task();
+                active_threads_--;
+            }
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (stop_flag_.exchange(true)) {
+            return;
+        }
+    }
+    condition_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable() && worker.get_id() != std::this_thread::get_id()) {
+            worker.join();
+        }
+    }
+}
+
+size_t ThreadPool::getQueueSize() const {
+    std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(queue_mutex_));
+    return tasks_.size();
+}
+
+} // namespace securechat::core
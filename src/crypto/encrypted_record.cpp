@@ -0,0 +1,234 @@
+// The SHA256_* calls are deprecated in OpenSSL 3 in favour of EVP digests,
+// but an EVP digest or MAC allocates a provider context on every init. The
+// tag keeps plain SHA-256 states instead, which a record only copies.
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include "crypto/encryption_manager.hpp"
+
+#include <cstring>
+
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+
+namespace securechat::crypto {
+
+namespace {
+
+void putUint32(unsigned char* out, uint32_t value) {
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+}
+
+void putUint64(unsigned char* out, uint64_t value) {
+    putUint32(out, static_cast<uint32_t>(value >> 32));
+    putUint32(out + 4, static_cast<uint32_t>(value));
+}
+
+uint64_t getUint64(const char* data) {
+    auto bytes = reinterpret_cast<const unsigned char*>(data);
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+constexpr size_t AUTHENTICATED_HEADER_SIZE = EncryptedRecord::TAG_LENGTH_OFFSET - EncryptedRecord::SEQUENCE_OFFSET;
+
+// Rough OpenSSL 3 allocations behind one AES-256-CBC context with its key
+// schedule
+constexpr size_t CIPHER_CONTEXT_BYTES = 768;
+
+static_assert(HMAC_DIGEST_SIZE == SHA256_DIGEST_LENGTH);
+static_assert(HMAC_KEY_SIZE <= SHA256_CBLOCK, "longer HMAC keys are hashed first");
+
+} // namespace
+
+struct RecordCipher::TagKeys {
+    SHA256_CTX inner;
+    SHA256_CTX outer;
+};
+
+RecordCipher::RecordCipher() = default;
+
+RecordCipher::~RecordCipher() {
+    releaseContexts();
+    OPENSSL_cleanse(key_.data(), key_.size());
+    OPENSSL_cleanse(hmac_key_.data(), hmac_key_.size());
+}
+
+void RecordCipher::setKeys(const AESKey& key, const HMACKey& hmac_key) {
+    releaseContexts();
+    key_ = key;
+    hmac_key_ = hmac_key;
+    has_keys_ = true;
+}
+
+bool RecordCipher::releaseContexts() {
+    bool released = tag_keys_ || encrypt_ || decrypt_;
+    if (tag_keys_) {
+        OPENSSL_cleanse(tag_keys_.get(), sizeof(TagKeys));
+        tag_keys_.reset();
+    }
+    EVP_CIPHER_CTX_free(encrypt_);
+    EVP_CIPHER_CTX_free(decrypt_);
+    encrypt_ = nullptr;
+    decrypt_ = nullptr;
+    return released;
+}
+
+size_t RecordCipher::getContextBytes() const {
+    return (tag_keys_ ? sizeof(TagKeys) : 0) + (encrypt_ ? CIPHER_CONTEXT_BYTES : 0) +
+           (decrypt_ ? CIPHER_CONTEXT_BYTES : 0);
+}
+
+// HMAC-SHA256 over the authenticated header (sequence through iv) and the
+// ciphertext, which sit on either side of the tag. The states after the
+// padded key are built once; each tag starts from copies of them.
+bool RecordCipher::computeTag(const unsigned char* header, const unsigned char* ciphertext,
+                              size_t ciphertext_size, unsigned char* tag) {
+    if (!tag_keys_) {
+        auto keys = std::make_unique<TagKeys>();
+        unsigned char inner_pad[SHA256_CBLOCK];
+        unsigned char outer_pad[SHA256_CBLOCK];
+        std::memset(inner_pad, 0x36, sizeof(inner_pad));
+        std::memset(outer_pad, 0x5c, sizeof(outer_pad));
+        for (size_t i = 0; i < hmac_key_.size(); ++i) {
+            inner_pad[i] ^= hmac_key_[i];
+            outer_pad[i] ^= hmac_key_[i];
+        }
+        bool ok = SHA256_Init(&keys->inner) == 1 && SHA256_Update(&keys->inner, inner_pad, sizeof(inner_pad)) == 1 &&
+                  SHA256_Init(&keys->outer) == 1 && SHA256_Update(&keys->outer, outer_pad, sizeof(outer_pad)) == 1;
+        OPENSSL_cleanse(inner_pad, sizeof(inner_pad));
+        OPENSSL_cleanse(outer_pad, sizeof(outer_pad));
+        if (!ok) {
+            OPENSSL_cleanse(keys.get(), sizeof(TagKeys));
+            return false;
+        }
+        tag_keys_ = std::move(keys);
+    }
+
+    unsigned char inner_digest[SHA256_DIGEST_LENGTH];
+    SHA256_CTX context = tag_keys_->inner;
+    bool ok = SHA256_Update(&context, header, AUTHENTICATED_HEADER_SIZE) == 1 &&
+              SHA256_Update(&context, ciphertext, ciphertext_size) == 1 && SHA256_Final(inner_digest, &context) == 1;
+    context = tag_keys_->outer;
+    ok = ok && SHA256_Update(&context, inner_digest, sizeof(inner_digest)) == 1 && SHA256_Final(tag, &context) == 1;
+    OPENSSL_cleanse(&context, sizeof(context));
+    return ok;
+}
+
+EncryptedRecord RecordCipher::seal(uint64_t sequence, uint64_t timestamp, std::string_view plaintext) {
+    using Layout = EncryptedRecord;
+    if (!has_keys_) {
+        return {};
+    }
+    if (!encrypt_) {
+        encrypt_ = EVP_CIPHER_CTX_new();
+        if (!encrypt_ || EVP_EncryptInit_ex(encrypt_, EVP_aes_256_cbc(), nullptr, key_.data(), nullptr) != 1) {
+            EVP_CIPHER_CTX_free(encrypt_);
+            encrypt_ = nullptr;
+            return {};
+        }
+    }
+
+    const size_t ciphertext_size = Layout::ciphertextSize(plaintext.size());
+    const size_t total = Layout::CIPHERTEXT_OFFSET + ciphertext_size;
+    bool ok = false;
+
+    utils::MessageBuffer bytes = utils::MessageBuffer::build(total, [&](char* out) {
+        auto record = reinterpret_cast<unsigned char*>(out);
+        putUint32(record, static_cast<uint32_t>(total - Layout::FRAME_HEADER_SIZE));
+        record[4] = Layout::DATA_FRAME_TYPE;
+        putUint64(record + Layout::SEQUENCE_OFFSET, sequence);
+        putUint64(record + Layout::TIMESTAMP_OFFSET, timestamp);
+        record[Layout::TAG_LENGTH_OFFSET] = static_cast<unsigned char>(HMAC_DIGEST_SIZE);
+        if (RAND_bytes(record + Layout::IV_OFFSET, static_cast<int>(AES_IV_SIZE)) != 1) {
+            return;
+        }
+
+        // Only the IV changes; the key schedule stays
+        unsigned char* ciphertext = record + Layout::CIPHERTEXT_OFFSET;
+        int written = 0;
+        int final_written = 0;
+        ok = EVP_EncryptInit_ex(encrypt_, nullptr, nullptr, nullptr, record + Layout::IV_OFFSET) == 1 &&
+             EVP_EncryptUpdate(encrypt_, ciphertext, &written, reinterpret_cast<const unsigned char*>(plaintext.data()),
+                               static_cast<int>(plaintext.size())) == 1 &&
+             EVP_EncryptFinal_ex(encrypt_, ciphertext + written, &final_written) == 1 &&
+             static_cast<size_t>(written + final_written) == ciphertext_size;
+
+        ok = ok && computeTag(record + Layout::SEQUENCE_OFFSET, ciphertext, ciphertext_size,
+                              record + Layout::TAG_OFFSET);
+    });
+
+    return ok ? EncryptedRecord(std::move(bytes)) : EncryptedRecord();
+}
+
+bool RecordCipher::open(std::string_view payload, std::string& plaintext) {
+    using Layout = EncryptedRecord;
+    // Offsets below are relative to the payload, i.e. without the frame header
+    constexpr size_t TAG_LENGTH = Layout::TAG_LENGTH_OFFSET - Layout::FRAME_HEADER_SIZE;
+    constexpr size_t TAG = Layout::TAG_OFFSET - Layout::FRAME_HEADER_SIZE;
+    constexpr size_t CIPHERTEXT = Layout::CIPHERTEXT_OFFSET - Layout::FRAME_HEADER_SIZE;
+    if (!has_keys_ || payload.size() < CIPHERTEXT + AES_IV_SIZE ||
+        static_cast<unsigned char>(payload[TAG_LENGTH]) != HMAC_DIGEST_SIZE ||
+        (payload.size() - CIPHERTEXT) % AES_IV_SIZE != 0) {
+        return false;
+    }
+
+    auto bytes = reinterpret_cast<const unsigned char*>(payload.data());
+    const unsigned char* ciphertext = bytes + CIPHERTEXT;
+    const size_t ciphertext_size = payload.size() - CIPHERTEXT;
+    unsigned char expected[HMAC_DIGEST_SIZE];
+    if (!computeTag(bytes, ciphertext, ciphertext_size, expected) ||
+        CRYPTO_memcmp(expected, bytes + TAG, HMAC_DIGEST_SIZE) != 0) {
+        return false;
+    }
+
+    if (!decrypt_) {
+        decrypt_ = EVP_CIPHER_CTX_new();
+        if (!decrypt_ || EVP_DecryptInit_ex(decrypt_, EVP_aes_256_cbc(), nullptr, key_.data(), nullptr) != 1) {
+            EVP_CIPHER_CTX_free(decrypt_);
+            decrypt_ = nullptr;
+            return false;
+        }
+    }
+
+    plaintext.resize(ciphertext_size);
+    auto out = reinterpret_cast<unsigned char*>(plaintext.data());
+    int written = 0;
+    int final_written = 0;
+    bool ok = EVP_DecryptInit_ex(decrypt_, nullptr, nullptr, nullptr,
+                                 bytes + Layout::IV_OFFSET - Layout::FRAME_HEADER_SIZE) == 1 &&
+              EVP_DecryptUpdate(decrypt_, out, &written, ciphertext, static_cast<int>(ciphertext_size)) == 1 &&
+              EVP_DecryptFinal_ex(decrypt_, out + written, &final_written) == 1;
+
+    plaintext.resize(ok ? static_cast<size_t>(written + final_written) : 0);
+    return ok;
+}
+
+EncryptedRecord EncryptedRecord::seal(const AESKey& key, const HMACKey& hmac_key, uint64_t sequence,
+                                      uint64_t timestamp, std::string_view plaintext) {
+    RecordCipher cipher;
+    cipher.setKeys(key, hmac_key);
+    return cipher.seal(sequence, timestamp, plaintext);
+}
+
+bool EncryptedRecord::open(const AESKey& key, const HMACKey& hmac_key, std::string_view payload,
+                           std::string& plaintext) {
+    RecordCipher cipher;
+    cipher.setKeys(key, hmac_key);
+    return cipher.open(payload, plaintext);
+}
+
+uint64_t EncryptedRecord::getSequence() const {
+    return empty() ? 0 : getUint64(bytes_.data() + SEQUENCE_OFFSET);
+}
+
+uint64_t EncryptedRecord::getTimestamp() const {
+    return empty() ? 0 : getUint64(bytes_.data() + TIMESTAMP_OFFSET);
+}
+
+} // namespace securechat::crypto
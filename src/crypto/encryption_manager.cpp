@@ -0,0 +1,371 @@
+#include "crypto/encryption_manager.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/kdf.h>
+#include <openssl/pem.h>
+
+namespace securechat::crypto {
+
+namespace {
+
+// Upper bound of what OpenSSL 3 allocates for one X25519 EVP_PKEY, generated
+// or read from PEM
+constexpr size_t KEY_OBJECT_BYTES = 1024;
+
+uint64_t nowMicros() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// DER SubjectPublicKeyInfo of an X25519 key, less the 32 key bytes. Public
+// keys travel as this in PEM; building and parsing it here skips OpenSSL 3's
+// generic decoder lookup, which costs about half a millisecond per key.
+constexpr unsigned char X25519_SPKI_PREFIX[] = {0x30, 0x2a, 0x30, 0x05, 0x06, 0x03, 0x2b, 0x65,
+                                                0x6e, 0x03, 0x21, 0x00};
+constexpr size_t X25519_KEY_SIZE = 32;
+constexpr size_t X25519_SPKI_SIZE = sizeof(X25519_SPKI_PREFIX) + X25519_KEY_SIZE;
+constexpr std::string_view PEM_BEGIN = "-----BEGIN PUBLIC KEY-----\n";
+constexpr std::string_view PEM_END = "-----END PUBLIC KEY-----\n";
+
+// nullptr unless pem is exactly the one-line PEM an X25519 key encodes to
+EVP_PKEY* readX25519PublicKey(std::string_view pem) {
+    if (pem.size() <= PEM_BEGIN.size() + PEM_END.size() || pem.substr(0, PEM_BEGIN.size()) != PEM_BEGIN ||
+        pem.substr(pem.size() - PEM_END.size()) != PEM_END) {
+        return nullptr;
+    }
+    std::string_view body = pem.substr(PEM_BEGIN.size(), pem.size() - PEM_BEGIN.size() - PEM_END.size());
+    if (body.empty() || body.back() != '\n') {
+        return nullptr;
+    }
+    body.remove_suffix(1);
+
+    // 44 DER bytes are 60 base64 characters, with one '=' of padding
+    unsigned char der[(X25519_SPKI_SIZE + 2) / 3 * 3];
+    if (body.size() != (X25519_SPKI_SIZE + 2) / 3 * 4 ||
+        EVP_DecodeBlock(der, reinterpret_cast<const unsigned char*>(body.data()), static_cast<int>(body.size())) !=
+            static_cast<int>(sizeof(der)) ||
+        std::memcmp(der, X25519_SPKI_PREFIX, sizeof(X25519_SPKI_PREFIX)) != 0) {
+        return nullptr;
+    }
+    return EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr, der + sizeof(X25519_SPKI_PREFIX),
+                                       X25519_KEY_SIZE);
+}
+
+// Payload of the DATA frame appendEncrypted() writes for this message, which
+// is what EncryptedRecord::open() takes
+std::string serialize(const EncryptedMessage& message) {
+    std::string payload;
+    payload.reserve(8 + 8 + AES_IV_SIZE + 1 + message.hmac.size() + message.ciphertext.size());
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        payload.push_back(static_cast<char>(message.sequence_number >> shift));
+    }
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        payload.push_back(static_cast<char>(message.timestamp >> shift));
+    }
+    payload.append(reinterpret_cast<const char*>(message.iv.data()), message.iv.size());
+    payload.push_back(static_cast<char>(message.hmac.size()));
+    payload.append(reinterpret_cast<const char*>(message.hmac.data()), message.hmac.size());
+    payload.append(reinterpret_cast<const char*>(message.ciphertext.data()), message.ciphertext.size());
+    return payload;
+}
+
+} // namespace
+
+EncryptionManager::EncryptionManager() = default;
+
+EncryptionManager::~EncryptionManager() {
+    EVP_PKEY_free(keypair_);
+    EVP_PKEY_free(peer_public_key_);
+    OPENSSL_cleanse(session_key_.data(), session_key_.size());
+    OPENSSL_cleanse(hmac_key_.data(), hmac_key_.size());
+}
+
+bool EncryptionManager::initialize() {
+    std::lock_guard<std::mutex> lock(crypto_mutex_);
+    if (initialized_) {
+        return true;
+    }
+    if (!initializeAES() || !initializeHMAC()) {
+        return false;
+    }
+    installSessionKeysLocked();
+    last_key_rotation_ = std::chrono::steady_clock::now();
+    initialized_ = true;
+    return true;
+}
+
+void EncryptionManager::installSessionKeysLocked() {
+    {
+        std::lock_guard<std::mutex> lock(seal_mutex_);
+        sealer_.setKeys(session_key_, hmac_key_);
+    }
+    std::lock_guard<std::mutex> lock(open_mutex_);
+    opener_.setKeys(session_key_, hmac_key_);
+}
+
+bool EncryptionManager::initializeAES() {
+    return RAND_bytes(session_key_.data(), static_cast<int>(session_key_.size())) == 1;
+}
+
+bool EncryptionManager::initializeHMAC() {
+    return RAND_bytes(hmac_key_.data(), static_cast<int>(hmac_key_.size())) == 1;
+}
+
+bool EncryptionManager::generateEphemeralKeys() {
+    EVP_PKEY* keypair = EVP_PKEY_Q_keygen(nullptr, nullptr, "X25519");
+    if (!keypair) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(crypto_mutex_);
+    EVP_PKEY_free(keypair_);
+    keypair_ = keypair;
+    last_key_rotation_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool EncryptionManager::exchangeKeys(const std::string& peer_public_key) {
+    EVP_PKEY* peer = readX25519PublicKey(peer_public_key);
+    if (!peer) {
+        BIO* bio = BIO_new_mem_buf(peer_public_key.data(), static_cast<int>(peer_public_key.size()));
+        peer = bio ? PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr) : nullptr;
+        BIO_free(bio);
+    }
+    if (!peer || EVP_PKEY_get_base_id(peer) != EVP_PKEY_X25519) {
+        EVP_PKEY_free(peer);
+        return false;
+    }
+
+    std::vector<unsigned char> shared_secret;
+    {
+        std::lock_guard<std::mutex> lock(crypto_mutex_);
+        if (!keypair_) {
+            EVP_PKEY_free(peer);
+            return false;
+        }
+
+        EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(keypair_, nullptr);
+        size_t secret_size = 0;
+        bool ok = ctx && EVP_PKEY_derive_init(ctx) == 1 && EVP_PKEY_derive_set_peer(ctx, peer) == 1 &&
+                  EVP_PKEY_derive(ctx, nullptr, &secret_size) == 1;
+        if (ok) {
+            shared_secret.resize(secret_size);
+            ok = EVP_PKEY_derive(ctx, shared_secret.data(), &secret_size) == 1;
+        }
+        EVP_PKEY_CTX_free(ctx);
+        if (!ok) {
+            EVP_PKEY_free(peer);
+            return false;
+        }
+
+        EVP_PKEY_free(peer_public_key_);
+        peer_public_key_ = peer;
+    }
+
+    bool derived = deriveSessionKeys(shared_secret);
+    OPENSSL_cleanse(shared_secret.data(), shared_secret.size());
+    return derived;
+}
+
+std::string EncryptionManager::getPublicKey() const {
+    std::lock_guard<std::mutex> lock(crypto_mutex_);
+    if (!keypair_) {
+        return {};
+    }
+
+    // Same bytes as PEM_write_bio_PUBKEY()
+    unsigned char der[X25519_SPKI_SIZE];
+    std::memcpy(der, X25519_SPKI_PREFIX, sizeof(X25519_SPKI_PREFIX));
+    size_t key_size = X25519_KEY_SIZE;
+    if (EVP_PKEY_get_raw_public_key(keypair_, der + sizeof(X25519_SPKI_PREFIX), &key_size) != 1 ||
+        key_size != X25519_KEY_SIZE) {
+        return {};
+    }
+    unsigned char base64[(X25519_SPKI_SIZE + 2) / 3 * 4 + 1];
+    int length = EVP_EncodeBlock(base64, der, static_cast<int>(sizeof(der)));
+
+    std::string pem;
+    pem.reserve(PEM_BEGIN.size() + static_cast<size_t>(length) + 1 + PEM_END.size());
+    pem.append(PEM_BEGIN).append(reinterpret_cast<const char*>(base64), static_cast<size_t>(length));
+    pem.push_back('\n');
+    pem.append(PEM_END);
+    return pem;
+}
+
+bool EncryptionManager::deriveSessionKeys(const std::vector<unsigned char>& shared_secret) {
+    // One HKDF output split into the AES and HMAC keys; both directions use
+    // the same keys, so the info string is fixed
+    static constexpr char INFO[] = "securechat session keys";
+    unsigned char keys[AES_KEY_SIZE + HMAC_KEY_SIZE];
+
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+    size_t length = sizeof(keys);
+    bool ok = ctx && EVP_PKEY_derive_init(ctx) == 1 &&
+              EVP_PKEY_CTX_set_hkdf_md(ctx, EVP_sha256()) == 1 &&
+              EVP_PKEY_CTX_set1_hkdf_key(ctx, shared_secret.data(), static_cast<int>(shared_secret.size())) == 1 &&
+              EVP_PKEY_CTX_add1_hkdf_info(ctx, reinterpret_cast<const unsigned char*>(INFO),
+                                          static_cast<int>(sizeof(INFO) - 1)) == 1 &&
+              EVP_PKEY_derive(ctx, keys, &length) == 1 && length == sizeof(keys);
+    EVP_PKEY_CTX_free(ctx);
+
+    if (ok) {
+        std::lock_guard<std::mutex> lock(crypto_mutex_);
+        std::memcpy(session_key_.data(), keys, AES_KEY_SIZE);
+        std::memcpy(hmac_key_.data(), keys + AES_KEY_SIZE, HMAC_KEY_SIZE);
+        installSessionKeysLocked();
+        initialized_ = true;
+    }
+    OPENSSL_cleanse(keys, sizeof(keys));
+    return ok;
+}
+
+bool EncryptionManager::releaseHandshakeKeys() {
+    std::lock_guard<std::mutex> lock(crypto_mutex_);
+    if (!initialized_ || !peer_public_key_) {
+        return false;
+    }
+    EVP_PKEY_free(keypair_);
+    EVP_PKEY_free(peer_public_key_);
+    keypair_ = nullptr;
+    peer_public_key_ = nullptr;
+    return true;
+}
+
+bool EncryptionManager::releaseRecordContexts() {
+    bool released = false;
+    {
+        std::lock_guard<std::mutex> lock(seal_mutex_);
+        released = sealer_.releaseContexts();
+    }
+    std::lock_guard<std::mutex> lock(open_mutex_);
+    return opener_.releaseContexts() || released;
+}
+
+size_t EncryptionManager::getResidentBytes() const {
+    size_t bytes = sizeof(*this);
+    {
+        std::lock_guard<std::mutex> lock(crypto_mutex_);
+        bytes += (keypair_ ? KEY_OBJECT_BYTES : 0) + (peer_public_key_ ? KEY_OBJECT_BYTES : 0);
+    }
+    {
+        std::lock_guard<std::mutex> lock(seal_mutex_);
+        bytes += sealer_.getContextBytes();
+    }
+    std::lock_guard<std::mutex> lock(open_mutex_);
+    return bytes + opener_.getContextBytes();
+}
+
+std::unique_ptr<EncryptedMessage> EncryptionManager::encrypt(const std::string& plaintext) {
+    EncryptedRecord record = encrypt(utils::MessageBuffer(plaintext));
+    if (record.empty()) {
+        return nullptr;
+    }
+
+    auto message = std::make_unique<EncryptedMessage>();
+    message->sequence_number = record.getSequence();
+    message->timestamp = record.getTimestamp();
+    std::memcpy(message->iv.data(), record.iv().data(), AES_IV_SIZE);
+    auto tag = record.tag();
+    message->hmac.assign(tag.begin(), tag.end());
+    auto ciphertext = record.ciphertext();
+    message->ciphertext.assign(ciphertext.begin(), ciphertext.end());
+    return message;
+}
+
+EncryptedRecord EncryptionManager::encrypt(const utils::MessageBuffer& plaintext) {
+    std::lock_guard<std::mutex> lock(seal_mutex_);
+    if (!sealer_.hasKeys()) {
+        return {};
+    }
+    uint64_t sequence = send_sequence_.fetch_add(1, std::memory_order_relaxed) + 1;
+    return sealer_.seal(sequence, nowMicros(), plaintext.view());
+}
+
+std::string EncryptionManager::decrypt(const EncryptedMessage& encrypted_msg) {
+    return decrypt(std::string_view(serialize(encrypted_msg)));
+}
+
+std::string EncryptionManager::decrypt(std::string_view record_payload) {
+    std::string plaintext;
+    decrypt(record_payload, plaintext);
+    return plaintext;
+}
+
+bool EncryptionManager::decrypt(std::string_view record_payload, std::string& plaintext) {
+    std::lock_guard<std::mutex> lock(open_mutex_);
+    if (!opener_.open(record_payload, plaintext)) {
+        plaintext.clear();
+        return false;
+    }
+    return true;
+}
+
+std::vector<unsigned char> EncryptionManager::computeHMAC(const std::vector<unsigned char>& data) const {
+    std::vector<unsigned char> digest(HMAC_DIGEST_SIZE);
+    unsigned int digest_length = 0;
+    std::lock_guard<std::mutex> lock(crypto_mutex_);
+    if (!HMAC(EVP_sha256(), hmac_key_.data(), static_cast<int>(hmac_key_.size()), data.data(), data.size(),
+              digest.data(), &digest_length)) {
+        return {};
+    }
+    digest.resize(digest_length);
+    return digest;
+}
+
+bool EncryptionManager::verifyHMAC(const std::vector<unsigned char>& data,
+                                   const std::vector<unsigned char>& hmac) const {
+    auto expected = computeHMAC(data);
+    return !expected.empty() && expected.size() == hmac.size() &&
+           CRYPTO_memcmp(expected.data(), hmac.data(), hmac.size()) == 0;
+}
+
+void EncryptionManager::rotateKeys() {
+    // A fresh key pair; the session keys change with the next exchangeKeys()
+    generateEphemeralKeys();
+}
+
+std::vector<unsigned char> EncryptionManager::generateRandomBytes(size_t length) {
+    std::vector<unsigned char> bytes(length);
+    if (length > 0 && RAND_bytes(bytes.data(), static_cast<int>(length)) != 1) {
+        throw std::runtime_error("RAND_bytes failed");
+    }
+    return bytes;
+}
+
+std::string EncryptionManager::bytesToHex(const std::vector<unsigned char>& bytes) {
+    static constexpr char DIGITS[] = "0123456789ABCDEF";
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (unsigned char byte : bytes) {
+        hex.push_back(DIGITS[byte >> 4]);
+        hex.push_back(DIGITS[byte & 0x0F]);
+    }
+    return hex;
+}
+
+std::vector<unsigned char> EncryptionManager::hexToBytes(const std::string& hex) {
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    std::vector<unsigned char> bytes;
+    bytes.reserve(hex.size() / 2);
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        int high = nibble(hex[i]);
+        int low = nibble(hex[i + 1]);
+        if (high < 0 || low < 0) {
+            return {};
+        }
+        bytes.push_back(static_cast<unsigned char>((high << 4) | low));
+    }
+    return bytes;
+}
+
+} // namespace securechat::crypto
@@ -0,0 +1,754 @@
+#include "loadgen/load_generator.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/hmac.h>
+
+#include "crypto/encryption_manager.hpp"
+#include "network/protocol_handler.hpp"
+
+namespace securechat::loadgen {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Plaintext stamp prefixed to every generated message: "LG1 <sender> <send_ns>|"
+constexpr std::string_view STAMP_PREFIX = "LG1 ";
+
+uint64_t toNanos(Clock::time_point time) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+bool parseStamp(std::string_view plaintext, uint64_t& sender_id, uint64_t& send_ns) {
+    if (plaintext.substr(0, STAMP_PREFIX.size()) != STAMP_PREFIX) {
+        return false;
+    }
+    const char* cursor = plaintext.data() + STAMP_PREFIX.size();
+    const char* end = plaintext.data() + plaintext.size();
+
+    auto sender = std::from_chars(cursor, end, sender_id);
+    if (sender.ec != std::errc() || sender.ptr == end || *sender.ptr != ' ') {
+        return false;
+    }
+    auto stamp = std::from_chars(sender.ptr + 1, end, send_ns);
+    return stamp.ec == std::errc() && stamp.ptr != end && *stamp.ptr == '|';
+}
+
+// Base64url without padding, as JWTs use it
+std::string base64Url(std::string_view data) {
+    static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string out;
+    out.reserve((data.size() * 4 + 2) / 3);
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t chunk = static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << 16;
+        if (i + 1 < data.size()) chunk |= static_cast<uint32_t>(static_cast<unsigned char>(data[i + 1])) << 8;
+        if (i + 2 < data.size()) chunk |= static_cast<unsigned char>(data[i + 2]);
+        out += ALPHABET[(chunk >> 18) & 63];
+        out += ALPHABET[(chunk >> 12) & 63];
+        if (i + 1 < data.size()) out += ALPHABET[(chunk >> 6) & 63];
+        if (i + 2 < data.size()) out += ALPHABET[chunk & 63];
+    }
+    return out;
+}
+
+// HS256 JWT for subject, the token AuthManager::authenticate() verifies.
+// Empty if signing fails.
+std::string signToken(const std::string& secret, const std::string& subject, int64_t expiry) {
+    std::string signing_input = base64Url(R"({"alg":"HS256","typ":"JWT"})") + "." +
+        base64Url(R"({"sub":")" + subject + R"(","exp":)" + std::to_string(expiry) + "}");
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_length = 0;
+    if (!HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+              reinterpret_cast<const unsigned char*>(signing_input.data()), signing_input.size(),
+              digest, &digest_length)) {
+        return {};
+    }
+    return signing_input + "." +
+        base64Url(std::string_view(reinterpret_cast<const char*>(digest), digest_length));
+}
+
+} // namespace
+
+class LoadGenerator::Worker {
+public:
+    Worker(const LoadGeneratorConfig& config, const sockaddr_in& address, uint64_t first_client,
+           size_t client_count, double connect_rate)
+        : config_(config)
+        , address_(address)
+        , connect_interval_(connect_rate > 0 ? std::chrono::duration_cast<Clock::duration>(
+                                                   std::chrono::duration<double>(1.0 / connect_rate))
+                                             : Clock::duration::zero())
+        , send_interval_(config.messages_per_second > 0
+                             ? std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>(1.0 / config.messages_per_second))
+                             : Clock::duration::zero())
+        , rng_(static_cast<uint32_t>(first_client))
+        , logger_("LoadGenerator") {
+        clients_.resize(client_count);
+        for (size_t i = 0; i < client_count; ++i) {
+            clients_[i].id = first_client + i;
+            clients_[i].room = (first_client + i) / std::max<size_t>(config_.room_size, 1);
+        }
+        read_buffer_.resize(READ_BUFFER_SIZE);
+    }
+
+    ~Worker() {
+        join();
+        for (auto& client : clients_) {
+            if (client.fd >= 0) {
+                close(client.fd);
+            }
+        }
+        if (epoll_fd_ >= 0) {
+            close(epoll_fd_);
+        }
+    }
+
+    void start(Clock::time_point measure_start, Clock::time_point end_time, const std::atomic<bool>& stop) {
+        measure_start_ = measure_start;
+        measure_start_ns_ = toNanos(measure_start);
+        end_time_ = end_time;
+        // Tokens outlive the run by an hour
+        token_expiry_ = std::chrono::duration_cast<std::chrono::seconds>(
+            (std::chrono::system_clock::now() + (end_time - Clock::now()) + std::chrono::hours(1))
+                .time_since_epoch()).count();
+        key_thread_ = std::thread([this, &stop]() { generateKeys(stop); });
+        thread_ = std::thread([this, &stop]() { run(stop); });
+    }
+
+    void join() {
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (key_thread_.joinable()) {
+            key_thread_.join();
+        }
+    }
+
+    // Progress counters readable while the worker runs
+    uint64_t getConnected() const { return connected_.load(std::memory_order_relaxed); }
+    uint64_t getSent() const { return sent_total_.load(std::memory_order_relaxed); }
+    uint64_t getReceived() const { return received_total_.load(std::memory_order_relaxed); }
+
+    // Valid after join()
+    void mergeInto(LoadReport& report) const {
+        report.connected += connected_.load();
+        report.handshake_failures += handshake_failures_;
+        report.auth_failures += auth_failures_;
+        report.disconnects += disconnects_;
+        report.decrypt_failures += decrypt_failures_;
+        report.messages_sent += measured_sent_;
+        report.messages_received += measured_received_;
+        report.handshake_latency.merge(handshake_latency_);
+        report.delivery_latency.merge(delivery_latency_);
+    }
+
+private:
+    enum class State : uint8_t {
+        IDLE,
+        CONNECTING,
+        KEY_EXCHANGE,
+        AUTHENTICATING,
+        ACTIVE,
+        CLOSED
+    };
+
+    struct Client {
+        int fd{-1};
+        uint64_t id{0};
+        uint64_t room{0};
+        State state{State::IDLE};
+        bool want_write{false};
+        Clock::time_point connect_start;
+        std::unique_ptr<crypto::EncryptionManager> encryption;
+        std::unique_ptr<network::ProtocolHandler> decoder;
+        std::string outbound;
+        size_t outbound_offset{0};
+        // Highest DATA record received but not yet acknowledged to the server
+        uint64_t unacked_sequence{0};
+    };
+
+    using SendEntry = std::pair<Clock::time_point, uint32_t>;
+    using KeyPtr = std::unique_ptr<crypto::EncryptionManager>;
+
+    // Key generation runs on its own thread ahead of the connect ramp
+    // instead of on the epoll loop. A null entry records a failed generation.
+    void generateKeys(const std::atomic<bool>& stop) {
+        for (size_t i = 0; i < clients_.size(); ++i) {
+            if (stop.load(std::memory_order_relaxed) || Clock::now() >= end_time_) {
+                break;
+            }
+            auto encryption = std::make_unique<crypto::EncryptionManager>();
+            if (!encryption->initialize() || !encryption->generateEphemeralKeys()) {
+                logger_.error("Failed to generate keys for client {}", clients_[i].id);
+                encryption.reset();
+            }
+            std::lock_guard<std::mutex> lock(key_mutex_);
+            generated_keys_.push_back(std::move(encryption));
+        }
+    }
+
+    // Moves every generated key into the loop's own queue under one lock
+    bool haveKeys() {
+        if (ready_keys_.empty()) {
+            std::lock_guard<std::mutex> lock(key_mutex_);
+            for (auto& key : generated_keys_) {
+                ready_keys_.push_back(std::move(key));
+            }
+            generated_keys_.clear();
+        }
+        return !ready_keys_.empty();
+    }
+
+    void run(const std::atomic<bool>& stop) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            logger_.error("epoll_create1 failed: {}", std::strerror(errno));
+            return;
+        }
+
+        std::vector<epoll_event> events(MAX_EVENTS);
+        auto next_connect = Clock::now();
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            auto now = Clock::now();
+            if (now >= end_time_) {
+                break;
+            }
+
+            // Ramp up connections at the configured rate, as fast as keys allow
+            bool waiting_for_keys = false;
+            while (next_connect_index_ < clients_.size() && now >= next_connect) {
+                if (!haveKeys()) {
+                    // Don't bank the lost time as a burst once keys catch up
+                    next_connect = now;
+                    waiting_for_keys = true;
+                    break;
+                }
+                beginConnect(static_cast<uint32_t>(next_connect_index_++));
+                next_connect += connect_interval_;
+            }
+
+            auto wake = std::min(end_time_, now + std::chrono::milliseconds(100));
+            if (waiting_for_keys) {
+                wake = std::min(wake, now + KEY_POLL_INTERVAL);
+            } else if (next_connect_index_ < clients_.size()) {
+                wake = std::min(wake, next_connect);
+            }
+            if (!send_schedule_.empty()) {
+                wake = std::min(wake, send_schedule_.top().first);
+            }
+            auto timeout_ms = static_cast<int>(std::max<int64_t>(0,
+                std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count()));
+
+            int count = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout_ms);
+            for (int i = 0; i < count; ++i) {
+                handleEvent(events[i].data.u32, events[i].events);
+            }
+
+            sendDueMessages();
+        }
+    }
+
+    void beginConnect(uint32_t index) {
+        Client& client = clients_[index];
+        client.connect_start = Clock::now();
+        client.encryption = std::move(ready_keys_.front());
+        ready_keys_.pop_front();
+        if (!client.encryption) {
+            fail(client, handshake_failures_);
+            return;
+        }
+
+        client.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (client.fd < 0) {
+            logger_.error("socket() failed for client {}: {}", client.id, std::strerror(errno));
+            fail(client, handshake_failures_);
+            return;
+        }
+
+        int one = 1;
+        setsockopt(client.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (connect(client.fd, reinterpret_cast<const sockaddr*>(&address_), sizeof(address_)) < 0 &&
+            errno != EINPROGRESS) {
+            logger_.debug("connect() failed for client {}: {}", client.id, std::strerror(errno));
+            fail(client, handshake_failures_);
+            return;
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+        event.data.u32 = index;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client.fd, &event);
+        client.state = State::CONNECTING;
+        client.want_write = true;
+    }
+
+    void handleEvent(uint32_t index, uint32_t events) {
+        Client& client = clients_[index];
+        if (client.state == State::CLOSED || client.state == State::IDLE) {
+            return;
+        }
+
+        if (client.state == State::CONNECTING) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(client.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0 || (events & (EPOLLERR | EPOLLHUP))) {
+                logger_.debug("Client {} failed to connect: {}", client.id, std::strerror(error));
+                fail(client, handshake_failures_);
+                return;
+            }
+            if (!(events & EPOLLOUT)) {
+                return;
+            }
+            startHandshake(client);
+            if (client.state == State::CLOSED) {
+                return;
+            }
+        }
+
+        if (events & EPOLLIN) {
+            readFrom(index);
+            if (client.state == State::CLOSED) {
+                return;
+            }
+        }
+        if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+            fail(client, client.state == State::ACTIVE ? disconnects_ : handshake_failures_);
+            return;
+        }
+        if (events & EPOLLOUT) {
+            flush(index);
+        }
+    }
+
+    void startHandshake(Client& client) {
+        // Each simulated client owns real ephemeral keys, generated before connect
+        client.decoder = std::make_unique<network::ProtocolHandler>();
+        network::ProtocolHandler::appendFrame(client.outbound, network::FrameType::KEY_EXCHANGE,
+                                              client.encryption->getPublicKey());
+        client.state = State::KEY_EXCHANGE;
+    }
+
+    void readFrom(uint32_t index) {
+        Client& client = clients_[index];
+        while (true) {
+            ssize_t received = recv(client.fd, read_buffer_.data(), read_buffer_.size(), 0);
+            if (received > 0) {
+                client.decoder->append(read_buffer_.data(), static_cast<size_t>(received));
+                if (static_cast<size_t>(received) < read_buffer_.size()) {
+                    break;
+                }
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                fail(client, client.state == State::ACTIVE ? disconnects_ : handshake_failures_);
+                return;
+            }
+            if (errno != EINTR) {
+                break;
+            }
+        }
+
+        network::Frame frame;
+        while (client.state != State::CLOSED && client.decoder->nextFrame(frame)) {
+            handleFrame(index, frame);
+        }
+        // One cumulative ack per read covers every record it delivered
+        if (client.state == State::ACTIVE && client.unacked_sequence != 0) {
+            network::ProtocolHandler::appendAck(client.outbound, client.unacked_sequence);
+            client.unacked_sequence = 0;
+        }
+        if (client.decoder && client.decoder->hasError()) {
+            logger_.warn("Client {} received an oversized frame", client.id);
+            fail(client, client.state == State::ACTIVE ? disconnects_ : handshake_failures_);
+            return;
+        }
+        if (client.state != State::CLOSED && !client.outbound.empty()) {
+            flush(index);
+        }
+    }
+
+    void handleFrame(uint32_t index, const network::Frame& frame) {
+        Client& client = clients_[index];
+        switch (frame.type) {
+            case network::FrameType::KEY_EXCHANGE: {
+                if (client.state != State::KEY_EXCHANGE ||
+                    !client.encryption->exchangeKeys(std::string(frame.payload))) {
+                    fail(client, handshake_failures_);
+                    return;
+                }
+                std::string username = config_.username_prefix + std::to_string(client.id);
+                std::string token = signToken(config_.jwt_secret, username, token_expiry_);
+                if (token.empty()) {
+                    fail(client, auth_failures_);
+                    return;
+                }
+                network::ProtocolHandler::appendAuth(client.outbound, username, token);
+                client.state = State::AUTHENTICATING;
+                break;
+            }
+
+            case network::FrameType::AUTH_RESULT: {
+                network::AuthStatus status;
+                std::string_view detail;
+                if (client.state != State::AUTHENTICATING ||
+                    !network::ProtocolHandler::parseAuthResult(frame.payload, status, detail) ||
+                    status != network::AuthStatus::OK) {
+                    fail(client, auth_failures_);
+                    return;
+                }
+                auto now = Clock::now();
+                handshake_latency_.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - client.connect_start).count()));
+                network::ProtocolHandler::appendJoinRoom(client.outbound, client.room);
+                client.state = State::ACTIVE;
+                connected_.fetch_add(1, std::memory_order_relaxed);
+
+                // Spread first sends across one interval so clients don't fire in lockstep
+                if (send_interval_ > Clock::duration::zero()) {
+                    std::uniform_int_distribution<int64_t> phase(0, send_interval_.count());
+                    send_schedule_.push({now + Clock::duration(phase(rng_)), index});
+                }
+                break;
+            }
+
+            case network::FrameType::DATA:
+                if (client.state == State::ACTIVE) {
+                    handleData(client, frame.payload);
+                }
+                break;
+
+            case network::FrameType::PING:
+                network::ProtocolHandler::appendFrame(client.outbound, network::FrameType::PONG, frame.payload);
+                break;
+
+            case network::FrameType::ERROR:
+                logger_.debug("Client {} received error: {}", client.id, std::string(frame.payload));
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    void handleData(Client& client, std::string_view payload) {
+        auto now_ns = toNanos(Clock::now());
+        if (!network::ProtocolHandler::parseEncrypted(payload, scratch_message_)) {
+            decrypt_failures_++;
+            return;
+        }
+        std::string plaintext = client.encryption->decrypt(scratch_message_);
+        if (plaintext.empty()) {
+            decrypt_failures_++;
+            return;
+        }
+
+        received_total_.fetch_add(1, std::memory_order_relaxed);
+        client.unacked_sequence = scratch_message_.sequence_number;
+        uint64_t sender_id = 0;
+        uint64_t send_ns = 0;
+        if (parseStamp(plaintext, sender_id, send_ns) && send_ns >= measure_start_ns_ && now_ns >= send_ns) {
+            measured_received_++;
+            delivery_latency_.record(now_ns - send_ns);
+        }
+    }
+
+    void sendDueMessages() {
+        auto now = Clock::now();
+        while (!send_schedule_.empty() && send_schedule_.top().first <= now) {
+            auto [due, index] = send_schedule_.top();
+            send_schedule_.pop();
+
+            Client& client = clients_[index];
+            if (client.state != State::ACTIVE) {
+                continue;
+            }
+
+            sendMessage(client, now);
+            flush(index);
+
+            // Keep the configured rate, but skip ahead rather than burst after a stall
+            auto next = due + send_interval_;
+            send_schedule_.push({next < now ? now + send_interval_ : next, index});
+        }
+    }
+
+    void sendMessage(Client& client, Clock::time_point now) {
+        auto send_ns = toNanos(now);
+        plaintext_.assign(STAMP_PREFIX);
+        plaintext_ += std::to_string(client.id);
+        plaintext_ += ' ';
+        plaintext_ += std::to_string(send_ns);
+        plaintext_ += '|';
+        if (plaintext_.size() < config_.message_size) {
+            plaintext_.append(config_.message_size - plaintext_.size(), 'x');
+        }
+
+        auto encrypted = client.encryption->encrypt(plaintext_);
+        if (!encrypted) {
+            return;
+        }
+        network::ProtocolHandler::appendEncrypted(client.outbound, *encrypted);
+
+        sent_total_.fetch_add(1, std::memory_order_relaxed);
+        if (now >= measure_start_) {
+            measured_sent_++;
+        }
+    }
+
+    void flush(uint32_t index) {
+        Client& client = clients_[index];
+        while (client.outbound_offset < client.outbound.size()) {
+            ssize_t written = send(client.fd, client.outbound.data() + client.outbound_offset,
+                                   client.outbound.size() - client.outbound_offset, MSG_NOSIGNAL);
+            if (written > 0) {
+                client.outbound_offset += static_cast<size_t>(written);
+                continue;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(client, client.state == State::ACTIVE ? disconnects_ : handshake_failures_);
+                return;
+            }
+            break;
+        }
+
+        if (client.outbound_offset == client.outbound.size()) {
+            client.outbound.clear();
+            client.outbound_offset = 0;
+        }
+
+        // Only poll for writability while there is a backlog
+        bool want_write = !client.outbound.empty();
+        if (want_write != client.want_write) {
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP | (want_write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+            event.data.u32 = index;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client.fd, &event);
+            client.want_write = want_write;
+        }
+    }
+
+    void fail(Client& client, uint64_t& counter) {
+        counter++;
+        if (client.state == State::ACTIVE) {
+            connected_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (client.fd >= 0) {
+            close(client.fd);
+            client.fd = -1;
+        }
+        client.state = State::CLOSED;
+        client.encryption.reset();
+        client.decoder.reset();
+        client.outbound.clear();
+        client.outbound.shrink_to_fit();
+    }
+
+    static constexpr size_t MAX_EVENTS = 1024;
+    static constexpr size_t READ_BUFFER_SIZE = 65536;
+    static constexpr auto KEY_POLL_INTERVAL = std::chrono::milliseconds(10);
+
+    const LoadGeneratorConfig& config_;
+    const sockaddr_in address_;
+    const Clock::duration connect_interval_;
+    const Clock::duration send_interval_;
+
+    std::vector<Client> clients_;
+    size_t next_connect_index_{0};
+    std::priority_queue<SendEntry, std::vector<SendEntry>, std::greater<SendEntry>> send_schedule_;
+
+    int epoll_fd_{-1};
+    std::thread thread_;
+
+    // Key pool filled by key_thread_; ready_keys_ is owned by the epoll loop
+    std::thread key_thread_;
+    std::mutex key_mutex_;
+    std::vector<KeyPtr> generated_keys_;
+    std::deque<KeyPtr> ready_keys_;
+    Clock::time_point measure_start_;
+    uint64_t measure_start_ns_{0};
+    Clock::time_point end_time_;
+    int64_t token_expiry_{0};
+
+    // Scratch space reused across messages
+    std::vector<char> read_buffer_;
+    std::string plaintext_;
+    crypto::EncryptedMessage scratch_message_;
+    std::mt19937 rng_;
+
+    // Statistics
+    std::atomic<uint64_t> connected_{0};
+    std::atomic<uint64_t> sent_total_{0};
+    std::atomic<uint64_t> received_total_{0};
+    uint64_t handshake_failures_{0};
+    uint64_t auth_failures_{0};
+    uint64_t disconnects_{0};
+    uint64_t decrypt_failures_{0};
+    uint64_t measured_sent_{0};
+    uint64_t measured_received_{0};
+    utils::LatencyHistogram handshake_latency_;
+    utils::LatencyHistogram delivery_latency_;
+
+    // Logging
+    utils::Logger logger_;
+};
+
+LoadGenerator::LoadGenerator(const LoadGeneratorConfig& config)
+    : config_(config)
+    , logger_("LoadGenerator") {
+}
+
+LoadGenerator::~LoadGenerator() {
+    stop();
+}
+
+LoadReport LoadGenerator::run() {
+    LoadReport report;
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(config_.port));
+    if (inet_pton(AF_INET, config_.host.c_str(), &address.sin_addr) != 1) {
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(config_.host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+            logger_.error("Cannot resolve {}", config_.host);
+            return report;
+        }
+        address.sin_addr = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr;
+        freeaddrinfo(result);
+    }
+
+    int threads = config_.threads > 0 ? config_.threads
+                                      : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threads = static_cast<int>(std::min<size_t>(static_cast<size_t>(threads), std::max<size_t>(config_.clients, 1)));
+
+    // Contiguous client ranges keep most rooms inside one worker
+    size_t per_worker = config_.clients / static_cast<size_t>(threads);
+    size_t remainder = config_.clients % static_cast<size_t>(threads);
+    uint64_t next_client = 0;
+    for (int i = 0; i < threads; ++i) {
+        size_t count = per_worker + (static_cast<size_t>(i) < remainder ? 1 : 0);
+        workers_.push_back(std::make_unique<Worker>(config_, address, next_client, count,
+                                                    config_.connect_rate / threads));
+        next_client += count;
+    }
+
+    logger_.info("Starting {} clients on {} threads against {}:{}", config_.clients, threads,
+                 config_.host, config_.port);
+
+    auto start = std::chrono::steady_clock::now();
+    auto measure_start = start + config_.warmup;
+    auto end_time = measure_start + config_.duration;
+    for (auto& worker : workers_) {
+        worker->start(measure_start, end_time, stop_requested_);
+    }
+
+    while (!stop_requested_.load() && std::chrono::steady_clock::now() < end_time) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        printProgress(start);
+    }
+
+    for (auto& worker : workers_) {
+        worker->join();
+        worker->mergeInto(report);
+    }
+
+    auto measured = std::min(std::chrono::steady_clock::now(), end_time) - measure_start;
+    report.measured_seconds = std::max(0.0, std::chrono::duration<double>(measured).count());
+
+    // Every message fans out to the rest of its room
+    size_t room = std::min(std::max<size_t>(config_.room_size, 1), std::max<size_t>(config_.clients, 1));
+    report.expected_deliveries = report.messages_sent * (room - 1);
+
+    workers_.clear();
+    return report;
+}
+
+void LoadGenerator::stop() {
+    stop_requested_.store(true);
+}
+
+void LoadGenerator::printProgress(std::chrono::steady_clock::time_point start) {
+    uint64_t connected = 0;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    for (const auto& worker : workers_) {
+        connected += worker->getConnected();
+        sent += worker->getSent();
+        received += worker->getReceived();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start);
+    logger_.info("[{}s] connected {}/{}, sent {}, received {}", elapsed.count(), connected, config_.clients,
+                 sent, received);
+}
+
+void LoadGenerator::printReport(const LoadGeneratorConfig& config, const LoadReport& report, std::ostream& out) {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    double seconds = report.measured_seconds > 0 ? report.measured_seconds : 1.0;
+
+    out << std::fixed << std::setprecision(1);
+    out << "\nSecureChat load test: " << config.clients << " clients, room size " << config.room_size
+        << ", " << config.messages_per_second << " msg/s per client, " << config.message_size
+        << " byte messages\n";
+
+    out << "\nConnections\n"
+        << "  established:        " << report.connected << " / " << config.clients << "\n"
+        << "  handshake failures: " << report.handshake_failures << "\n"
+        << "  auth failures:      " << report.auth_failures << "\n"
+        << "  disconnects:        " << report.disconnects << "\n"
+        << "  handshake p50/p99:  " << us(report.handshake_latency.percentile(50)) << " / "
+        << us(report.handshake_latency.percentile(99)) << " us\n";
+
+    double delivery_ratio = report.expected_deliveries
+        ? 100.0 * static_cast<double>(report.messages_received) / static_cast<double>(report.expected_deliveries)
+        : 0.0;
+    out << "\nMessages (" << report.measured_seconds << "s measured)\n"
+        << "  sent:               " << report.messages_sent << " ("
+        << static_cast<double>(report.messages_sent) / seconds << "/s)\n"
+        << "  delivered:          " << report.messages_received << " ("
+        << static_cast<double>(report.messages_received) / seconds << "/s)\n"
+        << "  expected:           " << report.expected_deliveries << " (" << delivery_ratio << "% delivered)\n"
+        << "  decrypt failures:   " << report.decrypt_failures << "\n";
+
+    const auto& latency = report.delivery_latency;
+    out << "\nDelivery latency (us)\n"
+        << "  min:    " << us(latency.getMin()) << "\n"
+        << "  mean:   " << latency.getMean() / 1000.0 << "\n"
+        << "  p50:    " << us(latency.percentile(50)) << "\n"
+        << "  p90:    " << us(latency.percentile(90)) << "\n"
+        << "  p99:    " << us(latency.percentile(99)) << "\n"
+        << "  p99.9:  " << us(latency.percentile(99.9)) << "\n"
+        << "  max:    " << us(latency.getMax()) << "\n";
+}
+
+} // namespace securechat::loadgen
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <csignal>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "loadgen/load_generator.hpp"
+#include "utils/logger.hpp"
+
+using namespace securechat;
+
+// Global generator instance for signal handling
+loadgen::LoadGenerator* g_generator = nullptr;
+
+void signalHandler(int) {
+    if (g_generator) {
+        g_generator->stop();
+    }
+}
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [OPTIONS]\n"
+              << "\nOptions:\n"
+              << "  -H, --host HOST          Server address (default: 127.0.0.1)\n"
+              << "  -p, --port PORT          Server port (default: 8080)\n"
+              << "  -n, --clients NUM        Simulated clients (default: 1000)\n"
+              << "  -t, --threads NUM        Event loop threads (default: auto)\n"
+              << "  -r, --room-size NUM      Clients per room (default: 100)\n"
+              << "  -m, --rate MSGS          Messages per second per client (default: 1)\n"
+              << "  -s, --message-size BYTES Plaintext message size (default: 128)\n"
+              << "  -c, --connect-rate NUM   New connections per second (default: 2000)\n"
+              << "  -w, --warmup SECONDS     Warmup before measuring (default: 5)\n"
+              << "  -d, --duration SECONDS   Measurement duration (default: 60)\n"
+              << "  -u, --user-prefix NAME   Username prefix (default: loadgen)\n"
+              << "  -S, --jwt-secret SECRET  The server's authentication.jwt_secret (required)\n"
+              << "  -l, --log-level LVL      Log level (trace|debug|info|warn|error|fatal)\n"
+              << "  -h, --help               Show this help message\n"
+              << std::endl;
+}
+
+// Each client needs a descriptor; raise the soft limit as far as allowed
+void raiseFileLimit(size_t clients) {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return;
+    }
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < clients + 64) {
+        utils::g_logger.warn("Open file limit {} is too low for {} clients", limit.rlim_cur, clients);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    loadgen::LoadGeneratorConfig config;
+    std::string log_level = "info";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " requires a value" << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        try {
+            if (arg == "-H" || arg == "--host") {
+                config.host = value;
+            } else if (arg == "-p" || arg == "--port") {
+                config.port = std::stoi(value);
+            } else if (arg == "-n" || arg == "--clients") {
+                config.clients = std::stoul(value);
+            } else if (arg == "-t" || arg == "--threads") {
+                config.threads = std::stoi(value);
+            } else if (arg == "-r" || arg == "--room-size") {
+                config.room_size = std::stoul(value);
+            } else if (arg == "-m" || arg == "--rate") {
+                config.messages_per_second = std::stod(value);
+            } else if (arg == "-s" || arg == "--message-size") {
+                config.message_size = std::stoul(value);
+            } else if (arg == "-c" || arg == "--connect-rate") {
+                config.connect_rate = std::stod(value);
+            } else if (arg == "-w" || arg == "--warmup") {
+                config.warmup = std::chrono::seconds(std::stoi(value));
+            } else if (arg == "-d" || arg == "--duration") {
+                config.duration = std::chrono::seconds(std::stoi(value));
+            } else if (arg == "-u" || arg == "--user-prefix") {
+                config.username_prefix = value;
+            } else if (arg == "-S" || arg == "--jwt-secret") {
+                config.jwt_secret = value;
+            } else if (arg == "-l" || arg == "--log-level") {
+                log_level = value;
+            } else {
+                std::cerr << "Error: Unknown option " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Error: Invalid value for " << arg << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    if (config.jwt_secret.empty()) {
+        std::cerr << "Error: --jwt-secret is required to sign client tokens" << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    utils::LogLevel level = utils::LogLevel::INFO;
+    if (log_level == "trace") level = utils::LogLevel::TRACE;
+    else if (log_level == "debug") level = utils::LogLevel::DEBUG;
+    else if (log_level == "warn") level = utils::LogLevel::WARN;
+    else if (log_level == "error") level = utils::LogLevel::ERROR;
+    else if (log_level == "fatal") level = utils::LogLevel::FATAL;
+    utils::Logger::setLogLevel(level);
+    utils::Logger::enableConsoleOutput(true);
+
+    raiseFileLimit(config.clients);
+
+    loadgen::LoadGenerator generator(config);
+    g_generator = &generator;
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    auto report = generator.run();
+    g_generator = nullptr;
+
+    loadgen::LoadGenerator::printReport(config, report, std::cout);
+    return report.connected > 0 ? 0 : 1;
+}
@@ -6,6 +6,7 @@
 
 #include "core/server.hpp"
 #include "utils/config_manager.hpp"
+#include "utils/cpu_topology.hpp"
 #include "utils/logger.hpp"
 
 using namespace securechat;
@@ -139,7 +140,6 @@ int main(int argc, char* argv[]) {
 
         utils::Logger::setLogLevel(level);
         utils::Logger::enableConsoleOutput(!daemon_mode);
-        utils::Logger::enableAsyncLogging(true);
         utils::Logger::setOutputFile("logs/securechat.log");
 
         utils::g_logger.info("Starting SecureChat Server v1.0.0");
@@ -154,6 +154,14 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
+        // The async log thread starts once placement is known, so it can be
+        // kept off the message cores
+        {
+            auto placement = utils::ThreadPlacement::fromConfig(config, utils::CpuTopology::system());
+            utils::ScopedAffinity affinity(placement.cpusFor(utils::ThreadRole::SERVICE));
+            utils::Logger::enableAsyncLogging(true);
+        }
+
         // Override config with command line arguments
         if (port != 8080) {
             config.setPort(port);
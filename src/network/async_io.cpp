@@ -0,0 +1,532 @@
+#include "network/async_io.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace securechat::network {
+
+namespace {
+
+#ifndef _WIN32
+constexpr uint32_t REGISTERED_EVENTS = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+constexpr uint32_t READ_EVENTS = EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR;
+constexpr uint32_t WRITE_EVENTS = EPOLLOUT | EPOLLHUP | EPOLLERR;
+
+bool wouldBlock(int error) {
+    return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+}
+#endif
+
+} // namespace
+
+AsyncIO::AsyncIO(AsyncIOConfig config)
+    : config_(std::move(config)) {
+}
+
+AsyncIO::~AsyncIO() {
+    stop();
+#ifndef _WIN32
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+#endif
+}
+
+bool AsyncIO::initialize() {
+#ifdef _WIN32
+    return false;
+#else
+    return initializeEpoll();
+#endif
+}
+
+void AsyncIO::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+#ifndef _WIN32
+    for (size_t i = 0; i < config_.worker_threads; ++i) {
+        worker_threads_.emplace_back(&AsyncIO::eventLoop, this, i);
+    }
+#endif
+}
+
+void AsyncIO::stop() {
+    if (running_.exchange(false)) {
+#ifndef _WIN32
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = ::write(wake_fd_, &one, sizeof(one));
+#endif
+    }
+    // A handler calling stop() cannot join its own thread; the workers are
+    // then joined by the next stop() or the destructor
+    for (auto& worker : worker_threads_) {
+        if (worker.get_id() == std::this_thread::get_id()) {
+            return;
+        }
+    }
+    for (auto& worker : worker_threads_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    worker_threads_.clear();
+}
+
+double AsyncIO::getAverageLatency() const {
+    uint64_t operations = total_operations_.load();
+    return operations ? static_cast<double>(total_latency_us_.load()) / static_cast<double>(operations) : 0.0;
+}
+
+#ifndef _WIN32
+
+bool AsyncIO::initializeEpoll() {
+    if (epoll_fd_ >= 0) {
+        return true;
+    }
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        return false;
+    }
+    // Level-triggered and never drained: once stop() writes it, every worker wakes
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) != 0) {
+        return false;
+    }
+
+    events_.resize(static_cast<size_t>(config_.max_events) * config_.worker_threads);
+    read_schedulers_.clear();
+    for (size_t i = 0; i < config_.worker_threads; ++i) {
+        read_schedulers_.push_back(std::make_unique<FairShareScheduler>(config_.read_budget_bytes));
+    }
+    return true;
+}
+
+bool AsyncIO::addSocket(int fd, IOCallback callback) {
+    auto context = std::make_shared<EpollContext>();
+    context->fd = fd;
+    context->callback = std::move(callback);
+    return registerContext(std::move(context));
+}
+
+bool AsyncIO::watchSocket(int fd, ReadHandler on_readable, std::function<void()> on_writable) {
+    auto context = std::make_shared<EpollContext>();
+    context->fd = fd;
+    context->on_readable = std::move(on_readable);
+    context->on_writable = std::move(on_writable);
+    return registerContext(std::move(context));
+}
+
+bool AsyncIO::registerContext(std::shared_ptr<EpollContext> context) {
+    if (epoll_fd_ < 0 || context->fd < 0) {
+        return false;
+    }
+
+    int fd = context->fd;
+    std::lock_guard<std::mutex> lock(sockets_mutex_);
+    if (epoll_contexts_.count(fd)) {
+        return false;
+    }
+    epoll_event event{};
+    event.events = REGISTERED_EVENTS;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+        return false;
+    }
+    epoll_contexts_[fd] = std::move(context);
+    return true;
+}
+
+bool AsyncIO::removeSocket(int fd) {
+    std::shared_ptr<EpollContext> context;
+    {
+        std::lock_guard<std::mutex> lock(sockets_mutex_);
+        auto it = epoll_contexts_.find(fd);
+        if (it == epoll_contexts_.end()) {
+            return false;
+        }
+        context = std::move(it->second);
+        epoll_contexts_.erase(it);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    context->removed.store(true);
+    // Wait out a handler running on another thread; on the handler's own
+    // thread the recursive lock is taken at once
+    std::lock_guard<std::recursive_mutex> wait(context->run_mutex);
+    return true;
+}
+
+bool AsyncIO::runExclusive(int fd, const std::function<void()>& task) {
+    auto context = findContext(fd);
+    if (!context || !context->run_mutex.try_lock()) {
+        return false;
+    }
+    bool ran = !context->removed.load();
+    if (ran) {
+        task();
+    }
+    context->run_mutex.unlock();
+    // Events that arrived meanwhile were left to the holder; hand them back
+    // to an I/O thread rather than running handlers on the caller's
+    if (context->pending_events.load() != 0) {
+        rearm(fd);
+    }
+    return ran;
+}
+
+std::shared_ptr<AsyncIO::EpollContext> AsyncIO::findContext(int fd) {
+    std::lock_guard<std::mutex> lock(sockets_mutex_);
+    auto it = epoll_contexts_.find(fd);
+    return it != epoll_contexts_.end() ? it->second : nullptr;
+}
+
+bool AsyncIO::rearm(int fd) {
+    epoll_event event{};
+    event.events = REGISTERED_EVENTS;
+    event.data.fd = fd;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+bool AsyncIO::asyncRead(int fd, char* buffer, size_t capacity, void* user_data) {
+    auto context = findContext(fd);
+    if (!context) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(context->op_mutex);
+        if (context->read_op.active) {
+            return false;
+        }
+        context->read_op = {true, user_data, std::chrono::steady_clock::now()};
+        context->read_buffer = buffer;
+        context->read_capacity = capacity;
+    }
+    pending_operations_++;
+    return rearm(fd);
+}
+
+bool AsyncIO::asyncWrite(int fd, const char* data, size_t length, void* user_data) {
+    auto context = findContext(fd);
+    if (!context) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(context->op_mutex);
+        if (context->write_op.active) {
+            return false;
+        }
+        context->write_op = {true, user_data, std::chrono::steady_clock::now()};
+        context->write_data = data;
+        context->write_length = length;
+        context->write_offset = 0;
+    }
+    pending_operations_++;
+    return rearm(fd);
+}
+
+bool AsyncIO::asyncAccept(int listen_fd, void* user_data) {
+    auto context = findContext(listen_fd);
+    if (!context) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(context->op_mutex);
+        if (context->accept_op.active) {
+            return false;
+        }
+        context->accept_op = {true, user_data, std::chrono::steady_clock::now()};
+    }
+    pending_operations_++;
+    return rearm(listen_fd);
+}
+
+bool AsyncIO::asyncConnect(int fd, const sockaddr* addr, socklen_t addrlen, void* user_data) {
+    auto context = findContext(fd);
+    if (!context) {
+        return false;
+    }
+    if (::connect(fd, addr, addrlen) != 0 && errno != EINPROGRESS) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(context->op_mutex);
+        context->connect_op = {true, user_data, std::chrono::steady_clock::now()};
+    }
+    pending_operations_++;
+    return rearm(fd);
+}
+
+void AsyncIO::eventLoop(size_t worker_index) {
+    const int max_events = config_.max_events;
+    epoll_event* events = events_.data() + worker_index * static_cast<size_t>(max_events);
+    FairShareScheduler& scheduler = *read_schedulers_[worker_index];
+    std::vector<int> readable;
+    readable.reserve(static_cast<size_t>(max_events));
+
+    while (running_.load(std::memory_order_relaxed)) {
+        // Sockets carried over are not reported again, so don't sleep on them
+        int ready = epoll_wait(epoll_fd_, events, max_events, scheduler.hasCarryOver() ? 0 : -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        // Watched sockets' reads go through the scheduler; everything else
+        // is dispatched as it comes
+        readable.clear();
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                continue;
+            }
+            auto context = findContext(fd);
+            if (!context) {
+                continue;
+            }
+            uint32_t pending = events[i].events;
+            if (context->on_readable && (pending & READ_EVENTS)) {
+                readable.push_back(fd);
+                pending &= ~READ_EVENTS;
+            }
+            if (pending != 0) {
+                dispatch(context, pending);
+            }
+        }
+
+        uint64_t hits = scheduler.getBudgetHits();
+        scheduler.runIteration(readable, [this](int fd, size_t max_bytes) { return readTurn(fd, max_bytes); });
+        if (uint64_t added = scheduler.getBudgetHits() - hits) {
+            budget_hits_.fetch_add(added, std::memory_order_relaxed);
+        }
+    }
+}
+
+ReadTurn AsyncIO::readTurn(int fd, size_t max_bytes) {
+    // A closed socket, or a reused fd, reads as drained and drops out
+    auto context = findContext(fd);
+    if (!context) {
+        return {};
+    }
+    if (!context->run_mutex.try_lock()) {
+        dispatch(context, EPOLLIN);
+        return {};
+    }
+    ReadTurn turn;
+    if (!context->removed.load()) {
+        turn = context->on_readable(max_bytes);
+    }
+    context->run_mutex.unlock();
+    // Events other threads left to us while we held the socket
+    dispatch(context, 0);
+    return turn;
+}
+
+void AsyncIO::dispatch(const std::shared_ptr<EpollContext>& context, uint32_t events) {
+    context->pending_events.fetch_or(events);
+    while (context->pending_events.load() != 0 && context->run_mutex.try_lock()) {
+        uint32_t pending;
+        while ((pending = context->pending_events.exchange(0)) != 0 && !context->removed.load()) {
+            runHandlers(*context, pending);
+        }
+        context->run_mutex.unlock();
+    }
+}
+
+void AsyncIO::runHandlers(EpollContext& context, uint32_t events) {
+    if (context.on_readable || context.on_writable) {
+        if ((events & READ_EVENTS) && context.on_readable) {
+            // Reads handed over from another worker's scheduler. One budget
+            // here too; the rearm reports what is left as a fresh edge.
+            ReadTurn turn = context.on_readable(config_.read_budget_bytes);
+            if (!turn.drained) {
+                budget_hits_.fetch_add(1, std::memory_order_relaxed);
+                rearm(context.fd);
+            }
+        }
+        if ((events & WRITE_EVENTS) && context.on_writable && !context.removed.load()) {
+            context.on_writable();
+        }
+        return;
+    }
+    completeOperations(context, events);
+}
+
+void AsyncIO::completeOperations(EpollContext& context, uint32_t events) {
+    std::unique_lock<std::mutex> lock(context.op_mutex);
+
+    if (context.accept_op.active && (events & READ_EVENTS)) {
+        int accepted = accept4(context.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (accepted >= 0 || !wouldBlock(errno)) {
+            IOEvent event{accepted, IOOperation::ACCEPT, nullptr, 0, accepted >= 0 ? 0 : errno,
+                          context.accept_op.user_data};
+            PendingOp& op = context.accept_op;
+            lock.unlock();
+            complete(context, op, std::move(event));
+            lock.lock();
+        }
+    }
+
+    if (context.read_op.active && (events & READ_EVENTS)) {
+        ssize_t received = ::read(context.fd, context.read_buffer, context.read_capacity);
+        if (received >= 0 || !wouldBlock(errno)) {
+            int error = received >= 0 ? 0 : errno;
+            size_t length = received > 0 ? static_cast<size_t>(received) : 0;
+            IOEvent event{context.fd, IOOperation::READ, context.read_buffer, length, error,
+                          context.read_op.user_data};
+            context.read_buffer = nullptr;
+            PendingOp& op = context.read_op;
+            lock.unlock();
+            complete(context, op, std::move(event));
+            lock.lock();
+        }
+    }
+
+    if (context.connect_op.active && (events & WRITE_EVENTS)) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(context.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        IOEvent event{context.fd, IOOperation::CONNECT, nullptr, 0, error, context.connect_op.user_data};
+        PendingOp& op = context.connect_op;
+        lock.unlock();
+        complete(context, op, std::move(event));
+        lock.lock();
+    }
+
+    if (context.write_op.active && (events & WRITE_EVENTS)) {
+        int error = 0;
+        while (context.write_offset < context.write_length) {
+            ssize_t sent = ::send(context.fd, context.write_data + context.write_offset,
+                                  context.write_length - context.write_offset, MSG_NOSIGNAL);
+            if (sent < 0) {
+                error = wouldBlock(errno) ? 0 : errno;
+                break;
+            }
+            context.write_offset += static_cast<size_t>(sent);
+        }
+        if (error != 0 || context.write_offset == context.write_length) {
+            IOEvent event{context.fd, IOOperation::WRITE, nullptr, context.write_offset, error,
+                          context.write_op.user_data};
+            context.write_data = nullptr;
+            PendingOp& op = context.write_op;
+            lock.unlock();
+            complete(context, op, std::move(event));
+            lock.lock();
+        }
+    }
+}
+
+void AsyncIO::complete(EpollContext& context, PendingOp& op, IOEvent event) {
+    {
+        std::lock_guard<std::mutex> lock(context.op_mutex);
+        auto elapsed = std::chrono::steady_clock::now() - op.start_time;
+        total_latency_us_ += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        op = {};
+    }
+    total_operations_++;
+    pending_operations_--;
+    // The callback may start the next operation of the same kind
+    if (context.callback) {
+        context.callback(event);
+    }
+}
+
+#endif
+
+bool SocketUtils::setNonBlocking(int fd) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(fd, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool SocketUtils::setReuseAddr(int fd) {
+    int one = 1;
+    return setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one)) == 0;
+}
+
+bool SocketUtils::setNoDelay(int fd) {
+    int one = 1;
+    return setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one)) == 0;
+}
+
+bool SocketUtils::setKeepAlive(int fd) {
+    int one = 1;
+    return setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, reinterpret_cast<const char*>(&one), sizeof(one)) == 0;
+}
+
+bool SocketUtils::setReceiveBuffer(int fd, int size) {
+    return setsockopt(fd, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&size), sizeof(size)) == 0;
+}
+
+bool SocketUtils::setSendBuffer(int fd, int size) {
+    return setsockopt(fd, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&size), sizeof(size)) == 0;
+}
+
+bool SocketUtils::supportsZeroCopy() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SocketUtils::supportsSendFile() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SocketUtils::supportsSplice() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SocketUtils::enableTCPFastOpen(int fd) {
+#ifdef TCP_FASTOPEN
+    int queue = 16;
+    return setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, reinterpret_cast<const char*>(&queue), sizeof(queue)) == 0;
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+bool SocketUtils::enableTCPNoDelay(int fd) {
+    return setNoDelay(fd);
+}
+
+bool SocketUtils::enableTCPCork(int fd) {
+#ifdef TCP_CORK
+    int one = 1;
+    return setsockopt(fd, IPPROTO_TCP, TCP_CORK, &one, sizeof(one)) == 0;
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+} // namespace securechat::network
@@ -0,0 +1,115 @@
+#include "network/busy_poll.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#endif
+
+// Older libc headers predate the prefer/budget options
+#ifdef __linux__
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET 70
+#endif
+#endif
+
+namespace securechat::network {
+
+BusyPollConfig BusyPollConfig::fromConfig(const utils::ConfigManager& config, size_t reactor_index) {
+    BusyPollConfig result;
+    result.enabled = config.isBusyPollEnabled();
+    result.min_spin = std::chrono::microseconds(std::max(0, config.getBusyPollMinSpinUs()));
+    result.max_spin = std::chrono::microseconds(std::max(0, config.getBusyPollMaxSpinUs()));
+    result.socket_busy_poll_us = std::max(0, config.getSocketBusyPollUs());
+    result.prefer_busy_poll = config.isPreferBusyPoll();
+    result.budget = std::max(0, config.getBusyPollBudget());
+
+    // Per-reactor override, e.g. "50,50,0" spins on reactors 0 and 1 only
+    std::istringstream overrides(config.getReactorMaxSpinUs());
+    std::string entry;
+    for (size_t index = 0; std::getline(overrides, entry, ','); ++index) {
+        if (index == reactor_index && !entry.empty()) {
+            try {
+                result.max_spin = std::chrono::microseconds(std::max(0, std::stoi(entry)));
+            } catch (const std::exception&) {
+                // Malformed entries keep the shared setting
+            }
+            break;
+        }
+    }
+    result.min_spin = std::min(result.min_spin, result.max_spin);
+    return result;
+}
+
+bool applySocketBusyPoll(int fd, const BusyPollConfig& config) {
+#ifdef __linux__
+    if (!config.enabled || config.socket_busy_poll_us <= 0 || fd < 0) {
+        return false;
+    }
+    int busy_poll = config.socket_busy_poll_us;
+    if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)) != 0) {
+        return false;
+    }
+    int prefer = config.prefer_busy_poll ? 1 : 0;
+    setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer));
+    if (config.budget > 0) {
+        int budget = config.budget;
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget));
+    }
+    return true;
+#else
+    (void)fd;
+    (void)config;
+    return false;
+#endif
+}
+
+AdaptiveSpin::AdaptiveSpin(const BusyPollConfig& config) {
+    configure(config);
+}
+
+void AdaptiveSpin::configure(const BusyPollConfig& config) {
+    min_spin_ = config.min_spin;
+    max_spin_ = config.max_spin;
+    enabled_ = config.enabled && max_spin_.count() > 0;
+    budget_ = enabled_ ? max_spin_ : duration::zero();
+}
+
+void AdaptiveSpin::onSpin(bool found_work) {
+    if (!enabled_) {
+        return;
+    }
+    if (found_work) {
+        spin_hits_++;
+        grow();
+        return;
+    }
+
+    spin_misses_++;
+    budget_ /= 2;
+    if (budget_ < min_spin_ || budget_.count() == 0) {
+        budget_ = duration::zero();
+    }
+}
+
+void AdaptiveSpin::onWake(duration blocked_for) {
+    // Work arrived soon enough that a spin would have caught it
+    if (enabled_ && budget_ < max_spin_ && blocked_for <= max_spin_) {
+        grow();
+    }
+}
+
+void AdaptiveSpin::grow() {
+    duration floor = std::max<duration>(min_spin_, std::chrono::microseconds(1));
+    budget_ = std::min(max_spin_, std::max(floor, budget_ * 2));
+}
+
+} // namespace securechat::network
@@ -0,0 +1,59 @@
+#include "network/fair_share.hpp"
+
+#include <algorithm>
+
+namespace securechat::network {
+
+FairShareScheduler::FairShareScheduler(size_t budget_bytes)
+    : budget_bytes_(std::max<size_t>(1, budget_bytes)) {
+}
+
+size_t FairShareScheduler::runIteration(const std::vector<int>& ready, const ReadFn& read) {
+    carried_.clear();
+    carried_.swap(carry_over_);
+    ++iteration_;
+
+    size_t total = 0;
+    auto turn = [&](int fd) {
+        // Level-triggered pollers report a carried socket again
+        if (fd < 0 || markServed(fd)) {
+            return;
+        }
+        ReadTurn result = read(fd, budget_bytes_);
+        total += result.bytes;
+        if (!result.drained && result.bytes >= budget_bytes_) {
+            budget_hits_++;
+            carry_over_.push_back(fd);
+        }
+    };
+
+    // Carried sockets first; they have already waited an iteration
+    for (int fd : carried_) {
+        turn(fd);
+    }
+    for (int fd : ready) {
+        turn(fd);
+    }
+    return total;
+}
+
+void FairShareScheduler::remove(int fd) {
+    if (fd < 0) {
+        return;
+    }
+    // Also skips a turn still due later in the current iteration
+    markServed(fd);
+    carry_over_.erase(std::remove(carry_over_.begin(), carry_over_.end(), fd), carry_over_.end());
+}
+
+bool FairShareScheduler::markServed(int fd) {
+    auto index = static_cast<size_t>(fd);
+    if (index >= served_in_.size()) {
+        served_in_.resize(index + 1, 0);
+    }
+    bool served = served_in_[index] == iteration_;
+    served_in_[index] = iteration_;
+    return served;
+}
+
+} // namespace securechat::network
@@ -0,0 +1,118 @@
+#include "network/async_io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+namespace securechat::network {
+
+bool IOAwaiter::await_suspend(std::coroutine_handle<> waiter) {
+    waiter_ = waiter;
+
+    // Once an operation has started it may complete, and resume the waiter,
+    // on an I/O thread before the call returns, so nothing here touches the
+    // awaiter after a successful start.
+    bool started = false;
+    switch (operation_) {
+        case IOOperation::READ:
+            started = delay_.count() >= 0 ? startTimer() : io_.asyncRead(fd_, read_buffer_, size_, this);
+            break;
+        case IOOperation::WRITE:
+            started = io_.asyncWrite(fd_, write_data_, size_, this);
+            break;
+        case IOOperation::ACCEPT:
+            started = io_.asyncAccept(fd_, this);
+            break;
+        default:
+            break;
+    }
+
+    if (!started && result_.error_code == 0) {
+        result_.error_code = EIO;
+    }
+    return started;
+}
+
+bool IOAwaiter::startTimer() {
+#ifdef __linux__
+    fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd_ < 0) {
+        result_.error_code = errno;
+        return false;
+    }
+
+    // A zero it_value disarms the timer, so round up to 1ms
+    auto delay = std::max(delay_, std::chrono::milliseconds(1));
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(delay.count() / 1000);
+    spec.it_value.tv_nsec = static_cast<long>(delay.count() % 1000) * 1000000L;
+    if (timerfd_settime(fd_, 0, &spec, nullptr) == 0 && io_.addAwaitableSocket(fd_)) {
+        if (io_.asyncRead(fd_, reinterpret_cast<char*>(&expirations_), sizeof(expirations_), this)) {
+            return true;
+        }
+        io_.removeSocket(fd_);
+    }
+    close(fd_);
+    fd_ = -1;
+    return false;
+#else
+    result_.error_code = ENOTSUP;
+    return false;
+#endif
+}
+
+void IOAwaiter::complete(const IOEvent& event) {
+    result_.fd = event.fd;
+    // Reads land in the caller's buffer directly; there is nothing to copy
+    result_.bytes_transferred = event.bytes_transferred;
+    result_.error_code = event.error_code;
+
+#ifdef __linux__
+    // Timers are one-shot descriptors owned by the awaiter
+    if (delay_.count() >= 0) {
+        io_.removeSocket(fd_);
+        close(fd_);
+        fd_ = -1;
+        result_ = IOResult{-1, 0, event.error_code};
+    }
+#endif
+
+    waiter_.resume();
+}
+
+bool AsyncIO::addAwaitableSocket(int fd) {
+    return addSocket(fd, [](const IOEvent& event) {
+        if (event.user_data) {
+            static_cast<IOAwaiter*>(event.user_data)->complete(event);
+        }
+    });
+}
+
+IOAwaiter AsyncIO::read(int fd, char* buffer, size_t capacity) {
+    IOAwaiter awaiter(*this, IOOperation::READ, fd);
+    awaiter.read_buffer_ = buffer;
+    awaiter.size_ = capacity;
+    return awaiter;
+}
+
+IOAwaiter AsyncIO::write(int fd, const char* data, size_t length) {
+    IOAwaiter awaiter(*this, IOOperation::WRITE, fd);
+    awaiter.write_data_ = data;
+    awaiter.size_ = length;
+    return awaiter;
+}
+
+IOAwaiter AsyncIO::accept(int listen_fd) {
+    return IOAwaiter(*this, IOOperation::ACCEPT, listen_fd);
+}
+
+IOAwaiter AsyncIO::sleep(std::chrono::milliseconds delay) {
+    IOAwaiter awaiter(*this, IOOperation::READ, -1);
+    awaiter.delay_ = std::max(delay, std::chrono::milliseconds(0));
+    return awaiter;
+}
+
+} // namespace securechat::network
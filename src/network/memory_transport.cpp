@@ -0,0 +1,174 @@
+#include "network/memory_transport.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace securechat::network {
+
+MemoryNetwork::MemoryNetwork(size_t buffer_size)
+    : buffer_size_(buffer_size) {
+}
+
+MemoryNetwork::~MemoryNetwork() = default;
+
+std::unique_ptr<MemoryTransport> MemoryNetwork::connect() {
+    auto client_id = static_cast<uint32_t>(endpoints_.size());
+    auto server_id = client_id + 1;
+
+    endpoints_.emplace_back().peer = server_id;
+    endpoints_.emplace_back().peer = client_id;
+    open_endpoints_ += 2;
+    pending_accepts_.push_back(server_id);
+
+    return std::unique_ptr<MemoryTransport>(new MemoryTransport(*this, client_id));
+}
+
+std::unique_ptr<MemoryTransport> MemoryNetwork::accept() {
+    if (pending_accepts_.empty()) {
+        return nullptr;
+    }
+    uint32_t id = pending_accepts_.front();
+    pending_accepts_.pop_front();
+    return std::unique_ptr<MemoryTransport>(new MemoryTransport(*this, id));
+}
+
+size_t MemoryNetwork::runReady(size_t max_events) {
+    size_t events = 0;
+    while (events < max_events && ready_head_ < ready_.size()) {
+        uint32_t id = ready_[ready_head_++];
+
+        Endpoint& endpoint = endpoints_[id];
+        endpoint.ready_queued = false;
+        if (!endpoint.open || !endpoint.read_handler) {
+            continue;
+        }
+
+        // The handler may close this endpoint, which resets read_handler, or
+        // replace it; it is moved out rather than copied and put back after
+        auto handler = std::move(endpoint.read_handler);
+        endpoint.read_handler = nullptr;
+        handler();
+        if (endpoint.open && !endpoint.read_handler) {
+            endpoint.read_handler = std::move(handler);
+        }
+        events++;
+    }
+    if (ready_head_ == ready_.size()) {
+        ready_.clear();
+        ready_head_ = 0;
+    }
+    return events;
+}
+
+int64_t MemoryNetwork::read(uint32_t id, char* buffer, size_t length) {
+    Endpoint& endpoint = endpoints_[id];
+    if (!endpoint.open) {
+        return -1;
+    }
+
+    size_t available = endpoint.inbox.size() - endpoint.read_offset;
+    if (available == 0) {
+        return endpoint.peer_closed ? -1 : 0;
+    }
+
+    size_t count = std::min(available, length);
+    std::memcpy(buffer, endpoint.inbox.data() + endpoint.read_offset, count);
+    endpoint.read_offset += count;
+
+    if (endpoint.read_offset == endpoint.inbox.size()) {
+        endpoint.inbox.clear();
+        endpoint.read_offset = 0;
+    } else if (endpoint.read_offset >= endpoint.inbox.size() / 2) {
+        endpoint.inbox.erase(0, endpoint.read_offset);
+        endpoint.read_offset = 0;
+    }
+    return static_cast<int64_t>(count);
+}
+
+int64_t MemoryNetwork::write(uint32_t id, const char* data, size_t length) {
+    Endpoint& endpoint = endpoints_[id];
+    if (!endpoint.open || endpoint.peer_closed) {
+        return -1;
+    }
+
+    Endpoint& peer = endpoints_[endpoint.peer];
+    size_t buffered = peer.inbox.size() - peer.read_offset;
+    size_t count = std::min(length, buffer_size_ - std::min(buffered, buffer_size_));
+    if (count == 0) {
+        return 0;
+    }
+
+    peer.inbox.append(data, count);
+    bytes_transferred_ += count;
+    markReadable(endpoint.peer);
+    return static_cast<int64_t>(count);
+}
+
+void MemoryNetwork::close(uint32_t id) {
+    Endpoint& endpoint = endpoints_[id];
+    if (!endpoint.open) {
+        return;
+    }
+
+    endpoint.open = false;
+    endpoint.read_handler = nullptr;
+    std::string().swap(endpoint.inbox);
+    endpoint.read_offset = 0;
+    open_endpoints_--;
+
+    Endpoint& peer = endpoints_[endpoint.peer];
+    if (peer.open) {
+        peer.peer_closed = true;
+        markReadable(endpoint.peer);
+    }
+}
+
+void MemoryNetwork::setReadHandler(uint32_t id, std::function<void()> handler) {
+    Endpoint& endpoint = endpoints_[id];
+    endpoint.read_handler = std::move(handler);
+
+    // Bytes that arrived before the handler was attached must still be seen
+    if (endpoint.read_handler && (endpoint.inbox.size() > endpoint.read_offset || endpoint.peer_closed)) {
+        markReadable(id);
+    }
+}
+
+void MemoryNetwork::markReadable(uint32_t id) {
+    Endpoint& endpoint = endpoints_[id];
+    if (!endpoint.ready_queued) {
+        endpoint.ready_queued = true;
+        ready_.push_back(id);
+    }
+}
+
+MemoryTransport::MemoryTransport(MemoryNetwork& network, uint32_t id)
+    : network_(network)
+    , id_(id) {
+}
+
+MemoryTransport::~MemoryTransport() {
+    close();
+}
+
+int64_t MemoryTransport::read(char* buffer, size_t length) {
+    return network_.read(id_, buffer, length);
+}
+
+int64_t MemoryTransport::write(const char* data, size_t length) {
+    return network_.write(id_, data, length);
+}
+
+void MemoryTransport::close() {
+    network_.close(id_);
+}
+
+bool MemoryTransport::isOpen() const {
+    return network_.isOpen(id_);
+}
+
+bool MemoryTransport::setReadHandler(std::function<void()> handler) {
+    network_.setReadHandler(id_, std::move(handler));
+    return true;
+}
+
+} // namespace securechat::network
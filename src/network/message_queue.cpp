@@ -0,0 +1,34 @@
+#include "network/message_queue.hpp"
+
+#include <algorithm>
+
+namespace securechat::network {
+
+void MessageQueue::push(utils::MessageBuffer message) {
+    if (message.empty()) {
+        return;
+    }
+    bytes_ += message.size();
+    messages_.push_back(std::move(message));
+}
+
+void MessageQueue::consume(size_t length) {
+    while (length > 0 && !messages_.empty()) {
+        size_t taken = std::min(length, frontSize());
+        front_offset_ += taken;
+        bytes_ -= taken;
+        length -= taken;
+        if (front_offset_ == messages_.front().size()) {
+            messages_.pop_front();
+            front_offset_ = 0;
+        }
+    }
+}
+
+void MessageQueue::clear() {
+    messages_.clear();
+    front_offset_ = 0;
+    bytes_ = 0;
+}
+
+} // namespace securechat::network
@@ -0,0 +1,186 @@
+#include "network/protocol_handler.hpp"
+
+#include <cstring>
+
+namespace securechat::network {
+
+namespace {
+
+void putUint32(std::string& out, uint32_t value) {
+    char bytes[4] = {
+        static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+        static_cast<char>(value >> 8), static_cast<char>(value),
+    };
+    out.append(bytes, sizeof(bytes));
+}
+
+void putUint64(std::string& out, uint64_t value) {
+    putUint32(out, static_cast<uint32_t>(value >> 32));
+    putUint32(out, static_cast<uint32_t>(value));
+}
+
+uint32_t getUint32(const char* data) {
+    auto bytes = reinterpret_cast<const unsigned char*>(data);
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+uint64_t getUint64(const char* data) {
+    return (static_cast<uint64_t>(getUint32(data)) << 32) | getUint32(data + 4);
+}
+
+// Writes the frame header and reserves room for a payload of known size
+void beginFrame(std::string& out, FrameType type, size_t payload_size) {
+    out.reserve(out.size() + ProtocolHandler::HEADER_SIZE + payload_size);
+    putUint32(out, static_cast<uint32_t>(payload_size));
+    out.push_back(static_cast<char>(type));
+}
+
+} // namespace
+
+ProtocolHandler::ProtocolHandler(size_t max_frame_size)
+    : max_frame_size_(max_frame_size) {
+}
+
+void ProtocolHandler::append(const char* data, size_t length) {
+    // Drop consumed bytes once they dominate the buffer so appends stay amortized O(1)
+    if (read_offset_ > 0 && read_offset_ >= buffer_.size() / 2) {
+        buffer_.erase(0, read_offset_);
+        read_offset_ = 0;
+    }
+    buffer_.append(data, length);
+}
+
+bool ProtocolHandler::nextFrame(Frame& frame) {
+    if (error_ || buffer_.size() - read_offset_ < HEADER_SIZE) {
+        return false;
+    }
+
+    const char* header = buffer_.data() + read_offset_;
+    size_t payload_size = getUint32(header);
+    if (payload_size > max_frame_size_) {
+        error_ = true;
+        return false;
+    }
+    if (buffer_.size() - read_offset_ < HEADER_SIZE + payload_size) {
+        return false;
+    }
+
+    frame.type = static_cast<FrameType>(header[4]);
+    frame.payload = std::string_view(header + HEADER_SIZE, payload_size);
+    read_offset_ += HEADER_SIZE + payload_size;
+    return true;
+}
+
+void ProtocolHandler::appendFrame(std::string& out, FrameType type, std::string_view payload) {
+    beginFrame(out, type, payload.size());
+    out.append(payload);
+}
+
+void ProtocolHandler::appendAuth(std::string& out, std::string_view username, std::string_view secret) {
+    beginFrame(out, FrameType::AUTH, username.size() + 1 + secret.size());
+    out.append(username);
+    out.push_back('\0');
+    out.append(secret);
+}
+
+void ProtocolHandler::appendAuthResult(std::string& out, AuthStatus status, std::string_view detail) {
+    beginFrame(out, FrameType::AUTH_RESULT, 1 + detail.size());
+    out.push_back(static_cast<char>(status));
+    out.append(detail);
+}
+
+void ProtocolHandler::appendJoinRoom(std::string& out, uint64_t room_id) {
+    beginFrame(out, FrameType::JOIN_ROOM, 8);
+    putUint64(out, room_id);
+}
+
+void ProtocolHandler::appendEncrypted(std::string& out, const crypto::EncryptedMessage& message) {
+    size_t payload_size = 8 + 8 + message.iv.size() + 1 + message.hmac.size() + message.ciphertext.size();
+    beginFrame(out, FrameType::DATA, payload_size);
+    putUint64(out, message.sequence_number);
+    putUint64(out, message.timestamp);
+    out.append(reinterpret_cast<const char*>(message.iv.data()), message.iv.size());
+    out.push_back(static_cast<char>(message.hmac.size()));
+    out.append(reinterpret_cast<const char*>(message.hmac.data()), message.hmac.size());
+    out.append(reinterpret_cast<const char*>(message.ciphertext.data()), message.ciphertext.size());
+}
+
+void ProtocolHandler::appendAck(std::string& out, uint64_t sequence) {
+    beginFrame(out, FrameType::ACK, 8);
+    putUint64(out, sequence);
+}
+
+void ProtocolHandler::appendResume(std::string& out, uint64_t sequence, std::string_view token) {
+    beginFrame(out, FrameType::RESUME, 8 + token.size());
+    putUint64(out, sequence);
+    out.append(token);
+}
+
+bool ProtocolHandler::parseAuth(std::string_view payload, std::string_view& username, std::string_view& secret) {
+    size_t separator = payload.find('\0');
+    if (separator == std::string_view::npos || separator == 0) {
+        return false;
+    }
+    username = payload.substr(0, separator);
+    secret = payload.substr(separator + 1);
+    return true;
+}
+
+bool ProtocolHandler::parseAuthResult(std::string_view payload, AuthStatus& status, std::string_view& detail) {
+    if (payload.empty()) {
+        return false;
+    }
+    status = static_cast<AuthStatus>(payload[0]);
+    detail = payload.substr(1);
+    return true;
+}
+
+bool ProtocolHandler::parseJoinRoom(std::string_view payload, uint64_t& room_id) {
+    if (payload.size() != 8) {
+        return false;
+    }
+    room_id = getUint64(payload.data());
+    return true;
+}
+
+bool ProtocolHandler::parseEncrypted(std::string_view payload, crypto::EncryptedMessage& message) {
+    constexpr size_t FIXED_SIZE = 8 + 8 + crypto::AES_IV_SIZE + 1;
+    if (payload.size() < FIXED_SIZE) {
+        return false;
+    }
+
+    const char* cursor = payload.data();
+    message.sequence_number = getUint64(cursor);
+    message.timestamp = getUint64(cursor + 8);
+    std::memcpy(message.iv.data(), cursor + 16, crypto::AES_IV_SIZE);
+    cursor += 16 + crypto::AES_IV_SIZE;
+
+    size_t hmac_size = static_cast<unsigned char>(*cursor++);
+    if (payload.size() < FIXED_SIZE + hmac_size) {
+        return false;
+    }
+    message.hmac.assign(cursor, cursor + hmac_size);
+    cursor += hmac_size;
+    message.ciphertext.assign(cursor, payload.data() + payload.size());
+    return true;
+}
+
+bool ProtocolHandler::parseAck(std::string_view payload, uint64_t& sequence) {
+    if (payload.size() != 8) {
+        return false;
+    }
+    sequence = getUint64(payload.data());
+    return true;
+}
+
+bool ProtocolHandler::parseResume(std::string_view payload, uint64_t& sequence, std::string_view& token) {
+    if (payload.size() <= 8) {
+        return false;
+    }
+    sequence = getUint64(payload.data());
+    token = payload.substr(8);
+    return true;
+}
+
+} // namespace securechat::network
@@ -0,0 +1,201 @@
+#include "network/socket_manager.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#endif
+
+namespace securechat::network {
+
+namespace {
+
+// accept() waits this long for a connection so a stop() is noticed promptly
+constexpr int ACCEPT_POLL_MS = 100;
+
+} // namespace
+
+SocketManager::SocketManager(const utils::ConfigManager& config)
+    : config_(config)
+    , logger_("SocketManager") {
+}
+
+SocketManager::~SocketManager() {
+    stop();
+#ifdef _WIN32
+    if (wsa_initialized_) {
+        WSACleanup();
+    }
+#endif
+}
+
+bool SocketManager::initialize() {
+#ifdef _WIN32
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data_) != 0) {
+        logger_.error("WSAStartup failed");
+        return false;
+    }
+    wsa_initialized_ = true;
+#endif
+    return true;
+}
+
+bool SocketManager::start() {
+    if (running_.load()) {
+        return true;
+    }
+    if (!createListenSocket() || !bindSocket() || !startListening()) {
+        if (listen_socket_ >= 0) {
+            closeSocket(listen_socket_);
+            listen_socket_ = -1;
+        }
+        return false;
+    }
+    running_.store(true);
+    logger_.info("Listening on {}:{}", config_.getBindAddress(), config_.getPort());
+    return true;
+}
+
+void SocketManager::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (listen_socket_ >= 0) {
+        closeSocket(listen_socket_);
+        listen_socket_ = -1;
+    }
+}
+
+int SocketManager::acceptConnection() {
+    if (!running_.load() || listen_socket_ < 0) {
+        return -1;
+    }
+
+#ifndef _WIN32
+    pollfd descriptor{listen_socket_, POLLIN, 0};
+    if (poll(&descriptor, 1, ACCEPT_POLL_MS) <= 0) {
+        return -1;
+    }
+    int client_fd = accept4(listen_socket_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && running_.load()) {
+            logger_.warn("accept failed: {}", std::strerror(errno));
+        }
+        return -1;
+    }
+#else
+    int client_fd = static_cast<int>(accept(listen_socket_, nullptr, nullptr));
+    if (client_fd < 0) {
+        return -1;
+    }
+    setNonBlocking(client_fd);
+#endif
+
+    configureSocket(client_fd);
+    total_connections_++;
+    active_connections_++;
+    return client_fd;
+}
+
+bool SocketManager::closeSocket(int socket_fd) {
+    if (socket_fd < 0) {
+        return false;
+    }
+#ifdef _WIN32
+    bool closed = closesocket(socket_fd) == 0;
+#else
+    bool closed = close(socket_fd) == 0;
+#endif
+    if (closed && socket_fd != listen_socket_ && active_connections_.load() > 0) {
+        active_connections_--;
+    }
+    return closed;
+}
+
+bool SocketManager::configureSocket(int socket_fd) {
+    bool ok = true;
+    if (config_.isTCPNoDelayEnabled()) {
+        ok = setNoDelay(socket_fd) && ok;
+    }
+    ok = setKeepAlive(socket_fd) && ok;
+
+    int receive_buffer = config_.getSocketRecvBuffer();
+    int send_buffer = config_.getSocketSendBuffer();
+    if (receive_buffer > 0) {
+        setsockopt(socket_fd, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receive_buffer),
+                   sizeof(receive_buffer));
+    }
+    if (send_buffer > 0) {
+        setsockopt(socket_fd, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&send_buffer),
+                   sizeof(send_buffer));
+    }
+    return ok;
+}
+
+bool SocketManager::setNonBlocking(int socket_fd) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket_fd, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket_fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket_fd, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool SocketManager::setReuseAddr(int socket_fd) {
+    int one = 1;
+    return setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one)) == 0;
+}
+
+bool SocketManager::setKeepAlive(int socket_fd) {
+    int one = 1;
+    return setsockopt(socket_fd, SOL_SOCKET, SO_KEEPALIVE, reinterpret_cast<const char*>(&one), sizeof(one)) == 0;
+}
+
+bool SocketManager::setNoDelay(int socket_fd) {
+    int one = 1;
+    return setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one)) == 0;
+}
+
+bool SocketManager::createListenSocket() {
+#ifdef _WIN32
+    listen_socket_ = static_cast<int>(socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+#else
+    listen_socket_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+#endif
+    if (listen_socket_ < 0) {
+        logger_.error("Failed to create listen socket: {}", std::strerror(errno));
+        return false;
+    }
+    return setReuseAddr(listen_socket_);
+}
+
+bool SocketManager::bindSocket() {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(config_.getPort()));
+    std::string bind_address = config_.getBindAddress();
+    if (inet_pton(AF_INET, bind_address.c_str(), &address.sin_addr) != 1) {
+        logger_.error("Invalid bind address {}", bind_address);
+        return false;
+    }
+    if (bind(listen_socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        logger_.error("Failed to bind {}:{}: {}", bind_address, config_.getPort(), std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool SocketManager::startListening() {
+    if (listen(listen_socket_, std::max(1, config_.getBacklog())) != 0) {
+        logger_.error("Failed to listen: {}", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+} // namespace securechat::network
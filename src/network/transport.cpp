@@ -0,0 +1,80 @@
+#include "network/transport.hpp"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace securechat::network {
+
+namespace {
+
+bool wouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+} // namespace
+
+SocketTransport::SocketTransport(int socket_fd)
+    : socket_fd_(socket_fd) {
+}
+
+SocketTransport::~SocketTransport() {
+    close();
+}
+
+int64_t SocketTransport::read(char* buffer, size_t length) {
+    if (socket_fd_ < 0) {
+        return -1;
+    }
+
+#ifdef _WIN32
+    int received = ::recv(socket_fd_, buffer, static_cast<int>(length), 0);
+#else
+    ssize_t received = ::recv(socket_fd_, buffer, length, MSG_DONTWAIT);
+#endif
+    if (received > 0) {
+        return received;
+    }
+    if (received < 0 && wouldBlock()) {
+        return 0;
+    }
+    return -1;
+}
+
+int64_t SocketTransport::write(const char* data, size_t length) {
+    if (socket_fd_ < 0) {
+        return -1;
+    }
+
+#ifdef _WIN32
+    int sent = ::send(socket_fd_, data, static_cast<int>(length), 0);
+#else
+    ssize_t sent = ::send(socket_fd_, data, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+#endif
+    if (sent >= 0) {
+        return sent;
+    }
+    return wouldBlock() ? 0 : -1;
+}
+
+void SocketTransport::close() {
+    if (socket_fd_ < 0) {
+        return;
+    }
+#ifdef _WIN32
+    ::closesocket(socket_fd_);
+#else
+    ::close(socket_fd_);
+#endif
+    socket_fd_ = -1;
+}
+
+} // namespace securechat::network
@@ -0,0 +1,434 @@
+#include "plugins/content_filter.hpp"
+#include "utils/cpu_features.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <queue>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SECURECHAT_X86_SIMD 1
+#endif
+
+namespace securechat::plugins {
+
+namespace {
+
+inline unsigned char foldCase(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+}
+
+inline bool isWordByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '_' || c >= 0x80;
+}
+
+size_t findCandidateScalar(const unsigned char* data, size_t pos, size_t length,
+                           const std::array<bool, 256>& start_bytes) {
+    while (pos < length && !start_bytes[data[pos]]) {
+        ++pos;
+    }
+    return pos;
+}
+
+#ifdef SECURECHAT_X86_SIMD
+__attribute__((target("ssse3")))
+size_t findCandidateSSSE3(const unsigned char* data, size_t pos, size_t length,
+                          const uint8_t* lo_table, const uint8_t* hi_table) {
+    const __m128i lo_tbl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo_table));
+    const __m128i hi_tbl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi_table));
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i zero = _mm_setzero_si128();
+
+    while (pos + 16 <= length) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i lo = _mm_and_si128(v, nibble);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+        __m128i hits = _mm_and_si128(_mm_shuffle_epi8(lo_tbl, lo), _mm_shuffle_epi8(hi_tbl, hi));
+        unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(hits, zero))) & 0xffffu;
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        pos += 16;
+    }
+    return pos;
+}
+
+__attribute__((target("avx2")))
+size_t findCandidateAVX2(const unsigned char* data, size_t pos, size_t length,
+                         const uint8_t* lo_table, const uint8_t* hi_table) {
+    const __m256i lo_tbl = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo_table)));
+    const __m256i hi_tbl = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi_table)));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+
+    while (pos + 32 <= length) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i lo = _mm256_and_si256(v, nibble);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+        __m256i hits = _mm256_and_si256(_mm256_shuffle_epi8(lo_tbl, lo),
+                                        _mm256_shuffle_epi8(hi_tbl, hi));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hits, zero)));
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        pos += 32;
+    }
+    return pos;
+}
+#endif
+
+// Generations are unique across all ContentFilter instances so the
+// thread-local snapshot cache can be keyed on the generation alone.
+std::atomic<uint64_t> g_next_generation{1};
+
+struct LocalSnapshot {
+    uint64_t generation{0};
+    std::shared_ptr<const PatternMatcher> matcher;
+};
+
+thread_local LocalSnapshot t_snapshot;
+
+} // namespace
+
+std::shared_ptr<const PatternMatcher> PatternMatcher::compile(const std::vector<FilterPattern>& patterns) {
+    std::shared_ptr<PatternMatcher> matcher(new PatternMatcher());
+
+    // Assign equivalence classes to every (case-folded) byte used by a pattern.
+    // Class 0 is shared by all bytes that never appear in any pattern.
+    std::array<bool, 256> used{};
+    for (const auto& pattern : patterns) {
+        for (unsigned char c : pattern.text) {
+            used[foldCase(c)] = true;
+        }
+    }
+
+    uint32_t classes = 1;
+    std::array<uint8_t, 256> folded_class{};
+    for (int c = 0; c < 256; ++c) {
+        if (used[c]) {
+            folded_class[c] = static_cast<uint8_t>(classes++);
+        }
+    }
+    for (int c = 0; c < 256; ++c) {
+        matcher->byte_class_[c] = folded_class[foldCase(static_cast<unsigned char>(c))];
+    }
+    matcher->stride_ = classes;
+
+    // Build the trie with a dense transition table
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> trie(classes, NONE);
+    std::vector<std::vector<uint32_t>> own_outputs(1);
+    size_t states = 1;
+
+    for (uint32_t id = 0; id < patterns.size(); ++id) {
+        const auto& pattern = patterns[id];
+        matcher->patterns_.push_back({static_cast<uint32_t>(pattern.text.size()),
+                                      pattern.action, pattern.whole_word});
+        if (pattern.text.empty()) {
+            continue;
+        }
+
+        uint32_t state = 0;
+        for (unsigned char c : pattern.text) {
+            uint32_t cls = matcher->byte_class_[c];
+            uint32_t& next = trie[state * classes + cls];
+            if (next == NONE) {
+                next = static_cast<uint32_t>(states++);
+                trie.resize(states * classes, NONE);
+                own_outputs.emplace_back();
+            }
+            state = trie[state * classes + cls];
+        }
+        own_outputs[state].push_back(id);
+    }
+
+    // Breadth-first construction of failure links, resolving every missing
+    // transition so the scan loop is a single table lookup per byte.
+    std::vector<uint32_t> fail(states, 0);
+    std::vector<std::vector<uint32_t>> outputs = own_outputs;
+    std::vector<uint32_t> order;
+    order.reserve(states);
+    std::queue<uint32_t> pending;
+
+    for (uint32_t cls = 0; cls < classes; ++cls) {
+        uint32_t& next = trie[cls];
+        if (next == NONE) {
+            next = 0;
+        } else {
+            fail[next] = 0;
+            pending.push(next);
+        }
+    }
+
+    while (!pending.empty()) {
+        uint32_t state = pending.front();
+        pending.pop();
+        order.push_back(state);
+
+        const auto& inherited = outputs[fail[state]];
+        outputs[state].insert(outputs[state].end(), inherited.begin(), inherited.end());
+
+        for (uint32_t cls = 0; cls < classes; ++cls) {
+            uint32_t& next = trie[state * classes + cls];
+            uint32_t via_fail = trie[fail[state] * classes + cls];
+            if (next == NONE) {
+                next = via_fail;
+            } else {
+                fail[next] = via_fail;
+                pending.push(next);
+            }
+        }
+    }
+
+    matcher->state_count_ = states;
+    matcher->output_begin_.resize(states + 1, 0);
+    for (size_t state = 0; state < states; ++state) {
+        matcher->output_begin_[state] = static_cast<uint32_t>(matcher->output_ids_.size());
+        matcher->output_ids_.insert(matcher->output_ids_.end(),
+                                    outputs[state].begin(), outputs[state].end());
+    }
+    matcher->output_begin_[states] = static_cast<uint32_t>(matcher->output_ids_.size());
+
+    matcher->transitions_.resize(states * classes);
+    for (size_t i = 0; i < trie.size(); ++i) {
+        uint32_t target = trie[i];
+        uint32_t entry = target * classes;
+        if (!outputs[target].empty()) {
+            entry |= OUTPUT_FLAG;
+        }
+        matcher->transitions_[i] = entry;
+    }
+
+    // Start-byte prefilter. Bytes are bucketed by high nibble; with at most
+    // eight distinct high nibbles the nibble tables are exact, otherwise
+    // buckets are shared and the automaton rejects the false positives.
+    size_t start_count = 0;
+    std::array<int, 16> bucket_of_high{};
+    bucket_of_high.fill(-1);
+    int next_bucket = 0;
+    for (const auto& pattern : patterns) {
+        if (pattern.text.empty()) {
+            continue;
+        }
+        unsigned char first = foldCase(static_cast<unsigned char>(pattern.text[0]));
+        for (unsigned char c : {first, static_cast<unsigned char>(
+                                           (first >= 'a' && first <= 'z') ? first - ('a' - 'A') : first)}) {
+            if (matcher->start_bytes_[c]) {
+                continue;
+            }
+            matcher->start_bytes_[c] = true;
+            ++start_count;
+
+            int high = c >> 4;
+            if (bucket_of_high[high] < 0) {
+                bucket_of_high[high] = next_bucket++ % 8;
+            }
+            uint8_t bit = static_cast<uint8_t>(1u << bucket_of_high[high]);
+            matcher->prefilter_hi_[high] |= bit;
+            matcher->prefilter_lo_[c & 0x0f] |= bit;
+        }
+    }
+    matcher->prefilter_enabled_ = start_count > 0 && start_count <= PREFILTER_MAX_START_BYTES;
+
+    return matcher;
+}
+
+size_t PatternMatcher::findCandidate(const unsigned char* data, size_t pos, size_t length) const {
+#ifdef SECURECHAT_X86_SIMD
+    const auto& features = utils::cpuFeatures();
+    if (features.avx2) {
+        pos = findCandidateAVX2(data, pos, length, prefilter_lo_.data(), prefilter_hi_.data());
+    } else if (features.ssse3) {
+        pos = findCandidateSSSE3(data, pos, length, prefilter_lo_.data(), prefilter_hi_.data());
+    }
+#endif
+    return findCandidateScalar(data, pos, length, start_bytes_);
+}
+
+bool PatternMatcher::isWordBoundary(std::string_view text, size_t begin, size_t end) const {
+    if (begin > 0 && isWordByte(static_cast<unsigned char>(text[begin - 1]))) {
+        return false;
+    }
+    if (end < text.size() && isWordByte(static_cast<unsigned char>(text[end]))) {
+        return false;
+    }
+    return true;
+}
+
+FilterAction PatternMatcher::scan(std::string_view text, std::vector<FilterMatch>* matches) const {
+    const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t length = text.size();
+    const uint32_t* table = transitions_.data();
+
+    FilterAction result = FilterAction::ALLOW;
+    uint32_t offset = 0;
+    size_t pos = 0;
+
+    while (pos < length) {
+        if (offset == 0 && prefilter_enabled_) {
+            pos = findCandidate(data, pos, length);
+            if (pos == length) {
+                break;
+            }
+        }
+
+        uint32_t entry = table[offset + byte_class_[data[pos]]];
+        offset = entry & OFFSET_MASK;
+
+        if (entry & OUTPUT_FLAG) {
+            uint32_t state = offset / stride_;
+            for (uint32_t i = output_begin_[state]; i < output_begin_[state + 1]; ++i) {
+                uint32_t id = output_ids_[i];
+                const auto& pattern = patterns_[id];
+                size_t end = pos + 1;
+                size_t begin = end - pattern.length;
+
+                if (pattern.whole_word && !isWordBoundary(text, begin, end)) {
+                    continue;
+                }
+
+                if (matches) {
+                    matches->push_back({begin, pattern.length, id});
+                } else if (pattern.action == FilterAction::REJECT) {
+                    return FilterAction::REJECT;
+                }
+                result = std::max(result, pattern.action);
+            }
+        }
+        ++pos;
+    }
+
+    return result;
+}
+
+size_t PatternMatcher::getMemoryUsage() const {
+    return sizeof(*this) +
+           transitions_.capacity() * sizeof(uint32_t) +
+           output_begin_.capacity() * sizeof(uint32_t) +
+           output_ids_.capacity() * sizeof(uint32_t) +
+           patterns_.capacity() * sizeof(CompiledPattern);
+}
+
+ContentFilter::ContentFilter(const utils::ConfigManager& config)
+    : config_(config)
+    , logger_("ContentFilter") {
+    setPatterns({});
+}
+
+bool ContentFilter::initialize() {
+    logger_.info("Initializing content filter");
+    return reload();
+}
+
+bool ContentFilter::reload() {
+    auto enabled = config_.getEnabledPlugins();
+    std::lock_guard<std::mutex> lock(lists_mutex_);
+    bool loaded = true;
+
+    auto load = [&](const std::string& plugin, const std::string& filename, FilterAction action, bool whole_word,
+                    std::vector<FilterPattern>& list) {
+        if (std::find(enabled.begin(), enabled.end(), plugin) == enabled.end()) {
+            list.clear();
+            return;
+        }
+        try {
+            list = loadPatternFile(filename, action, whole_word);
+        } catch (const std::exception& e) {
+            logger_.error("Failed to load {} word list, keeping {} patterns: {}", plugin, list.size(), e.what());
+            loaded = false;
+        }
+    };
+    load("message_filter", config_.getMessageFilterPatternsFile(), FilterAction::REJECT, false, blocked_patterns_);
+    load("profanity_filter", config_.getProfanityWordsFile(), FilterAction::MASK, true, masked_patterns_);
+
+    std::vector<FilterPattern> patterns = blocked_patterns_;
+    patterns.insert(patterns.end(), masked_patterns_.begin(), masked_patterns_.end());
+    setPatterns(patterns);
+    return loaded;
+}
+
+void ContentFilter::setPatterns(const std::vector<FilterPattern>& patterns) {
+    auto compiled = PatternMatcher::compile(patterns);
+
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    matcher_.store(compiled, std::memory_order_release);
+    generation_.store(g_next_generation.fetch_add(1), std::memory_order_release);
+
+    logger_.info("Compiled {} filter patterns into {} states ({} bytes, prefilter {})",
+                 compiled->getPatternCount(), compiled->getStateCount(),
+                 compiled->getMemoryUsage(), compiled->isPrefilterEnabled() ? "on" : "off");
+}
+
+std::shared_ptr<const PatternMatcher> ContentFilter::getMatcher() const {
+    return matcher_.load(std::memory_order_acquire);
+}
+
+const PatternMatcher& ContentFilter::localMatcher() const {
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (t_snapshot.generation != generation) {
+        t_snapshot.matcher = matcher_.load(std::memory_order_acquire);
+        t_snapshot.generation = generation;
+    }
+    return *t_snapshot.matcher;
+}
+
+FilterAction ContentFilter::check(std::string_view message) const {
+    FilterAction action = localMatcher().scan(message);
+    if (action == FilterAction::REJECT) {
+        rejected_messages_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return action;
+}
+
+FilterVerdict ContentFilter::apply(std::string_view message, std::string& rewritten) const {
+    const PatternMatcher& matcher = localMatcher();
+
+    FilterVerdict verdict;
+    verdict.action = matcher.scan(message);
+    if (verdict.action == FilterAction::ALLOW) {
+        return verdict;
+    }
+    if (verdict.action == FilterAction::REJECT) {
+        rejected_messages_.fetch_add(1, std::memory_order_relaxed);
+        verdict.match_count = 1;
+        return verdict;
+    }
+
+    // Only masking needs the match positions, so collect them on this slow path
+    std::vector<FilterMatch> matches;
+    matcher.scan(message, &matches);
+    verdict.match_count = matches.size();
+
+    rewritten.assign(message.data(), message.size());
+    for (const auto& match : matches) {
+        std::fill_n(rewritten.begin() + static_cast<std::ptrdiff_t>(match.offset), match.length, '*');
+    }
+    masked_messages_.fetch_add(1, std::memory_order_relaxed);
+    return verdict;
+}
+
+std::vector<FilterPattern> ContentFilter::loadPatternFile(const std::string& filename,
+                                                          FilterAction action, bool whole_word) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("cannot open pattern file " + filename);
+    }
+
+    std::vector<FilterPattern> patterns;
+    std::string line;
+    while (std::getline(file, line)) {
+        auto begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#') {
+            continue;
+        }
+        auto end = line.find_last_not_of(" \t\r");
+        patterns.push_back({line.substr(begin, end - begin + 1), action, whole_word});
+    }
+    return patterns;
+}
+
+} // namespace securechat::plugins
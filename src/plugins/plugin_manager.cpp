@@ -0,0 +1,459 @@
+#include "plugins/plugin_manager.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <set>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace securechat::plugins {
+
+namespace {
+
+std::atomic<uint64_t> g_next_manager_id{1};
+
+#ifdef _WIN32
+constexpr const char* PLUGIN_EXTENSION = ".dll";
+
+void* openLibrary(const std::string& path) {
+    return reinterpret_cast<void*>(LoadLibraryA(path.c_str()));
+}
+void* findSymbol(void* handle, const char* symbol) {
+    return reinterpret_cast<void*>(GetProcAddress(reinterpret_cast<HMODULE>(handle), symbol));
+}
+void closeLibrary(void* handle) {
+    FreeLibrary(reinterpret_cast<HMODULE>(handle));
+}
+std::string libraryError() {
+    return "error " + std::to_string(GetLastError());
+}
+#else
+constexpr const char* PLUGIN_EXTENSION = ".so";
+
+void* openLibrary(const std::string& path) {
+    return dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+}
+void* findSymbol(void* handle, const char* symbol) {
+    return dlsym(handle, symbol);
+}
+void closeLibrary(void* handle) {
+    dlclose(handle);
+}
+std::string libraryError() {
+    const char* error = dlerror();
+    return error ? error : "unknown error";
+}
+#endif
+
+// Counters have a single writer, so plain load/store avoids locked instructions
+inline void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+} // namespace
+
+struct PluginManager::PipelineRegistry {
+    std::mutex mutex;
+    // Bumped by shutdown(); cached pointers from older generations are dead
+    std::atomic<uint64_t> generation{1};
+    std::vector<std::unique_ptr<PluginPipeline>> pipelines;
+    std::vector<uint32_t> free_indices;
+    uint32_t next_index{0};
+    // Counters of pipelines whose thread has exited
+    std::vector<PluginStats> retired;
+};
+
+// Per-thread cache of pipelines, keyed by manager id so a thread may serve
+// several managers. Destroying it at thread exit hands each pipeline back.
+struct PluginManager::ThreadPipelines {
+    struct Entry {
+        uint64_t manager_id;
+        uint64_t generation;
+        PluginPipeline* pipeline;
+        std::weak_ptr<PipelineRegistry> registry;
+    };
+
+    ~ThreadPipelines() {
+        for (const auto& entry : entries) {
+            if (auto registry = entry.registry.lock()) {
+                releasePipeline(*registry, entry.generation, entry.pipeline);
+            }
+        }
+    }
+
+    std::vector<Entry> entries;
+};
+
+PluginPipeline::PluginPipeline(PluginManager& manager, uint32_t worker_index)
+    : manager_(manager)
+    , worker_index_(worker_index) {
+    for (size_t i = 0; i < manager_.plugins_.size(); ++i) {
+        const auto& plugin = manager_.plugins_[i];
+        void* instance = plugin.descriptor->create_instance(plugin.config.c_str(), worker_index_);
+        if (!instance) {
+            manager_.logger_.warn("Plugin {} declined to create an instance for worker {}",
+                                  plugin.name, worker_index_);
+            continue;
+        }
+        bool rewrites = plugin.descriptor->struct_size < offsetof(securechat_plugin, flags) + sizeof(uint32_t) ||
+                        (plugin.descriptor->flags & SECURECHAT_PLUGIN_REWRITES) != 0;
+        stages_.push_back({plugin.descriptor, instance, i, rewrites, std::make_unique<Counters>()});
+    }
+}
+
+PluginPipeline::~PluginPipeline() {
+    for (auto& stage : stages_) {
+        stage.descriptor->destroy_instance(stage.instance);
+    }
+}
+
+char* PluginPipeline::rewriteBuffer(int index) {
+    // Allocated when a rewriting stage first runs, so pipelines of read-only
+    // plugins never allocate one
+    if (!buffers_[index]) {
+        buffers_[index].reset(new char[manager_.rewrite_capacity_]);
+    }
+    return buffers_[index].get();
+}
+
+securechat_verdict PluginPipeline::process(const securechat_message_header& header,
+                                           std::string_view message, std::string_view& output) {
+    output = message;
+    securechat_verdict result = SECURECHAT_VERDICT_ACCEPT;
+    int next_buffer = 0;
+
+    // One clock read per stage: each stage ends where the next one starts
+    auto start = std::chrono::steady_clock::now();
+    for (auto& stage : stages_) {
+        securechat_message_view view{output.data(), output.size(), &header};
+        securechat_rewrite_buffer rewrite{nullptr, 0, 0};
+        if (stage.rewrites) {
+            rewrite = {rewriteBuffer(next_buffer), manager_.rewrite_capacity_, 0};
+        }
+
+        securechat_verdict verdict = stage.descriptor->on_message(stage.instance, &view, &rewrite);
+        auto end = std::chrono::steady_clock::now();
+        auto elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        start = end;
+
+        Counters& counters = *stage.counters;
+        bump(counters.calls);
+        bump(counters.total_ns, elapsed);
+        if (elapsed > counters.max_ns.load(std::memory_order_relaxed)) {
+            counters.max_ns.store(elapsed, std::memory_order_relaxed);
+        }
+        if (elapsed > manager_.slow_call_ns_) {
+            bump(counters.slow_calls);
+            // Report the first slow call immediately, then back off exponentially
+            uint64_t slow = counters.slow_calls.load(std::memory_order_relaxed);
+            if ((slow & (slow - 1)) == 0) {
+                manager_.reportSlowCall(stage.plugin_index, worker_index_, elapsed);
+            }
+        }
+
+        if (verdict == SECURECHAT_VERDICT_REJECT) {
+            bump(counters.rejects);
+            return SECURECHAT_VERDICT_REJECT;
+        }
+        if (verdict == SECURECHAT_VERDICT_REWRITE) {
+            if (!stage.rewrites || rewrite.length > rewrite.capacity) {
+                bump(counters.rejects);
+                return SECURECHAT_VERDICT_REJECT;
+            }
+            bump(counters.rewrites);
+            output = std::string_view(rewrite.data, rewrite.length);
+            next_buffer ^= 1;
+            result = SECURECHAT_VERDICT_REWRITE;
+        }
+    }
+
+    return result;
+}
+
+PluginManager::PluginManager(const utils::ConfigManager& config)
+    : config_(config)
+    , id_(g_next_manager_id.fetch_add(1))
+    , registry_(std::make_shared<PipelineRegistry>())
+    , rewrite_capacity_(static_cast<size_t>(config.getMaxMessageSize()))
+    , slow_call_ns_(static_cast<uint64_t>(config.getPluginSlowCallThreshold()) * 1000)
+    , logger_("PluginManager") {
+}
+
+PluginManager::~PluginManager() {
+    shutdown();
+}
+
+bool PluginManager::initialize() {
+    const std::filesystem::path directory = config_.getPluginDirectory();
+    std::vector<std::string> paths;
+    bool success = true;
+
+    for (const auto& name : config_.getEnabledPlugins()) {
+        if (isBuiltinPlugin(name)) {
+            continue;
+        }
+
+        std::string found;
+        for (const auto& candidate : {name + PLUGIN_EXTENSION, "lib" + name + PLUGIN_EXTENSION}) {
+            if (std::filesystem::exists(directory / candidate)) {
+                found = (directory / candidate).string();
+                break;
+            }
+        }
+        if (found.empty()) {
+            logger_.error("Enabled plugin {} not found in {}", name, directory.string());
+            success = false;
+            continue;
+        }
+        paths.push_back(found);
+    }
+
+    if (config_.isAutoLoadEnabled()) {
+        std::error_code ec;
+        std::set<std::string> discovered;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == PLUGIN_EXTENSION) {
+                discovered.insert(entry.path().string());
+            }
+        }
+        for (const auto& path : discovered) {
+            if (std::find(paths.begin(), paths.end(), path) == paths.end()) {
+                paths.push_back(path);
+            }
+        }
+    }
+
+    for (const auto& path : paths) {
+        success = loadPlugin(path) && success;
+    }
+
+    logger_.info("Loaded {} message pipeline plugins from {}", getPluginCount(), directory.string());
+    return success;
+}
+
+securechat_verdict PluginManager::process(const securechat_message_header& header,
+                                          std::string_view message, std::string_view& output) {
+    // Announce the call, then look for shutdown: either shutdown() sees the
+    // count and waits, or this call sees the flag and stays out
+    auto& reader = readers_[readerStripe()].active;
+    reader.fetch_add(1, std::memory_order_seq_cst);
+    if (closing_.load(std::memory_order_seq_cst) != 0) {
+        reader.fetch_sub(1, std::memory_order_release);
+        output = message;
+        return SECURECHAT_VERDICT_ACCEPT;
+    }
+    securechat_verdict verdict = localPipeline().process(header, message, output);
+    reader.fetch_sub(1, std::memory_order_release);
+    return verdict;
+}
+
+size_t PluginManager::readerStripe() {
+    static std::atomic<size_t> next_stripe{0};
+    thread_local const size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % READER_STRIPES;
+    return stripe;
+}
+
+void PluginManager::shutdown() {
+    // Readers first, and without mutex_: a call in process() may be about to
+    // take it to create its pipeline
+    closing_.fetch_add(1, std::memory_order_seq_cst);
+    for (auto& stripe : readers_) {
+        while (stripe.active.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Instances are destroyed before their libraries are unloaded. The new
+    // generation makes every thread drop its cached pointer on next use.
+    {
+        std::lock_guard<std::mutex> registry_lock(registry_->mutex);
+        registry_->generation.fetch_add(1, std::memory_order_release);
+        registry_->pipelines.clear();
+        registry_->free_indices.clear();
+        registry_->next_index = 0;
+        registry_->retired.clear();
+    }
+    for (auto& plugin : plugins_) {
+        if (plugin.handle) {
+            closeLibrary(plugin.handle);
+        }
+    }
+    plugins_.clear();
+    plugin_count_.store(0, std::memory_order_release);
+    closing_.fetch_sub(1, std::memory_order_release);
+}
+
+bool PluginManager::loadPlugin(const std::string& path) {
+    void* handle = openLibrary(path);
+    if (!handle) {
+        logger_.error("Failed to load plugin {}: {}", path, libraryError());
+        return false;
+    }
+
+    auto entry = reinterpret_cast<securechat_plugin_entry_fn>(findSymbol(handle, SECURECHAT_PLUGIN_ENTRY));
+    const securechat_plugin* descriptor = entry ? entry() : nullptr;
+    if (!descriptor) {
+        logger_.error("Plugin {} does not export {}", path, SECURECHAT_PLUGIN_ENTRY);
+        closeLibrary(handle);
+        return false;
+    }
+
+    LoadedPlugin plugin{descriptor->name ? descriptor->name : "", path, "", handle, descriptor};
+    if (!addPlugin(std::move(plugin))) {
+        closeLibrary(handle);
+        return false;
+    }
+    return true;
+}
+
+bool PluginManager::registerPlugin(const securechat_plugin* descriptor, const std::string& plugin_config) {
+    if (!descriptor) {
+        return false;
+    }
+    return addPlugin({descriptor->name ? descriptor->name : "", "<static>", plugin_config, nullptr, descriptor});
+}
+
+bool PluginManager::addPlugin(LoadedPlugin plugin) {
+    const securechat_plugin* descriptor = plugin.descriptor;
+    // flags was appended after the first descriptors were built
+    if (descriptor->abi_version != SECURECHAT_PLUGIN_ABI_VERSION ||
+        descriptor->struct_size < offsetof(securechat_plugin, flags)) {
+        logger_.error("Plugin {} has incompatible ABI version {} (expected {})",
+                      plugin.path, descriptor->abi_version, SECURECHAT_PLUGIN_ABI_VERSION);
+        return false;
+    }
+    if (plugin.name.empty() || !descriptor->create_instance || !descriptor->destroy_instance ||
+        !descriptor->on_message) {
+        logger_.error("Plugin {} has an incomplete descriptor", plugin.path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sealed_) {
+        logger_.error("Cannot load plugin {} after the message pipeline has started", plugin.name);
+        return false;
+    }
+    for (const auto& loaded : plugins_) {
+        if (loaded.name == plugin.name) {
+            logger_.warn("Plugin {} is already loaded from {}", plugin.name, loaded.path);
+            return false;
+        }
+    }
+
+    if (plugin.config.empty()) {
+        plugin.config = config_.getPluginConfig(plugin.name);
+    }
+
+    logger_.info("Loaded plugin {} {} from {}", plugin.name,
+                 descriptor->version ? descriptor->version : "", plugin.path);
+    plugins_.push_back(std::move(plugin));
+    plugin_count_.store(plugins_.size(), std::memory_order_release);
+    return true;
+}
+
+PluginManager::ThreadPipelines& PluginManager::threadPipelines() {
+    thread_local ThreadPipelines pipelines;
+    return pipelines;
+}
+
+PluginPipeline& PluginManager::localPipeline() {
+    auto& local = threadPipelines();
+    const uint64_t generation = registry_->generation.load(std::memory_order_acquire);
+    for (const auto& entry : local.entries) {
+        if (entry.manager_id == id_ && entry.generation == generation) {
+            return *entry.pipeline;
+        }
+    }
+
+    // Anything else cached for this manager was destroyed by shutdown()
+    local.entries.erase(std::remove_if(local.entries.begin(), local.entries.end(),
+                                       [this](const ThreadPipelines::Entry& entry) {
+                                           return entry.manager_id == id_ || entry.registry.expired();
+                                       }),
+                        local.entries.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    sealed_ = true;
+
+    std::lock_guard<std::mutex> registry_lock(registry_->mutex);
+    uint32_t worker_index;
+    if (registry_->free_indices.empty()) {
+        worker_index = registry_->next_index++;
+    } else {
+        worker_index = registry_->free_indices.back();
+        registry_->free_indices.pop_back();
+    }
+
+    registry_->pipelines.push_back(std::unique_ptr<PluginPipeline>(new PluginPipeline(*this, worker_index)));
+    PluginPipeline* pipeline = registry_->pipelines.back().get();
+    local.entries.push_back({id_, registry_->generation.load(std::memory_order_relaxed), pipeline, registry_});
+    return *pipeline;
+}
+
+void PluginManager::releasePipeline(PipelineRegistry& registry, uint64_t generation, PluginPipeline* pipeline) {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (registry.generation.load(std::memory_order_relaxed) != generation) {
+        return;
+    }
+
+    auto it = std::find_if(registry.pipelines.begin(), registry.pipelines.end(),
+                           [pipeline](const auto& owned) { return owned.get() == pipeline; });
+    if (it == registry.pipelines.end()) {
+        return;
+    }
+
+    addCounters(registry.retired, *pipeline);
+    registry.free_indices.push_back(pipeline->worker_index_);
+    registry.pipelines.erase(it);
+}
+
+void PluginManager::addCounters(std::vector<PluginStats>& stats, const PluginPipeline& pipeline) {
+    for (const auto& stage : pipeline.stages_) {
+        if (stats.size() <= stage.plugin_index) {
+            stats.resize(stage.plugin_index + 1);
+        }
+        auto& entry = stats[stage.plugin_index];
+        const auto& counters = *stage.counters;
+        entry.calls += counters.calls.load(std::memory_order_relaxed);
+        entry.rejects += counters.rejects.load(std::memory_order_relaxed);
+        entry.rewrites += counters.rewrites.load(std::memory_order_relaxed);
+        entry.slow_calls += counters.slow_calls.load(std::memory_order_relaxed);
+        entry.total_ns += counters.total_ns.load(std::memory_order_relaxed);
+        entry.max_ns = std::max(entry.max_ns, counters.max_ns.load(std::memory_order_relaxed));
+    }
+}
+
+std::vector<PluginStats> PluginManager::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> registry_lock(registry_->mutex);
+
+    std::vector<PluginStats> stats = registry_->retired;
+    stats.resize(plugins_.size());
+    for (size_t i = 0; i < plugins_.size(); ++i) {
+        stats[i].name = plugins_[i].name;
+    }
+
+    for (const auto& pipeline : registry_->pipelines) {
+        addCounters(stats, *pipeline);
+    }
+    return stats;
+}
+
+bool PluginManager::isBuiltinPlugin(const std::string& name) {
+    return name == "message_filter" || name == "profanity_filter" || name == "spam_detection";
+}
+
+void PluginManager::reportSlowCall(size_t plugin_index, uint32_t worker_index, uint64_t elapsed_ns) {
+    logger_.warn("Slow plugin {}: {} us on worker {} (threshold {} us)",
+                 plugins_[plugin_index].name, elapsed_ns / 1000, worker_index, slow_call_ns_ / 1000);
+}
+
+} // namespace securechat::plugins
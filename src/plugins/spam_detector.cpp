@@ -0,0 +1,239 @@
+#include "plugins/spam_detector.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <thread>
+
+namespace securechat::plugins {
+
+namespace {
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline bool isTokenByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+inline unsigned char foldCase(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+}
+
+size_t roundUpPowerOfTwo(size_t value) {
+    return value < 2 ? 2 : std::bit_ceil(value);
+}
+
+class SpinLock {
+public:
+    explicit SpinLock(std::atomic<uint32_t>& lock) : lock_(lock) {
+        while (lock_.exchange(1, std::memory_order_acquire) != 0) {
+            while (lock_.load(std::memory_order_relaxed) != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    ~SpinLock() { lock_.store(0, std::memory_order_release); }
+
+    SpinLock(const SpinLock&) = delete;
+    SpinLock& operator=(const SpinLock&) = delete;
+
+private:
+    std::atomic<uint32_t>& lock_;
+};
+
+} // namespace
+
+FingerprintWindowTable::FingerprintWindowTable(size_t slots)
+    : slots_(std::make_unique<Slot[]>(roundUpPowerOfTwo(slots)))
+    , mask_(roundUpPowerOfTwo(slots) - 1) {
+}
+
+uint8_t FingerprintWindowTable::recordAndCount(uint64_t key, uint64_t fingerprint, uint32_t now_ms,
+                                               uint32_t horizon_ms, int radius) {
+    size_t index = static_cast<size_t>(mix64(key)) & mask_ & ~static_cast<size_t>(1);
+    Slot* set = &slots_[index];
+    SpinLock guard(set[0].lock);
+
+    // Pick the slot owning this key, else an empty one, else the least recently used
+    Slot* slot = nullptr;
+    for (int way = 0; way < 2; ++way) {
+        if (set[way].size > 0 && set[way].key == key) {
+            slot = &set[way];
+            break;
+        }
+    }
+    if (!slot) {
+        if (set[0].size == 0) {
+            slot = &set[0];
+        } else if (set[1].size == 0) {
+            slot = &set[1];
+        } else {
+            slot = (now_ms - set[0].last_seen) >= (now_ms - set[1].last_seen) ? &set[0] : &set[1];
+        }
+        slot->key = key;
+        slot->head = 0;
+        slot->size = 0;
+    }
+
+    uint8_t near_duplicates = 0;
+    for (size_t i = 0; i < slot->size; ++i) {
+        bool recent = (now_ms - slot->stamps[i]) <= horizon_ms;
+        bool close = std::popcount(slot->fingerprints[i] ^ fingerprint) <= radius;
+        near_duplicates += static_cast<uint8_t>(recent && close);
+    }
+
+    slot->fingerprints[slot->head] = fingerprint;
+    slot->stamps[slot->head] = now_ms;
+    slot->head = static_cast<uint8_t>((slot->head + 1) % WINDOW_SIZE);
+    slot->size = static_cast<uint8_t>(std::min<size_t>(slot->size + 1u, WINDOW_SIZE));
+    slot->last_seen = now_ms;
+
+    return near_duplicates;
+}
+
+SpamDetector::SpamDetector(const SpamDetectorConfig& config)
+    : config_(config)
+    , epoch_(std::chrono::steady_clock::now())
+    , user_windows_(config.table_slots)
+    , room_windows_(config.table_slots)
+    , logger_("SpamDetector") {
+    logger_.info("Spam detection enabled: radius {} bits, at least {} tokens, window {}s, {} KB of fingerprint tables",
+                 config_.hamming_radius, config_.min_tokens, config_.window.count(), getMemoryUsage() / 1024);
+}
+
+SpamVerdict SpamDetector::check(uint64_t user_id, uint64_t room_id, std::string_view message,
+                                std::chrono::steady_clock::time_point now) {
+    SpamVerdict verdict;
+    verdict.fingerprint = fingerprint(message, verdict.tokens);
+    if (verdict.tokens < config_.min_tokens) {
+        return verdict;
+    }
+
+    auto now_ms = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - epoch_).count());
+    auto horizon_ms = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(config_.window).count());
+
+    verdict.user_duplicates = user_windows_.recordAndCount(
+        user_id, verdict.fingerprint, now_ms, horizon_ms, config_.hamming_radius);
+    if (room_id != NO_ROOM) {
+        verdict.room_duplicates = room_windows_.recordAndCount(
+            room_id, verdict.fingerprint, now_ms, horizon_ms, config_.hamming_radius);
+    }
+
+    verdict.flagged = verdict.user_duplicates >= config_.user_threshold ||
+                      verdict.room_duplicates >= config_.room_threshold;
+    if (verdict.flagged) {
+        flagged_messages_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return verdict;
+}
+
+uint64_t SpamDetector::fingerprint(std::string_view message) {
+    size_t tokens = 0;
+    return fingerprint(message, tokens);
+}
+
+uint64_t SpamDetector::fingerprint(std::string_view message, size_t& tokens) {
+    // Per-bit votes are kept in bit-sliced counters: slice j holds bit j of
+    // all 64 per-position counts, so adding a token hash is a ripple-carry
+    // over a few words instead of 64 increments, and the majority decision is
+    // a bit-sliced compare. Messages with more than 255 tokens spill into
+    // wide per-bit totals.
+    constexpr int LEVELS = 8;
+    constexpr int SPILL_EVERY = (1 << LEVELS) - 1;
+
+    static const auto fold_table = []() {
+        std::array<unsigned char, 256> table{};
+        for (int c = 0; c < 256; ++c) {
+            auto byte = static_cast<unsigned char>(c);
+            table[c] = isTokenByte(byte) ? foldCase(byte) : 0;
+        }
+        return table;
+    }();
+
+    uint64_t slices[LEVELS] = {};
+    int pending = 0;
+    std::vector<int32_t> spilled;
+    tokens = 0;
+
+    auto addToken = [&](uint64_t hash) {
+        ++tokens;
+        uint64_t carry = mix64(hash);
+        for (int level = 0; level < LEVELS && carry; ++level) {
+            uint64_t next = slices[level] & carry;
+            slices[level] ^= carry;
+            carry = next;
+        }
+        if (++pending == SPILL_EVERY) {
+            spilled.resize(64, 0);
+            for (int bit = 0; bit < 64; ++bit) {
+                int32_t count = 0;
+                for (int level = 0; level < LEVELS; ++level) {
+                    count |= static_cast<int32_t>((slices[level] >> bit) & 1) << level;
+                }
+                spilled[bit] += 2 * count - pending;
+            }
+            std::fill(std::begin(slices), std::end(slices), 0);
+            pending = 0;
+        }
+    };
+
+    constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+    uint64_t hash = FNV_OFFSET;
+    bool in_token = false;
+    for (unsigned char byte : message) {
+        unsigned char folded = fold_table[byte];
+        if (folded) {
+            hash = (hash ^ folded) * FNV_PRIME;
+            in_token = true;
+        } else if (in_token) {
+            addToken(hash);
+            hash = FNV_OFFSET;
+            in_token = false;
+        }
+    }
+    if (in_token) {
+        addToken(hash);
+    }
+
+    if (spilled.empty()) {
+        // Bit-sliced "count > pending / 2" across all 64 positions at once
+        const auto threshold = static_cast<unsigned>(pending / 2);
+        uint64_t greater = 0;
+        uint64_t equal = ~0ULL;
+        for (int level = LEVELS - 1; level >= 0; --level) {
+            if ((threshold >> level) & 1) {
+                equal &= slices[level];
+            } else {
+                greater |= equal & slices[level];
+                equal &= ~slices[level];
+            }
+        }
+        return greater;
+    }
+
+    uint64_t result = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        int32_t count = 0;
+        for (int level = 0; level < LEVELS; ++level) {
+            count |= static_cast<int32_t>((slices[level] >> bit) & 1) << level;
+        }
+        result |= static_cast<uint64_t>(spilled[bit] + 2 * count - pending > 0) << bit;
+    }
+    return result;
+}
+
+int SpamDetector::distance(uint64_t a, uint64_t b) {
+    return std::popcount(a ^ b);
+}
+
+} // namespace securechat::plugins
@@ -0,0 +1,202 @@
+#include "security/auth_manager.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+namespace securechat::security {
+
+namespace {
+
+// Base64url without padding, as JWTs use it. Returns false on a character
+// outside the alphabet or an impossible length.
+bool decodeBase64Url(std::string_view in, std::string& out) {
+    out.clear();
+    out.reserve(in.size() * 3 / 4);
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : in) {
+        int value;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '-') value = 62;
+        else if (c == '_') value = 63;
+        else return false;
+
+        buffer = (buffer << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+        }
+    }
+    return bits < 6;
+}
+
+// Position just past `"name":` in a flat JSON object, or npos
+size_t findClaim(std::string_view json, std::string_view name) {
+    std::string quoted = "\"" + std::string(name) + "\"";
+    size_t pos = json.find(quoted);
+    while (pos != std::string_view::npos) {
+        size_t cursor = pos + quoted.size();
+        while (cursor < json.size() && std::isspace(static_cast<unsigned char>(json[cursor]))) {
+            ++cursor;
+        }
+        if (cursor < json.size() && json[cursor] == ':') {
+            ++cursor;
+            while (cursor < json.size() && std::isspace(static_cast<unsigned char>(json[cursor]))) {
+                ++cursor;
+            }
+            return cursor;
+        }
+        pos = json.find(quoted, pos + 1);
+    }
+    return std::string_view::npos;
+}
+
+bool stringClaim(std::string_view json, std::string_view name, std::string& value) {
+    size_t cursor = findClaim(json, name);
+    if (cursor == std::string_view::npos || cursor >= json.size() || json[cursor] != '"') {
+        return false;
+    }
+    value.clear();
+    for (++cursor; cursor < json.size(); ++cursor) {
+        char c = json[cursor];
+        if (c == '"') {
+            return true;
+        }
+        if (c == '\\') {
+            if (++cursor >= json.size()) {
+                return false;
+            }
+            c = json[cursor];
+        }
+        value.push_back(c);
+    }
+    return false;
+}
+
+bool numberClaim(std::string_view json, std::string_view name, int64_t& value) {
+    size_t cursor = findClaim(json, name);
+    if (cursor == std::string_view::npos || cursor >= json.size() ||
+        !std::isdigit(static_cast<unsigned char>(json[cursor]))) {
+        return false;
+    }
+    value = 0;
+    while (cursor < json.size() && std::isdigit(static_cast<unsigned char>(json[cursor]))) {
+        value = value * 10 + (json[cursor++] - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+AuthManager::AuthManager(const utils::ConfigManager& config, const utils::Clock& clock)
+    : config_(config)
+    , clock_(clock)
+    , logger_("AuthManager") {
+}
+
+bool AuthManager::initialize() {
+    jwt_enabled_ = config_.isJWTEnabled();
+    secret_ = config_.getJWTSecret();
+    max_attempts_ = std::max(1, config_.getLoginAttempts());
+    lockout_duration_ = std::chrono::seconds(std::max(0, config_.getLockoutDuration()));
+
+    if (!jwt_enabled_) {
+        logger_.warn("JWT authentication is disabled; every AUTH will be rejected");
+        return true;
+    }
+    if (secret_.empty()) {
+        logger_.error("authentication.jwt_secret is not set");
+        return false;
+    }
+    return true;
+}
+
+network::AuthStatus AuthManager::authenticate(std::string_view username, std::string_view token) {
+    std::string user(username);
+    auto now = clock_.now();
+    {
+        std::lock_guard<std::mutex> lock(failures_mutex_);
+        auto it = failures_.find(user);
+        if (it != failures_.end() && it->second.locked_until > now) {
+            failed_logins_++;
+            return network::AuthStatus::RATE_LIMITED;
+        }
+    }
+
+    if (jwt_enabled_ && verifyToken(username, token)) {
+        std::lock_guard<std::mutex> lock(failures_mutex_);
+        failures_.erase(user);
+        successful_logins_++;
+        return network::AuthStatus::OK;
+    }
+
+    failed_logins_++;
+    std::lock_guard<std::mutex> lock(failures_mutex_);
+    auto& failures = failures_[user];
+    if (++failures.count >= max_attempts_) {
+        failures.count = 0;
+        failures.locked_until = now + lockout_duration_;
+        logger_.warn("Locking out {} for {}s after {} failed logins", user, lockout_duration_.count(),
+                     max_attempts_);
+    }
+    return network::AuthStatus::INVALID_CREDENTIALS;
+}
+
+bool AuthManager::verifyToken(std::string_view username, std::string_view token) const {
+    size_t first_dot = token.find('.');
+    size_t second_dot = first_dot == std::string_view::npos ? first_dot : token.find('.', first_dot + 1);
+    if (second_dot == std::string_view::npos) {
+        return false;
+    }
+
+    std::string header;
+    std::string payload;
+    std::string signature;
+    if (!decodeBase64Url(token.substr(0, first_dot), header) ||
+        !decodeBase64Url(token.substr(first_dot + 1, second_dot - first_dot - 1), payload) ||
+        !decodeBase64Url(token.substr(second_dot + 1), signature)) {
+        return false;
+    }
+
+    // Only HS256; accepting "none" or another algorithm would let the token choose its own check
+    std::string algorithm;
+    if (!stringClaim(header, "alg", algorithm) || algorithm != "HS256") {
+        return false;
+    }
+
+    std::string_view signing_input = token.substr(0, second_dot);
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_length = 0;
+    if (!HMAC(EVP_sha256(), secret_.data(), static_cast<int>(secret_.size()),
+              reinterpret_cast<const unsigned char*>(signing_input.data()), signing_input.size(),
+              digest, &digest_length) ||
+        signature.size() != digest_length || CRYPTO_memcmp(digest, signature.data(), digest_length) != 0) {
+        return false;
+    }
+
+    std::string subject;
+    if (!stringClaim(payload, "sub", subject) || subject != username) {
+        return false;
+    }
+
+    int64_t expiry = 0;
+    if (numberClaim(payload, "exp", expiry)) {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (expiry <= seconds) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace securechat::security
@@ -0,0 +1,34 @@
+#include "security/rate_limiter.hpp"
+
+#include <algorithm>
+
+namespace securechat::security {
+
+RateLimiter::RateLimiter(RateLimitConfig config, const utils::Clock& clock)
+    : config_(config)
+    , clock_(clock)
+    , tokens_(config.burst_size)
+    , last_refill_(clock.now()) {
+}
+
+bool RateLimiter::tryAcquire(double cost) {
+    refill();
+    if (tokens_ < cost) {
+        rejected_++;
+        return false;
+    }
+    tokens_ -= cost;
+    return true;
+}
+
+void RateLimiter::refill() {
+    auto now = clock_.now();
+    if (now <= last_refill_) {
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+    tokens_ = std::min(config_.burst_size, tokens_ + elapsed * config_.messages_per_second);
+    last_refill_ = now;
+}
+
+} // namespace securechat::security
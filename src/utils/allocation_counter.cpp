@@ -0,0 +1,64 @@
+#include "utils/allocation_counter.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace securechat::utils {
+
+namespace {
+
+// Trivially initialized, so reading them from inside operator new or malloc
+// never runs a TLS constructor that could allocate
+thread_local uint64_t t_allocations = 0;
+thread_local uint64_t t_allocated_bytes = 0;
+
+} // namespace
+
+bool AllocationCounter::isEnabled() {
+    static const bool enabled = []() {
+        uint64_t before = t_allocations;
+        // Direct calls, unlike new-expressions, may not be elided
+        ::operator delete(::operator new(1));
+        return t_allocations != before;
+    }();
+    return enabled;
+}
+
+uint64_t AllocationCounter::getThreadAllocations() {
+    return t_allocations;
+}
+
+uint64_t AllocationCounter::getThreadAllocatedBytes() {
+    return t_allocated_bytes;
+}
+
+void AllocationCounter::record(size_t bytes) {
+    t_allocations++;
+    t_allocated_bytes += bytes;
+}
+
+NoAllocationScope::NoAllocationScope(const char* name)
+    : name_(name)
+    , start_allocations_(AllocationCounter::getThreadAllocations())
+    , start_bytes_(AllocationCounter::getThreadAllocatedBytes()) {}
+
+NoAllocationScope::~NoAllocationScope() {
+    if (finished_) {
+        return;
+    }
+    uint64_t allocations = getAllocations();
+    if (allocations > 0) {
+        std::fprintf(stderr, "NoAllocationScope '%s': %llu heap allocations (%llu bytes)\n", name_,
+                     static_cast<unsigned long long>(allocations),
+                     static_cast<unsigned long long>(getAllocatedBytes()));
+        std::abort();
+    }
+}
+
+uint64_t NoAllocationScope::finish() {
+    finished_ = true;
+    return getAllocations();
+}
+
+} // namespace securechat::utils
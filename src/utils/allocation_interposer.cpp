@@ -0,0 +1,186 @@
+// Replacement global allocation functions that count every allocation per
+// thread (see utils/allocation_counter.hpp). Linked only into test and
+// benchmark binaries built with -DENABLE_ALLOCATION_COUNTING=ON.
+//
+// operator new is always replaced. On glibc outside sanitizer builds, malloc
+// and friends are wrapped as well, so allocations inside C libraries such as
+// OpenSSL are counted too; sanitizers install their own malloc, so there only
+// C++ allocations are seen.
+
+#include "utils/allocation_counter.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define SECURECHAT_COUNT_MALLOC 1
+#endif
+
+using securechat::utils::AllocationCounter;
+
+#ifdef SECURECHAT_COUNT_MALLOC
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size) {
+    AllocationCounter::record(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    AllocationCounter::record(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    AllocationCounter::record(size);
+    return __libc_realloc(pointer, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    AllocationCounter::record(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    AllocationCounter::record(size);
+    void* pointer = __libc_memalign(alignment, size);
+    if (!pointer) {
+        return ENOMEM;
+    }
+    *out = pointer;
+    return 0;
+}
+
+void free(void* pointer) {
+    __libc_free(pointer);
+}
+
+} // extern "C"
+
+namespace {
+
+// operator new goes around the malloc wrapper so it is counted once
+void* allocate(size_t size) {
+    AllocationCounter::record(size);
+    return __libc_malloc(size ? size : 1);
+}
+
+void* allocateAligned(size_t size, std::align_val_t alignment) {
+    AllocationCounter::record(size);
+    return __libc_memalign(static_cast<size_t>(alignment), size ? size : 1);
+}
+
+void release(void* pointer) {
+    __libc_free(pointer);
+}
+
+} // namespace
+
+#else
+
+namespace {
+
+void* allocate(size_t size) {
+    AllocationCounter::record(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* allocateAligned(size_t size, std::align_val_t alignment) {
+    AllocationCounter::record(size);
+    size_t align = static_cast<size_t>(alignment);
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void release(void* pointer) {
+    std::free(pointer);
+}
+
+} // namespace
+
+#endif
+
+void* operator new(size_t size) {
+    if (void* pointer = allocate(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* pointer = allocateAligned(size, alignment)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    release(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    release(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+    release(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    release(pointer);
+}
@@ -0,0 +1,84 @@
+#include "utils/clock.hpp"
+
+#include <algorithm>
+
+namespace securechat::utils {
+
+namespace {
+
+class SteadyClock : public Clock {
+public:
+    time_point now() const override { return std::chrono::steady_clock::now(); }
+};
+
+} // namespace
+
+Clock& Clock::system() {
+    static SteadyClock clock;
+    return clock;
+}
+
+SimulatedClock::SimulatedClock(time_point start)
+    : now_(start) {
+}
+
+SimulatedClock::TimerId SimulatedClock::runAt(time_point deadline, std::function<void()> callback) {
+    TimerId id = next_timer_id_++;
+    // A deadline in the past fires on the next advance, never retroactively
+    timers_.push(Timer{std::max(deadline, now_), id, std::move(callback)});
+    live_timers_.insert(id);
+    return id;
+}
+
+SimulatedClock::TimerId SimulatedClock::runAfter(duration delay, std::function<void()> callback) {
+    return runAt(now_ + delay, std::move(callback));
+}
+
+bool SimulatedClock::cancel(TimerId id) {
+    // The heap entry stays behind and is skipped when it reaches the top
+    return live_timers_.erase(id) > 0;
+}
+
+size_t SimulatedClock::advance(duration delta) {
+    return advanceTo(now_ + delta);
+}
+
+size_t SimulatedClock::advanceTo(time_point target) {
+    size_t fired = 0;
+    while (!timers_.empty() && timers_.top().deadline <= target) {
+        // priority_queue::top() is const; the entry is popped right after
+        Timer timer = std::move(const_cast<Timer&>(timers_.top()));
+        timers_.pop();
+
+        if (live_timers_.erase(timer.id) == 0) {
+            continue;
+        }
+        now_ = timer.deadline;
+        timer.callback();
+        fired++;
+    }
+
+    if (target > now_) {
+        now_ = target;
+    }
+    fired_timers_ += fired;
+    return fired;
+}
+
+size_t SimulatedClock::advanceToNextTimer() {
+    time_point deadline;
+    return getNextDeadline(deadline) ? advanceTo(deadline) : 0;
+}
+
+bool SimulatedClock::getNextDeadline(time_point& deadline) {
+    while (!timers_.empty() && live_timers_.count(timers_.top().id) == 0) {
+        timers_.pop();
+    }
+    if (timers_.empty()) {
+        return false;
+    }
+    deadline = timers_.top().deadline;
+    return true;
+}
+
+} // namespace securechat::utils
@@ -0,0 +1,464 @@
+#include "utils/config_manager.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace securechat::utils {
+
+namespace {
+
+// Minimal JSON reader for the configuration file. Objects are flattened into
+// dotted keys ("server.port") and array elements get their index as the last
+// segment ("plugins.enabled_plugins.0"); scalars keep their source text, with
+// strings unescaped. null values are skipped, so their getters fall back to
+// the default.
+class JsonFlattener {
+public:
+    JsonFlattener(const std::string& text, std::unordered_map<std::string, std::string>& out)
+        : text_(text), out_(out) {}
+
+    bool parse() {
+        skipWhitespace();
+        if (!parseValue("")) {
+            return false;
+        }
+        skipWhitespace();
+        return pos_ == text_.size();
+    }
+
+    size_t position() const { return pos_; }
+
+private:
+    bool parseValue(const std::string& key) {
+        skipWhitespace();
+        if (pos_ >= text_.size()) {
+            return false;
+        }
+        switch (text_[pos_]) {
+            case '{':
+                return parseObject(key);
+            case '[':
+                return parseArray(key);
+            case '"': {
+                std::string value;
+                if (!parseString(value)) {
+                    return false;
+                }
+                store(key, std::move(value));
+                return true;
+            }
+            default:
+                return parseLiteral(key);
+        }
+    }
+
+    bool parseObject(const std::string& prefix) {
+        ++pos_;
+        skipWhitespace();
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            skipWhitespace();
+            std::string name;
+            if (!parseString(name)) {
+                return false;
+            }
+            skipWhitespace();
+            if (!consume(':') || !parseValue(prefix.empty() ? name : prefix + "." + name)) {
+                return false;
+            }
+            skipWhitespace();
+        } while (consume(','));
+        return consume('}');
+    }
+
+    bool parseArray(const std::string& prefix) {
+        ++pos_;
+        skipWhitespace();
+        if (consume(']')) {
+            return true;
+        }
+        size_t index = 0;
+        do {
+            if (!parseValue(prefix + "." + std::to_string(index++))) {
+                return false;
+            }
+            skipWhitespace();
+        } while (consume(','));
+        return consume(']');
+    }
+
+    bool parseString(std::string& value) {
+        if (!consume('"')) {
+            return false;
+        }
+        while (pos_ < text_.size()) {
+            char c = text_[pos_++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                value.push_back(c);
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                return false;
+            }
+            switch (text_[pos_++]) {
+                case '"': value.push_back('"'); break;
+                case '\\': value.push_back('\\'); break;
+                case '/': value.push_back('/'); break;
+                case 'b': value.push_back('\b'); break;
+                case 'f': value.push_back('\f'); break;
+                case 'n': value.push_back('\n'); break;
+                case 'r': value.push_back('\r'); break;
+                case 't': value.push_back('\t'); break;
+                case 'u': {
+                    uint32_t code = 0;
+                    if (!parseHex4(code)) {
+                        return false;
+                    }
+                    // Surrogate pair
+                    if (code >= 0xD800 && code <= 0xDBFF && text_.compare(pos_, 2, "\\u") == 0) {
+                        pos_ += 2;
+                        uint32_t low = 0;
+                        if (!parseHex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(value, code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    bool parseHex4(uint32_t& code) {
+        if (pos_ + 4 > text_.size()) {
+            return false;
+        }
+        for (int i = 0; i < 4; ++i) {
+            char c = text_[pos_++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') code |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') code |= static_cast<uint32_t>(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    // Numbers, true, false and null
+    bool parseLiteral(const std::string& key) {
+        size_t start = pos_;
+        while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+                                       text_[pos_] == '-' || text_[pos_] == '+' || text_[pos_] == '.')) {
+            ++pos_;
+        }
+        std::string literal = text_.substr(start, pos_ - start);
+        if (literal.empty()) {
+            return false;
+        }
+        if (literal == "null") {
+            return true;
+        }
+        if (literal != "true" && literal != "false") {
+            std::istringstream number(literal);
+            double value = 0.0;
+            if (!(number >> value) || !number.eof()) {
+                pos_ = start;
+                return false;
+            }
+        }
+        store(key, std::move(literal));
+        return true;
+    }
+
+    void store(const std::string& key, std::string value) {
+        if (!key.empty()) {
+            out_[key] = std::move(value);
+        }
+    }
+
+    void skipWhitespace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    bool consume(char expected) {
+        if (pos_ < text_.size() && text_[pos_] == expected) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    const std::string& text_;
+    std::unordered_map<std::string, std::string>& out_;
+    size_t pos_{0};
+};
+
+std::string escapeJson(const std::string& value) {
+    std::string out;
+    out.reserve(value.size() + 2);
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                    out += escaped;
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    return out;
+}
+
+bool isScalarLiteral(const std::string& value) {
+    if (value == "true" || value == "false") {
+        return true;
+    }
+    std::istringstream number(value);
+    double parsed = 0.0;
+    return !value.empty() && (number >> parsed) && number.eof();
+}
+
+bool isIndex(const std::string& segment) {
+    return !segment.empty() && std::all_of(segment.begin(), segment.end(),
+                                           [](unsigned char c) { return std::isdigit(c); });
+}
+
+// Tree rebuilt from the dotted keys for saveToFile()
+struct Node {
+    std::string value;
+    bool leaf{false};
+    std::map<std::string, Node> children;
+};
+
+void writeNode(std::ostream& out, const Node& node, int indent) {
+    if (node.leaf) {
+        out << (isScalarLiteral(node.value) ? node.value : "\"" + escapeJson(node.value) + "\"");
+        return;
+    }
+
+    // A node whose children are all indices is an array, in index order
+    bool array = !node.children.empty() &&
+                 std::all_of(node.children.begin(), node.children.end(),
+                             [](const auto& child) { return isIndex(child.first); });
+    std::vector<std::pair<std::string, const Node*>> children;
+    for (const auto& [name, child] : node.children) {
+        children.emplace_back(name, &child);
+    }
+    if (array) {
+        std::sort(children.begin(), children.end(), [](const auto& a, const auto& b) {
+            return std::stoul(a.first) < std::stoul(b.first);
+        });
+    }
+
+    std::string pad(static_cast<size_t>(indent + 2), ' ');
+    out << (array ? "[" : "{");
+    for (size_t i = 0; i < children.size(); ++i) {
+        out << (i ? ",\n" : "\n") << pad;
+        if (!array) {
+            out << "\"" << escapeJson(children[i].first) << "\": ";
+        }
+        writeNode(out, *children[i].second, indent + 2);
+    }
+    if (!children.empty()) {
+        out << "\n" << std::string(static_cast<size_t>(indent), ' ');
+    }
+    out << (array ? "]" : "}");
+}
+
+} // namespace
+
+bool ConfigManager::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        g_logger.error("Cannot open configuration file {}", filename);
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+
+    std::unordered_map<std::string, std::string> parsed;
+    JsonFlattener parser(text, parsed);
+    if (!parser.parse()) {
+        g_logger.error("Malformed configuration file {} near byte {}", filename, parser.position());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    config_data_ = std::move(parsed);
+    return true;
+}
+
+bool ConfigManager::saveToFile(const std::string& filename) const {
+    Node root;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        for (const auto& [key, value] : config_data_) {
+            Node* node = &root;
+            for (const auto& part : splitKey(key)) {
+                node = &node->children[part];
+            }
+            node->leaf = true;
+            node->value = value;
+        }
+    }
+
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    writeNode(file, root, 0);
+    file << "\n";
+    return static_cast<bool>(file);
+}
+
+std::vector<std::string> ConfigManager::getEnabledPlugins() const {
+    std::vector<std::string> plugins;
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    for (size_t i = 0;; ++i) {
+        auto it = config_data_.find(joinKey({"plugins", "enabled_plugins", std::to_string(i)}));
+        if (it == config_data_.end()) {
+            break;
+        }
+        plugins.push_back(it->second);
+    }
+    return plugins;
+}
+
+std::string ConfigManager::getString(const std::string& key, const std::string& default_value) const {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    auto it = config_data_.find(key);
+    return it != config_data_.end() ? it->second : default_value;
+}
+
+int ConfigManager::getInt(const std::string& key, int default_value) const {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    auto it = config_data_.find(key);
+    if (it == config_data_.end()) {
+        return default_value;
+    }
+    try {
+        size_t used = 0;
+        double value = std::stod(it->second, &used);
+        return used == it->second.size() ? static_cast<int>(value) : default_value;
+    } catch (const std::exception&) {
+        return default_value;
+    }
+}
+
+bool ConfigManager::getBool(const std::string& key, bool default_value) const {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    auto it = config_data_.find(key);
+    if (it == config_data_.end()) {
+        return default_value;
+    }
+    if (it->second == "true" || it->second == "1") {
+        return true;
+    }
+    if (it->second == "false" || it->second == "0") {
+        return false;
+    }
+    return default_value;
+}
+
+double ConfigManager::getDouble(const std::string& key, double default_value) const {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    auto it = config_data_.find(key);
+    if (it == config_data_.end()) {
+        return default_value;
+    }
+    try {
+        size_t used = 0;
+        double value = std::stod(it->second, &used);
+        return used == it->second.size() ? value : default_value;
+    } catch (const std::exception&) {
+        return default_value;
+    }
+}
+
+void ConfigManager::setString(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(config_mutex_);
+    config_data_[key] = value;
+}
+
+void ConfigManager::setInt(const std::string& key, int value) {
+    setString(key, std::to_string(value));
+}
+
+void ConfigManager::setBool(const std::string& key, bool value) {
+    setString(key, value ? "true" : "false");
+}
+
+void ConfigManager::setDouble(const std::string& key, double value) {
+    std::ostringstream text;
+    text << value;
+    setString(key, text.str());
+}
+
+std::vector<std::string> ConfigManager::splitKey(const std::string& key) const {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        size_t dot = key.find('.', start);
+        parts.push_back(key.substr(start, dot - start));
+        if (dot == std::string::npos) {
+            break;
+        }
+        start = dot + 1;
+    }
+    return parts;
+}
+
+std::string ConfigManager::joinKey(const std::vector<std::string>& parts) const {
+    std::string key;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (i > 0) {
+            key.push_back('.');
+        }
+        key += parts[i];
+    }
+    return key;
+}
+
+} // namespace securechat::utils
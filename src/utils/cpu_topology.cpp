@@ -0,0 +1,274 @@
+#include "utils/cpu_topology.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace securechat::utils {
+
+namespace {
+
+bool parseInt(std::string_view text, int& value) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\n')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\n')) text.remove_suffix(1);
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size() && value >= 0;
+}
+
+CpuSet intersect(const CpuSet& a, const CpuSet& b) {
+    CpuSet result;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+CpuSet allowedCpus() {
+#ifdef __linux__
+    CpuSet allowed = getThreadAffinity();
+    if (!allowed.empty()) {
+        return allowed;
+    }
+#endif
+    CpuSet all;
+    for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+        all.push_back(static_cast<int>(cpu));
+    }
+    return all;
+}
+
+} // namespace
+
+CpuSet parseCpuList(std::string_view list) {
+    CpuSet cpus;
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view range = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        size_t dash = range.find('-');
+        int first = 0;
+        int last = 0;
+        if (!parseInt(range.substr(0, dash), first)) {
+            return {};
+        }
+        last = first;
+        if (dash != std::string_view::npos && (!parseInt(range.substr(dash + 1), last) || last < first)) {
+            return {};
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string formatCpuList(const CpuSet& cpus) {
+    std::ostringstream out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+        if (i > 0) {
+            out << ',';
+        }
+        out << cpus[i];
+        if (j > i) {
+            out << '-' << cpus[j];
+        }
+        i = j + 1;
+    }
+    return out.str();
+}
+
+size_t CpuTopology::nodeOf(int cpu) const {
+    return cpu >= 0 && static_cast<size_t>(cpu) < node_of_cpu_.size() ? node_of_cpu_[cpu] : 0;
+}
+
+std::string CpuTopology::describe() const {
+    std::ostringstream out;
+    out << cpus.size() << " CPUs in " << nodes.size() << " NUMA node" << (nodes.size() == 1 ? "" : "s");
+    for (size_t node = 0; node < nodes.size(); ++node) {
+        out << (node == 0 ? " (" : ", ") << "node" << node << ": " << formatCpuList(nodes[node]);
+    }
+    out << (nodes.empty() ? "" : ")");
+    return out.str();
+}
+
+void CpuTopology::index() {
+    int max_cpu = cpus.empty() ? 0 : cpus.back();
+    node_of_cpu_.assign(static_cast<size_t>(max_cpu) + 1, 0);
+    for (size_t node = 0; node < nodes.size(); ++node) {
+        for (int cpu : nodes[node]) {
+            node_of_cpu_[cpu] = node;
+        }
+    }
+}
+
+CpuTopology CpuTopology::detect(const std::string& sysfs_root) {
+    CpuTopology topology;
+    topology.cpus = allowedCpus();
+
+    // Node directories in numeric order; ids can be sparse
+    std::vector<std::pair<int, std::filesystem::path>> node_dirs;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(sysfs_root + "/node", error)) {
+        std::string name = entry.path().filename().string();
+        int id = 0;
+        if (name.rfind("node", 0) == 0 && parseInt(std::string_view(name).substr(4), id)) {
+            node_dirs.emplace_back(id, entry.path());
+        }
+    }
+    std::sort(node_dirs.begin(), node_dirs.end());
+
+    for (const auto& [id, path] : node_dirs) {
+        std::ifstream file(path / "cpulist");
+        std::string list;
+        std::getline(file, list);
+        CpuSet node_cpus = intersect(parseCpuList(list), topology.cpus);
+        if (!node_cpus.empty()) {
+            topology.nodes.push_back(std::move(node_cpus));
+        }
+    }
+
+    if (topology.nodes.empty()) {
+        topology.nodes.push_back(topology.cpus);
+    }
+    topology.index();
+    return topology;
+}
+
+const CpuTopology& CpuTopology::system() {
+    static const CpuTopology topology = detect();
+    return topology;
+}
+
+size_t currentNumaNode() {
+#ifdef __linux__
+    const CpuTopology& topology = CpuTopology::system();
+    if (topology.getNodeCount() > 1) {
+        return topology.nodeOf(sched_getcpu());
+    }
+#endif
+    return 0;
+}
+
+bool setThreadAffinity(const CpuSet& cpus) {
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &mask);
+        }
+    }
+    return !cpus.empty() && pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+CpuSet getThreadAffinity() {
+    CpuSet cpus;
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(mask), &mask) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &mask)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+ScopedAffinity::ScopedAffinity(const CpuSet& cpus) {
+    if (cpus.empty()) {
+        return;
+    }
+    previous_ = getThreadAffinity();
+    applied_ = !previous_.empty() && setThreadAffinity(cpus);
+}
+
+ScopedAffinity::~ScopedAffinity() {
+    if (applied_) {
+        setThreadAffinity(previous_);
+    }
+}
+
+const CpuSet& ThreadPlacement::cpusFor(ThreadRole role) const {
+    switch (role) {
+        case ThreadRole::REACTOR:
+            return reactor;
+        case ThreadRole::WORKER:
+            return workers;
+        default:
+            return service;
+    }
+}
+
+std::string ThreadPlacement::describe() const {
+    if (!enabled) {
+        return "threads not pinned";
+    }
+    return "reactor " + formatCpuList(reactor) + ", workers " + formatCpuList(workers) +
+           ", service " + formatCpuList(service);
+}
+
+ThreadPlacement ThreadPlacement::fromConfig(const ConfigManager& config, const CpuTopology& topology) {
+    ThreadPlacement placement;
+    const CpuSet& cpus = topology.cpus;
+    if (!config.isCpuAffinityEnabled()) {
+        return placement;
+    }
+    if (cpus.size() < 4) {
+        placement.warnings.push_back("CPU affinity needs at least 4 CPUs, " +
+                                     std::to_string(cpus.size()) + " available; threads not pinned");
+        return placement;
+    }
+
+    // Derived defaults: service threads on the last CPU, reactors on the first
+    size_t reactor_count = std::max<size_t>(1, (cpus.size() - 1) / 8);
+    CpuSet default_service(cpus.end() - 1, cpus.end());
+    CpuSet default_reactor(cpus.begin(), cpus.begin() + static_cast<std::ptrdiff_t>(reactor_count));
+    CpuSet default_workers(cpus.begin() + static_cast<std::ptrdiff_t>(reactor_count), cpus.end() - 1);
+
+    auto resolve = [&](const std::string& key, const std::string& list, const CpuSet& fallback) {
+        if (list.empty()) {
+            return fallback;
+        }
+        CpuSet chosen = intersect(parseCpuList(list), cpus);
+        if (chosen.empty()) {
+            placement.warnings.push_back(key + " \"" + list + "\" names no usable CPU; using " +
+                                         formatCpuList(fallback));
+            return fallback;
+        }
+        return chosen;
+    };
+
+    placement.enabled = true;
+    placement.reactor = resolve("reactor_cpus", config.getReactorCpus(), default_reactor);
+    placement.workers = resolve("worker_cpus", config.getWorkerCpus(), default_workers);
+    placement.service = resolve("service_cpus", config.getServiceCpus(), default_service);
+
+    if (!intersect(placement.service, placement.reactor).empty() ||
+        !intersect(placement.service, placement.workers).empty()) {
+        placement.warnings.push_back("service_cpus overlap the message cores; logging and metrics are not isolated");
+    }
+    return placement;
+}
+
+} // namespace securechat::utils
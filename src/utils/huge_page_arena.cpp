@@ -0,0 +1,141 @@
+#include "utils/huge_page_arena.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace securechat::utils {
+
+std::atomic<HugePageArena*> HugePageArena::buffers_{nullptr};
+
+namespace {
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+HugePageConfig HugePageConfig::fromConfig(const ConfigManager& config) {
+    HugePageConfig huge_pages;
+    huge_pages.enabled = config.isHugePagesEnabled();
+    huge_pages.mode = config.getHugePagesMode() == "hugetlb" ? HugePageMode::HUGETLB : HugePageMode::TRANSPARENT;
+    huge_pages.lock = config.isHugePagesLocked();
+    huge_pages.bytes = static_cast<size_t>(std::max(1, config.getMaxConnections())) *
+                       static_cast<size_t>(std::max(0, config.getHugePagesPerConnectionBytes()));
+    return huge_pages;
+}
+
+HugePageArena::HugePageArena(HugePageConfig config) : config_(config) {}
+
+HugePageArena::~HugePageArena() {
+    release();
+}
+
+bool HugePageArena::reserve() {
+#ifdef __linux__
+    if (base_) {
+        return true;
+    }
+    if (config_.bytes == 0) {
+        return fail("huge page arena size is 0; check performance.huge_pages.per_connection_bytes", 0);
+    }
+    const size_t size = roundUp(config_.bytes, HUGE_PAGE_SIZE);
+
+    if (config_.mode == HugePageMode::HUGETLB) {
+        // MAP_POPULATE takes every page from the hugetlb pool now, so a
+        // short pool fails here instead of with SIGBUS under load
+        void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        if (mapping == MAP_FAILED) {
+            return fail("mmap(MAP_HUGETLB) of " + std::to_string(size / HUGE_PAGE_SIZE) +
+                        " 2 MB pages failed; raise vm.nr_hugepages or use mode \"thp\"", errno);
+        }
+        mapping_ = static_cast<char*>(mapping);
+        mapping_size_ = size;
+        base_ = mapping_;
+    } else {
+        std::ifstream setting("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string modes;
+        if (std::getline(setting, modes) && modes.find("[never]") != std::string::npos) {
+            return fail("transparent huge pages are disabled (transparent_hugepage/enabled is never); "
+                        "enable madvise or use mode \"hugetlb\"", 0);
+        }
+
+        // Over-map by one page so base_ can start on a huge page boundary
+        mapping_size_ = size + HUGE_PAGE_SIZE;
+        void* mapping = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            mapping_size_ = 0;
+            return fail("mmap of " + std::to_string(size) + " bytes for the huge page arena failed", errno);
+        }
+        mapping_ = static_cast<char*>(mapping);
+        base_ = mapping_ + (roundUp(reinterpret_cast<uintptr_t>(mapping_), HUGE_PAGE_SIZE) -
+                            reinterpret_cast<uintptr_t>(mapping_));
+        if (madvise(base_, size, MADV_HUGEPAGE) != 0) {
+            return fail("madvise(MADV_HUGEPAGE) failed; the kernel lacks transparent huge page support", errno);
+        }
+        // One write per huge page faults the whole page in
+        for (size_t offset = 0; offset < size; offset += HUGE_PAGE_SIZE) {
+            base_[offset] = 0;
+        }
+    }
+    size_ = size;
+
+    if (config_.lock) {
+        if (mlock(base_, size_) != 0) {
+            return fail("mlock of " + std::to_string(size_) +
+                        " bytes failed; raise RLIMIT_MEMLOCK (ulimit -l) or turn off performance.huge_pages.lock",
+                        errno);
+        }
+        locked_ = true;
+    }
+    return true;
+#else
+    return fail("huge page arenas are only supported on Linux", 0);
+#endif
+}
+
+char* HugePageArena::carve(size_t size) {
+    size_t aligned = roundUp(size, BLOCK_ALIGNMENT);
+    size_t offset = used_.fetch_add(aligned, std::memory_order_relaxed);
+    if (!base_ || offset + aligned > size_) {
+        return nullptr;
+    }
+    return base_ + offset;
+}
+
+HugePageArena* HugePageArena::install(std::unique_ptr<HugePageArena> arena) {
+    HugePageArena* expected = nullptr;
+    if (arena && buffers_.compare_exchange_strong(expected, arena.get(), std::memory_order_acq_rel)) {
+        // Owned by the process from here on
+        return arena.release();
+    }
+    return expected;
+}
+
+bool HugePageArena::fail(const std::string& what, int error_number) {
+    error_ = error_number ? what + ": " + std::strerror(error_number) : what;
+    release();
+    return false;
+}
+
+void HugePageArena::release() {
+#ifdef __linux__
+    if (mapping_) {
+        // munmap drops any lock along with the mapping
+        munmap(mapping_, mapping_size_);
+    }
+#endif
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    base_ = nullptr;
+    size_ = 0;
+    locked_ = false;
+}
+
+} // namespace securechat::utils
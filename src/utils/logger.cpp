@@ -0,0 +1,339 @@
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+namespace securechat::utils {
+
+// Static configuration
+std::atomic<LogLevel> Logger::log_level_{LogLevel::INFO};
+std::atomic<bool> Logger::console_output_{true};
+std::atomic<bool> Logger::async_logging_{false};
+std::atomic<size_t> Logger::max_file_size_{100 * 1024 * 1024};
+std::atomic<int> Logger::max_files_{10};
+std::string Logger::output_file_;
+
+// Async logging
+std::queue<LogEntry> Logger::log_queue_;
+std::mutex Logger::queue_mutex_;
+std::condition_variable Logger::queue_cv_;
+std::thread Logger::log_thread_;
+std::atomic<bool> Logger::shutdown_{false};
+
+// File handling
+std::ofstream Logger::log_file_;
+std::mutex Logger::file_mutex_;
+std::atomic<size_t> Logger::current_file_size_{0};
+
+// Statistics
+std::atomic<uint64_t> Logger::total_entries_{0};
+std::atomic<uint64_t> Logger::dropped_entries_{0};
+std::atomic<uint64_t> Logger::total_processing_time_us_{0};
+
+Logger g_logger("SecureChat");
+
+namespace {
+
+// Entries beyond this are dropped rather than letting a stalled disk grow
+// the queue without bound
+constexpr size_t MAX_QUEUED_ENTRIES = 65536;
+
+// Defined after the statics above, so it is destroyed first and the log
+// thread is flushed and joined while the queue still exists
+struct AsyncLogShutdown {
+    ~AsyncLogShutdown() { Logger::enableAsyncLogging(false); }
+} async_log_shutdown;
+
+} // namespace
+
+Logger::Logger(const std::string& component)
+    : component_(component) {
+}
+
+Logger::~Logger() = default;
+
+void Logger::setLogLevel(LogLevel level) {
+    log_level_.store(level);
+}
+
+void Logger::setOutputFile(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (log_file_.is_open()) {
+        log_file_.close();
+    }
+    output_file_ = filename;
+    current_file_size_.store(0);
+    if (filename.empty()) {
+        return;
+    }
+
+    std::error_code error;
+    auto directory = std::filesystem::path(filename).parent_path();
+    if (!directory.empty()) {
+        std::filesystem::create_directories(directory, error);
+    }
+    log_file_.open(filename, std::ios::app);
+    if (log_file_.is_open()) {
+        current_file_size_.store(static_cast<size_t>(std::filesystem::file_size(filename, error)));
+    } else {
+        std::cerr << "Failed to open log file " << filename << std::endl;
+    }
+}
+
+void Logger::enableConsoleOutput(bool enable) {
+    console_output_.store(enable);
+}
+
+void Logger::enableAsyncLogging(bool enable) {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    if (enable == async_logging_.load()) {
+        return;
+    }
+
+    if (enable) {
+        shutdown_.store(false);
+        async_logging_.store(true);
+        log_thread_ = std::thread(&Logger::processLogQueue);
+        return;
+    }
+
+    // The thread drains what is queued before it exits
+    async_logging_.store(false);
+    shutdown_.store(true);
+    lock.unlock();
+    queue_cv_.notify_all();
+    if (log_thread_.joinable()) {
+        log_thread_.join();
+    }
+}
+
+void Logger::setMaxFileSize(size_t max_size) {
+    max_file_size_.store(max_size);
+}
+
+void Logger::setMaxFiles(int max_files) {
+    max_files_.store(max_files);
+}
+
+void Logger::trace(const std::string& message, const char* file, int line, const char* function) {
+    if (shouldLog(LogLevel::TRACE)) {
+        log(LogLevel::TRACE, message, file, line, function);
+    }
+}
+
+void Logger::debug(const std::string& message, const char* file, int line, const char* function) {
+    if (shouldLog(LogLevel::DEBUG)) {
+        log(LogLevel::DEBUG, message, file, line, function);
+    }
+}
+
+void Logger::info(const std::string& message, const char* file, int line, const char* function) {
+    if (shouldLog(LogLevel::INFO)) {
+        log(LogLevel::INFO, message, file, line, function);
+    }
+}
+
+void Logger::warn(const std::string& message, const char* file, int line, const char* function) {
+    if (shouldLog(LogLevel::WARN)) {
+        log(LogLevel::WARN, message, file, line, function);
+    }
+}
+
+void Logger::error(const std::string& message, const char* file, int line, const char* function) {
+    if (shouldLog(LogLevel::ERROR)) {
+        log(LogLevel::ERROR, message, file, line, function);
+    }
+}
+
+void Logger::fatal(const std::string& message, const char* file, int line, const char* function) {
+    if (shouldLog(LogLevel::FATAL)) {
+        log(LogLevel::FATAL, message, file, line, function);
+    }
+}
+
+Logger::LogBuilder::LogBuilder(Logger& logger, LogLevel level)
+    : logger_(logger), level_(level) {
+}
+
+Logger::LogBuilder::~LogBuilder() {
+    if (shouldLog(level_)) {
+        logger_.log(level_, stream_.str());
+    }
+}
+
+Logger::LogBuilder& Logger::LogBuilder::field(const std::string& key, const std::string& value) {
+    stream_ << (has_fields_ ? " " : "") << key << "=\"" << value << "\"";
+    has_fields_ = true;
+    return *this;
+}
+
+Logger::LogBuilder& Logger::LogBuilder::field(const std::string& key, int value) {
+    stream_ << (has_fields_ ? " " : "") << key << "=" << value;
+    has_fields_ = true;
+    return *this;
+}
+
+Logger::LogBuilder& Logger::LogBuilder::field(const std::string& key, double value) {
+    stream_ << (has_fields_ ? " " : "") << key << "=" << value;
+    has_fields_ = true;
+    return *this;
+}
+
+Logger::LogBuilder& Logger::LogBuilder::field(const std::string& key, bool value) {
+    stream_ << (has_fields_ ? " " : "") << key << "=" << (value ? "true" : "false");
+    has_fields_ = true;
+    return *this;
+}
+
+Logger::LogBuilder& Logger::LogBuilder::message(const std::string& msg) {
+    stream_ << (has_fields_ ? " " : "") << "msg=\"" << msg << "\"";
+    has_fields_ = true;
+    return *this;
+}
+
+Logger::LogBuilder Logger::structured(LogLevel level) {
+    return LogBuilder(*this, level);
+}
+
+uint64_t Logger::getTotalLogEntries() {
+    return total_entries_.load();
+}
+
+uint64_t Logger::getDroppedEntries() {
+    return dropped_entries_.load();
+}
+
+double Logger::getAverageProcessingTime() {
+    uint64_t entries = total_entries_.load();
+    return entries > 0 ? static_cast<double>(total_processing_time_us_.load()) / static_cast<double>(entries) : 0.0;
+}
+
+void Logger::log(LogLevel level, const std::string& message, const char* file, int line, const char* function) {
+    LogEntry entry{level, message, file ? file : "", line, function ? function : "",
+                   std::chrono::system_clock::now(), std::this_thread::get_id(), component_};
+
+    if (async_logging_.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            if (async_logging_.load()) {
+                if (log_queue_.size() >= MAX_QUEUED_ENTRIES) {
+                    dropped_entries_++;
+                    return;
+                }
+                log_queue_.push(std::move(entry));
+                queue_cv_.notify_one();
+                return;
+            }
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    writeLogEntry(entry);
+    total_entries_++;
+    total_processing_time_us_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+void Logger::processLogQueue() {
+    std::queue<LogEntry> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, []() { return !log_queue_.empty() || shutdown_.load(); });
+            if (log_queue_.empty() && shutdown_.load()) {
+                return;
+            }
+            batch.swap(log_queue_);
+        }
+
+        while (!batch.empty()) {
+            auto start = std::chrono::steady_clock::now();
+            writeLogEntry(batch.front());
+            batch.pop();
+            total_entries_++;
+            total_processing_time_us_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+    }
+}
+
+void Logger::writeLogEntry(const LogEntry& entry) {
+    std::string line = formatLogEntry(entry);
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (console_output_.load(std::memory_order_relaxed)) {
+        auto& stream = entry.level >= LogLevel::WARN ? std::cerr : std::cout;
+        stream << line << '\n';
+        stream.flush();
+    }
+    if (log_file_.is_open()) {
+        log_file_ << line << '\n';
+        log_file_.flush();
+        current_file_size_ += line.size() + 1;
+        if (current_file_size_.load() >= max_file_size_.load()) {
+            rotateLogFile();
+        }
+    }
+}
+
+std::string Logger::formatLogEntry(const LogEntry& entry) {
+    auto seconds = std::chrono::system_clock::to_time_t(entry.timestamp);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        entry.timestamp.time_since_epoch()).count() % 1000;
+    std::tm local{};
+    localtime_r(&seconds, &local);
+
+    std::ostringstream out;
+    out << '[' << std::put_time(&local, "%Y-%m-%d %H:%M:%S") << '.' << std::setw(3) << std::setfill('0')
+        << millis << "] [" << levelToString(entry.level) << ']';
+    if (!entry.component.empty()) {
+        out << " [" << entry.component << ']';
+    }
+    out << ' ' << entry.message;
+    if (!entry.file.empty() && entry.line > 0) {
+        out << " (" << std::filesystem::path(entry.file).filename().string() << ':' << entry.line << ')';
+    }
+    return out.str();
+}
+
+std::string Logger::levelToString(LogLevel level) {
+    switch (level) {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARN: return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::FATAL: return "FATAL";
+    }
+    return "UNKNOWN";
+}
+
+bool Logger::shouldLog(LogLevel level) {
+    return level >= log_level_.load(std::memory_order_relaxed);
+}
+
+void Logger::rotateLogFile() {
+    // Caller holds file_mutex_. securechat.log becomes securechat.log.1, the
+    // old .1 becomes .2 and so on; the oldest beyond max_files is removed.
+    log_file_.close();
+    std::error_code error;
+    int max_files = std::max(1, max_files_.load());
+    std::filesystem::remove(output_file_ + "." + std::to_string(max_files - 1), error);
+    for (int i = max_files - 2; i >= 1; --i) {
+        std::filesystem::rename(output_file_ + "." + std::to_string(i),
+                                output_file_ + "." + std::to_string(i + 1), error);
+    }
+    if (max_files > 1) {
+        std::filesystem::rename(output_file_, output_file_ + ".1", error);
+    } else {
+        std::filesystem::remove(output_file_, error);
+    }
+    log_file_.open(output_file_, std::ios::trunc);
+    current_file_size_.store(0);
+}
+
+} // namespace securechat::utils
@@ -0,0 +1,67 @@
+#include "utils/memory_pool.hpp"
+
+#include "utils/huge_page_arena.hpp"
+
+namespace securechat::utils {
+
+MemoryPool::MemoryPool(size_t block_size, size_t max_cached_blocks, HugePageArena* arena)
+    : block_size_(block_size)
+    , max_cached_blocks_(max_cached_blocks)
+    , arena_(arena) {
+    free_blocks_.reserve(max_cached_blocks_);
+}
+
+MemoryPool::~MemoryPool() {
+    for (char* block : free_blocks_) {
+        if (!arena_ || !arena_->contains(block)) {
+            delete[] block;
+        }
+    }
+}
+
+MemoryPool::Block MemoryPool::acquire() {
+    return Block(this, allocate());
+}
+
+char* MemoryPool::allocate() {
+    char* block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_blocks_.empty()) {
+            block = free_blocks_.back();
+            free_blocks_.pop_back();
+        }
+    }
+
+    if (!block && arena_) {
+        block = arena_->carve(block_size_);
+        if (block) {
+            arena_allocations_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (!block) {
+        block = new char[block_size_];
+        heap_allocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+    blocks_in_use_.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+void MemoryPool::deallocate(char* block) {
+    blocks_in_use_.fetch_sub(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_blocks_.size() < max_cached_blocks_ || (arena_ && arena_->contains(block))) {
+            free_blocks_.push_back(block);
+            return;
+        }
+    }
+    delete[] block;
+}
+
+size_t MemoryPool::getCachedBlocks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_blocks_.size();
+}
+
+} // namespace securechat::utils
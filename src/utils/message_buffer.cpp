@@ -0,0 +1,71 @@
+#include "utils/message_buffer.hpp"
+
+#include <array>
+#include <memory>
+#include <new>
+
+#include "utils/huge_page_arena.hpp"
+#include "utils/memory_pool.hpp"
+
+namespace securechat::utils {
+
+namespace {
+
+// Block sizes include the Storage header
+constexpr std::array<size_t, 5> SIZE_CLASSES = {256, 1024, 4096, 16384, MessageBuffer::MAX_POOLED_SIZE};
+constexpr size_t CACHED_BLOCKS_PER_CLASS = 256;
+
+MemoryPool& sizeClassPool(size_t index) {
+    static std::array<std::unique_ptr<MemoryPool>, SIZE_CLASSES.size()> pools = []() {
+        std::array<std::unique_ptr<MemoryPool>, SIZE_CLASSES.size()> created;
+        for (size_t i = 0; i < SIZE_CLASSES.size(); ++i) {
+            created[i] = std::make_unique<MemoryPool>(SIZE_CLASSES[i], CACHED_BLOCKS_PER_CLASS,
+                                                      HugePageArena::buffers());
+        }
+        return created;
+    }();
+    return *pools[index];
+}
+
+} // namespace
+
+MessageBuffer::MessageBuffer(std::string_view bytes) {
+    std::memcpy(allocate(bytes.size()), bytes.data(), bytes.size());
+}
+
+char* MessageBuffer::allocate(size_t size) {
+    size_ = size;
+    if (isInline()) {
+        return inline_;
+    }
+
+    size_t total = sizeof(Storage) + size;
+    uint32_t pool_class = 0;
+    void* block = nullptr;
+    for (size_t i = 0; i < SIZE_CLASSES.size(); ++i) {
+        if (total <= SIZE_CLASSES[i]) {
+            block = sizeClassPool(i).allocate();
+            pool_class = static_cast<uint32_t>(i + 1);
+            break;
+        }
+    }
+    if (!block) {
+        block = ::operator new(total);
+    }
+
+    storage_ = new (block) Storage{};
+    storage_->pool_class = pool_class;
+    return storage_->bytes();
+}
+
+void MessageBuffer::free(Storage* storage) {
+    uint32_t pool_class = storage->pool_class;
+    storage->~Storage();
+    if (pool_class > 0) {
+        sizeClassPool(pool_class - 1).deallocate(reinterpret_cast<char*>(storage));
+    } else {
+        ::operator delete(storage);
+    }
+}
+
+} // namespace securechat::utils
@@ -0,0 +1,188 @@
+#include "utils/metrics_collector.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace securechat::utils {
+
+namespace {
+
+constexpr const char* METRIC_PREFIX = "securechat_";
+
+// Prometheus names allow [a-zA-Z0-9_:]; plugin names may not
+std::string sanitize(const std::string& name) {
+    std::string out = name;
+    for (char& c : out) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != ':') {
+            c = '_';
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+MetricsCollector::MetricsCollector(const ConfigManager& config)
+    : config_(config)
+    , path_(config.getMetricsPath())
+    , logger_("MetricsCollector") {
+}
+
+MetricsCollector::~MetricsCollector() {
+    stop();
+}
+
+bool MetricsCollector::initialize() {
+#ifdef _WIN32
+    logger_.warn("Metrics endpoint is not supported on this platform");
+    return false;
+#else
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        logger_.error("Failed to create metrics socket: {}", std::strerror(errno));
+        return false;
+    }
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(config_.getMetricsPort()));
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd_, 16) != 0) {
+        logger_.error("Failed to listen on metrics port {}: {}", config_.getMetricsPort(), std::strerror(errno));
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    running_.store(true);
+    server_thread_ = std::thread(&MetricsCollector::serve, this);
+    logger_.info("Serving metrics on port {} at {}", config_.getMetricsPort(), path_);
+    return true;
+#endif
+}
+
+void MetricsCollector::stop() {
+    running_.store(false);
+    if (server_thread_.joinable()) {
+        server_thread_.join();
+    }
+#ifndef _WIN32
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+#endif
+}
+
+void MetricsCollector::incrementCounter(const std::string& name, uint64_t value) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    counters_[name] += value;
+}
+
+void MetricsCollector::setGauge(const std::string& name, double value) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    gauges_[name] = value;
+}
+
+uint64_t MetricsCollector::getCounter(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    auto it = counters_.find(name);
+    return it != counters_.end() ? it->second : 0;
+}
+
+double MetricsCollector::getGauge(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    auto it = gauges_.find(name);
+    return it != gauges_.end() ? it->second : 0.0;
+}
+
+std::string MetricsCollector::exportPrometheus() const {
+    std::ostringstream out;
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    for (const auto& [name, value] : counters_) {
+        std::string metric = METRIC_PREFIX + sanitize(name);
+        out << "# TYPE " << metric << " counter\n" << metric << ' ' << value << '\n';
+    }
+    for (const auto& [name, value] : gauges_) {
+        std::string metric = METRIC_PREFIX + sanitize(name);
+        out << "# TYPE " << metric << " gauge\n" << metric << ' ' << value << '\n';
+    }
+    return out.str();
+}
+
+void MetricsCollector::serve() {
+#ifndef _WIN32
+    // Scrapes are rare; poll so stop() is noticed within a quarter second
+    while (running_.load()) {
+        pollfd descriptor{listen_fd_, POLLIN, 0};
+        if (poll(&descriptor, 1, 250) <= 0) {
+            continue;
+        }
+        int client_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd >= 0) {
+            handleScrape(client_fd);
+            close(client_fd);
+        }
+    }
+#endif
+}
+
+void MetricsCollector::handleScrape(int client_fd) {
+#ifndef _WIN32
+    timeval timeout{1, 0};
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char request[1024];
+    ssize_t received = recv(client_fd, request, sizeof(request) - 1, 0);
+    if (received <= 0) {
+        return;
+    }
+    request[received] = '\0';
+
+    // "GET /metrics HTTP/1.1"
+    std::istringstream line(request);
+    std::string method;
+    std::string target;
+    line >> method >> target;
+
+    std::string status = "200 OK";
+    std::string body;
+    if (method != "GET") {
+        status = "405 Method Not Allowed";
+    } else if (target.substr(0, target.find('?')) != path_) {
+        status = "404 Not Found";
+    } else {
+        body = exportPrometheus();
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+    size_t offset = 0;
+    while (offset < response.size()) {
+        ssize_t sent = send(client_fd, response.data() + offset, response.size() - offset, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return;
+        }
+        offset += static_cast<size_t>(sent);
+    }
+#else
+    (void)client_fd;
+#endif
+}
+
+} // namespace securechat::utils
@@ -0,0 +1,330 @@
+#include "utils/text_validator.hpp"
+#include "utils/cpu_features.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SECURECHAT_X86_SIMD 1
+#endif
+
+namespace securechat::utils {
+
+namespace {
+
+constexpr size_t SIMD_MIN_LENGTH = 16;
+
+inline bool isControlByte(unsigned char c) {
+    return (c < 0x20 && c != '\t' && c != '\n' && c != '\r') || c == 0x7F;
+}
+
+#ifdef SECURECHAT_X86_SIMD
+
+// Error classes of a (previous byte, current byte) pair. A pair is invalid
+// when the three nibble lookups share a bit; TWO_CONTS is instead checked
+// against where continuations are required.
+constexpr uint8_t TOO_SHORT = 1 << 0;       // 11______ 0_______, 11______ 11______
+constexpr uint8_t TOO_LONG = 1 << 1;        // 0_______ 10______
+constexpr uint8_t OVERLONG_3 = 1 << 2;      // 11100000 100_____
+constexpr uint8_t TOO_LARGE = 1 << 3;       // 11110100 1001____, 11110100 101_____, 11110101+
+constexpr uint8_t SURROGATE = 1 << 4;       // 11101101 101_____
+constexpr uint8_t OVERLONG_2 = 1 << 5;      // 1100000_ 10______
+constexpr uint8_t TOO_LARGE_1000 = 1 << 6;  // 11110101+ 1000____
+constexpr uint8_t OVERLONG_4 = 1 << 6;      // 11110000 1000____
+constexpr uint8_t TWO_CONTS = 1 << 7;       // 10______ 10______
+constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+// Indexed by the high nibble of the previous byte
+alignas(16) constexpr uint8_t BYTE_1_HIGH[16] = {
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+    TOO_SHORT | OVERLONG_2,
+    TOO_SHORT,
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+
+// Indexed by the low nibble of the previous byte
+alignas(16) constexpr uint8_t BYTE_1_LOW[16] = {
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+    CARRY | OVERLONG_2,
+    CARRY,
+    CARRY,
+    CARRY | TOO_LARGE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+
+// Indexed by the high nibble of the current byte
+alignas(16) constexpr uint8_t BYTE_2_HIGH[16] = {
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+
+// 16-byte steps. Blocks are checked against the previous block's bytes so
+// sequences may straddle blocks; the tail is checked in a zero-padded block,
+// whose padding is ASCII and so exposes a truncated final sequence.
+struct SSSE3Validator {
+    // Zeroed by run(), which carries the target attribute
+    __m128i prev_input;
+    __m128i prev_incomplete;
+    __m128i error;
+    __m128i control;
+
+    __attribute__((target("ssse3")))
+    static __m128i lookup(const uint8_t* table, __m128i nibbles) {
+        return _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(table)), nibbles);
+    }
+
+    // Returns the disallowed control bytes of input, as 0xFF lanes
+    __attribute__((target("ssse3")))
+    __m128i step(__m128i input) {
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, prev_incomplete);
+        } else {
+            __m128i special = _mm_and_si128(
+                _mm_and_si128(lookup(BYTE_1_HIGH, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                              lookup(BYTE_1_LOW, _mm_and_si128(prev1, nibble))),
+                lookup(BYTE_2_HIGH, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+            // Third and fourth bytes of 3- and 4-byte sequences must be continuations
+            __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+            __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+            __m128i must_continue = _mm_and_si128(
+                _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xe0 - 0x80))),
+                             _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xf0 - 0x80)))),
+                _mm_set1_epi8(static_cast<char>(0x80)));
+            error = _mm_or_si128(error, _mm_xor_si128(must_continue, special));
+            // A lead byte too close to the end to be complete
+            prev_incomplete = _mm_subs_epu8(input, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                                 static_cast<char>(0xef), static_cast<char>(0xdf),
+                                                                 static_cast<char>(0xbf)));
+        }
+        prev_input = input;
+
+        // C0 controls other than tab, LF and CR; DEL; C1 controls (C2 80-C2 9F)
+        __m128i c0 = _mm_cmpeq_epi8(_mm_min_epu8(input, _mm_set1_epi8(0x1f)), input);
+        __m128i allowed = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(input, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(input, _mm_set1_epi8('\n'))),
+            _mm_cmpeq_epi8(input, _mm_set1_epi8('\r')));
+        __m128i del = _mm_cmpeq_epi8(input, _mm_set1_epi8(0x7f));
+        __m128i c1 = _mm_and_si128(_mm_cmpeq_epi8(prev1, _mm_set1_epi8(static_cast<char>(0xc2))),
+                                   _mm_cmpeq_epi8(_mm_min_epu8(input, _mm_set1_epi8(static_cast<char>(0x9f))), input));
+        return _mm_or_si128(_mm_or_si128(_mm_andnot_si128(allowed, c0), del), c1);
+    }
+
+    __attribute__((target("ssse3")))
+    TextStatus run(const unsigned char* data, size_t length) {
+        prev_input = prev_incomplete = error = control = _mm_setzero_si128();
+        size_t pos = 0;
+        for (; pos + 16 <= length; pos += 16) {
+            control = _mm_or_si128(control, step(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos))));
+        }
+
+        alignas(16) unsigned char tail[16] = {};
+        size_t remaining = length - pos;
+        std::memcpy(tail, data + pos, remaining);
+        unsigned tail_control = static_cast<unsigned>(
+            _mm_movemask_epi8(step(_mm_load_si128(reinterpret_cast<const __m128i*>(tail)))));
+        error = _mm_or_si128(error, prev_incomplete);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xffff) {
+            return TextStatus::INVALID_UTF8;
+        }
+        // Padding is NUL, which would count as a control character
+        tail_control &= (1u << remaining) - 1;
+        return _mm_movemask_epi8(control) != 0 || tail_control != 0 ? TextStatus::CONTROL_CHARACTER
+                                                                     : TextStatus::VALID;
+    }
+};
+
+// The same algorithm in 32-byte steps
+struct AVX2Validator {
+    __m256i prev_input;
+    __m256i prev_incomplete;
+    __m256i error;
+    __m256i control;
+
+    __attribute__((target("avx2")))
+    static __m256i lookup(const uint8_t* table, __m256i nibbles) {
+        return _mm256_shuffle_epi8(
+            _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table))), nibbles);
+    }
+
+    // Bytes shifted in from the previous block, as _mm_alignr_epi8 across lanes
+    template<int N>
+    __attribute__((target("avx2")))
+    __m256i prev(__m256i input) const {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+    }
+
+    __attribute__((target("avx2")))
+    __m256i step(__m256i input) {
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        __m256i prev1 = prev<1>(input);
+
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = _mm256_or_si256(error, prev_incomplete);
+        } else {
+            __m256i special = _mm256_and_si256(
+                _mm256_and_si256(lookup(BYTE_1_HIGH, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                                 lookup(BYTE_1_LOW, _mm256_and_si256(prev1, nibble))),
+                lookup(BYTE_2_HIGH, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+            __m256i must_continue = _mm256_and_si256(
+                _mm256_or_si256(_mm256_subs_epu8(prev<2>(input), _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80))),
+                                _mm256_subs_epu8(prev<3>(input), _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)))),
+                _mm256_set1_epi8(static_cast<char>(0x80)));
+            error = _mm256_or_si256(error, _mm256_xor_si256(must_continue, special));
+            prev_incomplete = _mm256_subs_epu8(
+                input, _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        static_cast<char>(0xef), static_cast<char>(0xdf), static_cast<char>(0xbf)));
+        }
+        prev_input = input;
+
+        __m256i c0 = _mm256_cmpeq_epi8(_mm256_min_epu8(input, _mm256_set1_epi8(0x1f)), input);
+        __m256i allowed = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(input, _mm256_set1_epi8('\t')),
+                            _mm256_cmpeq_epi8(input, _mm256_set1_epi8('\n'))),
+            _mm256_cmpeq_epi8(input, _mm256_set1_epi8('\r')));
+        __m256i del = _mm256_cmpeq_epi8(input, _mm256_set1_epi8(0x7f));
+        __m256i c1 = _mm256_and_si256(
+            _mm256_cmpeq_epi8(prev1, _mm256_set1_epi8(static_cast<char>(0xc2))),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(input, _mm256_set1_epi8(static_cast<char>(0x9f))), input));
+        return _mm256_or_si256(_mm256_or_si256(_mm256_andnot_si256(allowed, c0), del), c1);
+    }
+
+    __attribute__((target("avx2")))
+    TextStatus run(const unsigned char* data, size_t length) {
+        prev_input = prev_incomplete = error = control = _mm256_setzero_si256();
+        size_t pos = 0;
+        for (; pos + 32 <= length; pos += 32) {
+            control = _mm256_or_si256(control,
+                                      step(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos))));
+        }
+
+        alignas(32) unsigned char tail[32] = {};
+        size_t remaining = length - pos;
+        std::memcpy(tail, data + pos, remaining);
+        unsigned tail_control = static_cast<unsigned>(
+            _mm256_movemask_epi8(step(_mm256_load_si256(reinterpret_cast<const __m256i*>(tail)))));
+        error = _mm256_or_si256(error, prev_incomplete);
+
+        if (!_mm256_testz_si256(error, error)) {
+            return TextStatus::INVALID_UTF8;
+        }
+        tail_control &= remaining < 32 ? (1u << remaining) - 1 : ~0u;
+        return !_mm256_testz_si256(control, control) || tail_control != 0 ? TextStatus::CONTROL_CHARACTER
+                                                                           : TextStatus::VALID;
+    }
+};
+
+#endif
+
+} // namespace
+
+TextStatus validateTextScalar(std::string_view text) {
+    auto data = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t length = text.size();
+    bool control = false;
+
+    size_t i = 0;
+    while (i < length) {
+        unsigned char lead = data[i];
+        if (lead < 0x80) {
+            control = control || isControlByte(lead);
+            ++i;
+            continue;
+        }
+
+        size_t sequence_length;
+        uint32_t code_point;
+        uint32_t min_code_point;
+        if ((lead & 0xe0) == 0xc0) {
+            sequence_length = 2;
+            code_point = lead & 0x1f;
+            min_code_point = 0x80;
+        } else if ((lead & 0xf0) == 0xe0) {
+            sequence_length = 3;
+            code_point = lead & 0x0f;
+            min_code_point = 0x800;
+        } else if ((lead & 0xf8) == 0xf0) {
+            sequence_length = 4;
+            code_point = lead & 0x07;
+            min_code_point = 0x10000;
+        } else {
+            return TextStatus::INVALID_UTF8;
+        }
+        if (length - i < sequence_length) {
+            return TextStatus::INVALID_UTF8;
+        }
+        for (size_t k = 1; k < sequence_length; ++k) {
+            unsigned char continuation = data[i + k];
+            if ((continuation & 0xc0) != 0x80) {
+                return TextStatus::INVALID_UTF8;
+            }
+            code_point = (code_point << 6) | (continuation & 0x3f);
+        }
+        if (code_point < min_code_point || code_point > 0x10ffff ||
+            (code_point >= 0xd800 && code_point <= 0xdfff)) {
+            return TextStatus::INVALID_UTF8;
+        }
+        control = control || code_point <= 0x9f;
+        i += sequence_length;
+    }
+    return control ? TextStatus::CONTROL_CHARACTER : TextStatus::VALID;
+}
+
+TextStatus validateTextSSSE3(std::string_view text) {
+#ifdef SECURECHAT_X86_SIMD
+    if (cpuFeatures().ssse3) {
+        SSSE3Validator validator;
+        return validator.run(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+    }
+#endif
+    return validateTextScalar(text);
+}
+
+TextStatus validateTextAVX2(std::string_view text) {
+#ifdef SECURECHAT_X86_SIMD
+    if (cpuFeatures().avx2) {
+        AVX2Validator validator;
+        return validator.run(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+    }
+#endif
+    return validateTextScalar(text);
+}
+
+TextStatus validateText(std::string_view text) {
+#ifdef SECURECHAT_X86_SIMD
+    if (text.size() >= SIMD_MIN_LENGTH) {
+        const auto& features = cpuFeatures();
+        if (features.avx2) {
+            AVX2Validator validator;
+            return validator.run(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+        }
+        if (features.ssse3) {
+            SSSE3Validator validator;
+            return validator.run(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+        }
+    }
+#endif
+    return validateTextScalar(text);
+}
+
+} // namespace securechat::utils
@@ -0,0 +1,67 @@
+// Sample message pipeline plugin used by test_plugins.
+//
+// Rejects messages containing the word given as the plugin config, rewrites
+// "/shout <text>" to upper case and accepts everything else.
+
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "plugins/plugin_abi.h"
+
+namespace {
+
+struct SampleInstance {
+    std::string blocked_word;
+    uint32_t worker_index;
+};
+
+void* createInstance(const char* config, uint32_t worker_index) {
+    return new SampleInstance{config, worker_index};
+}
+
+void destroyInstance(void* instance) {
+    delete static_cast<SampleInstance*>(instance);
+}
+
+securechat_verdict onMessage(void* instance, const securechat_message_view* message,
+                             securechat_rewrite_buffer* rewrite) {
+    auto* self = static_cast<SampleInstance*>(instance);
+    std::string_view text(message->data, message->length);
+
+    if (!self->blocked_word.empty() && text.find(self->blocked_word) != std::string_view::npos) {
+        return SECURECHAT_VERDICT_REJECT;
+    }
+
+    constexpr std::string_view SHOUT = "/shout ";
+    if (text.substr(0, SHOUT.size()) != SHOUT) {
+        return SECURECHAT_VERDICT_ACCEPT;
+    }
+
+    text.remove_prefix(SHOUT.size());
+    rewrite->length = text.size();
+    if (text.size() <= rewrite->capacity) {
+        for (size_t i = 0; i < text.size(); ++i) {
+            rewrite->data[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(text[i])));
+        }
+    }
+    return SECURECHAT_VERDICT_REWRITE;
+}
+
+const securechat_plugin DESCRIPTOR = {
+    SECURECHAT_PLUGIN_ABI_VERSION,
+    sizeof(securechat_plugin),
+    "sample",
+    "1.0.0",
+    createInstance,
+    destroyInstance,
+    onMessage,
+    SECURECHAT_PLUGIN_REWRITES,
+};
+
+} // namespace
+
+extern "C" SECURECHAT_PLUGIN_EXPORT const securechat_plugin* securechat_plugin_descriptor(void) {
+    return &DESCRIPTOR;
+}
@@ -0,0 +1,939 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/client_connection.hpp"
+#include "core/connection_table.hpp"
+#include "core/event_loop.hpp"
+#include "core/executor.hpp"
+#include "core/message_deduplicator.hpp"
+#include "core/retransmit_window.hpp"
+#include "core/shard.hpp"
+#include "core/task.hpp"
+#include "network/memory_transport.hpp"
+#include "network/protocol_handler.hpp"
+#include "utils/allocation_counter.hpp"
+#include "utils/clock.hpp"
+#include "utils/memory_pool.hpp"
+#include "utils/message_buffer.hpp"
+#include "utils/spsc_queue.hpp"
+
+using securechat::core::ClientConnection;
+using securechat::core::ClientState;
+using securechat::core::ConnectionHandle;
+using securechat::core::ConnectionTable;
+using securechat::core::DeduplicationConfig;
+using securechat::core::EventLoop;
+using securechat::core::Executor;
+using securechat::core::ExecutorConfig;
+using securechat::core::MessageDeduplicator;
+using securechat::core::ResumableWindows;
+using securechat::core::RetransmitWindow;
+using securechat::core::Shard;
+using securechat::core::ShardedRuntime;
+using securechat::core::Task;
+using securechat::utils::AllocationCounter;
+using securechat::utils::MessageBuffer;
+using securechat::utils::NoAllocationScope;
+
+class ShardedRuntimeTest : public ::testing::Test {
+protected:
+    struct Delivery {
+        size_t shard;
+        uint64_t client_id;
+        uint64_t sender_id;
+        std::string message;
+    };
+
+    void TearDown() override {
+        if (runtime_) {
+            runtime_->stop();
+        }
+    }
+
+    void createRuntime(size_t shards, size_t queue_capacity = ShardedRuntime::DEFAULT_QUEUE_CAPACITY) {
+        runtime_ = std::make_unique<ShardedRuntime>(
+            shards,
+            [this](Shard& shard, uint64_t client_id, uint64_t sender_id, const MessageBuffer& message) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                deliveries_.push_back({shard.getIndex(), client_id, sender_id, message.str()});
+            },
+            securechat::utils::CpuSet{}, queue_capacity);
+        runtime_->start();
+    }
+
+    // Runs task on the client's shard and waits for it
+    void onShardOf(uint64_t client_id, std::function<void(Shard&)> task) {
+        std::promise<void> done;
+        runtime_->post(runtime_->shardOf(client_id), [&](Shard& shard) {
+            task(shard);
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
+
+    bool waitForDeliveries(size_t count) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (deliveries_.size() >= count) {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    // Lets interest notices settle on every shard
+    void settle() {
+        for (uint64_t client = 0; client < runtime_->getShardCount(); ++client) {
+            onShardOf(client, [](Shard&) {});
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    std::unique_ptr<ShardedRuntime> runtime_;
+    std::mutex mutex_;
+    std::vector<Delivery> deliveries_;
+};
+
+TEST_F(ShardedRuntimeTest, DeliversAcrossShardsOnTheRecipientShard) {
+    createRuntime(4);
+    for (uint64_t client = 0; client < 8; ++client) {
+        onShardOf(client, [client](Shard& shard) { shard.join(client, 1); });
+    }
+    settle();
+
+    onShardOf(0, [](Shard& shard) { shard.publish(1, 0, MessageBuffer("hello")); });
+    ASSERT_TRUE(waitForDeliveries(7));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    EXPECT_EQ(deliveries_.size(), 7u);
+    for (const auto& delivery : deliveries_) {
+        EXPECT_NE(delivery.client_id, 0u);
+        EXPECT_EQ(delivery.shard, runtime_->shardOf(delivery.client_id));
+        EXPECT_EQ(delivery.sender_id, 0u);
+        EXPECT_EQ(delivery.message, "hello");
+    }
+    // One copy per interested shard, not per recipient
+    EXPECT_EQ(runtime_->getShard(0).getForwarded(), 3u);
+}
+
+TEST_F(ShardedRuntimeTest, ForwardsOnlyToShardsWithMembers) {
+    createRuntime(4);
+    onShardOf(0, [](Shard& shard) { shard.join(0, 7); });
+    onShardOf(2, [](Shard& shard) { shard.join(2, 7); });
+    settle();
+
+    onShardOf(0, [](Shard& shard) { shard.publish(7, 0, MessageBuffer("a")); });
+    ASSERT_TRUE(waitForDeliveries(1));
+    EXPECT_EQ(runtime_->getShard(0).getForwarded(), 1u);
+
+    onShardOf(2, [](Shard& shard) { shard.leave(2, 7); });
+    settle();
+    onShardOf(0, [](Shard& shard) { shard.publish(7, 0, MessageBuffer("b")); });
+    settle();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ASSERT_EQ(deliveries_.size(), 1u);
+    EXPECT_EQ(deliveries_[0].client_id, 2u);
+    EXPECT_EQ(runtime_->getShard(0).getForwarded(), 1u);
+}
+
+TEST_F(ShardedRuntimeTest, SendsDirectMessagesToTheOwningShard) {
+    createRuntime(4);
+
+    // Client 4 is local to shard 0, client 6 lives on shard 2
+    onShardOf(0, [](Shard& shard) {
+        shard.sendTo(4, 8, MessageBuffer("here"));
+        shard.sendTo(6, 8, MessageBuffer("there"));
+    });
+    ASSERT_TRUE(waitForDeliveries(2));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ASSERT_EQ(deliveries_.size(), 2u);
+    for (const auto& delivery : deliveries_) {
+        EXPECT_EQ(delivery.shard, runtime_->shardOf(delivery.client_id));
+        EXPECT_EQ(delivery.sender_id, 8u);
+        EXPECT_EQ(delivery.message, delivery.client_id == 4 ? "here" : "there");
+    }
+    EXPECT_EQ(runtime_->getShard(0).getLocalDeliveries(), 1u);
+    EXPECT_EQ(runtime_->getShard(0).getForwarded(), 1u);
+    EXPECT_EQ(runtime_->getShard(2).getLocalDeliveries(), 1u);
+}
+
+TEST_F(ShardedRuntimeTest, BacklogsWhenQueueIsFullWithoutLosingOrder) {
+    constexpr int MESSAGES = 500;
+    createRuntime(2, 4);
+    onShardOf(1, [](Shard& shard) { shard.join(1, 3); });
+    settle();
+
+    onShardOf(0, [](Shard& shard) {
+        for (int i = 0; i < MESSAGES; ++i) {
+            shard.publish(3, 0, MessageBuffer(std::to_string(i)));
+        }
+    });
+    ASSERT_TRUE(waitForDeliveries(MESSAGES));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < MESSAGES; ++i) {
+        ASSERT_EQ(deliveries_[i].message, std::to_string(i));
+    }
+    EXPECT_GT(runtime_->getShard(0).getBackloggedMessages(), 0u);
+    EXPECT_GT(runtime_->getShard(1).getBatchesDrained(), 0u);
+}
+
+TEST_F(ShardedRuntimeTest, RunsShardTimers) {
+    createRuntime(2);
+    std::promise<size_t> fired;
+    runtime_->post(1, [&](Shard& shard) {
+        shard.timers().runAfter(std::chrono::milliseconds(10), [&]() {
+            fired.set_value(Shard::current()->getIndex());
+        });
+    });
+
+    auto future = fired.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(future.get(), 1u);
+}
+
+TEST_F(ShardedRuntimeTest, BusyPollingSpinsThenBacksOff) {
+    createRuntime(2);
+    securechat::network::BusyPollConfig busy_poll;
+    busy_poll.enabled = true;
+    busy_poll.max_spin = std::chrono::microseconds(200);
+    for (uint64_t client = 0; client < 2; ++client) {
+        onShardOf(client, [&](Shard& shard) { shard.setBusyPoll(busy_poll); });
+    }
+    onShardOf(1, [](Shard& shard) { shard.join(1, 5); });
+    settle();
+
+    onShardOf(0, [](Shard& shard) { shard.publish(5, 0, MessageBuffer("tick")); });
+    ASSERT_TRUE(waitForDeliveries(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // Idle shards gave up spinning after a bounded number of misses
+    for (size_t i = 0; i < 2; ++i) {
+        const Shard& shard = runtime_->getShard(i);
+        EXPECT_GT(shard.getSpinMisses(), 0u);
+        EXPECT_LT(shard.getSpinMisses(), 1000u);
+    }
+}
+
+namespace {
+
+// Resumes the awaiting coroutine from a SimulatedClock timer
+struct SleepOn {
+    securechat::utils::SimulatedClock& clock;
+    securechat::utils::Clock::duration delay;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> waiter) { clock.runAfter(delay, [waiter]() { waiter.resume(); }); }
+    void await_resume() const noexcept {}
+};
+
+Task<int> doubleAfter(std::allocator_arg_t, securechat::utils::MemoryPool&,
+                      securechat::utils::SimulatedClock& clock, int value) {
+    co_await SleepOn{clock, std::chrono::seconds(1)};
+    co_return value * 2;
+}
+
+Task<int> failAfter(securechat::utils::SimulatedClock& clock) {
+    co_await SleepOn{clock, std::chrono::seconds(1)};
+    throw std::runtime_error("handshake failed");
+}
+
+} // namespace
+
+TEST(TaskTest, RunsSequentiallyAcrossSuspensionsWithPooledFrames) {
+    securechat::utils::MemoryPool pool(1024, 4);
+    securechat::utils::SimulatedClock clock;
+    std::vector<int> results;
+
+    auto session = [&](std::allocator_arg_t, securechat::utils::MemoryPool& frames) -> Task<> {
+        int first = co_await doubleAfter(std::allocator_arg, frames, clock, 1);
+        results.push_back(first);
+        results.push_back(co_await doubleAfter(std::allocator_arg, frames, clock, first));
+    };
+    securechat::core::spawn(session(std::allocator_arg, pool));
+
+    EXPECT_TRUE(results.empty());
+    EXPECT_EQ(pool.getBlocksInUse(), 2u);  // session and the first step
+    clock.advance(std::chrono::seconds(1));
+    EXPECT_EQ(results, (std::vector<int>{2}));
+    clock.advance(std::chrono::seconds(1));
+    EXPECT_EQ(results, (std::vector<int>{2, 4}));
+
+    // Every frame went back to the pool, and only two were ever allocated
+    EXPECT_EQ(pool.getBlocksInUse(), 0u);
+    EXPECT_EQ(pool.getHeapAllocations(), 2u);
+}
+
+TEST(TaskTest, PropagatesExceptionsToTheAwaiter) {
+    securechat::utils::SimulatedClock clock;
+    std::string error;
+
+    auto session = [&]() -> Task<> {
+        try {
+            co_await failAfter(clock);
+        } catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+    };
+    securechat::core::spawn(session());
+
+    clock.advance(std::chrono::seconds(1));
+    EXPECT_EQ(error, "handshake failed");
+}
+
+class ExecutorTest : public ::testing::Test {
+protected:
+    static ExecutorConfig config(size_t min_threads, size_t max_threads) {
+        ExecutorConfig config;
+        config.name = "test";
+        config.min_threads = min_threads;
+        config.max_threads = max_threads;
+        config.target_queue_delay = std::chrono::milliseconds(1);
+        config.idle_timeout = std::chrono::milliseconds(50);
+        return config;
+    }
+
+    static bool waitUntil(const std::function<bool()>& condition) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+};
+
+TEST_F(ExecutorTest, GrowsOnQueueDelayAndShrinksWhenIdle) {
+    Executor executor(config(1, 4));
+    EXPECT_EQ(executor.getThreadCount(), 1u);
+
+    // Tasks that block keep later ones waiting, so delay drives growth
+    std::atomic<bool> release{false};
+    std::atomic<int> finished{0};
+    for (int i = 0; i < 16; ++i) {
+        ASSERT_TRUE(executor.submit([&]() {
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            finished++;
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_EQ(executor.getThreadCount(), 4u);
+
+    release.store(true);
+    ASSERT_TRUE(waitUntil([&]() { return finished.load() == 16; }));
+    EXPECT_GT(executor.getQueueDelay().count(), 0);
+    ASSERT_TRUE(waitUntil([&]() { return executor.getThreadCount() == 1; }));
+}
+
+TEST_F(ExecutorTest, ManyShortTasksDoNotGrow) {
+    Executor executor(config(1, 4));
+    std::atomic<int> finished{0};
+    for (int i = 0; i < 200; ++i) {
+        executor.submit([&]() { finished++; });
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    ASSERT_TRUE(waitUntil([&]() { return finished.load() == 200; }));
+    EXPECT_EQ(executor.getThreadCount(), 1u);
+}
+
+TEST_F(ExecutorTest, StopRunsQueuedTasksAndReportsUtilization) {
+    Executor executor(config(0, 2));
+    executor.sampleUtilization();
+    std::atomic<int> finished{0};
+    for (int i = 0; i < 10; ++i) {
+        executor.submit([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            finished++;
+        });
+    }
+    executor.stop();
+
+    EXPECT_EQ(finished.load(), 10);
+    EXPECT_EQ(executor.getTasksCompleted(), 10u);
+    EXPECT_FALSE(executor.submit([]() {}));
+    EXPECT_GT(executor.sampleUtilization(), 0.0);
+}
+
+class EventLoopTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(loop_.initialize());
+        loop_.start();
+    }
+
+    void TearDown() override { loop_.stop(); }
+
+    // Round trip through the loop so everything posted before has run
+    void flush() {
+        std::promise<void> done;
+        loop_.scheduleTask([&done]() { done.set_value(); });
+        ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    }
+
+    EventLoop loop_;
+};
+
+TEST_F(EventLoopTest, RunsTasksFromManyThreadsOneAtATime) {
+    constexpr int THREADS = 4;
+    constexpr int PER_THREAD = 1000;
+
+    // Batches may run on different reactor threads but never overlap, so
+    // only the count of running tasks needs to be atomic
+    int ran = 0;
+    std::atomic<int> running{0};
+    std::atomic<bool> overlapped{false};
+    std::vector<std::thread> producers;
+    for (int t = 0; t < THREADS; ++t) {
+        producers.emplace_back([&]() {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                loop_.scheduleTask([&]() {
+                    if (running.fetch_add(1) != 0) {
+                        overlapped = true;
+                    }
+                    ran++;
+                    running.fetch_sub(1);
+                });
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    flush();
+    EXPECT_EQ(ran, THREADS * PER_THREAD);
+    EXPECT_FALSE(overlapped.load());
+}
+
+TEST_F(EventLoopTest, StopFromATaskDoesNotJoinItsOwnThread) {
+    std::promise<void> stopped;
+    loop_.scheduleTask([this, &stopped]() {
+        loop_.stop();
+        stopped.set_value();
+    });
+    ASSERT_EQ(stopped.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_FALSE(loop_.isRunning());
+}
+
+TEST_F(EventLoopTest, CoalescesWakeupsForABurst) {
+    flush();
+    uint64_t wakeups_before = loop_.getWakeups();
+
+    // Hold the loop busy while a burst is posted
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> blocked;
+    loop_.scheduleTask([&blocked, released]() {
+        blocked.set_value();
+        released.wait();
+    });
+    blocked.get_future().wait();
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 1000; ++i) {
+        loop_.scheduleTask([&ran]() { ran++; });
+    }
+    release.set_value();
+    flush();
+
+    EXPECT_EQ(ran.load(), 1000);
+    EXPECT_LE(loop_.getWakeups() - wakeups_before, 2u);
+}
+
+TEST_F(EventLoopTest, RunsDelayedAndPeriodicTasksInDeadlineOrder) {
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic<int> ticks{0};
+    std::promise<void> done;
+
+    loop_.scheduleDelayedTask([&]() { std::lock_guard<std::mutex> lock(mutex); order.push_back(2); },
+                              std::chrono::milliseconds(40));
+    loop_.scheduleDelayedTask([&]() { std::lock_guard<std::mutex> lock(mutex); order.push_back(1); },
+                              std::chrono::milliseconds(10));
+    loop_.schedulePeriodicTask([&]() { ticks++; }, std::chrono::milliseconds(5));
+    loop_.scheduleDelayedTask([&]() { done.set_value(); }, std::chrono::milliseconds(60));
+
+    ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(order, (std::vector<int>{1, 2}));
+    EXPECT_GE(ticks.load(), 3);
+}
+
+class ConnectionTableTest : public ::testing::Test {
+protected:
+    std::shared_ptr<ClientConnection> connect(uint64_t id) {
+        peers_.push_back(network_.connect());
+        return std::make_shared<ClientConnection>(network_.accept(), id);
+    }
+
+    securechat::network::MemoryNetwork network_;
+    std::vector<std::unique_ptr<securechat::network::MemoryTransport>> peers_;
+    ConnectionTable table_{4};
+    ConnectionTable::TimePoint start_{std::chrono::seconds(100)};
+};
+
+TEST_F(ConnectionTableTest, InsertsFindsAndRejectsWhenFull) {
+    for (uint64_t id = 1; id <= 4; ++id) {
+        EXPECT_EQ(table_.insert(id, connect(id), ClientState::CONNECTING, start_), id - 1);
+    }
+    EXPECT_EQ(table_.insert(5, connect(5), ClientState::CONNECTING, start_), ConnectionTable::INVALID_SLOT);
+    EXPECT_EQ(table_.size(), 4u);
+
+    auto slot = table_.find(3);
+    ASSERT_NE(slot, ConnectionTable::INVALID_SLOT);
+    EXPECT_EQ(table_.get(slot)->getId(), 3u);
+    EXPECT_EQ(table_.getClientId(slot), 3u);
+    EXPECT_EQ(table_.find(5), ConnectionTable::INVALID_SLOT);
+
+    ASSERT_NE(table_.remove(table_.find(1)), nullptr);
+    EXPECT_EQ(table_.insert(2, connect(2), ClientState::CONNECTING, start_), ConnectionTable::INVALID_SLOT);
+}
+
+TEST_F(ConnectionTableTest, ReusesRemovedSlotsOnlyAfterReclaim) {
+    for (uint64_t id = 1; id <= 4; ++id) {
+        table_.insert(id, connect(id), ClientState::AUTHENTICATED, start_);
+    }
+    auto slot = table_.find(2);
+    table_.row(slot).addBytesIn(100);
+    auto removed = table_.remove(slot);
+    ASSERT_NE(removed, nullptr);
+    EXPECT_EQ(removed->getId(), 2u);
+    EXPECT_EQ(table_.remove(slot), nullptr);
+    EXPECT_EQ(table_.insert(5, connect(5), ClientState::CONNECTING, start_), ConnectionTable::INVALID_SLOT);
+
+    // Kept for as long as anyone else still holds the connection
+    table_.reclaim();
+    table_.reclaim();
+    EXPECT_EQ(removed.use_count(), 2);
+    EXPECT_EQ(table_.insert(5, connect(5), ClientState::CONNECTING, start_), ConnectionTable::INVALID_SLOT);
+
+    std::weak_ptr<ClientConnection> released = removed;
+    removed.reset();
+    table_.reclaim();
+    EXPECT_TRUE(released.expired());
+    EXPECT_EQ(table_.insert(5, connect(5), ClientState::CONNECTING, start_), slot);
+    EXPECT_EQ(table_.getBytesIn(slot), 0u);
+    EXPECT_EQ(table_.getState(slot), ClientState::CONNECTING);
+    EXPECT_EQ(table_.find(2), ConnectionTable::INVALID_SLOT);
+}
+
+TEST_F(ConnectionTableTest, FullTableReclaimsOnInsert) {
+    for (uint64_t id = 1; id <= 4; ++id) {
+        table_.insert(id, connect(id), ClientState::AUTHENTICATED, start_);
+    }
+    auto slot = table_.find(3);
+    ASSERT_NE(table_.remove(slot), nullptr);
+
+    // No sweep has run; the slot is freed by the insert that needs it
+    EXPECT_EQ(table_.insert(5, connect(5), ClientState::CONNECTING, start_), slot);
+    EXPECT_EQ(table_.size(), 4u);
+    EXPECT_EQ(table_.insert(6, connect(6), ClientState::CONNECTING, start_), ConnectionTable::INVALID_SLOT);
+}
+
+TEST_F(ConnectionTableTest, ReadGuardsPinConnectionsRemovedWhileOpen) {
+    auto slot = table_.insert(1, connect(1), ClientState::AUTHENTICATED, start_);
+    ConnectionHandle handle = table_.handle(slot);
+    std::weak_ptr<ClientConnection> connection = table_.get(slot);
+
+    auto guard = std::make_unique<ConnectionTable::ReadGuard>(table_);
+    ClientConnection* client = table_.resolve(handle, *guard);
+    ASSERT_NE(client, nullptr);
+    table_.remove(slot);
+
+    // However many sweeps run, a guard open at removal keeps the connection
+    for (int i = 0; i < 5; ++i) {
+        table_.reclaim();
+    }
+    EXPECT_FALSE(connection.expired());
+    EXPECT_EQ(client->getId(), 1u);
+
+    // A guard opened after removal does not hold it back
+    {
+        ConnectionTable::ReadGuard later(table_);
+        EXPECT_EQ(table_.resolve(handle, later), nullptr);
+        guard.reset();
+        table_.reclaim();
+        EXPECT_TRUE(connection.expired());
+    }
+    EXPECT_EQ(table_.insert(2, connect(2), ClientState::AUTHENTICATED, start_), slot);
+}
+
+TEST_F(ConnectionTableTest, RowsOfRemovedConnectionsDropWrites) {
+    auto slot = table_.insert(1, connect(1), ClientState::AUTHENTICATED, start_);
+    auto old_row = table_.row(slot);
+    ASSERT_TRUE(old_row.isCurrent());
+    table_.remove(slot);
+    EXPECT_FALSE(old_row.isCurrent());
+    table_.reclaim();
+    table_.reclaim();
+
+    auto next = table_.insert(2, connect(2), ClientState::AUTHENTICATED, start_);
+    ASSERT_EQ(next, slot);
+    auto row = table_.row(next);
+    row.addBytesIn(10);
+
+    // The old row names the same slot but not the same connection
+    old_row.setState(ClientState::DISCONNECTED);
+    old_row.touch(start_ + std::chrono::seconds(60));
+    old_row.setQueueDepth(9);
+    old_row.addBytesIn(100);
+    old_row.addBytesOut(100);
+    old_row.setRetransmitWindow(9, 900);
+
+    EXPECT_EQ(table_.getState(slot), ClientState::AUTHENTICATED);
+    EXPECT_EQ(table_.getLastActivity(slot), start_);
+    EXPECT_EQ(table_.getQueueDepth(slot), 0u);
+    EXPECT_EQ(table_.getBytesIn(slot), 10u);
+    EXPECT_EQ(table_.getBytesOut(slot), 0u);
+    EXPECT_EQ(table_.getUnackedMessages(slot), 0u);
+    EXPECT_EQ(table_.getUnackedBytes(slot), 0u);
+    EXPECT_TRUE(table_.collectDisconnected().empty());
+}
+
+TEST_F(ConnectionTableTest, SweepsSelectRowsFromColumns) {
+    std::vector<std::shared_ptr<ClientConnection>> clients;
+    for (uint64_t id = 1; id <= 4; ++id) {
+        clients.push_back(connect(id));
+        auto slot = table_.insert(id, clients.back(), ClientState::AUTHENTICATED, start_);
+        clients.back()->attachToTable(table_, slot);
+    }
+
+    // Connections write their own rows
+    auto row = clients[0]->getTableRow();
+    ASSERT_TRUE(row);
+    row.touch(start_ + std::chrono::seconds(30));
+    row.addBytesIn(100);
+    row.addBytesOut(40);
+    row.setQueueDepth(3);
+    clients[1]->getTableRow().setState(ClientState::DISCONNECTING);
+    clients[2]->getTableRow().setQueueDepth(5);
+    clients[3]->getTableRow().touch(start_ + std::chrono::seconds(20));
+
+    EXPECT_EQ(table_.collectDisconnected(), (std::vector<ConnectionTable::Slot>{1}));
+    EXPECT_EQ(table_.collectIdleSince(start_ + std::chrono::seconds(20)),
+              (std::vector<ConnectionTable::Slot>{1, 2, 3}));
+
+    auto totals = table_.sumColumns();
+    EXPECT_EQ(totals.connections, 4u);
+    EXPECT_EQ(totals.authenticated, 3u);
+    EXPECT_EQ(totals.queue_depth, 8u);
+    EXPECT_EQ(totals.max_queue_depth, 5u);
+    EXPECT_EQ(totals.bytes_in, 100u);
+    EXPECT_EQ(totals.bytes_out, 40u);
+
+    // Removed rows drop out of every sweep
+    table_.remove(1);
+    EXPECT_TRUE(table_.collectDisconnected().empty());
+    EXPECT_EQ(table_.sumColumns().connections, 3u);
+}
+
+TEST_F(ConnectionTableTest, HandlesGoStaleWhenTheirConnectionIsRemoved) {
+    auto slot = table_.insert(1, connect(1), ClientState::AUTHENTICATED, start_);
+    ConnectionHandle handle = table_.handle(slot);
+    ASSERT_TRUE(handle);
+    {
+        ConnectionTable::ReadGuard guard(table_);
+        ClientConnection* client = table_.resolve(handle, guard);
+        ASSERT_NE(client, nullptr);
+        EXPECT_EQ(client->getId(), 1u);
+        EXPECT_EQ(table_.resolve(ConnectionHandle{}, guard), nullptr);
+
+        table_.remove(slot);
+        EXPECT_EQ(table_.resolve(handle, guard), nullptr);
+    }
+
+    // The slot's next occupant gets a new generation; the old handle stays stale
+    table_.reclaim();
+    ASSERT_EQ(table_.insert(2, connect(2), ClientState::AUTHENTICATED, start_), slot);
+    ConnectionTable::ReadGuard guard(table_);
+    EXPECT_EQ(table_.resolve(handle, guard), nullptr);
+    ConnectionHandle current = table_.handle(slot);
+    EXPECT_NE(current, handle);
+    ASSERT_NE(table_.resolve(current, guard), nullptr);
+    EXPECT_EQ(table_.resolve(current, guard)->getId(), 2u);
+}
+
+TEST_F(ConnectionTableTest, ResolvesConcurrentlyWithChurn) {
+    // The id each generation of each slot is given, published before insert
+    const size_t generations = 256;
+    std::vector<std::atomic<uint64_t>> expected(table_.capacity() * generations);
+    auto occupy = [&](uint64_t id) {
+        ConnectionTable::Slot slot;
+        do {
+            table_.reclaim();
+            slot = static_cast<ConnectionTable::Slot>(id % table_.capacity());
+            expected[slot * generations + table_.handle(slot).generation] = id;
+        } while (table_.insert(id, connect(id), ClientState::AUTHENTICATED, start_) == ConnectionTable::INVALID_SLOT &&
+                 (std::this_thread::yield(), true));
+    };
+    for (uint64_t id = 4; id < 8; ++id) {
+        occupy(id);
+    }
+
+    // Readers resolve without the owner's lock while slots are removed,
+    // reclaimed and refilled, and dereference what they get. Removed
+    // connections are held by nothing but the table, so freeing one a
+    // reader still uses would be a use after free.
+    std::atomic<bool> done{false};
+    std::atomic<bool> mismatch{false};
+    std::atomic<uint64_t> resolved{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&]() {
+            while (!done.load()) {
+                ConnectionTable::ReadGuard guard(table_);
+                for (ConnectionTable::Slot slot = 0; slot < table_.capacity(); ++slot) {
+                    ConnectionHandle handle = table_.handle(slot);
+                    if (ClientConnection* client = table_.resolve(handle, guard)) {
+                        if (client->getId() != expected[slot * generations + handle.generation].load()) {
+                            mismatch = true;
+                        }
+                        resolved++;
+                    }
+                }
+            }
+        });
+    }
+    while (resolved.load() == 0) {
+        std::this_thread::yield();
+    }
+    for (uint64_t id = 8; id < 200; ++id) {
+        table_.remove(static_cast<ConnectionTable::Slot>(id % table_.capacity()));
+        occupy(id);
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_FALSE(mismatch.load());
+}
+
+class MessageDeduplicatorTest : public ::testing::Test {
+protected:
+    static DeduplicationConfig makeConfig(size_t capacity) {
+        DeduplicationConfig config;
+        config.window = std::chrono::seconds(10);
+        config.capacity = capacity;
+        return config;
+    }
+
+    MessageDeduplicator::TimePoint start_{std::chrono::seconds(100)};
+};
+
+TEST_F(MessageDeduplicatorTest, DropsRepeatsFromTheSameSenderOnly) {
+    MessageDeduplicator deduplicator(makeConfig(1024));
+
+    EXPECT_FALSE(deduplicator.checkAndRecord(1, "a1b2", start_));
+    EXPECT_TRUE(deduplicator.checkAndRecord(1, "a1b2", start_ + std::chrono::seconds(1)));
+    // Ids are only unique per sender
+    EXPECT_FALSE(deduplicator.checkAndRecord(2, "a1b2", start_));
+    EXPECT_FALSE(deduplicator.checkAndRecord(1, "c3d4", start_));
+    EXPECT_EQ(deduplicator.getDuplicates(), 1u);
+}
+
+TEST_F(MessageDeduplicatorTest, RemembersIdsForOneToTwoWindows) {
+    MessageDeduplicator deduplicator(makeConfig(1024));
+
+    EXPECT_FALSE(deduplicator.checkAndRecord(1, "early", start_));
+    // Rotating moves "early" to the previous generation, where it still counts
+    EXPECT_FALSE(deduplicator.checkAndRecord(1, "late", start_ + std::chrono::seconds(12)));
+    EXPECT_TRUE(deduplicator.checkAndRecord(1, "early", start_ + std::chrono::seconds(13)));
+    EXPECT_TRUE(deduplicator.checkAndRecord(1, "late", start_ + std::chrono::seconds(13)));
+
+    // Two quiet windows later nothing is remembered
+    EXPECT_FALSE(deduplicator.checkAndRecord(1, "early", start_ + std::chrono::seconds(40)));
+    EXPECT_FALSE(deduplicator.checkAndRecord(1, "late", start_ + std::chrono::seconds(40)));
+}
+
+TEST_F(MessageDeduplicatorTest, RotatesEarlyInsteadOfGrowing) {
+    MessageDeduplicator deduplicator(makeConfig(MessageDeduplicator::STRIPES * 4));
+    const size_t memory = deduplicator.getMemoryUsage();
+
+    // Far more ids than capacity within one window
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_FALSE(deduplicator.checkAndRecord(7, "id-" + std::to_string(i), start_));
+    }
+    EXPECT_GT(deduplicator.getEarlyRotations(), 0u);
+    EXPECT_EQ(deduplicator.getMemoryUsage(), memory);
+    // The most recent ids survive the rotations
+    EXPECT_TRUE(deduplicator.checkAndRecord(7, "id-9999", start_));
+}
+
+TEST_F(MessageDeduplicatorTest, ExtractsTheMessageIdField) {
+    EXPECT_EQ(MessageDeduplicator::extractMessageId(
+                  R"({"type":"text","messageId":"5f0c-11ee","content":"hi"})"),
+              "5f0c-11ee");
+    EXPECT_EQ(MessageDeduplicator::extractMessageId(R"({"messageId" : "abc", "x": 1})"), "abc");
+    // The key must be a whole quoted member name
+    EXPECT_EQ(MessageDeduplicator::extractMessageId(R"({"content":"messageId","messageId":"real"})"), "real");
+    EXPECT_EQ(MessageDeduplicator::extractMessageId(R"({"xmessageId":"no"})"), "");
+    EXPECT_EQ(MessageDeduplicator::extractMessageId(R"({"messageId":42})"), "");
+    EXPECT_EQ(MessageDeduplicator::extractMessageId(R"({"messageId":"a\"b"})"), "");
+    EXPECT_EQ(MessageDeduplicator::extractMessageId(R"({"messageId":"unterminated)"), "");
+    EXPECT_EQ(MessageDeduplicator::extractMessageId("plain text"), "");
+    EXPECT_EQ(MessageDeduplicator::extractMessageId(
+                  "{\"messageId\":\"" + std::string(MessageDeduplicator::MAX_MESSAGE_ID_LENGTH + 1, 'x') + "\"}"),
+              "");
+}
+
+TEST(RetransmitWindowTest, TrimsOnCumulativeAcksAndDropsTheOldestWhenFull) {
+    RetransmitWindow window(3);
+    MessageBuffer message("shared by every recipient of a broadcast, not copied per window");
+    const uint32_t references = message.useCount();
+
+    // The ring is only allocated while something is in flight
+    const size_t empty_bytes = window.getResidentBytes();
+    EXPECT_FALSE(window.releaseIfEmpty());
+
+    EXPECT_TRUE(window.push(1, message));
+    EXPECT_TRUE(window.push(2, message));
+    EXPECT_TRUE(window.push(3, message));
+    EXPECT_EQ(message.useCount(), references + 3);
+    EXPECT_FALSE(window.releaseIfEmpty());
+    EXPECT_EQ(window.getBytes(), 3 * message.size());
+    // Full: the oldest entry makes room
+    EXPECT_FALSE(window.push(4, message));
+    EXPECT_EQ(window.getOverflows(), 1u);
+    EXPECT_EQ(window.size(), 3u);
+    EXPECT_EQ(message.useCount(), references + 3);
+
+    EXPECT_EQ(window.acknowledge(2), 1u);
+    EXPECT_EQ(window.size(), 2u);
+    EXPECT_EQ(message.useCount(), references + 2);
+    // Stale acks change nothing
+    EXPECT_EQ(window.acknowledge(1), 0u);
+    EXPECT_EQ(window.acknowledge(4), 2u);
+    EXPECT_EQ(window.size(), 0u);
+    EXPECT_EQ(window.getBytes(), 0u);
+    EXPECT_EQ(message.useCount(), references);
+    EXPECT_TRUE(window.releaseIfEmpty());
+    EXPECT_EQ(window.getResidentBytes(), empty_bytes);
+    EXPECT_TRUE(window.push(5, message));
+}
+
+TEST(RetransmitWindowTest, DrainsWhatThePeerNeverSawInOrder) {
+    RetransmitWindow window(8);
+    for (uint64_t sequence = 1; sequence <= 5; ++sequence) {
+        window.push(sequence, MessageBuffer("message " + std::to_string(sequence)));
+    }
+    window.acknowledge(1);
+
+    // The peer saw up to 3 before the connection dropped, but its ack was lost
+    auto replay = window.drainAfter(3);
+    ASSERT_EQ(replay.size(), 2u);
+    EXPECT_EQ(replay[0].view(), "message 4");
+    EXPECT_EQ(replay[1].view(), "message 5");
+    EXPECT_EQ(window.size(), 0u);
+    EXPECT_EQ(window.getAcknowledged(), 3u);
+}
+
+TEST(ResumableWindowsTest, ClaimsOnceBeforeTheTimeout) {
+    ResumableWindows windows(std::chrono::seconds(30));
+    ResumableWindows::TimePoint start{std::chrono::seconds(100)};
+    auto window = std::make_shared<RetransmitWindow>(4);
+    window->push(1, MessageBuffer("unacknowledged"));
+
+    windows.park("token-a", "alice", window, start);
+    windows.park("token-b", "bob", std::make_shared<RetransmitWindow>(4), start);
+    windows.park("token-c", "", std::make_shared<RetransmitWindow>(4), start);
+    EXPECT_EQ(windows.size(), 2u);
+    EXPECT_EQ(windows.getBytes(), window->getBytes());
+
+    EXPECT_EQ(windows.claim("token-a", "alice", start + std::chrono::seconds(10)), window);
+    EXPECT_EQ(windows.claim("token-a", "alice", start + std::chrono::seconds(10)), nullptr);
+    EXPECT_EQ(windows.claim("unknown", "alice", start), nullptr);
+
+    EXPECT_EQ(windows.expire(start + std::chrono::seconds(30)), 1u);
+    EXPECT_EQ(windows.size(), 0u);
+}
+
+TEST(ResumableWindowsTest, OnlyTheSessionsUserCanClaim) {
+    ResumableWindows windows(std::chrono::seconds(30));
+    ResumableWindows::TimePoint start{std::chrono::seconds(100)};
+    auto window = std::make_shared<RetransmitWindow>(4);
+    window->push(1, MessageBuffer("for alice only"));
+    windows.park("token-a", "alice", window, start);
+
+    // A stolen or guessed token gets nothing and leaves the window parked
+    EXPECT_EQ(windows.claim("token-a", "mallory", start), nullptr);
+    EXPECT_EQ(windows.claim("token-a", "", start), nullptr);
+    EXPECT_EQ(windows.size(), 1u);
+    EXPECT_EQ(windows.claim("token-a", "alice", start), window);
+}
+
+// The shard runtime's part of a chat message: a frame is decoded, wrapped
+// once, published to the room's members and queued on each recipient's send
+// queue, which is then drained. Once pools and buffers are warm none of
+// this may touch the heap. Connections, checks and encryption are not
+// involved; MemoryNetworkTest.ServerRelaysMessagesWithoutAllocating covers
+// the server's whole path.
+TEST(SteadyStateAllocationTest, ShardRoutingAndFanOutDoNotAllocate) {
+    if (!AllocationCounter::isEnabled()) {
+        GTEST_SKIP() << "build with -DENABLE_ALLOCATION_COUNTING=ON";
+    }
+    constexpr uint64_t ROOM = 7;
+    constexpr uint64_t SENDER = 0;
+    constexpr size_t RECIPIENTS = 256;
+
+    std::vector<std::unique_ptr<securechat::utils::SpscQueue<MessageBuffer>>> send_queues;
+    for (size_t i = 0; i <= RECIPIENTS; ++i) {
+        send_queues.push_back(std::make_unique<securechat::utils::SpscQueue<MessageBuffer>>(8));
+    }
+    ShardedRuntime runtime(1, [&send_queues](Shard&, uint64_t client_id, uint64_t, const MessageBuffer& message) {
+        MessageBuffer queued(message);
+        send_queues[client_id]->tryPush(std::move(queued));
+    });
+    runtime.start();
+
+    std::string wire;
+    securechat::network::ProtocolHandler::appendFrame(wire, securechat::network::FrameType::DATA,
+                                                      std::string(512, 'm'));
+    securechat::network::ProtocolHandler decoder;
+    size_t sent = 0;
+    auto handleMessage = [&](Shard& shard) {
+        decoder.append(wire.data(), wire.size());
+        securechat::network::Frame frame;
+        while (decoder.nextFrame(frame)) {
+            MessageBuffer payload(frame.payload);
+            shard.publish(ROOM, SENDER, payload);
+        }
+        for (auto& queue : send_queues) {
+            sent += queue->drain([](MessageBuffer&&) {}, 8);
+        }
+    };
+
+    std::promise<uint64_t> allocations;
+    runtime.post(0, [&](Shard& shard) {
+        for (uint64_t client = 0; client <= RECIPIENTS; ++client) {
+            shard.join(client, ROOM);
+        }
+        for (int i = 0; i < 3; ++i) {
+            handleMessage(shard);
+        }
+
+        NoAllocationScope steady_state("receive, route and fan out");
+        for (int i = 0; i < 100; ++i) {
+            handleMessage(shard);
+        }
+        allocations.set_value(steady_state.finish());
+    });
+    auto result = allocations.get_future();
+    ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(result.get(), 0u);
+    runtime.stop();
+    EXPECT_EQ(sent, 103 * RECIPIENTS);
+}
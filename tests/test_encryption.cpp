@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <thread>
+#include <vector>
 #include "crypto/encryption_manager.hpp"
+#include "network/protocol_handler.hpp"
 
 using namespace securechat::crypto;
 
@@ -27,7 +30,7 @@ TEST_F(EncryptionManagerTest, KeyGeneration) {
     
     std::string public_key = encryption_manager_->getPublicKey();
     EXPECT_FALSE(public_key.empty());
-    EXPECT_GT(public_key.length(), 100); // RSA-2048 public key should be substantial
+    EXPECT_GT(public_key.length(), 100); // PEM-wrapped X25519 public key
 }
 
 TEST_F(EncryptionManagerTest, EncryptDecryptRoundTrip) {
@@ -208,4 +211,111 @@ TEST_F(EncryptionManagerTest, ThreadSafety) {
     }
     
     EXPECT_EQ(successful_operations.load(), num_threads * operations_per_thread);
-}
\ No newline at end of file
+}
+class EncryptedRecordTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        key_.fill(0x11);
+        hmac_key_.fill(0x22);
+    }
+
+    AESKey key_;
+    HMACKey hmac_key_;
+};
+
+TEST_F(EncryptedRecordTest, SealOpenRoundTrip) {
+    for (size_t size : {size_t{0}, size_t{15}, size_t{16}, size_t{1000}, size_t{70000}}) {
+        std::string plaintext(size, 'p');
+        auto record = EncryptedRecord::seal(key_, hmac_key_, 7, 1234, plaintext);
+        ASSERT_FALSE(record.empty());
+        EXPECT_EQ(record.size(), EncryptedRecord::CIPHERTEXT_OFFSET + EncryptedRecord::ciphertextSize(size));
+        EXPECT_EQ(record.getSequence(), 7u);
+        EXPECT_EQ(record.getTimestamp(), 1234u);
+
+        std::string payload(record.data() + EncryptedRecord::FRAME_HEADER_SIZE,
+                            record.size() - EncryptedRecord::FRAME_HEADER_SIZE);
+        std::string opened;
+        ASSERT_TRUE(EncryptedRecord::open(key_, hmac_key_, payload, opened));
+        EXPECT_EQ(opened, plaintext);
+    }
+}
+
+TEST_F(EncryptedRecordTest, RejectsTamperingAndWrongKeys) {
+    auto record = EncryptedRecord::seal(key_, hmac_key_, 1, 2, "attack at dawn");
+    ASSERT_FALSE(record.empty());
+    std::string payload(record.data() + EncryptedRecord::FRAME_HEADER_SIZE,
+                        record.size() - EncryptedRecord::FRAME_HEADER_SIZE);
+    std::string opened;
+
+    // Sequence, iv, tag and ciphertext are all covered
+    for (size_t offset : {size_t{0}, size_t{20}, size_t{40}, payload.size() - 1}) {
+        std::string tampered = payload;
+        tampered[offset] ^= 0x01;
+        EXPECT_FALSE(EncryptedRecord::open(key_, hmac_key_, tampered, opened)) << offset;
+    }
+
+    HMACKey other = hmac_key_;
+    other[0] ^= 0x01;
+    EXPECT_FALSE(EncryptedRecord::open(key_, other, payload, opened));
+    EXPECT_FALSE(EncryptedRecord::open(key_, hmac_key_, payload.substr(0, 40), opened));
+}
+
+TEST_F(EncryptedRecordTest, MatchesProtocolHandlerWireFormat) {
+    auto record = EncryptedRecord::seal(key_, hmac_key_, 42, 99, "hello over the wire");
+    ASSERT_FALSE(record.empty());
+
+    securechat::network::ProtocolHandler decoder;
+    decoder.append(record.data(), record.size());
+    securechat::network::Frame frame;
+    ASSERT_TRUE(decoder.nextFrame(frame));
+    EXPECT_EQ(frame.type, securechat::network::FrameType::DATA);
+
+    EncryptedMessage parsed;
+    ASSERT_TRUE(securechat::network::ProtocolHandler::parseEncrypted(frame.payload, parsed));
+    EXPECT_EQ(parsed.sequence_number, 42u);
+    EXPECT_EQ(parsed.timestamp, 99u);
+    EXPECT_EQ(std::string_view(reinterpret_cast<const char*>(parsed.iv.data()), parsed.iv.size()), record.iv());
+    EXPECT_EQ(std::string(parsed.hmac.begin(), parsed.hmac.end()), record.tag());
+    EXPECT_EQ(std::string(parsed.ciphertext.begin(), parsed.ciphertext.end()), record.ciphertext());
+
+    // Re-serializing the parsed message reproduces the record byte for byte
+    std::string reencoded;
+    securechat::network::ProtocolHandler::appendEncrypted(reencoded, parsed);
+    EXPECT_EQ(reencoded, std::string(record.data(), record.size()));
+}
+
+// A cipher keeps its MAC and AES contexts between records; every record must
+// still carry the tag a fresh HMAC computes and open with another cipher
+TEST_F(EncryptedRecordTest, RecordCipherReusesContextsAcrossRecords) {
+    RecordCipher sealer;
+    RecordCipher opener;
+    sealer.setKeys(key_, hmac_key_);
+    opener.setKeys(key_, hmac_key_);
+
+    for (uint64_t sequence = 1; sequence <= 8; ++sequence) {
+        std::string plaintext(static_cast<size_t>(sequence * 7), static_cast<char>('a' + sequence));
+        auto record = sealer.seal(sequence, sequence * 10, plaintext);
+        ASSERT_FALSE(record.empty());
+
+        std::string authenticated(record.data() + EncryptedRecord::SEQUENCE_OFFSET,
+                                  EncryptedRecord::TAG_LENGTH_OFFSET - EncryptedRecord::SEQUENCE_OFFSET);
+        authenticated.append(record.ciphertext());
+        unsigned char digest[HMAC_DIGEST_SIZE];
+        unsigned int digest_length = 0;
+        HMAC(EVP_sha256(), hmac_key_.data(), static_cast<int>(hmac_key_.size()),
+             reinterpret_cast<const unsigned char*>(authenticated.data()), authenticated.size(), digest,
+             &digest_length);
+        EXPECT_EQ(record.tag(), std::string_view(reinterpret_cast<const char*>(digest), digest_length));
+
+        std::string opened;
+        ASSERT_TRUE(opener.open(std::string_view(record.data() + EncryptedRecord::FRAME_HEADER_SIZE,
+                                                 record.size() - EncryptedRecord::FRAME_HEADER_SIZE),
+                                opened));
+        EXPECT_EQ(opened, plaintext);
+        if (sequence == 4) {
+            EXPECT_GT(sealer.getContextBytes(), 0u);
+            EXPECT_TRUE(sealer.releaseContexts());
+            EXPECT_EQ(sealer.getContextBytes(), 0u);
+        }
+    }
+}
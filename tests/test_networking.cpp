@@ -1,6 +1,970 @@
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+#include <sys/socket.h>
+#include <openssl/hmac.h>
+#include "core/server.hpp"
+#include "core/task.hpp"
+#include "crypto/encryption_manager.hpp"
+#include "network/async_io.hpp"
+#include "network/busy_poll.hpp"
+#include "network/fair_share.hpp"
+#include "network/memory_transport.hpp"
+#include "network/protocol_handler.hpp"
+#include "utils/allocation_counter.hpp"
+#include "utils/clock.hpp"
+#include "utils/config_manager.hpp"
+#include "utils/logger.hpp"
+
+using namespace securechat::network;
+using securechat::crypto::EncryptedMessage;
+using securechat::crypto::HMAC_DIGEST_SIZE;
+using securechat::utils::SimulatedClock;
 
 // Placeholder networking tests
 TEST(NetworkingTest, BasicTest) {
     EXPECT_TRUE(true);
-}
\ No newline at end of file
+}
+
+class ProtocolHandlerTest : public ::testing::Test {
+protected:
+    ProtocolHandler handler_{1024};
+};
+
+TEST_F(ProtocolHandlerTest, DecodesFramesSplitAcrossReads) {
+    std::string wire;
+    ProtocolHandler::appendFrame(wire, FrameType::KEY_EXCHANGE, "public-key");
+    ProtocolHandler::appendAuth(wire, "alice", "secret");
+
+    // Feed one byte at a time to exercise partial headers and payloads
+    std::vector<std::pair<FrameType, std::string>> frames;
+    Frame frame;
+    for (char byte : wire) {
+        handler_.append(&byte, 1);
+        while (handler_.nextFrame(frame)) {
+            frames.emplace_back(frame.type, std::string(frame.payload));
+        }
+    }
+
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].first, FrameType::KEY_EXCHANGE);
+    EXPECT_EQ(frames[0].second, "public-key");
+    EXPECT_EQ(frames[1].first, FrameType::AUTH);
+
+    std::string_view username;
+    std::string_view secret;
+    ASSERT_TRUE(ProtocolHandler::parseAuth(frames[1].second, username, secret));
+    EXPECT_EQ(username, "alice");
+    EXPECT_EQ(secret, "secret");
+    EXPECT_EQ(handler_.getBufferedBytes(), 0u);
+}
+
+TEST_F(ProtocolHandlerTest, RejectsOversizedFrames) {
+    std::string wire;
+    ProtocolHandler::appendFrame(wire, FrameType::DATA, std::string(2048, 'x'));
+    handler_.append(wire.data(), wire.size());
+
+    Frame frame;
+    EXPECT_FALSE(handler_.nextFrame(frame));
+    EXPECT_TRUE(handler_.hasError());
+}
+
+TEST_F(ProtocolHandlerTest, ControlFramesRoundTrip) {
+    std::string wire;
+    ProtocolHandler::appendAuthResult(wire, AuthStatus::RATE_LIMITED, "slow down");
+    ProtocolHandler::appendJoinRoom(wire, 0x0102030405060708ULL);
+    handler_.append(wire.data(), wire.size());
+
+    Frame frame;
+    ASSERT_TRUE(handler_.nextFrame(frame));
+    AuthStatus status;
+    std::string_view detail;
+    ASSERT_TRUE(ProtocolHandler::parseAuthResult(frame.payload, status, detail));
+    EXPECT_EQ(status, AuthStatus::RATE_LIMITED);
+    EXPECT_EQ(detail, "slow down");
+
+    ASSERT_TRUE(handler_.nextFrame(frame));
+    uint64_t room_id = 0;
+    ASSERT_TRUE(ProtocolHandler::parseJoinRoom(frame.payload, room_id));
+    EXPECT_EQ(room_id, 0x0102030405060708ULL);
+}
+
+TEST_F(ProtocolHandlerTest, DeliveryFramesRoundTrip) {
+    std::string wire;
+    ProtocolHandler::appendAck(wire, 1001);
+    ProtocolHandler::appendResume(wire, 77, "previous-session-token");
+    handler_.append(wire.data(), wire.size());
+
+    Frame frame;
+    ASSERT_TRUE(handler_.nextFrame(frame));
+    EXPECT_EQ(frame.type, FrameType::ACK);
+    uint64_t sequence = 0;
+    ASSERT_TRUE(ProtocolHandler::parseAck(frame.payload, sequence));
+    EXPECT_EQ(sequence, 1001u);
+
+    ASSERT_TRUE(handler_.nextFrame(frame));
+    EXPECT_EQ(frame.type, FrameType::RESUME);
+    std::string_view token;
+    ASSERT_TRUE(ProtocolHandler::parseResume(frame.payload, sequence, token));
+    EXPECT_EQ(sequence, 77u);
+    EXPECT_EQ(token, "previous-session-token");
+
+    // A resume without a token cannot name a session
+    EXPECT_FALSE(ProtocolHandler::parseResume(std::string_view("\0\0\0\0\0\0\0\1", 8), sequence, token));
+    EXPECT_FALSE(ProtocolHandler::parseAck("short", sequence));
+}
+
+TEST_F(ProtocolHandlerTest, EncryptedMessageRoundTrip) {
+    EncryptedMessage original;
+    original.ciphertext = {1, 2, 3, 4, 5};
+    original.iv.fill(7);
+    original.hmac.assign(HMAC_DIGEST_SIZE, 9);
+    original.timestamp = 1234567890123ULL;
+    original.sequence_number = 42;
+
+    std::string wire;
+    ProtocolHandler::appendEncrypted(wire, original);
+    handler_.append(wire.data(), wire.size());
+
+    Frame frame;
+    ASSERT_TRUE(handler_.nextFrame(frame));
+    EXPECT_EQ(frame.type, FrameType::DATA);
+
+    EncryptedMessage decoded;
+    ASSERT_TRUE(ProtocolHandler::parseEncrypted(frame.payload, decoded));
+    EXPECT_EQ(decoded.ciphertext, original.ciphertext);
+    EXPECT_EQ(decoded.iv, original.iv);
+    EXPECT_EQ(decoded.hmac, original.hmac);
+    EXPECT_EQ(decoded.timestamp, original.timestamp);
+    EXPECT_EQ(decoded.sequence_number, original.sequence_number);
+
+    EXPECT_FALSE(ProtocolHandler::parseEncrypted(frame.payload.substr(0, 20), decoded));
+}
+
+// Performance test
+TEST_F(ProtocolHandlerTest, DecodeThroughput) {
+    std::string wire;
+    const int frames = 100000;
+    for (int i = 0; i < frames; ++i) {
+        ProtocolHandler::appendFrame(wire, FrameType::DATA, std::string(200, 'm'));
+    }
+
+    ProtocolHandler handler(ProtocolHandler::DEFAULT_MAX_FRAME_SIZE);
+    auto start = std::chrono::high_resolution_clock::now();
+    int decoded = 0;
+    Frame frame;
+    for (size_t offset = 0; offset < wire.size(); offset += 4096) {
+        handler.append(wire.data() + offset, std::min<size_t>(4096, wire.size() - offset));
+        while (handler.nextFrame(frame)) {
+            decoded++;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    double frames_per_second = (decoded * 1000000.0) / std::max<int64_t>(duration.count(), 1);
+
+    std::cout << "Frame decode throughput: " << frames_per_second << " frames/second" << std::endl;
+    EXPECT_EQ(decoded, frames);
+    EXPECT_GT(frames_per_second, 1000000);
+}
+
+class MemoryNetworkTest : public ::testing::Test {
+protected:
+    static std::string drain(Transport& transport) {
+        std::string received;
+        char buffer[4096];
+        int64_t n;
+        while ((n = transport.read(buffer, sizeof(buffer))) > 0) {
+            received.append(buffer, static_cast<size_t>(n));
+        }
+        return received;
+    }
+
+    MemoryNetwork network_{1024};
+};
+
+TEST_F(MemoryNetworkTest, ConnectsAndDeliversEndOfStream) {
+    auto client = network_.connect();
+    EXPECT_EQ(network_.getPendingAccepts(), 1u);
+    auto server = network_.accept();
+    ASSERT_NE(server, nullptr);
+    EXPECT_EQ(network_.accept(), nullptr);
+
+    int wakeups = 0;
+    std::string received;
+    server->setReadHandler([&]() {
+        wakeups++;
+        received += drain(*server);
+    });
+
+    client->write("hello ", 6);
+    client->write("world", 5);
+    EXPECT_EQ(network_.runReady(), 1u);
+    EXPECT_EQ(received, "hello world");
+    EXPECT_EQ(network_.runReady(), 0u);
+
+    // Closing delivers end-of-stream after any buffered bytes
+    client->write("!", 1);
+    client->close();
+    EXPECT_EQ(network_.runReady(), 1u);
+    EXPECT_EQ(received, "hello world!");
+    char byte;
+    EXPECT_EQ(server->read(&byte, 1), -1);
+    EXPECT_EQ(server->write("x", 1), -1);
+    EXPECT_EQ(wakeups, 2);
+}
+
+TEST_F(MemoryNetworkTest, BoundedBuffersApplyBackpressure) {
+    auto client = network_.connect();
+    auto server = network_.accept();
+
+    std::string payload(1500, 'p');
+    EXPECT_EQ(client->write(payload.data(), payload.size()), 1024);
+    EXPECT_EQ(client->write(payload.data(), payload.size()), 0);
+
+    char buffer[512];
+    EXPECT_EQ(server->read(buffer, sizeof(buffer)), 512);
+    EXPECT_EQ(client->write(payload.data(), payload.size()), 512);
+    EXPECT_EQ(drain(*server).size(), 1024u);
+    EXPECT_EQ(network_.getBytesTransferred(), 1536u);
+}
+
+namespace {
+
+constexpr const char* SIMULATION_JWT_SECRET = "simulation-secret";
+
+std::string base64Url(const unsigned char* data, size_t length) {
+    static const char* ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string out;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t chunk = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < length) chunk |= static_cast<uint32_t>(data[i + 1]) << 8;
+        if (i + 2 < length) chunk |= data[i + 2];
+        out += ALPHABET[(chunk >> 18) & 63];
+        out += ALPHABET[(chunk >> 12) & 63];
+        if (i + 1 < length) out += ALPHABET[(chunk >> 6) & 63];
+        if (i + 2 < length) out += ALPHABET[chunk & 63];
+    }
+    return out;
+}
+
+// HS256 token for the simulated server's secret; the expiry is fixed so every
+// run sends identical bytes
+std::string simulationToken(const std::string& subject) {
+    auto base64 = [](const std::string& text) {
+        return base64Url(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+    };
+    std::string signing_input = base64(R"({"alg":"HS256","typ":"JWT"})") + "." +
+        base64(R"({"sub":")" + subject + R"(","exp":4102444800})");
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_length = 0;
+    HMAC(EVP_sha256(), SIMULATION_JWT_SECRET, static_cast<int>(std::strlen(SIMULATION_JWT_SECRET)),
+         reinterpret_cast<const unsigned char*>(signing_input.data()), signing_input.size(),
+         digest, &digest_length);
+    return signing_input + "." + base64Url(digest, digest_length);
+}
+
+} // namespace
+
+// Runs a real Server on a simulated clock with 100k clients on memory pipes:
+// every client does the key exchange, authenticates and joins room
+// (index % rooms), then one sender per room broadcasts, staggered by a
+// millisecond, and the run is repeated to check it is reproducible. The
+// executors run inline and the server is never start()ed, so the whole run
+// happens on this thread inside runReady().
+TEST_F(MemoryNetworkTest, ServerFansOutTo100kMemoryClientsDeterministically) {
+    const size_t clients = 100000;
+    const size_t room_size = 100;
+    const size_t rooms = clients / room_size;
+
+    const std::string config_path = "simulation_server.json";
+    std::ofstream(config_path) << R"({
+  "server": {"max_connections": )" << clients << R"(},
+  "security": {"enable_tls": false},
+  "authentication": {"enable_jwt": true, "jwt_secret": ")" << SIMULATION_JWT_SECRET << R"("},
+  "rate_limiting": {"messages_per_second": 1000000, "burst_size": 1000000, "connection_rate": 1000000},
+  "performance": {"executors": {"inline": true}},
+  "monitoring": {"enable_metrics": false},
+  "logging": {"level": "warn", "enable_console": false},
+  "plugins": {"auto_load": false, "enabled_plugins": []}
+})";
+    securechat::utils::ConfigManager config;
+    ASSERT_TRUE(config.loadFromFile(config_path));
+    std::remove(config_path.c_str());
+    securechat::utils::Logger::setLogLevel(securechat::utils::LogLevel::WARN);
+
+    // Listeners share one key pair; senders need their own session keys
+    securechat::crypto::EncryptionManager listener_keys;
+    ASSERT_TRUE(listener_keys.generateEphemeralKeys());
+    const std::string listener_public_key = listener_keys.getPublicKey();
+
+    auto simulate = [&](uint64_t& digest, size_t& deliveries, size_t& connected) {
+        MemoryNetwork network;
+        SimulatedClock clock;
+        securechat::core::Server server(config, clock);
+        ASSERT_TRUE(server.initialize());
+        auto start = clock.now();
+
+        struct User {
+            std::unique_ptr<MemoryTransport> transport;
+            ProtocolHandler decoder;
+            std::unique_ptr<securechat::crypto::EncryptionManager> keys;
+        };
+        std::vector<User> users(clients);
+
+        digest = 1469598103934665603ULL;
+        deliveries = 0;
+
+        for (size_t i = 0; i < clients; ++i) {
+            User& user = users[i];
+            user.transport = network.connect();
+            server.acceptTransport(network.accept());
+
+            // User i is in room i for i < rooms: one sender per room
+            std::string hello;
+            if (i < rooms) {
+                user.keys = std::make_unique<securechat::crypto::EncryptionManager>();
+                ASSERT_TRUE(user.keys->generateEphemeralKeys());
+                ProtocolHandler::appendFrame(hello, FrameType::KEY_EXCHANGE, user.keys->getPublicKey());
+            } else {
+                ProtocolHandler::appendFrame(hello, FrameType::KEY_EXCHANGE, listener_public_key);
+            }
+            std::string username = "user" + std::to_string(i);
+            ProtocolHandler::appendAuth(hello, username, simulationToken(username));
+            ProtocolHandler::appendJoinRoom(hello, i % rooms);
+            user.transport->write(hello.data(), hello.size());
+
+            user.transport->setReadHandler([&, i]() {
+                User& self = users[i];
+                char buffer[4096];
+                int64_t n;
+                while ((n = self.transport->read(buffer, sizeof(buffer))) > 0) {
+                    self.decoder.append(buffer, static_cast<size_t>(n));
+                }
+                auto elapsed = static_cast<uint64_t>((clock.now() - start).count());
+                Frame frame;
+                while (self.decoder.nextFrame(frame)) {
+                    if (frame.type == FrameType::KEY_EXCHANGE && self.keys) {
+                        EXPECT_TRUE(self.keys->exchangeKeys(std::string(frame.payload)));
+                    } else if (frame.type == FrameType::DATA) {
+                        digest = (digest ^ (i * 1000003ULL + elapsed + frame.payload.size())) * 1099511628211ULL;
+                        deliveries++;
+                    }
+                }
+            });
+        }
+        network.runReady();
+        connected = server.getConnectedClientsCount();
+
+        for (size_t room = 0; room < rooms; ++room) {
+            clock.runAfter(std::chrono::milliseconds(room), [&, room]() {
+                auto record = users[room].keys->encrypt(
+                    securechat::utils::MessageBuffer("hello room " + std::to_string(room)));
+                ASSERT_FALSE(record.empty());
+                users[room].transport->write(record.data(), record.size());
+            });
+        }
+        while (clock.advanceToNextTimer() > 0) {
+            network.runReady();
+        }
+        network.runReady();
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t first_digest = 0;
+    size_t first_deliveries = 0;
+    size_t first_connected = 0;
+    simulate(first_digest, first_deliveries, first_connected);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin);
+
+    uint64_t second_digest = 0;
+    size_t second_deliveries = 0;
+    size_t second_connected = 0;
+    simulate(second_digest, second_deliveries, second_connected);
+
+    std::cout << "Simulated " << first_connected << " clients, " << first_deliveries
+              << " deliveries in " << elapsed.count() << " ms" << std::endl;
+    EXPECT_EQ(first_connected, clients);
+    EXPECT_EQ(first_deliveries, rooms * (room_size - 1));
+    EXPECT_EQ(first_digest, second_digest);
+    EXPECT_EQ(first_deliveries, second_deliveries);
+    EXPECT_EQ(first_connected, second_connected);
+}
+
+// The same server with one sender and 100 listeners in a room, relaying
+// encrypted messages that carry a message id. Once connections, pools and
+// buffers are warm, reading a record, decrypting it, the duplicate, text,
+// filter and spam checks, fan-out in two batches and sealing the message
+// for every listener must not touch the heap. The executors run inline, so
+// handing tasks between threads is not covered. The listeners' own reads
+// run inside the scope too, so they drain into a fixed buffer.
+TEST_F(MemoryNetworkTest, ServerRelaysMessagesWithoutAllocating) {
+    if (!securechat::utils::AllocationCounter::isEnabled()) {
+        GTEST_SKIP() << "build with -DENABLE_ALLOCATION_COUNTING=ON";
+    }
+    const size_t listeners = 100;
+    const uint64_t room = 1;
+    const size_t warmup = 20;
+    const size_t measured = 100;
+
+    const std::string config_path = "allocation_server.json";
+    std::ofstream(config_path) << R"({
+  "security": {"enable_tls": false},
+  "authentication": {"enable_jwt": true, "jwt_secret": ")" << SIMULATION_JWT_SECRET << R"("},
+  "rate_limiting": {"messages_per_second": 1000000, "burst_size": 1000000, "connection_rate": 1000000},
+  "performance": {"executors": {"inline": true}},
+  "monitoring": {"enable_metrics": false},
+  "logging": {"level": "warn", "enable_console": false},
+  "plugins": {"auto_load": false, "enabled_plugins": ["spam_detection"]}
+})";
+    securechat::utils::ConfigManager config;
+    ASSERT_TRUE(config.loadFromFile(config_path));
+    std::remove(config_path.c_str());
+    securechat::utils::Logger::setLogLevel(securechat::utils::LogLevel::WARN);
+
+    MemoryNetwork network;
+    SimulatedClock clock;
+    securechat::core::Server server(config, clock);
+    ASSERT_TRUE(server.initialize());
+
+    securechat::crypto::EncryptionManager sender_keys;
+    ASSERT_TRUE(sender_keys.generateEphemeralKeys());
+    securechat::crypto::EncryptionManager listener_keys;
+    ASSERT_TRUE(listener_keys.generateEphemeralKeys());
+
+    std::vector<std::unique_ptr<MemoryTransport>> transports;
+    size_t deliveries = 0;
+    for (size_t i = 0; i <= listeners; ++i) {
+        transports.push_back(network.connect());
+        server.acceptTransport(network.accept());
+
+        std::string hello;
+        ProtocolHandler::appendFrame(hello, FrameType::KEY_EXCHANGE,
+                                     i == 0 ? sender_keys.getPublicKey() : listener_keys.getPublicKey());
+        std::string username = "user" + std::to_string(i);
+        ProtocolHandler::appendAuth(hello, username, simulationToken(username));
+        ProtocolHandler::appendJoinRoom(hello, room);
+        transports[i]->write(hello.data(), hello.size());
+    }
+
+    // The sender needs the server's key; listeners only count DATA frames,
+    // each of which arrives whole in one write
+    auto sender_decoder = std::make_shared<ProtocolHandler>();
+    transports[0]->setReadHandler([&, sender_decoder]() {
+        char buffer[4096];
+        int64_t n;
+        while ((n = transports[0]->read(buffer, sizeof(buffer))) > 0) {
+            sender_decoder->append(buffer, static_cast<size_t>(n));
+        }
+        Frame frame;
+        while (sender_decoder->nextFrame(frame)) {
+            if (frame.type == FrameType::KEY_EXCHANGE) {
+                EXPECT_TRUE(sender_keys.exchangeKeys(std::string(frame.payload)));
+            }
+        }
+    });
+    for (size_t i = 1; i <= listeners; ++i) {
+        transports[i]->setReadHandler([&, i]() {
+            char buffer[4096];
+            int64_t n;
+            while ((n = transports[i]->read(buffer, sizeof(buffer))) > 0) {
+                for (size_t offset = 0; offset + ProtocolHandler::HEADER_SIZE <= static_cast<size_t>(n);) {
+                    uint32_t length = static_cast<uint8_t>(buffer[offset]) << 24 |
+                        static_cast<uint8_t>(buffer[offset + 1]) << 16 |
+                        static_cast<uint8_t>(buffer[offset + 2]) << 8 | static_cast<uint8_t>(buffer[offset + 3]);
+                    if (static_cast<FrameType>(buffer[offset + 4]) == FrameType::DATA) {
+                        deliveries++;
+                    }
+                    offset += ProtocolHandler::HEADER_SIZE + length;
+                }
+            }
+        });
+    }
+    network.runReady();
+    ASSERT_EQ(server.getConnectedClientsCount(), listeners + 1);
+
+    // Sealed up front: building them allocates. Every message has its own
+    // id and words, so none is a retry or a near-duplicate.
+    std::vector<securechat::crypto::EncryptedRecord> records;
+    for (size_t i = 0; i < warmup + measured; ++i) {
+        std::string text = R"({"messageId":"m)" + std::to_string(i) + R"(","text":")";
+        for (size_t word = 0; word < 8; ++word) {
+            text += "w" + std::to_string(i * 131 + word * 7919) + " ";
+        }
+        text += R"("})";
+        records.push_back(sender_keys.encrypt(securechat::utils::MessageBuffer(text)));
+        ASSERT_FALSE(records.back().empty());
+    }
+    auto relay = [&](const securechat::crypto::EncryptedRecord& record) {
+        transports[0]->write(record.data(), record.size());
+        network.runReady();
+    };
+
+    for (size_t i = 0; i < warmup; ++i) {
+        relay(records[i]);
+    }
+    securechat::utils::NoAllocationScope steady_state("server relay");
+    for (size_t i = warmup; i < warmup + measured; ++i) {
+        relay(records[i]);
+    }
+    EXPECT_EQ(steady_state.finish(), 0u);
+    EXPECT_EQ(deliveries, (warmup + measured) * listeners);
+}
+
+// A real Server on memory transports with inline executors, and chat
+// clients that may drop their connection and join again as the same user
+class ReconnectingClientTest : public ::testing::Test {
+protected:
+    struct Peer {
+        std::unique_ptr<MemoryTransport> transport;
+        securechat::crypto::EncryptionManager keys;
+        ProtocolHandler decoder;
+        size_t received{0};
+    };
+
+    void startServer(const std::string& plugins) {
+        const std::string config_path = "reconnect_server.json";
+        std::ofstream(config_path) << R"({
+  "security": {"enable_tls": false},
+  "authentication": {"enable_jwt": true, "jwt_secret": ")" << SIMULATION_JWT_SECRET << R"("},
+  "performance": {"executors": {"inline": true}},
+  "monitoring": {"enable_metrics": false},
+  "logging": {"level": "warn", "enable_console": false},
+  "plugins": {"auto_load": false, "enabled_plugins": [)" << plugins << R"(]}
+})";
+        ASSERT_TRUE(config_.loadFromFile(config_path));
+        std::remove(config_path.c_str());
+        securechat::utils::Logger::setLogLevel(securechat::utils::LogLevel::WARN);
+        server_ = std::make_unique<securechat::core::Server>(config_, clock_);
+        ASSERT_TRUE(server_->initialize());
+    }
+
+    // Connects, authenticates as username and joins room 1
+    std::unique_ptr<Peer> join(const std::string& username) {
+        auto peer = std::make_unique<Peer>();
+        EXPECT_TRUE(peer->keys.generateEphemeralKeys());
+        peer->transport = network_.connect();
+        server_->acceptTransport(network_.accept());
+
+        std::string hello;
+        ProtocolHandler::appendFrame(hello, FrameType::KEY_EXCHANGE, peer->keys.getPublicKey());
+        ProtocolHandler::appendAuth(hello, username, simulationToken(username));
+        ProtocolHandler::appendJoinRoom(hello, 1);
+        peer->transport->write(hello.data(), hello.size());
+        peer->transport->setReadHandler([self = peer.get()]() {
+            char buffer[4096];
+            int64_t n;
+            while ((n = self->transport->read(buffer, sizeof(buffer))) > 0) {
+                self->decoder.append(buffer, static_cast<size_t>(n));
+            }
+            Frame frame;
+            while (self->decoder.nextFrame(frame)) {
+                if (frame.type == FrameType::KEY_EXCHANGE) {
+                    EXPECT_TRUE(self->keys.exchangeKeys(std::string(frame.payload)));
+                } else if (frame.type == FrameType::DATA) {
+                    self->received++;
+                }
+            }
+        });
+        network_.runReady();
+        return peer;
+    }
+
+    std::unique_ptr<Peer> reconnect(std::unique_ptr<Peer> peer, const std::string& username) {
+        peer->transport->close();
+        network_.runReady();
+        return join(username);
+    }
+
+    void send(Peer& peer, const std::string& text) {
+        auto record = peer.keys.encrypt(securechat::utils::MessageBuffer(text));
+        ASSERT_FALSE(record.empty());
+        peer.transport->write(record.data(), record.size());
+        network_.runReady();
+    }
+
+    securechat::utils::ConfigManager config_;
+    MemoryNetwork network_;
+    SimulatedClock clock_;
+    std::unique_ptr<securechat::core::Server> server_;
+};
+
+// A client that loses its connection right after sending retries the same
+// message id from a new connection. Retries are matched on the user, so
+// the room sees the message once; another user may use the same id.
+TEST_F(ReconnectingClientTest, RetriesAfterReconnectAreDropped) {
+    startServer("");
+    const std::string message = R"({"messageId":"m-1","text":"see you at noon"})";
+
+    auto listener = join("listener");
+    auto alice = join("alice");
+    send(*alice, message);
+    EXPECT_EQ(listener->received, 1u);
+
+    // The ack never arrived; alice reconnects and retries
+    alice = reconnect(std::move(alice), "alice");
+    ASSERT_EQ(server_->getConnectedClientsCount(), 2u);
+    send(*alice, message);
+    EXPECT_EQ(listener->received, 1u);
+
+    auto bob = join("bob");
+    send(*bob, message);
+    EXPECT_EQ(listener->received, 2u);
+}
+
+// Reconnecting does not give a flooding user a fresh spam window
+TEST_F(ReconnectingClientTest, SpamWindowFollowsTheUserAcrossReconnects) {
+    startServer(R"("spam_detection")");
+    const std::string flood = "buy cheap followers at this great link today";
+
+    auto listener = join("listener");
+    auto mallory = join("mallory");
+    for (int i = 0; i < 2; ++i) {
+        send(*mallory, flood);
+    }
+    mallory = reconnect(std::move(mallory), "mallory");
+    for (int i = 0; i < 2; ++i) {
+        send(*mallory, flood);
+    }
+    // The default threshold flags the fourth near-duplicate from one user
+    EXPECT_EQ(listener->received, 3u);
+}
+
+// Frames read while AUTH is unanswered are held back, but only up to one
+// largest frame; a peer that keeps sending is disconnected.
+TEST_F(MemoryNetworkTest, BytesHeldBehindPendingAuthAreBounded) {
+    using securechat::core::ClientConnection;
+    struct HeldAuth : securechat::core::MessageHandler {
+        std::function<void(AuthStatus)> done;
+        AuthStatus authenticate(ClientConnection&, std::string_view, std::string_view) override {
+            return AuthStatus::OK;
+        }
+        void authenticateAsync(ClientConnection&, std::string, std::string,
+                               std::function<void(AuthStatus)> answer) override {
+            done = std::move(answer);
+        }
+        void onJoinRoom(ClientConnection&, uint64_t) override {}
+        void onMessage(ClientConnection&, const std::string&) override {}
+        void onResume(ClientConnection&, std::string_view, uint64_t) override {}
+        void onDisconnect(ClientConnection&) override {}
+        securechat::security::RateLimitConfig getRateLimit() const override { return {}; }
+    } handler;
+
+    MemoryNetwork network;
+    auto client = network.connect();
+    auto connection = std::make_shared<ClientConnection>(network.accept(), 1);
+    connection->setMessageHandler(&handler);
+    ASSERT_TRUE(connection->initialize());
+    connection->start(nullptr);
+
+    securechat::crypto::EncryptionManager keys;
+    ASSERT_TRUE(keys.generateEphemeralKeys());
+    std::string wire;
+    ProtocolHandler::appendFrame(wire, FrameType::KEY_EXCHANGE, keys.getPublicKey());
+    ProtocolHandler::appendAuth(wire, "alice", "secret");
+    client->write(wire.data(), wire.size());
+    network.runReady();
+    ASSERT_TRUE(handler.done);
+    ASSERT_TRUE(connection->isConnected());
+
+    const std::string chunk(64 * 1024, 'x');
+    size_t sent = 0;
+    while (connection->isConnected() && sent <= 2 * ProtocolHandler::DEFAULT_MAX_FRAME_SIZE) {
+        int64_t n = client->write(chunk.data(), chunk.size());
+        ASSERT_GE(n, 0);
+        sent += static_cast<size_t>(n);
+        network.runReady();
+    }
+    EXPECT_FALSE(connection->isConnected());
+    EXPECT_LE(sent, ProtocolHandler::HEADER_SIZE + ProtocolHandler::DEFAULT_MAX_FRAME_SIZE + chunk.size());
+}
+
+TEST(AdaptiveSpinTest, BacksOffToBlockingWithBoundedIdleSpin) {
+    securechat::network::BusyPollConfig config;
+    config.enabled = true;
+    config.min_spin = std::chrono::microseconds(5);
+    config.max_spin = std::chrono::microseconds(64);
+    securechat::network::AdaptiveSpin spin(config);
+    EXPECT_EQ(spin.getSpinBudget(), std::chrono::microseconds(64));
+
+    // Idle: every spin expires, and the total spent stays under 2 * max_spin
+    std::chrono::nanoseconds spent{0};
+    while (spin.getSpinBudget().count() > 0) {
+        spent += spin.getSpinBudget();
+        spin.onSpin(false);
+    }
+    EXPECT_LT(spent, std::chrono::microseconds(128));
+    EXPECT_EQ(spin.getSpinMisses(), 4u);  // 64, 32, 16, 8
+
+    // Traffic returns: a quick wake re-arms, hits grow back to the cap
+    spin.onWake(std::chrono::microseconds(20));
+    EXPECT_EQ(spin.getSpinBudget(), std::chrono::microseconds(5));
+    for (int i = 0; i < 10; ++i) {
+        spin.onSpin(true);
+    }
+    EXPECT_EQ(spin.getSpinBudget(), std::chrono::microseconds(64));
+
+    // A long blocking wait is not a reason to spin
+    securechat::network::AdaptiveSpin idle(config);
+    while (idle.getSpinBudget().count() > 0) {
+        idle.onSpin(false);
+    }
+    idle.onWake(std::chrono::milliseconds(10));
+    EXPECT_EQ(idle.getSpinBudget().count(), 0);
+}
+
+TEST(AdaptiveSpinTest, DisabledNeverSpins) {
+    securechat::network::AdaptiveSpin spin;
+    EXPECT_FALSE(spin.isEnabled());
+    spin.onSpin(true);
+    spin.onWake(std::chrono::microseconds(1));
+    EXPECT_EQ(spin.getSpinBudget().count(), 0);
+}
+
+class FairShareSchedulerTest : public ::testing::Test {
+protected:
+    static constexpr size_t BUDGET = 4096;
+
+    // Serves reads from per-socket byte counts standing in for receive buffers
+    FairShareScheduler::ReadFn reader() {
+        return [this](int fd, size_t max_bytes) {
+            size_t& pending = pending_[fd];
+            size_t bytes = std::min(pending, max_bytes);
+            pending -= bytes;
+            reads_.push_back(fd);
+            return ReadTurn{bytes, pending == 0};
+        };
+    }
+
+    FairShareScheduler scheduler_{BUDGET};
+    std::map<int, size_t> pending_;
+    std::vector<int> reads_;
+};
+
+TEST_F(FairShareSchedulerTest, FloodingSocketCannotStarveQuietOnes) {
+    constexpr int FLOOD = 3;
+    pending_[FLOOD] = 10 * BUDGET;
+
+    // The flooder is read once per iteration; quiet sockets ready later are
+    // served in the iteration they become ready
+    EXPECT_EQ(scheduler_.runIteration({FLOOD}, reader()), BUDGET);
+    EXPECT_TRUE(scheduler_.hasCarryOver());
+    for (int quiet = 10; quiet < 15; ++quiet) {
+        pending_[quiet] = 100;
+        reads_.clear();
+        EXPECT_EQ(scheduler_.runIteration({quiet}, reader()), BUDGET + 100);
+        EXPECT_EQ(reads_, (std::vector<int>{FLOOD, quiet}));
+        EXPECT_EQ(pending_[quiet], 0u);
+    }
+
+    // Six full turns so far; the remaining four drain it
+    size_t iterations = 0;
+    while (scheduler_.hasCarryOver()) {
+        scheduler_.runIteration({}, reader());
+        iterations++;
+    }
+    EXPECT_EQ(iterations, 4u);
+    EXPECT_EQ(pending_[FLOOD], 0u);
+    EXPECT_EQ(scheduler_.getBudgetHits(), 9u);
+}
+
+TEST_F(FairShareSchedulerTest, ReportedAgainIsReadOnceAndRemovedIsSkipped) {
+    pending_[3] = 3 * BUDGET;
+    pending_[4] = 3 * BUDGET;
+    scheduler_.runIteration({3, 4}, reader());
+
+    // Level-triggered readiness reports carried sockets again
+    reads_.clear();
+    scheduler_.runIteration({4, 3}, reader());
+    EXPECT_EQ(reads_, (std::vector<int>{3, 4}));
+
+    scheduler_.remove(3);
+    reads_.clear();
+    scheduler_.runIteration({}, reader());
+    EXPECT_EQ(reads_, (std::vector<int>{4}));
+    EXPECT_FALSE(scheduler_.hasCarryOver());
+}
+
+#ifdef __linux__
+// The reactor reads a watched socket one budget per iteration, so a socket
+// that becomes ready while another floods is read long before the flood ends
+TEST(AsyncIOTest, WatchedSocketsShareEachIterationsReadBudget) {
+    constexpr size_t BUDGET = 4096;
+    constexpr size_t FLOOD_BYTES = 16 * BUDGET;
+    AsyncIO io{AsyncIOConfig{64, 1, BUDGET}};
+    ASSERT_TRUE(io.initialize());
+
+    int flood[2];
+    int quiet[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, flood), 0);
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, quiet), 0);
+    std::string bytes(FLOOD_BYTES, 'f');
+    ASSERT_EQ(write(flood[1], bytes.data(), bytes.size()), static_cast<ssize_t>(bytes.size()));
+
+    auto drain = [](int fd, size_t max_bytes) {
+        char buffer[1024];
+        ReadTurn turn;
+        while (turn.bytes < max_bytes) {
+            ssize_t n = read(fd, buffer, std::min(sizeof(buffer), max_bytes - turn.bytes));
+            if (n <= 0) {
+                return turn;
+            }
+            turn.bytes += static_cast<size_t>(n);
+        }
+        turn.drained = false;
+        return turn;
+    };
+
+    // Runs on the single worker, so no locking
+    size_t flooded = 0;
+    size_t flooded_when_quiet_read = 0;
+    bool finished = false;
+    std::promise<void> done;
+    auto finish = [&]() {
+        if (!finished && flooded == FLOOD_BYTES && flooded_when_quiet_read > 0) {
+            finished = true;
+            done.set_value();
+        }
+    };
+    ASSERT_TRUE(io.watchSocket(quiet[0], [&](size_t max_bytes) {
+        ReadTurn turn = drain(quiet[0], max_bytes);
+        flooded_when_quiet_read = flooded;
+        finish();
+        return turn;
+    }));
+    ASSERT_TRUE(io.watchSocket(flood[0], [&](size_t max_bytes) {
+        ReadTurn turn = drain(flood[0], max_bytes);
+        EXPECT_LE(turn.bytes, max_bytes);
+        if (flooded == 0) {
+            // Ready from the next iteration on
+            EXPECT_EQ(write(quiet[1], "hi", 2), 2);
+        }
+        flooded += turn.bytes;
+        finish();
+        return turn;
+    }));
+    io.start();
+
+    ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_LE(flooded_when_quiet_read, 2 * BUDGET);
+    EXPECT_GE(io.getBudgetHits(), FLOOD_BYTES / BUDGET - 1);
+
+    io.removeSocket(quiet[0]);
+    io.removeSocket(flood[0]);
+    io.stop();
+    for (int fd : {flood[0], flood[1], quiet[0], quiet[1]}) {
+        close(fd);
+    }
+}
+
+class IOAwaiterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(io_.initialize());
+        io_.start();
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds_), 0);
+        ASSERT_TRUE(io_.addAwaitableSocket(fds_[0]));
+        ASSERT_TRUE(io_.addAwaitableSocket(fds_[1]));
+    }
+
+    void TearDown() override {
+        io_.removeSocket(fds_[0]);
+        io_.removeSocket(fds_[1]);
+        io_.stop();
+        close(fds_[0]);
+        close(fds_[1]);
+    }
+
+    AsyncIO io_{AsyncIOConfig{64, 1, 65536}};
+    int fds_[2]{-1, -1};
+};
+
+TEST_F(IOAwaiterTest, ReadsAndWritesThroughCallerBuffers) {
+    const std::vector<char> request{'p', 'i', 'n', 'g'};
+    char buffer[16]{};
+    IOResult written;
+    IOResult received;
+    std::promise<void> done;
+
+    auto session = [&]() -> securechat::core::Task<> {
+        written = co_await io_.write(fds_[0], request.data(), request.size());
+        received = co_await io_.read(fds_[1], buffer, sizeof(buffer));
+        done.set_value();
+    };
+    securechat::core::spawn(session());
+
+    ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_TRUE(written.ok());
+    EXPECT_EQ(written.bytes_transferred, request.size());
+    EXPECT_TRUE(received.ok());
+    ASSERT_EQ(received.bytes_transferred, request.size());
+    EXPECT_EQ(std::string(buffer, received.bytes_transferred), "ping");
+}
+
+TEST_F(IOAwaiterTest, ReadsNoMoreThanTheCallerBufferHolds) {
+    const std::vector<char> request(64, 'x');
+    char buffer[8]{};
+    IOResult received;
+    std::promise<void> done;
+
+    auto session = [&]() -> securechat::core::Task<> {
+        co_await io_.write(fds_[0], request.data(), request.size());
+        received = co_await io_.read(fds_[1], buffer, sizeof(buffer));
+        done.set_value();
+    };
+    securechat::core::spawn(session());
+
+    ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_TRUE(received.ok());
+    EXPECT_LE(received.bytes_transferred, sizeof(buffer));
+    EXPECT_EQ(std::string(buffer, received.bytes_transferred), std::string(received.bytes_transferred, 'x'));
+}
+
+TEST_F(IOAwaiterTest, AsyncReadCompletesInTheCallersBuffer) {
+    int pair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, pair), 0);
+
+    char buffer[16]{};
+    std::promise<IOEvent> completed;
+    ASSERT_TRUE(io_.addSocket(pair[1], [&completed](const IOEvent& event) { completed.set_value(event); }));
+    ASSERT_TRUE(io_.asyncRead(pair[1], buffer, sizeof(buffer)));
+    ASSERT_EQ(::write(pair[0], "pong", 4), 4);
+
+    auto future = completed.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    IOEvent event = future.get();
+    EXPECT_EQ(event.buffer, buffer);
+    ASSERT_EQ(event.bytes_transferred, 4u);
+    EXPECT_EQ(std::string(buffer, 4), "pong");
+
+    io_.removeSocket(pair[1]);
+    close(pair[0]);
+    close(pair[1]);
+}
+
+TEST_F(IOAwaiterTest, SleepResumesOnTimerfd) {
+    IOResult slept;
+    std::chrono::steady_clock::duration elapsed{};
+    std::promise<void> done;
+
+    auto session = [&]() -> securechat::core::Task<> {
+        auto start = std::chrono::steady_clock::now();
+        slept = co_await io_.sleep(std::chrono::milliseconds(20));
+        elapsed = std::chrono::steady_clock::now() - start;
+        done.set_value();
+    };
+    securechat::core::spawn(session());
+
+    ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_TRUE(slept.ok());
+    EXPECT_GE(elapsed, std::chrono::milliseconds(20));
+}
+#endif
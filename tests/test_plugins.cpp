@@ -0,0 +1,707 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <thread>
+#include "plugins/content_filter.hpp"
+#include "plugins/plugin_manager.hpp"
+#include "plugins/spam_detector.hpp"
+
+using namespace securechat::plugins;
+
+class PatternMatcherTest : public ::testing::Test {
+protected:
+    static std::shared_ptr<const PatternMatcher> compile(std::vector<FilterPattern> patterns) {
+        return PatternMatcher::compile(patterns);
+    }
+};
+
+TEST_F(PatternMatcherTest, EmptyPatternSetAllowsEverything) {
+    auto matcher = compile({});
+    EXPECT_EQ(matcher->scan("anything at all"), FilterAction::ALLOW);
+    EXPECT_EQ(matcher->scan(""), FilterAction::ALLOW);
+}
+
+TEST_F(PatternMatcherTest, FindsOverlappingPatterns) {
+    auto matcher = compile({
+        {"he", FilterAction::MASK, false},
+        {"she", FilterAction::MASK, false},
+        {"his", FilterAction::MASK, false},
+        {"hers", FilterAction::MASK, false},
+    });
+
+    std::vector<FilterMatch> matches;
+    EXPECT_EQ(matcher->scan("ushers", &matches), FilterAction::MASK);
+
+    // "she" at 1, "he" at 2, "hers" at 2
+    ASSERT_EQ(matches.size(), 3u);
+    std::vector<std::pair<size_t, size_t>> found;
+    for (const auto& match : matches) {
+        found.emplace_back(match.offset, match.length);
+    }
+    EXPECT_NE(std::find(found.begin(), found.end(), std::make_pair<size_t, size_t>(1, 3)), found.end());
+    EXPECT_NE(std::find(found.begin(), found.end(), std::make_pair<size_t, size_t>(2, 2)), found.end());
+    EXPECT_NE(std::find(found.begin(), found.end(), std::make_pair<size_t, size_t>(2, 4)), found.end());
+}
+
+TEST_F(PatternMatcherTest, CaseInsensitive) {
+    auto matcher = compile({{"spam", FilterAction::REJECT, false}});
+    EXPECT_EQ(matcher->scan("Buy SPAM now"), FilterAction::REJECT);
+    EXPECT_EQ(matcher->scan("Buy sPaM now"), FilterAction::REJECT);
+    EXPECT_EQ(matcher->scan("Buy spa now"), FilterAction::ALLOW);
+}
+
+TEST_F(PatternMatcherTest, WholeWordMatching) {
+    auto matcher = compile({{"ass", FilterAction::MASK, true}});
+    EXPECT_EQ(matcher->scan("first class passage"), FilterAction::ALLOW);
+    EXPECT_EQ(matcher->scan("what an ass!"), FilterAction::MASK);
+    EXPECT_EQ(matcher->scan("ass"), FilterAction::MASK);
+}
+
+TEST_F(PatternMatcherTest, RejectOutranksMask) {
+    auto matcher = compile({
+        {"darn", FilterAction::MASK, true},
+        {"http://evil", FilterAction::REJECT, false},
+    });
+    EXPECT_EQ(matcher->scan("darn"), FilterAction::MASK);
+    EXPECT_EQ(matcher->scan("darn, see http://evil.example"), FilterAction::REJECT);
+}
+
+TEST_F(PatternMatcherTest, PrefilterAgreesWithAutomatonOnLongInputs) {
+    // Few distinct start bytes keep the prefilter enabled
+    auto matcher = compile({
+        {"zebra", FilterAction::MASK, false},
+        {"quartz", FilterAction::MASK, false},
+    });
+    ASSERT_TRUE(matcher->isPrefilterEnabled());
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> letter('a', 'p');
+    for (size_t length : {0u, 15u, 16u, 31u, 32u, 33u, 100u, 1000u}) {
+        for (size_t pos = 0; pos + 5 <= length; pos += 7) {
+            std::string text(length, 'x');
+            for (auto& c : text) {
+                c = static_cast<char>(letter(rng));
+            }
+            text.replace(pos, 5, "ZeBrA");
+
+            std::vector<FilterMatch> matches;
+            EXPECT_EQ(matcher->scan(text, &matches), FilterAction::MASK);
+            ASSERT_EQ(matches.size(), 1u);
+            EXPECT_EQ(matches[0].offset, pos);
+        }
+    }
+}
+
+TEST_F(PatternMatcherTest, ManyPatternsDisablePrefilter) {
+    std::vector<FilterPattern> patterns;
+    for (char c = 'a'; c <= 'z'; ++c) {
+        patterns.push_back({std::string(1, c) + "xq", FilterAction::MASK, false});
+    }
+    auto matcher = compile(patterns);
+    EXPECT_FALSE(matcher->isPrefilterEnabled());
+    EXPECT_EQ(matcher->scan("hello mxq"), FilterAction::MASK);
+    EXPECT_EQ(matcher->scan("hello world"), FilterAction::ALLOW);
+}
+
+class ContentFilterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        filter_ = std::make_unique<ContentFilter>(config_);
+        filter_->setPatterns({
+            {"badword", FilterAction::MASK, true},
+            {"buy followers", FilterAction::REJECT, false},
+        });
+    }
+
+    securechat::utils::ConfigManager config_;
+    std::unique_ptr<ContentFilter> filter_;
+};
+
+TEST_F(ContentFilterTest, MasksMatchedWords) {
+    std::string rewritten;
+    auto verdict = filter_->apply("you badword, BADWORD", rewritten);
+    EXPECT_EQ(verdict.action, FilterAction::MASK);
+    EXPECT_EQ(verdict.match_count, 2u);
+    EXPECT_EQ(rewritten, "you *******, *******");
+    EXPECT_EQ(filter_->getMaskedMessages(), 1u);
+}
+
+TEST_F(ContentFilterTest, RejectsBlockedContent) {
+    std::string rewritten;
+    auto verdict = filter_->apply("cheap! buy followers today", rewritten);
+    EXPECT_EQ(verdict.action, FilterAction::REJECT);
+    EXPECT_TRUE(rewritten.empty());
+    EXPECT_EQ(filter_->getRejectedMessages(), 1u);
+}
+
+TEST_F(ContentFilterTest, SwapIsVisibleToScanningThreads) {
+    EXPECT_EQ(filter_->check("fresh term"), FilterAction::ALLOW);
+
+    auto generation = filter_->getGeneration();
+    filter_->setPatterns({{"fresh", FilterAction::REJECT, true}});
+    EXPECT_NE(filter_->getGeneration(), generation);
+
+    EXPECT_EQ(filter_->check("fresh term"), FilterAction::REJECT);
+
+    FilterAction seen = FilterAction::ALLOW;
+    std::thread worker([&]() { seen = filter_->check("fresh term"); });
+    worker.join();
+    EXPECT_EQ(seen, FilterAction::REJECT);
+}
+
+TEST_F(ContentFilterTest, ConcurrentScansDuringReload) {
+    const int scans_per_thread = 20000;
+    std::atomic<int> scans{0};
+    std::vector<std::thread> scanners;
+    for (int t = 0; t < 4; ++t) {
+        scanners.emplace_back([&]() {
+            for (int i = 0; i < scans_per_thread; ++i) {
+                auto action = filter_->check("a message with badword inside");
+                EXPECT_EQ(action, FilterAction::MASK);
+                scans.fetch_add(1);
+            }
+        });
+    }
+
+    for (int i = 0; i < 50; ++i) {
+        filter_->setPatterns({{"badword", FilterAction::MASK, true},
+                              {"pattern" + std::to_string(i), FilterAction::MASK, true}});
+        std::this_thread::yield();
+    }
+    for (auto& scanner : scanners) {
+        scanner.join();
+    }
+    EXPECT_EQ(scans.load(), 4 * scans_per_thread);
+}
+
+// A word list that cannot be read fails the load without taking the other
+// list down, and keeps what it had loaded before
+TEST_F(ContentFilterTest, LoadsEachWordListIndependently) {
+    const std::string blocked_file = "content_filter_blocked_test.txt";
+    const std::string masked_file = "content_filter_masked_test.txt";
+    std::remove(blocked_file.c_str());
+    std::ofstream(masked_file) << "# masked\nbadword\n";
+
+    const std::string config_file = "content_filter_test.json";
+    std::ofstream(config_file) << R"({"plugins": {
+  "enabled_plugins": ["message_filter", "profanity_filter"],
+  "message_filter": {"patterns_file": ")" << blocked_file << R"("},
+  "profanity_filter": {"words_file": ")" << masked_file << R"("}}})";
+    securechat::utils::ConfigManager config;
+    ASSERT_TRUE(config.loadFromFile(config_file));
+    std::remove(config_file.c_str());
+    ContentFilter filter(config);
+
+    EXPECT_FALSE(filter.initialize());
+    EXPECT_EQ(filter.check("you badword"), FilterAction::MASK);
+    EXPECT_EQ(filter.check("buy followers"), FilterAction::ALLOW);
+
+    std::ofstream(blocked_file) << "buy followers\n";
+    EXPECT_TRUE(filter.reload());
+    EXPECT_EQ(filter.check("buy followers"), FilterAction::REJECT);
+
+    std::remove(masked_file.c_str());
+    EXPECT_FALSE(filter.reload());
+    EXPECT_EQ(filter.check("you badword"), FilterAction::MASK);
+    EXPECT_EQ(filter.check("buy followers"), FilterAction::REJECT);
+    std::remove(blocked_file.c_str());
+}
+
+// Performance benchmark test
+TEST_F(ContentFilterTest, ScanThroughput) {
+    std::vector<FilterPattern> patterns;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    for (int i = 0; i < 1000; ++i) {
+        std::string word(5 + i % 6, 'a');
+        for (auto& c : word) {
+            c = static_cast<char>(letter(rng));
+        }
+        patterns.push_back({word, FilterAction::MASK, true});
+    }
+    filter_->setPatterns(patterns);
+
+    const std::string message = "Hey everyone, the deploy finished and metrics look healthy. "
+                                "Ping me if the dashboards show anything odd tonight.";
+    const int num_messages = 200000;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    int allowed = 0;
+    for (int i = 0; i < num_messages; ++i) {
+        allowed += filter_->check(message) == FilterAction::ALLOW;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    double messages_per_second = num_messages * 1000000.0 / std::max<int64_t>(duration.count(), 1);
+    std::cout << "Content filter: " << messages_per_second << " messages/second ("
+              << message.size() << " byte messages, 1000 patterns)" << std::endl;
+
+    EXPECT_EQ(allowed, num_messages);
+#ifdef NDEBUG
+    // Target is 1M messages/s per core in optimized builds
+    EXPECT_GT(messages_per_second, 1000000.0);
+#endif
+}
+
+class SpamDetectorTest : public ::testing::Test {
+protected:
+    // The defaults are the shipped configuration
+    void SetUp() override {
+        detector_ = std::make_unique<SpamDetector>();
+        now_ = std::chrono::steady_clock::now();
+    }
+
+    std::unique_ptr<SpamDetector> detector_;
+    std::chrono::steady_clock::time_point now_;
+};
+
+TEST_F(SpamDetectorTest, FingerprintIsCaseAndPunctuationInsensitive) {
+    EXPECT_EQ(SpamDetector::fingerprint("Buy cheap watches now"),
+              SpamDetector::fingerprint("buy, CHEAP watches... now!!"));
+}
+
+TEST_F(SpamDetectorTest, OneTokenEditsStayWithinDefaultRadius) {
+    const std::string base = "Limited offer! Get free crypto coins at our site, join thousands of "
+                             "happy members today and claim your welcome bonus";
+    const int radius = SpamDetectorConfig{}.hamming_radius;
+    uint64_t original = SpamDetector::fingerprint(base);
+    uint64_t unrelated = SpamDetector::fingerprint("Standup moved to 10:30 tomorrow, same room as usual");
+
+    const std::string edits[] = {
+        base + " 42",
+        base + " now",
+        "Limited offer! Get free crypto coins at our site, join thousands of happy members today and claim your bonus",
+    };
+    for (const auto& edited : edits) {
+        EXPECT_LE(SpamDetector::distance(original, SpamDetector::fingerprint(edited)), radius) << edited;
+    }
+    EXPECT_GT(SpamDetector::distance(original, unrelated), radius);
+}
+
+TEST_F(SpamDetectorTest, FlagsUserRepeatingNearDuplicates) {
+    // Each copy carries a different one-token edit, as flood scripts do
+    const std::string spam = "Limited offer! Get free crypto coins at our site, join thousands of "
+                             "happy members today and claim your welcome bonus";
+    const char* suffixes[] = {"", " 17", " now", " today"};
+
+    SpamVerdict verdict;
+    for (int i = 0; i < 3; ++i) {
+        verdict = detector_->check(1, 100, spam + suffixes[i], now_ + std::chrono::seconds(i));
+        EXPECT_FALSE(verdict.flagged);
+    }
+    verdict = detector_->check(1, 100, spam + suffixes[3], now_ + std::chrono::seconds(3));
+    EXPECT_TRUE(verdict.flagged);
+    EXPECT_EQ(verdict.user_duplicates, 3);
+    EXPECT_EQ(detector_->getFlaggedMessages(), 1u);
+}
+
+TEST_F(SpamDetectorTest, ShortMessagesAreNotChecked) {
+    // Token-less messages all fingerprint to 0; short ones are too unstable
+    // to compare. Neither is flagged however often it repeats.
+    for (const char* message : {"!!!", ":)", "ok thanks", "see you all soon"}) {
+        for (int i = 0; i < 6; ++i) {
+            auto verdict = detector_->check(3, 500, message, now_ + std::chrono::seconds(i));
+            EXPECT_FALSE(verdict.flagged) << message;
+            EXPECT_EQ(verdict.user_duplicates, 0) << message;
+            EXPECT_LT(verdict.tokens, SpamDetectorConfig{}.min_tokens);
+        }
+    }
+    EXPECT_EQ(detector_->getFlaggedMessages(), 0u);
+}
+
+TEST_F(SpamDetectorTest, DistinctMessagesAreNotFlagged) {
+    const char* messages[] = {
+        "Morning all, coffee is in the kitchen",
+        "Did anyone see the build failure on main?",
+        "I'll take the on-call shift this weekend",
+        "Reminder: retro at 4pm in the big room",
+        "The new dashboard is live, feedback welcome",
+        "Lunch order closes in ten minutes",
+    };
+    for (int i = 0; i < 6; ++i) {
+        auto verdict = detector_->check(7, 200, messages[i], now_ + std::chrono::seconds(i));
+        EXPECT_FALSE(verdict.flagged) << messages[i];
+    }
+}
+
+TEST_F(SpamDetectorTest, OldFingerprintsExpire) {
+    const std::string spam = "click this link to win a brand new phone today";
+    for (int i = 0; i < 3; ++i) {
+        detector_->check(2, 300, spam, now_ + std::chrono::seconds(i));
+    }
+    auto verdict = detector_->check(2, 300, spam, now_ + std::chrono::seconds(120));
+    EXPECT_FALSE(verdict.flagged);
+    EXPECT_EQ(verdict.user_duplicates, 0);
+}
+
+TEST_F(SpamDetectorTest, FlagsCoordinatedRoomFlood) {
+    const std::string spam = "join my server for free nitro giveaways every hour";
+    SpamVerdict verdict;
+    for (uint64_t user = 10; user < 16; ++user) {
+        verdict = detector_->check(user, 400, spam, now_);
+    }
+    EXPECT_TRUE(verdict.flagged);
+    EXPECT_EQ(verdict.user_duplicates, 0);
+    EXPECT_EQ(verdict.room_duplicates, 5);
+}
+
+TEST_F(SpamDetectorTest, MessagesOutsideRoomsSkipTheRoomCheck) {
+    const std::string message = "good morning everyone, coffee is ready in the kitchen";
+    SpamVerdict verdict;
+    for (uint64_t user = 20; user < 30; ++user) {
+        verdict = detector_->check(user, SpamDetector::NO_ROOM, message, now_);
+        EXPECT_FALSE(verdict.flagged);
+    }
+    EXPECT_EQ(verdict.room_duplicates, 0);
+}
+
+// Performance benchmark test
+TEST_F(SpamDetectorTest, CheckLatency) {
+    const std::string message = "Hey everyone, the deploy finished and metrics look healthy. "
+                                "Ping me if the dashboards show anything odd tonight.";
+    const int num_messages = 200000;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_messages; ++i) {
+        detector_->check(static_cast<uint64_t>(i % 5000), static_cast<uint64_t>(i % 64), message, now_);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+    double ns_per_message = static_cast<double>(duration.count()) / num_messages;
+    std::cout << "Spam detection: " << ns_per_message << " ns/message ("
+              << message.size() << " byte messages)" << std::endl;
+#ifdef NDEBUG
+    EXPECT_LT(ns_per_message, 1000.0);
+#endif
+}
+
+namespace {
+
+// In-process plugins exercising the C ABI without a shared object
+struct AppendInstance {
+    std::string suffix;
+    uint32_t worker_index;
+};
+
+void* createAppend(const char* config, uint32_t worker_index) {
+    return new AppendInstance{config, worker_index};
+}
+
+void destroyAppend(void* instance) {
+    delete static_cast<AppendInstance*>(instance);
+}
+
+securechat_verdict appendSuffix(void* instance, const securechat_message_view* message,
+                                securechat_rewrite_buffer* rewrite) {
+    auto* self = static_cast<AppendInstance*>(instance);
+    rewrite->length = message->length + self->suffix.size();
+    if (rewrite->length <= rewrite->capacity) {
+        std::memcpy(rewrite->data, message->data, message->length);
+        std::memcpy(rewrite->data + message->length, self->suffix.data(), self->suffix.size());
+    }
+    return SECURECHAT_VERDICT_REWRITE;
+}
+
+securechat_verdict rejectFromSender(void* instance, const securechat_message_view* message,
+                                    securechat_rewrite_buffer*) {
+    (void)instance;
+    return message->header->sender_id == 13 ? SECURECHAT_VERDICT_REJECT : SECURECHAT_VERDICT_ACCEPT;
+}
+
+securechat_verdict acceptAll(void*, const securechat_message_view*, securechat_rewrite_buffer*) {
+    return SECURECHAT_VERDICT_ACCEPT;
+}
+
+std::atomic<int> g_live_instances{0};
+
+void* createCounted(const char*, uint32_t) {
+    g_live_instances.fetch_add(1);
+    return &g_live_instances;
+}
+
+void destroyCounted(void*) {
+    g_live_instances.fetch_sub(1);
+}
+
+std::atomic<uint32_t> g_max_worker_index{0};
+
+void* createIndexed(const char*, uint32_t worker_index) {
+    uint32_t seen = g_max_worker_index.load();
+    while (worker_index > seen && !g_max_worker_index.compare_exchange_weak(seen, worker_index)) {
+    }
+    return createCounted(nullptr, worker_index);
+}
+
+// Rewrites without declaring SECURECHAT_PLUGIN_REWRITES
+std::atomic<bool> g_saw_rewrite_buffer{false};
+
+securechat_verdict rewriteUndeclared(void*, const securechat_message_view*, securechat_rewrite_buffer* rewrite) {
+    g_saw_rewrite_buffer.store(rewrite->data != nullptr || rewrite->capacity != 0);
+    rewrite->length = 0;
+    return SECURECHAT_VERDICT_REWRITE;
+}
+
+// Holds its caller until released
+std::atomic<bool> g_in_plugin{false};
+std::atomic<bool> g_release_plugin{false};
+
+securechat_verdict blockUntilReleased(void*, const securechat_message_view*, securechat_rewrite_buffer*) {
+    g_in_plugin.store(true);
+    while (!g_release_plugin.load()) {
+        std::this_thread::yield();
+    }
+    return SECURECHAT_VERDICT_ACCEPT;
+}
+
+const securechat_plugin APPEND_A = {SECURECHAT_PLUGIN_ABI_VERSION, sizeof(securechat_plugin), "append_a", "1.0",
+                                    createAppend, destroyAppend, appendSuffix, SECURECHAT_PLUGIN_REWRITES};
+const securechat_plugin APPEND_B = {SECURECHAT_PLUGIN_ABI_VERSION, sizeof(securechat_plugin), "append_b", "1.0",
+                                    createAppend, destroyAppend, appendSuffix, SECURECHAT_PLUGIN_REWRITES};
+const securechat_plugin SENDER_BLOCK = {SECURECHAT_PLUGIN_ABI_VERSION, sizeof(securechat_plugin), "sender_block",
+                                        "1.0", createAppend, destroyAppend, rejectFromSender, 0};
+const securechat_plugin NOOP = {SECURECHAT_PLUGIN_ABI_VERSION, sizeof(securechat_plugin), "noop", "1.0",
+                                createCounted, destroyCounted, acceptAll, 0};
+const securechat_plugin INDEXED = {SECURECHAT_PLUGIN_ABI_VERSION, sizeof(securechat_plugin), "indexed", "1.0",
+                                   createIndexed, destroyCounted, acceptAll, 0};
+const securechat_plugin READ_ONLY = {SECURECHAT_PLUGIN_ABI_VERSION, sizeof(securechat_plugin), "read_only", "1.0",
+                                     createCounted, destroyCounted, rewriteUndeclared, 0};
+const securechat_plugin BLOCKING = {SECURECHAT_PLUGIN_ABI_VERSION, sizeof(securechat_plugin), "blocking", "1.0",
+                                    createCounted, destroyCounted, blockUntilReleased, 0};
+const securechat_plugin FUTURE_ABI = {SECURECHAT_PLUGIN_ABI_VERSION + 1, sizeof(securechat_plugin), "future", "2.0",
+                                      createCounted, destroyCounted, acceptAll, 0};
+
+} // namespace
+
+class PluginManagerTest : public ::testing::Test {
+protected:
+    securechat_message_header header(uint64_t sender_id = 1) {
+        securechat_message_header header{};
+        header.sender_id = sender_id;
+        return header;
+    }
+
+    securechat::utils::ConfigManager config_;
+};
+
+TEST_F(PluginManagerTest, EmptyPipelineAcceptsWithoutCopying) {
+    PluginManager manager(config_);
+    EXPECT_TRUE(manager.empty());
+
+    std::string message = "hello";
+    std::string_view output;
+    EXPECT_EQ(manager.process(header(), message, output), SECURECHAT_VERDICT_ACCEPT);
+    EXPECT_EQ(output.data(), message.data());
+}
+
+TEST_F(PluginManagerTest, RewritesChainInLoadOrder) {
+    PluginManager manager(config_);
+    ASSERT_TRUE(manager.registerPlugin(&APPEND_A, "-a"));
+    ASSERT_TRUE(manager.registerPlugin(&APPEND_B, "-b"));
+    ASSERT_TRUE(manager.registerPlugin(&SENDER_BLOCK));
+
+    std::string_view output;
+    EXPECT_EQ(manager.process(header(), "msg", output), SECURECHAT_VERDICT_REWRITE);
+    EXPECT_EQ(output, "msg-a-b");
+
+    // Repeated calls reuse the same two buffers without corrupting the chain
+    EXPECT_EQ(manager.process(header(), "again", output), SECURECHAT_VERDICT_REWRITE);
+    EXPECT_EQ(output, "again-a-b");
+}
+
+TEST_F(PluginManagerTest, RejectStopsThePipeline) {
+    PluginManager manager(config_);
+    ASSERT_TRUE(manager.registerPlugin(&SENDER_BLOCK));
+    ASSERT_TRUE(manager.registerPlugin(&APPEND_A, "-a"));
+
+    std::string_view output;
+    EXPECT_EQ(manager.process(header(13), "msg", output), SECURECHAT_VERDICT_REJECT);
+
+    auto stats = manager.getStats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[0].calls, 1u);
+    EXPECT_EQ(stats[0].rejects, 1u);
+    EXPECT_EQ(stats[1].calls, 0u);
+}
+
+TEST_F(PluginManagerTest, OversizedRewriteIsRejected) {
+    PluginManager manager(config_);
+    std::string huge_suffix(static_cast<size_t>(config_.getMaxMessageSize()), 'x');
+    ASSERT_TRUE(manager.registerPlugin(&APPEND_A, huge_suffix));
+
+    std::string_view output;
+    EXPECT_EQ(manager.process(header(), "msg", output), SECURECHAT_VERDICT_REJECT);
+    EXPECT_EQ(manager.getStats()[0].rejects, 1u);
+}
+
+TEST_F(PluginManagerTest, OnlyRewritingPluginsGetARewriteBuffer) {
+    PluginManager manager(config_);
+    ASSERT_TRUE(manager.registerPlugin(&READ_ONLY));
+
+    std::string_view output;
+    EXPECT_EQ(manager.process(header(), "msg", output), SECURECHAT_VERDICT_REJECT);
+    EXPECT_FALSE(g_saw_rewrite_buffer.load());
+    EXPECT_EQ(manager.getStats()[0].rejects, 1u);
+}
+
+TEST_F(PluginManagerTest, RejectsIncompatibleAbiAndDuplicates) {
+    PluginManager manager(config_);
+    EXPECT_FALSE(manager.registerPlugin(&FUTURE_ABI));
+    EXPECT_FALSE(manager.registerPlugin(nullptr));
+    EXPECT_TRUE(manager.registerPlugin(&NOOP));
+    EXPECT_FALSE(manager.registerPlugin(&NOOP));
+    EXPECT_EQ(manager.getPluginCount(), 1u);
+}
+
+TEST_F(PluginManagerTest, PluginSetIsFixedOnceTrafficStarts) {
+    PluginManager manager(config_);
+    ASSERT_TRUE(manager.registerPlugin(&NOOP));
+
+    std::string_view output;
+    manager.process(header(), "msg", output);
+    EXPECT_FALSE(manager.registerPlugin(&APPEND_A, "-a"));
+    EXPECT_EQ(manager.getPluginCount(), 1u);
+}
+
+TEST_F(PluginManagerTest, OneInstancePerThread) {
+    {
+        PluginManager manager(config_);
+        ASSERT_TRUE(manager.registerPlugin(&NOOP));
+
+        constexpr int THREADS = 4;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&]() {
+                std::string_view output;
+                for (int i = 0; i < 100; ++i) {
+                    manager.process(header(), "msg", output);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        // Exited threads destroyed their instances but kept their counters
+        EXPECT_EQ(g_live_instances.load(), 0);
+        auto stats = manager.getStats();
+        EXPECT_EQ(stats[0].calls, static_cast<uint64_t>(THREADS * 100));
+        EXPECT_GE(stats[0].max_ns, stats[0].total_ns / stats[0].calls);
+
+        std::string_view output;
+        manager.process(header(), "msg", output);
+        EXPECT_EQ(g_live_instances.load(), 1);
+    }
+    EXPECT_EQ(g_live_instances.load(), 0);
+}
+
+TEST_F(PluginManagerTest, ThreadChurnReusesWorkerIndices) {
+    PluginManager manager(config_);
+    ASSERT_TRUE(manager.registerPlugin(&INDEXED));
+    g_max_worker_index.store(0);
+
+    for (int round = 0; round < 16; ++round) {
+        std::thread([&]() {
+            std::string_view output;
+            manager.process(header(), "msg", output);
+        }).join();
+    }
+
+    EXPECT_EQ(g_live_instances.load(), 0);
+    EXPECT_EQ(g_max_worker_index.load(), 0u);
+    EXPECT_EQ(manager.getStats()[0].calls, 16u);
+}
+
+TEST_F(PluginManagerTest, ShutdownDropsCachedPipelines) {
+    PluginManager manager(config_);
+    ASSERT_TRUE(manager.registerPlugin(&NOOP));
+
+    std::string_view output;
+    manager.process(header(), "msg", output);
+    EXPECT_EQ(g_live_instances.load(), 1);
+
+    manager.shutdown();
+    EXPECT_EQ(g_live_instances.load(), 0);
+
+    // The stale cached pointer must not be used after shutdown
+    EXPECT_EQ(manager.process(header(), "msg", output), SECURECHAT_VERDICT_ACCEPT);
+    EXPECT_EQ(output, "msg");
+    EXPECT_EQ(g_live_instances.load(), 0);
+}
+
+TEST_F(PluginManagerTest, ShutdownWaitsForCallsInProgress) {
+    PluginManager manager(config_);
+    ASSERT_TRUE(manager.registerPlugin(&BLOCKING));
+    g_in_plugin.store(false);
+    g_release_plugin.store(false);
+
+    std::thread reader([&]() {
+        std::string_view output;
+        manager.process(header(), "msg", output);
+    });
+    while (!g_in_plugin.load()) {
+        std::this_thread::yield();
+    }
+
+    std::atomic<bool> shut_down{false};
+    std::thread closer([&]() {
+        manager.shutdown();
+        shut_down.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(shut_down.load());
+    EXPECT_EQ(g_live_instances.load(), 1);
+
+    g_release_plugin.store(true);
+    reader.join();
+    closer.join();
+    EXPECT_TRUE(shut_down.load());
+    EXPECT_EQ(g_live_instances.load(), 0);
+}
+
+TEST_F(PluginManagerTest, MissingLibraryFailsToLoad) {
+    PluginManager manager(config_);
+    EXPECT_FALSE(manager.loadPlugin("/nonexistent/plugin.so"));
+    EXPECT_TRUE(manager.empty());
+}
+
+#ifdef SAMPLE_PLUGIN_PATH
+TEST_F(PluginManagerTest, LoadsSharedObjectPlugin) {
+    PluginManager manager(config_);
+    ASSERT_TRUE(manager.loadPlugin(SAMPLE_PLUGIN_PATH));
+    EXPECT_EQ(manager.getStats()[0].name, "sample");
+
+    std::string_view output;
+    EXPECT_EQ(manager.process(header(), "/shout hello", output), SECURECHAT_VERDICT_REWRITE);
+    EXPECT_EQ(output, "HELLO");
+    EXPECT_EQ(manager.process(header(), "quiet", output), SECURECHAT_VERDICT_ACCEPT);
+    EXPECT_EQ(output, "quiet");
+}
+#endif
+
+// Performance test
+TEST_F(PluginManagerTest, PerPluginOverhead) {
+    PluginManager manager(config_);
+    ASSERT_TRUE(manager.registerPlugin(&NOOP));
+
+    const int iterations = 200000;
+    std::string message(128, 'm');
+    std::string_view output;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        manager.process(header(), message, output);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double ns_per_call = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / iterations;
+
+    std::cout << "Plugin pipeline overhead: " << ns_per_call << " ns per message per plugin" << std::endl;
+#ifdef NDEBUG
+    EXPECT_LT(ns_per_call, 1000.0);
+#endif
+}
@@ -1,6 +1,579 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils/allocation_counter.hpp"
+#include "utils/clock.hpp"
+#include "utils/cpu_topology.hpp"
+#include "utils/huge_page_arena.hpp"
+#include "utils/latency_histogram.hpp"
+#include "utils/memory_pool.hpp"
+#include "utils/message_buffer.hpp"
+#include "utils/mpsc_queue.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/text_validator.hpp"
+
+using securechat::utils::AllocationCounter;
+using securechat::utils::HugePageArena;
+using securechat::utils::HugePageConfig;
+using securechat::utils::HugePageMode;
+using securechat::utils::LatencyHistogram;
+using securechat::utils::MemoryPool;
+using securechat::utils::MessageBuffer;
+using securechat::utils::MpscQueue;
+using securechat::utils::NoAllocationScope;
+using securechat::utils::SimulatedClock;
+using securechat::utils::SpscQueue;
+using securechat::utils::TextStatus;
 
 // Placeholder utils tests
 TEST(UtilsTest, BasicTest) {
     EXPECT_TRUE(true);
-}
\ No newline at end of file
+}
+
+class LatencyHistogramTest : public ::testing::Test {
+protected:
+    LatencyHistogram histogram_;
+};
+
+TEST_F(LatencyHistogramTest, EmptyHistogramReportsZero) {
+    EXPECT_EQ(histogram_.getCount(), 0u);
+    EXPECT_EQ(histogram_.percentile(99), 0u);
+    EXPECT_EQ(histogram_.getMin(), 0u);
+    EXPECT_EQ(histogram_.getMean(), 0.0);
+}
+
+TEST_F(LatencyHistogramTest, PercentilesWithinBucketPrecision) {
+    for (uint64_t value = 1; value <= 100000; ++value) {
+        histogram_.record(value * 1000);
+    }
+
+    EXPECT_EQ(histogram_.getCount(), 100000u);
+    EXPECT_EQ(histogram_.getMin(), 1000u);
+    EXPECT_EQ(histogram_.getMax(), 100000000u);
+
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        double expected = p * 1000.0 * 1000.0;
+        double actual = static_cast<double>(histogram_.percentile(p));
+        EXPECT_NEAR(actual, expected, expected * 0.04) << "p" << p;
+    }
+    EXPECT_EQ(histogram_.percentile(100), histogram_.getMax());
+}
+
+TEST_F(LatencyHistogramTest, SmallValuesAreExact) {
+    for (uint64_t value = 0; value < LatencyHistogram::SUB_BUCKETS; ++value) {
+        histogram_.record(value);
+    }
+    EXPECT_EQ(histogram_.percentile(50), LatencyHistogram::SUB_BUCKETS / 2 - 1);
+}
+
+TEST_F(LatencyHistogramTest, MergeCombinesCounts) {
+    LatencyHistogram other;
+    histogram_.record(100);
+    other.record(5000000);
+    other.record(7);
+
+    histogram_.merge(other);
+    EXPECT_EQ(histogram_.getCount(), 3u);
+    EXPECT_EQ(histogram_.getMin(), 7u);
+    EXPECT_EQ(histogram_.getMax(), 5000000u);
+}
+
+class SimulatedClockTest : public ::testing::Test {
+protected:
+    SimulatedClock clock_;
+    std::vector<std::string> fired_;
+};
+
+TEST_F(SimulatedClockTest, FiresTimersInDeadlineThenSchedulingOrder) {
+    auto start = clock_.now();
+    clock_.runAfter(std::chrono::milliseconds(20), [this]() { fired_.push_back("c"); });
+    clock_.runAfter(std::chrono::milliseconds(10), [this]() { fired_.push_back("a"); });
+    clock_.runAfter(std::chrono::milliseconds(10), [this]() { fired_.push_back("b"); });
+
+    EXPECT_EQ(clock_.advance(std::chrono::milliseconds(9)), 0u);
+    EXPECT_EQ(clock_.advance(std::chrono::milliseconds(11)), 3u);
+    EXPECT_EQ(fired_, (std::vector<std::string>{"a", "b", "c"}));
+    EXPECT_EQ(clock_.now() - start, std::chrono::milliseconds(20));
+    EXPECT_EQ(clock_.getPendingTimers(), 0u);
+}
+
+TEST_F(SimulatedClockTest, CallbacksSeeTheirDeadlineAndCanReschedule) {
+    auto start = clock_.now();
+    std::vector<SimulatedClock::duration> seen;
+    std::function<void()> tick = [&]() {
+        seen.push_back(clock_.now() - start);
+        if (seen.size() < 5) {
+            clock_.runAfter(std::chrono::seconds(1), tick);
+        }
+    };
+    clock_.runAfter(std::chrono::seconds(1), tick);
+
+    EXPECT_EQ(clock_.advance(std::chrono::seconds(3)), 3u);
+    EXPECT_EQ(clock_.advanceToNextTimer(), 1u);
+    EXPECT_EQ(clock_.now() - start, std::chrono::seconds(4));
+    clock_.advance(std::chrono::minutes(1));
+
+    ASSERT_EQ(seen.size(), 5u);
+    for (size_t i = 0; i < seen.size(); ++i) {
+        EXPECT_EQ(seen[i], std::chrono::seconds(i + 1));
+    }
+}
+
+TEST_F(SimulatedClockTest, CancelledTimersDoNotFire) {
+    auto id = clock_.runAfter(std::chrono::seconds(1), [this]() { fired_.push_back("cancelled"); });
+    clock_.runAfter(std::chrono::seconds(2), [this]() { fired_.push_back("kept"); });
+
+    EXPECT_TRUE(clock_.cancel(id));
+    EXPECT_FALSE(clock_.cancel(id));
+    EXPECT_EQ(clock_.advance(std::chrono::seconds(5)), 1u);
+    EXPECT_EQ(fired_, (std::vector<std::string>{"kept"}));
+    EXPECT_EQ(clock_.getFiredTimers(), 1u);
+}
+
+class MemoryPoolTest : public ::testing::Test {
+protected:
+    MemoryPool pool_{1024, 2};
+};
+
+TEST_F(MemoryPoolTest, ReusesReleasedBlocks) {
+    auto block = pool_.acquire();
+    ASSERT_TRUE(block);
+    EXPECT_EQ(block.size(), 1024u);
+    char* first = block.data();
+    block.reset();
+    EXPECT_FALSE(block);
+    EXPECT_EQ(pool_.getCachedBlocks(), 1u);
+
+    auto again = pool_.acquire();
+    EXPECT_EQ(again.data(), first);
+    EXPECT_EQ(pool_.getHeapAllocations(), 1u);
+    EXPECT_EQ(pool_.getBlocksInUse(), 1u);
+}
+
+TEST_F(MemoryPoolTest, CachesAtMostTheConfiguredBlocks) {
+    std::vector<MemoryPool::Block> blocks;
+    for (int i = 0; i < 5; ++i) {
+        blocks.push_back(pool_.acquire());
+    }
+    EXPECT_EQ(pool_.getBlocksInUse(), 5u);
+
+    blocks.clear();
+    EXPECT_EQ(pool_.getBlocksInUse(), 0u);
+    EXPECT_EQ(pool_.getCachedBlocks(), 2u);
+}
+
+class HugePageArenaTest : public ::testing::Test {
+protected:
+    // A THP arena of one huge page; null with error_ set where the kernel
+    // has THP turned off
+    std::unique_ptr<HugePageArena> reserveOnePage() {
+        HugePageConfig config;
+        config.enabled = true;
+        config.mode = HugePageMode::TRANSPARENT;
+        config.bytes = 1;
+        auto arena = std::make_unique<HugePageArena>(config);
+        if (!arena->reserve()) {
+            error_ = arena->getError();
+            return nullptr;
+        }
+        return arena;
+    }
+
+    std::string error_;
+};
+
+TEST_F(HugePageArenaTest, ReservesWholeAlignedPagesAndCarvesUntilFull) {
+    auto arena = reserveOnePage();
+    if (!arena) {
+        GTEST_SKIP() << error_;
+    }
+    EXPECT_EQ(arena->getReservedBytes(), HugePageArena::HUGE_PAGE_SIZE);
+
+    char* first = arena->carve(100);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % HugePageArena::HUGE_PAGE_SIZE, 0u);
+    char* second = arena->carve(100);
+    EXPECT_EQ(second, first + HugePageArena::BLOCK_ALIGNMENT * 2);
+    EXPECT_TRUE(arena->contains(second));
+    EXPECT_EQ(arena->getUsedBytes(), HugePageArena::BLOCK_ALIGNMENT * 4);
+
+    EXPECT_EQ(arena->carve(HugePageArena::HUGE_PAGE_SIZE), nullptr);
+    int outside = 0;
+    EXPECT_FALSE(arena->contains(&outside));
+}
+
+TEST_F(HugePageArenaTest, ReportsWhyAReservationFailed) {
+    HugePageConfig config;
+    config.enabled = true;
+    config.bytes = 0;
+    HugePageArena empty(config);
+    EXPECT_FALSE(empty.reserve());
+    EXPECT_NE(empty.getError().find("per_connection_bytes"), std::string::npos);
+
+    // Far more explicit huge pages than any test machine sets aside
+    config.mode = HugePageMode::HUGETLB;
+    config.bytes = size_t{1} << 46;
+    HugePageArena hugetlb(config);
+    EXPECT_FALSE(hugetlb.reserve());
+    EXPECT_NE(hugetlb.getError().find("vm.nr_hugepages"), std::string::npos);
+    EXPECT_EQ(hugetlb.getReservedBytes(), 0u);
+    EXPECT_EQ(hugetlb.carve(64), nullptr);
+}
+
+TEST_F(HugePageArenaTest, BackedPoolKeepsArenaBlocksAndFallsBackToHeap) {
+    auto arena = reserveOnePage();
+    if (!arena) {
+        GTEST_SKIP() << error_;
+    }
+    const size_t block_size = HugePageArena::HUGE_PAGE_SIZE / 4;
+    MemoryPool pool(block_size, 1, arena.get());
+
+    std::vector<MemoryPool::Block> blocks;
+    for (int i = 0; i < 5; ++i) {
+        blocks.push_back(pool.acquire());
+    }
+    EXPECT_EQ(pool.getArenaAllocations(), 4u);
+    EXPECT_EQ(pool.getHeapAllocations(), 1u);
+    EXPECT_TRUE(arena->contains(blocks[3].data()));
+    EXPECT_FALSE(arena->contains(blocks[4].data()));
+
+    // Arena blocks are kept past max_cached_blocks; the heap block is not
+    blocks.clear();
+    EXPECT_EQ(pool.getCachedBlocks(), 4u);
+}
+
+class AllocationCounterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!AllocationCounter::isEnabled()) {
+            GTEST_SKIP() << "build with -DENABLE_ALLOCATION_COUNTING=ON";
+        }
+    }
+};
+
+TEST_F(AllocationCounterTest, CountsOnlyTheCallingThreadInsideTheScope) {
+    std::vector<int> reserved;
+    reserved.reserve(16);
+    std::atomic<bool> go{false};
+    std::thread other([&go]() {
+        while (!go.load()) {
+            std::this_thread::yield();
+        }
+        std::vector<int> elsewhere(64);
+    });
+
+    NoAllocationScope scope("counter test");
+    reserved.push_back(1);
+    go = true;
+    other.join();
+    EXPECT_EQ(scope.getAllocations(), 0u);
+
+    auto owned = std::make_unique<std::string>(100, 'x');
+    EXPECT_EQ(scope.getAllocations(), 2u);
+    EXPECT_GE(scope.getAllocatedBytes(), 100u);
+    EXPECT_EQ(scope.finish(), scope.getAllocations());
+}
+
+TEST_F(AllocationCounterTest, UnfinishedScopeAbortsOnAllocation) {
+    EXPECT_DEATH(
+        {
+            NoAllocationScope scope("must not allocate");
+            auto leaked = std::make_unique<std::vector<char>>(32);
+        },
+        "NoAllocationScope 'must not allocate'");
+}
+
+class TextValidatorTest : public ::testing::Test {
+protected:
+    // Every implementation must agree, wherever the text falls in a SIMD block
+    static void expectStatus(const std::string& text, TextStatus expected) {
+        for (size_t offset : {0, 1, 13, 15, 16, 31, 32, 45}) {
+            std::string padded = std::string(offset, 'a') + text;
+            SCOPED_TRACE("offset " + std::to_string(offset));
+            EXPECT_EQ(securechat::utils::validateTextScalar(padded), expected);
+            EXPECT_EQ(securechat::utils::validateTextSSSE3(padded), expected);
+            EXPECT_EQ(securechat::utils::validateTextAVX2(padded), expected);
+            EXPECT_EQ(securechat::utils::validateText(padded), expected);
+        }
+    }
+};
+
+TEST_F(TextValidatorTest, AcceptsWellFormedText) {
+    expectStatus("", TextStatus::VALID);
+    expectStatus("hello\tworld\r\n", TextStatus::VALID);
+    expectStatus("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80", TextStatus::VALID);
+    // Boundaries: U+0080 is C1, so start at U+00A0; then U+07FF, U+0800,
+    // U+D7FF, U+E000, U+FFFF, U+10000 and U+10FFFF
+    expectStatus("\xc2\xa0\xdf\xbf\xe0\xa0\x80\xed\x9f\xbf\xee\x80\x80\xef\xbf\xbf"
+                 "\xf0\x90\x80\x80\xf4\x8f\xbf\xbf",
+                 TextStatus::VALID);
+}
+
+TEST_F(TextValidatorTest, RejectsMalformedUtf8) {
+    for (const char* text : {
+             "\x80",                 // stray continuation
+             "\xc3",                 // truncated at the end
+             "\xe2\x82",             // truncated at the end
+             "\xf0\x9f\x98",         // truncated at the end
+             "\xc3 x",               // missing continuation
+             "\xc0\xaf",             // overlong two-byte
+             "\xe0\x80\xaf",         // overlong three-byte
+             "\xf0\x80\x80\xaf",     // overlong four-byte
+             "\xed\xa0\x80",         // surrogate
+             "\xf4\x90\x80\x80",     // beyond U+10FFFF
+             "\xf8\x88\x80\x80\x80", // five-byte form
+             "\xff",
+             "\xe2\x82\xac\xac",     // extra continuation
+         }) {
+        SCOPED_TRACE(::testing::PrintToString(std::string(text)));
+        expectStatus(text, TextStatus::INVALID_UTF8);
+    }
+    // Invalid UTF-8 outranks a control character earlier in the text
+    expectStatus(std::string("\x01 ok \xc0\xaf"), TextStatus::INVALID_UTF8);
+}
+
+TEST_F(TextValidatorTest, RejectsControlCharacters) {
+    expectStatus(std::string("nul \0 byte", 10), TextStatus::CONTROL_CHARACTER);
+    expectStatus("\x1b[2J clear screen", TextStatus::CONTROL_CHARACTER);
+    expectStatus("bell \x07", TextStatus::CONTROL_CHARACTER);
+    expectStatus("del \x7f", TextStatus::CONTROL_CHARACTER);
+    // C1 controls: U+0085 (NEL) and U+009B (CSI)
+    expectStatus("next\xc2\x85line", TextStatus::CONTROL_CHARACTER);
+    expectStatus("\xc2\x9b" "31m", TextStatus::CONTROL_CHARACTER);
+}
+
+TEST_F(TextValidatorTest, ImplementationsAgreeOnRandomText) {
+    // Mostly-valid text with occasional corruption exercises sequences that
+    // straddle SIMD blocks
+    static const std::vector<std::string> pieces = {
+        "a", "hello ", "\n", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\x9f\xbf", "\xc2\xa0",
+    };
+    std::mt19937 rng(42);
+    for (int round = 0; round < 5000; ++round) {
+        std::string text;
+        size_t length = rng() % 200;
+        while (text.size() < length) {
+            text += pieces[rng() % pieces.size()];
+        }
+        if (!text.empty() && rng() % 2 == 0) {
+            text[rng() % text.size()] = static_cast<char>(rng() % 256);
+        }
+        TextStatus expected = securechat::utils::validateTextScalar(text);
+        ASSERT_EQ(securechat::utils::validateTextSSSE3(text), expected) << ::testing::PrintToString(text);
+        ASSERT_EQ(securechat::utils::validateTextAVX2(text), expected) << ::testing::PrintToString(text);
+    }
+}
+
+TEST(CpuTopologyTest, ParsesAndFormatsCpuLists) {
+    EXPECT_EQ(securechat::utils::parseCpuList("0-3,8,10-11"),
+              (securechat::utils::CpuSet{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(securechat::utils::parseCpuList("5,1-2,2\n"), (securechat::utils::CpuSet{1, 2, 5}));
+    EXPECT_TRUE(securechat::utils::parseCpuList("3-1").empty());
+    EXPECT_TRUE(securechat::utils::parseCpuList("a,b").empty());
+    EXPECT_EQ(securechat::utils::formatCpuList({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+}
+
+TEST(CpuTopologyTest, ReadsNumaNodesFromSysfs) {
+    namespace fs = std::filesystem;
+    auto allowed = securechat::utils::getThreadAffinity();
+    if (allowed.size() < 2) {
+        GTEST_SKIP() << "needs at least two usable CPUs";
+    }
+
+    // Fake sysfs splitting the usable CPUs across two nodes, listed out of order
+    fs::path root = fs::temp_directory_path() / "securechat_topology_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "node" / "node0");
+    fs::create_directories(root / "node" / "node2");
+    size_t half = allowed.size() / 2;
+    std::ofstream(root / "node" / "node2" / "cpulist") << securechat::utils::formatCpuList(
+        securechat::utils::CpuSet(allowed.begin() + static_cast<std::ptrdiff_t>(half), allowed.end())) << "\n";
+    std::ofstream(root / "node" / "node0" / "cpulist") << securechat::utils::formatCpuList(
+        securechat::utils::CpuSet(allowed.begin(), allowed.begin() + static_cast<std::ptrdiff_t>(half))) << "\n";
+
+    auto topology = securechat::utils::CpuTopology::detect(root.string());
+    fs::remove_all(root);
+
+    ASSERT_EQ(topology.getNodeCount(), 2u);
+    EXPECT_EQ(topology.cpus, allowed);
+    EXPECT_EQ(topology.nodeOf(allowed.front()), 0u);
+    EXPECT_EQ(topology.nodeOf(allowed.back()), 1u);
+}
+
+TEST(CpuTopologyTest, ScopedAffinityRestoresMask) {
+    auto original = securechat::utils::getThreadAffinity();
+    if (original.empty()) {
+        GTEST_SKIP() << "thread affinity not supported";
+    }
+    {
+        securechat::utils::ScopedAffinity affinity({original.front()});
+        ASSERT_TRUE(affinity.applied());
+        EXPECT_EQ(securechat::utils::getThreadAffinity(), securechat::utils::CpuSet{original.front()});
+
+        // Threads started inside the scope inherit it
+        securechat::utils::CpuSet inherited;
+        std::thread([&]() { inherited = securechat::utils::getThreadAffinity(); }).join();
+        EXPECT_EQ(inherited, securechat::utils::CpuSet{original.front()});
+    }
+    EXPECT_EQ(securechat::utils::getThreadAffinity(), original);
+}
+
+TEST(SpscQueueTest, RejectsPushWhenFullAndDrainsInOrder) {
+    SpscQueue<std::string> queue(3);
+    ASSERT_EQ(queue.capacity(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.tryPush(std::to_string(i)));
+    }
+    std::string extra = "extra";
+    EXPECT_FALSE(queue.tryPush(std::move(extra)));
+    EXPECT_EQ(extra, "extra");
+
+    std::vector<std::string> drained;
+    auto collect = [&](std::string&& value) { drained.push_back(std::move(value)); };
+    EXPECT_EQ(queue.drain(collect, 3), 3u);
+    EXPECT_TRUE(queue.tryPush(std::move(extra)));
+    EXPECT_EQ(queue.drain(collect, 64), 2u);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(drained, (std::vector<std::string>{"0", "1", "2", "3", "extra"}));
+}
+
+TEST(SpscQueueTest, TransfersAcrossThreads) {
+    constexpr uint64_t COUNT = 10000;
+    SpscQueue<uint64_t> queue(64);
+    std::thread producer([&]() {
+        for (uint64_t i = 0; i < COUNT;) {
+            uint64_t value = i;
+            if (queue.tryPush(std::move(value))) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < COUNT) {
+        queue.drain([&](uint64_t&& value) { ordered = ordered && value == expected++; }, 16);
+    }
+    producer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpscQueueTest, DrainsWholeBatchInOrder) {
+    MpscQueue<std::string> queue;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_TRUE(queue.push("0"));
+    EXPECT_FALSE(queue.push("1"));
+    EXPECT_FALSE(queue.push("2"));
+
+    std::vector<std::string> drained;
+    auto collect = [&](std::string&& value) { drained.push_back(std::move(value)); };
+    EXPECT_EQ(queue.drain(collect), 3u);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_TRUE(queue.push("3"));
+    EXPECT_EQ(queue.drain(collect), 1u);
+    EXPECT_EQ(drained, (std::vector<std::string>{"0", "1", "2", "3"}));
+}
+
+TEST(MpscQueueTest, ReusesDrainedNodes) {
+    MpscQueue<std::string> queue;
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < 8; ++i) {
+            queue.push(std::string(64, 'x'));
+        }
+        EXPECT_EQ(queue.drain([](std::string&&) {}), 8u);
+    }
+    EXPECT_EQ(queue.getAllocatedNodes(), 8u);
+}
+
+TEST(MpscQueueTest, KeepsPerProducerOrderAcrossThreads) {
+    constexpr uint64_t PRODUCERS = 4;
+    constexpr uint64_t PER_PRODUCER = 5000;
+    MpscQueue<uint64_t> queue;
+    std::vector<std::thread> producers;
+    for (uint64_t p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (uint64_t i = 0; i < PER_PRODUCER; ++i) {
+                queue.push(p * PER_PRODUCER + i);
+            }
+        });
+    }
+
+    std::vector<uint64_t> next(PRODUCERS, 0);
+    uint64_t received = 0;
+    while (received < PRODUCERS * PER_PRODUCER) {
+        received += queue.drain([&](uint64_t value) {
+            uint64_t producer = value / PER_PRODUCER;
+            EXPECT_EQ(value % PER_PRODUCER, next[producer]);
+            next[producer]++;
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MessageBufferTest, SmallPayloadsAreInlineAndLargeOnesShared) {
+    MessageBuffer small("hello");
+    EXPECT_TRUE(small.isInline());
+    EXPECT_EQ(small.view(), "hello");
+
+    std::string text(1000, 'x');
+    MessageBuffer large(text);
+    EXPECT_FALSE(large.isInline());
+    MessageBuffer shared = large;
+    EXPECT_EQ(shared.data(), large.data());
+    EXPECT_EQ(large.useCount(), 2u);
+    {
+        MessageBuffer moved = std::move(shared);
+        EXPECT_TRUE(shared.empty());
+        EXPECT_EQ(moved.view(), text);
+        EXPECT_EQ(large.useCount(), 2u);
+    }
+    EXPECT_EQ(large.useCount(), 1u);
+
+    large = small;
+    EXPECT_EQ(large, small);
+    EXPECT_TRUE(large.isInline());
+}
+
+TEST(MessageBufferTest, BuildWritesOnceAndCoversEverySizeClass) {
+    for (size_t size : {size_t{0}, MessageBuffer::INLINE_CAPACITY, MessageBuffer::INLINE_CAPACITY + 1,
+                        size_t{4000}, MessageBuffer::MAX_POOLED_SIZE, size_t{1} << 20}) {
+        MessageBuffer buffer = MessageBuffer::build(size, [size](char* out) {
+            for (size_t i = 0; i < size; ++i) {
+                out[i] = static_cast<char>(i);
+            }
+        });
+        ASSERT_EQ(buffer.size(), size);
+        for (size_t i = 0; i < size; i += 997) {
+            EXPECT_EQ(buffer.data()[i], static_cast<char>(i));
+        }
+    }
+}
+
+TEST(MessageBufferTest, SharedAcrossThreadsIsReleasedOnce) {
+    MessageBuffer buffer(std::string(512, 'm'));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([buffer]() {
+            for (int i = 0; i < 1000; ++i) {
+                MessageBuffer copy = buffer;
+                EXPECT_EQ(copy.size(), 512u);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(buffer.useCount(), 1u);
+}